@@ -33,6 +33,8 @@ $SCRIPTPATH/include/roaring/roaring_version.h
 $SCRIPTPATH/include/roaring/roaring_types.h
 $SCRIPTPATH/include/roaring/roaring.h
 $SCRIPTPATH/include/roaring/memory.h
+$SCRIPTPATH/include/roaring/roaring64.h
+$SCRIPTPATH/include/roaring/roaring_bsi.h
 "
 
 # .hh header files for the C++ API wrapper => Order does not matter at present
@@ -40,6 +42,7 @@ $SCRIPTPATH/include/roaring/memory.h
 ALL_PUBLIC_HH="
 $SCRIPTPATH/cpp/roaring.hh
 $SCRIPTPATH/cpp/roaring64map.hh
+$SCRIPTPATH/cpp/roaring_bsi.hh
 "
 
 # internal .h files => These are used in the implementation but aren't part of
@@ -67,6 +70,7 @@ $SCRIPTPATH/include/roaring/containers/mixed_union.h
 $SCRIPTPATH/include/roaring/containers/mixed_xor.h
 $SCRIPTPATH/include/roaring/containers/containers.h
 $SCRIPTPATH/include/roaring/roaring_array.h
+$SCRIPTPATH/include/roaring/art/art.h
 $SCRIPTPATH/include/roaring/misc/configreport.h
 "
 
@@ -114,6 +114,25 @@ void run_test(uint32_t spanlen, uint32_t intvlen, double density, order_t order)
     }
     printf("     %6.1f\n", array_min(results, num_passes));
 
+    if (order == ASC) {
+        printf("  roaring_bitmap_from_sorted():");
+        uint32_t values[intvlen * count];
+        for (int64_t i = 0; i < count; i++) {
+            for (uint32_t j = 0; j < intvlen; j++) {
+                values[i * intvlen + j] = offsets[i] + j;
+            }
+        }
+        for (int p = 0; p < num_passes; p++) {
+            RDTSC_START(cycles_start);
+            roaring_bitmap_t *r =
+                roaring_bitmap_from_sorted(values, intvlen * count);
+            RDTSC_FINAL(cycles_final);
+            results[p] = (cycles_final - cycles_start) * 1.0 / count / intvlen;
+            roaring_bitmap_free(r);
+        }
+        printf("  %6.1f\n", array_min(results, num_passes));
+    }
+
     printf("  roaring_bitmap_add_bulk():");
     for (int p = 0; p < num_passes; p++) {
         roaring_bitmap_t *r = roaring_bitmap_create();
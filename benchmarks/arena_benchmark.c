@@ -0,0 +1,67 @@
+#define _GNU_SOURCE
+#include <roaring/roaring.h>
+#include <stdio.h>
+#include "benchmark.h"
+#include "random.h"
+
+// A query-like workload: a few temporary results per request, thrown away
+// at the end of the request.
+enum { NUMBER_OF_INPUTS = 16, NUMBER_OF_QUERIES = 64 };
+
+static roaring_bitmap_t *inputs[NUMBER_OF_INPUTS];
+
+static uint64_t run_query(int q) {
+    const roaring_bitmap_t *a = inputs[q % NUMBER_OF_INPUTS];
+    const roaring_bitmap_t *b = inputs[(q + 5) % NUMBER_OF_INPUTS];
+    const roaring_bitmap_t *c = inputs[(q + 11) % NUMBER_OF_INPUTS];
+    roaring_bitmap_t *ab = roaring_bitmap_and(a, b);
+    roaring_bitmap_t *ac = roaring_bitmap_or(a, c);
+    roaring_bitmap_t *result = roaring_bitmap_andnot(ac, ab);
+    roaring_bitmap_add_range(result, 0, 1000);
+    uint64_t card = roaring_bitmap_get_cardinality(result);
+    roaring_bitmap_free(ab);
+    roaring_bitmap_free(ac);
+    roaring_bitmap_free(result);
+    return card;
+}
+
+static uint64_t queries_default(void) {
+    uint64_t total = 0;
+    for (int q = 0; q < NUMBER_OF_QUERIES; q++) {
+        total += run_query(q);
+    }
+    return total;
+}
+
+static uint64_t queries_arena(roaring_arena_t *arena) {
+    uint64_t total = 0;
+    for (int q = 0; q < NUMBER_OF_QUERIES; q++) {
+        roaring_arena_activate(arena);
+        total += run_query(q);
+        roaring_arena_activate(NULL);
+        roaring_arena_reset(arena);
+    }
+    return total;
+}
+
+int main() {
+    int repeat = 50;
+    for (int i = 0; i < NUMBER_OF_INPUTS; i++) {
+        inputs[i] = roaring_bitmap_create();
+        // sparse values (array containers) over many keys
+        for (int j = 0; j < 200000; j++) {
+            roaring_bitmap_add(inputs[i], pcg32_random() % (1u << 26));
+        }
+    }
+    roaring_arena_t *arena = roaring_arena_create(1 << 20);
+    uint64_t answer = queries_default();
+    printf("arena benchmark, %d queries, times in cycles per query\n",
+           NUMBER_OF_QUERIES);
+    BEST_TIME(queries_default(), answer, repeat, NUMBER_OF_QUERIES);
+    BEST_TIME(queries_arena(arena), answer, repeat, NUMBER_OF_QUERIES);
+    roaring_arena_free(arena);
+    for (int i = 0; i < NUMBER_OF_INPUTS; i++) {
+        roaring_bitmap_free(inputs[i]);
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <roaring/portability.h>
+#include <roaring/array_util.h>
 #include <roaring/containers/array.h>
 #include <roaring/misc/configreport.h>
 #include "benchmark.h"
@@ -71,6 +72,131 @@ int intersection_test(array_container_t* B1, array_container_t* B2,
     array_container_intersection(B1, B2, BO);
     return BO->cardinality;
 }
+// direct calls into the array kernels, to compare the instruction sets
+int scalar_intersection_test(array_container_t* B1, array_container_t* B2,
+                             array_container_t* BO) {
+    return intersect_uint16(B1->array, B1->cardinality, B2->array,
+                            B2->cardinality, BO->array);
+}
+
+int scalar_union_test(array_container_t* B1, array_container_t* B2,
+                      array_container_t* BO) {
+    return (int)union_uint16(B1->array, B1->cardinality, B2->array,
+                             B2->cardinality, BO->array);
+}
+
+int scalar_xor_test(array_container_t* B1, array_container_t* B2,
+                    array_container_t* BO) {
+    return xor_uint16(B1->array, B1->cardinality, B2->array, B2->cardinality,
+                      BO->array);
+}
+
+int scalar_difference_test(array_container_t* B1, array_container_t* B2,
+                           array_container_t* BO) {
+    return difference_uint16(B1->array, B1->cardinality, B2->array,
+                             B2->cardinality, BO->array);
+}
+
+#ifdef CROARING_IS_X64
+int sse_intersection_test(array_container_t* B1, array_container_t* B2,
+                          array_container_t* BO) {
+    return intersect_vector16(B1->array, B1->cardinality, B2->array,
+                              B2->cardinality, BO->array);
+}
+
+int sse_union_test(array_container_t* B1, array_container_t* B2,
+                   array_container_t* BO) {
+    return (int)union_vector16(B1->array, B1->cardinality, B2->array,
+                               B2->cardinality, BO->array);
+}
+
+int sse_xor_test(array_container_t* B1, array_container_t* B2,
+                 array_container_t* BO) {
+    return (int)xor_vector16(B1->array, B1->cardinality, B2->array,
+                             B2->cardinality, BO->array);
+}
+
+int sse_difference_test(array_container_t* B1, array_container_t* B2,
+                        array_container_t* BO) {
+    return difference_vector16(B1->array, B1->cardinality, B2->array,
+                               B2->cardinality, BO->array);
+}
+#endif
+
+#if CROARING_COMPILER_SUPPORTS_AVX512
+int avx512_union_test(array_container_t* B1, array_container_t* B2,
+                      array_container_t* BO) {
+    return (int)union_vector16_avx512(B1->array, B1->cardinality, B2->array,
+                                      B2->cardinality, BO->array);
+}
+
+int avx512_xor_test(array_container_t* B1, array_container_t* B2,
+                    array_container_t* BO) {
+    return (int)xor_vector16_avx512(B1->array, B1->cardinality, B2->array,
+                                    B2->cardinality, BO->array);
+}
+#endif
+
+// times each available implementation of the array kernels on two random
+// containers with the given cardinalities
+void kernel_comparison(int card1, int card2, int repeat) {
+    array_container_t* B1 = array_container_create();
+    array_container_t* B2 = array_container_create();
+    while (B1->cardinality < card1) {
+        array_container_add(B1, (uint16_t)pcg32_random());
+    }
+    while (B2->cardinality < card2) {
+        array_container_add(B2, (uint16_t)pcg32_random());
+    }
+    int32_t inputsize = B1->cardinality + B2->cardinality;
+    array_container_t* BO = array_container_create_given_capacity(inputsize);
+    printf("==kernels, input 1 cardinality = %d, input 2 cardinality = %d \n",
+           B1->cardinality, B2->cardinality);
+    int answer = scalar_intersection_test(B1, B2, BO);
+    BEST_TIME(scalar_intersection_test(B1, B2, BO), answer, repeat, inputsize);
+#ifdef CROARING_IS_X64
+    if (croaring_avx2()) {
+        BEST_TIME(sse_intersection_test(B1, B2, BO), answer, repeat,
+                  inputsize);
+    }
+#endif
+    answer = scalar_union_test(B1, B2, BO);
+    BEST_TIME(scalar_union_test(B1, B2, BO), answer, repeat, inputsize);
+#ifdef CROARING_IS_X64
+    if (croaring_avx2()) {
+        BEST_TIME(sse_union_test(B1, B2, BO), answer, repeat, inputsize);
+    }
+#endif
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if (croaring_avx512()) {
+        BEST_TIME(avx512_union_test(B1, B2, BO), answer, repeat, inputsize);
+    }
+#endif
+    answer = scalar_xor_test(B1, B2, BO);
+    BEST_TIME(scalar_xor_test(B1, B2, BO), answer, repeat, inputsize);
+#ifdef CROARING_IS_X64
+    if (croaring_avx2()) {
+        BEST_TIME(sse_xor_test(B1, B2, BO), answer, repeat, inputsize);
+    }
+#endif
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if (croaring_avx512()) {
+        BEST_TIME(avx512_xor_test(B1, B2, BO), answer, repeat, inputsize);
+    }
+#endif
+    answer = scalar_difference_test(B1, B2, BO);
+    BEST_TIME(scalar_difference_test(B1, B2, BO), answer, repeat, inputsize);
+#ifdef CROARING_IS_X64
+    if (croaring_avx2()) {
+        BEST_TIME(sse_difference_test(B1, B2, BO), answer, repeat,
+                  inputsize);
+    }
+#endif
+    array_container_free(B1);
+    array_container_free(B2);
+    array_container_free(BO);
+}
+
 int main() {
     int repeat = 500;
     int size = TESTSIZE;
@@ -158,5 +284,13 @@ int main() {
     array_container_free(B1);
     array_container_free(B2);
     array_container_free(BO);
+
+    printf("\nArray kernels at posting-list sizes...\n");
+    printf(
+        "times are expressed in cycles per number of input elements "
+        "(both arrays)\n\n");
+    kernel_comparison(1024, 1024, repeat);
+    kernel_comparison(1024, 4096, repeat);
+    kernel_comparison(4096, 4096, repeat);
     return 0;
 }
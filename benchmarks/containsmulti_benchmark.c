@@ -21,6 +21,10 @@ void contains_multi_bulk(roaring_bitmap_t* bm, const uint32_t* values, bool* res
     }
 }
 
+void contains_multi_many(roaring_bitmap_t* bm, const uint32_t* values, uint64_t* mask, const size_t count) {
+    roaring_bitmap_contains_many(bm, values, count, mask);
+}
+
 int compare_uint32(const void* a, const void* b) {
     uint32_t arg1 = *(const uint32_t*)a;
     uint32_t arg2 = *(const uint32_t*)b;
@@ -88,6 +92,16 @@ int main(int argc, char* argv[]) {
     }
     printf("\n");
 
+    printf("                     roaring_bitmap_contains_many:");
+    for (int p = 0; p < num_passes; p++) {
+        uint64_t mask[(count[p] + 63) / 64];
+        RDTSC_START(cycles_start);
+        contains_multi_many(bm, values[p], mask, count[p]);
+        RDTSC_FINAL(cycles_final);
+        printf(" %10f", (cycles_final - cycles_start) * 1.0 / count[p]);
+    }
+    printf("\n");
+
     // sort input array
     for (size_t i = 0; i < fields; ++i) {
         qsort(values[i], count[i], sizeof(uint32_t), compare_uint32);
@@ -113,6 +127,16 @@ int main(int argc, char* argv[]) {
     }
     printf("\n");
 
+    printf("   roaring_bitmap_contains_many with sorted input:");
+    for (int p = 0; p < num_passes; p++) {
+        uint64_t mask[(count[p] + 63) / 64];
+        RDTSC_START(cycles_start);
+        contains_multi_many(bm, values[p], mask, count[p]);
+        RDTSC_FINAL(cycles_final);
+        printf(" %10f", (cycles_final - cycles_start) * 1.0 / count[p]);
+    }
+    printf("\n");
+
     roaring_bitmap_free(bm);
     for (size_t i = 0; i < fields; ++i) {
         free(values[i]);
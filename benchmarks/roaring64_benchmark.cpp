@@ -0,0 +1,158 @@
+/**
+ * Compares the ART-based roaring64_bitmap_t with Roaring64Map on memory use
+ * and lookup speed, for sparse values spread over the 64-bit space and for
+ * values clustered in a few 32-bit buckets.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <roaring/roaring64.h>
+#include "roaring64map.hh"
+#include "benchmark.h"
+
+using roaring::Roaring64Map;
+
+namespace {
+
+// Every allocation, whether through operator new (std::map nodes) or through
+// the roaring memory hooks (containers, ART nodes), is counted here. Each
+// block starts with a header recording its size and, for aligned blocks, the
+// start of the underlying malloc() block.
+size_t allocated_bytes = 0;
+
+struct alloc_header {
+    size_t size;
+    void *base;
+};
+
+const size_t header_size = 2 * sizeof(alloc_header);  // keeps 16B alignment
+
+void *tracked_aligned_malloc(size_t alignment, size_t size) {
+    if (alignment < header_size) alignment = header_size;
+    char *base = (char *)malloc(size + alignment + header_size);
+    if (base == NULL) return NULL;
+    uintptr_t start = (uintptr_t)(base + header_size);
+    start = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    alloc_header *header = (alloc_header *)start - 1;
+    header->size = size;
+    header->base = base;
+    allocated_bytes += size;
+    return (void *)start;
+}
+
+void *tracked_malloc(size_t size) {
+    return tracked_aligned_malloc(header_size, size);
+}
+
+void tracked_free(void *p) {
+    if (p == NULL) return;
+    alloc_header *header = (alloc_header *)p - 1;
+    allocated_bytes -= header->size;
+    free(header->base);
+}
+
+void *tracked_realloc(void *p, size_t size) {
+    void *result = tracked_malloc(size);
+    if (p != NULL && result != NULL) {
+        size_t old_size = ((alloc_header *)p - 1)->size;
+        memcpy(result, p, old_size < size ? old_size : size);
+        tracked_free(p);
+    }
+    return result;
+}
+
+void *tracked_calloc(size_t n, size_t size) {
+    void *result = tracked_malloc(n * size);
+    if (result != NULL) memset(result, 0, n * size);
+    return result;
+}
+
+const size_t num_values = 1000000;
+const size_t num_lookups = 1000000;
+
+std::vector<uint64_t> sparse_values() {
+    std::mt19937_64 gen(1234);
+    std::vector<uint64_t> values(num_values);
+    for (auto &v : values) v = gen();
+    return values;
+}
+
+// 16 buckets of 2^32 values, each with 1M/16 random values spread over 2^24.
+std::vector<uint64_t> clustered_values() {
+    std::mt19937_64 gen(1234);
+    std::vector<uint64_t> values(num_values);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = ((uint64_t)(i % 16) << 32) | (gen() & 0xFFFFFF);
+    }
+    return values;
+}
+
+void benchmark(const char *name, const std::vector<uint64_t> &values) {
+    std::cout << "*** " << name << " (" << values.size() << " values) ***\n";
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> lookups(num_lookups);
+    for (size_t i = 0; i < lookups.size(); i++) {
+        // Half hits, half (likely) misses.
+        lookups[i] = (i % 2 == 0) ? values[gen() % values.size()]
+                                  : values[gen() % values.size()] ^ 1;
+    }
+    uint64_t cycles_start, cycles_final;
+
+    size_t before = allocated_bytes;
+    Roaring64Map *map = new Roaring64Map();
+    for (uint64_t v : values) map->add(v);
+    map->runOptimize();
+    size_t map_bytes = allocated_bytes - before;
+
+    size_t hits = 0;
+    RDTSC_START(cycles_start);
+    for (uint64_t v : lookups) hits += map->contains(v);
+    RDTSC_FINAL(cycles_final);
+    std::cout << "Roaring64Map:       " << map_bytes << " bytes, "
+              << (double)(cycles_final - cycles_start) / lookups.size()
+              << " cycles per contains (" << hits << " hits)\n";
+    delete map;
+
+    before = allocated_bytes;
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    for (uint64_t v : values) roaring64_bitmap_add(r, v);
+    roaring64_bitmap_run_optimize(r);
+    size_t r_bytes = allocated_bytes - before;
+
+    hits = 0;
+    RDTSC_START(cycles_start);
+    for (uint64_t v : lookups) hits += roaring64_bitmap_contains(r, v);
+    RDTSC_FINAL(cycles_final);
+    std::cout << "roaring64_bitmap_t: " << r_bytes << " bytes, "
+              << (double)(cycles_final - cycles_start) / lookups.size()
+              << " cycles per contains (" << hits << " hits)\n";
+    roaring64_bitmap_free(r);
+}
+
+}  // namespace
+
+void *operator new(size_t size) {
+    void *p = tracked_malloc(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { tracked_free(p); }
+void operator delete(void *p, size_t) noexcept { tracked_free(p); }
+
+int main() {
+    roaring_memory_t hooks = {tracked_malloc,         tracked_realloc,
+                              tracked_calloc,         tracked_free,
+                              tracked_aligned_malloc, tracked_free};
+    roaring_init_memory_hook(hooks);
+    benchmark("sparse", sparse_values());
+    benchmark("clustered", clustered_values());
+    return 0;
+}
@@ -8,9 +8,13 @@ A C++ header for Roaring Bitmaps.
 
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <new>
+#include <ostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #if !defined(ROARING_EXCEPTIONS)
 // __cpp_exceptions is required by C++98 and we require C++11 or better.
@@ -38,10 +42,60 @@ A C++ header for Roaring Bitmaps.
 
 #include <roaring/roaring_array.h>  // roaring::internal array functions used
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 namespace roaring {
 
+namespace internal {
+/**
+ * Index of the lowest set bit of a non-zero word. The amalgamated header
+ * does not ship the __builtin_ctzll shim from portability.h, so forEach
+ * uses this instead.
+ */
+inline int trailing_zeroes(uint64_t word) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+#ifdef _WIN64
+    _BitScanForward64(&index, word);
+#else
+    if ((uint32_t)word != 0) {
+        _BitScanForward(&index, (uint32_t)word);
+    } else {
+        _BitScanForward(&index, (uint32_t)(word >> 32));
+        index += 32;
+    }
+#endif
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+}  // namespace internal
+
 class RoaringSetBitForwardIterator;
 
+/**
+ * Activates an arena (see roaring_arena_activate) on the current thread for
+ * the lifetime of this object, then restores the arena that was active
+ * before. Roaring objects created within the scope must not be modified
+ * after it ends, and must be destroyed before the arena is reset.
+ */
+class RoaringArenaScope {
+public:
+    explicit RoaringArenaScope(roaring_arena_t *arena)
+        : previous(roaring_arena_activate(arena)) {}
+
+    ~RoaringArenaScope() { roaring_arena_activate(previous); }
+
+    RoaringArenaScope(const RoaringArenaScope &) = delete;
+    RoaringArenaScope &operator=(const RoaringArenaScope &) = delete;
+
+private:
+    roaring_arena_t *previous;
+};
+
 class Roaring {
     typedef api::roaring_bitmap_t roaring_bitmap_t;  // class-local name alias
 
@@ -123,6 +177,18 @@ public:
         return ans;
     }
 
+    /**
+     * Construct a bitmap from n values sorted in increasing order, see
+     * `roaring_bitmap_from_sorted()`.
+     */
+    static Roaring fromSorted(const uint32_t *vals, size_t n) {
+        roaring_bitmap_t *r = api::roaring_bitmap_from_sorted(vals, n);
+        if (r == NULL) {
+            ROARING_TERMINATE("failed memory alloc in fromSorted");
+        }
+        return Roaring(r);
+    }
+
     /**
      * Add value x
      */
@@ -251,10 +317,14 @@ public:
      */
     Roaring &operator=(Roaring &&r) noexcept {
         api::roaring_bitmap_clear(&roaring);  // free this class's allocations
+        const uint32_t version = std::max(roaring.high_low_container.version,
+                                          r.roaring.high_low_container.version);
 
         // !!! See notes in the Move Constructor regarding roaring_bitmap_move()
         //
         roaring = r.roaring;
+        // rank indexes of the old content must not match the new one
+        roaring.high_low_container.version = version + 1;
         api::roaring_bitmap_init_cleared(&r.roaring);
 
         return *this;
@@ -305,7 +375,14 @@ public:
     /**
      * Exchange the content of this bitmap with another.
      */
-    void swap(Roaring &r) { std::swap(r.roaring, roaring); }
+    void swap(Roaring &r) {
+        const uint32_t version = std::max(roaring.high_low_container.version,
+                                          r.roaring.high_low_container.version);
+        std::swap(r.roaring, roaring);
+        // rank indexes of either bitmap must notice the exchange
+        roaring.high_low_container.version = version + 1;
+        r.roaring.high_low_container.version = version + 1;
+    }
 
     /**
      * Get the cardinality of the bitmap (number of elements).
@@ -407,6 +484,92 @@ public:
         api::roaring_iterate(&roaring, iterator, ptr);
     }
 
+    /**
+     * Calls the visitor once per container with a view of its raw contents,
+     * see roaring_visit_containers.
+     */
+    bool visitContainers(api::roaring_container_visitor visitor,
+                         void *ptr) const {
+        return api::roaring_visit_containers(&roaring, visitor, ptr);
+    }
+
+    /**
+     * Iterate over the maximal intervals [start, end) of consecutive values,
+     * see roaring_iterate_ranges.
+     */
+    bool iterateRanges(api::roaring_range_iterator iterator, void *ptr) const {
+        return api::roaring_iterate_ranges(&roaring, iterator, ptr);
+    }
+
+    /**
+     * Calls f(value) for every value, in increasing order. Unlike iterate,
+     * the dispatch on the container type happens once per container, and f
+     * is inlined into the loop over each container (bitsets are scanned a
+     * word at a time), so this is the fastest way to visit all the values.
+     */
+    template <class F>
+    void forEach(F &&f) const {
+        typedef typename std::remove_reference<F>::type function_t;
+        api::roaring_visit_containers(
+            &roaring,
+            [](const api::roaring_container_span_t *span, void *ptr) -> bool {
+                function_t &fn = *static_cast<function_t *>(ptr);
+                const uint32_t high = uint32_t(span->key) << 16;
+                switch (span->type) {
+                    case api::ROARING_SPAN_BITSET:
+                        for (uint32_t i = 0; i < span->length; i++) {
+                            uint64_t word = span->words[i];
+                            while (word != 0) {
+                                fn(high | (i * 64 +
+                                           internal::trailing_zeroes(word)));
+                                word &= word - 1;
+                            }
+                        }
+                        break;
+                    case api::ROARING_SPAN_ARRAY:
+                        for (uint32_t i = 0; i < span->length; i++) {
+                            fn(high | span->array[i]);
+                        }
+                        break;
+                    default:
+                        for (uint32_t i = 0; i < span->length; i++) {
+                            uint32_t value = high | span->runs[i].value;
+                            const uint32_t last = value + span->runs[i].length;
+                            for (;; value++) {
+                                fn(value);
+                                if (value == last) break;
+                            }
+                        }
+                        break;
+                }
+                return true;
+            },
+            const_cast<void *>(static_cast<const void *>(std::addressof(f))));
+    }
+
+    /**
+     * Like forEach, but calls f(const uint32_t *values, size_t count) with
+     * the values in increasing order, up to 256 at a time.
+     */
+    template <class F>
+    void forEachBatch(F &&f) const {
+        struct batch_t {
+            size_t count;
+            uint32_t values[256];
+        } batch;
+        batch.count = 0;
+        forEach([&f, &batch](uint32_t value) {
+            batch.values[batch.count++] = value;
+            if (batch.count == 256) {
+                f(static_cast<const uint32_t *>(batch.values), batch.count);
+                batch.count = 0;
+            }
+        });
+        if (batch.count > 0) {
+            f(static_cast<const uint32_t *>(batch.values), batch.count);
+        }
+    }
+
     /**
      * Selects the value at index rnk in the bitmap, where the smallest value
      * is at index 0.
@@ -524,6 +687,26 @@ public:
             return api::roaring_bitmap_serialize(&roaring, buf);
     }
 
+    /**
+     * Write the portable serialization of the bitmap (the same bytes as
+     * write(buf, true)) to a stream, a bounded batch of chunks at a time,
+     * without building it in memory first. Returns how many bytes were
+     * written, or 0 if the stream went bad.
+     */
+    size_t write(std::ostream &out) const {
+        auto writer = [](void *context, const api::roaring_iovec_t *iov,
+                         size_t iovcnt) -> bool {
+            std::ostream &o = *static_cast<std::ostream *>(context);
+            for (size_t i = 0; i < iovcnt; i++) {
+                o.write(static_cast<const char *>(iov[i].base),
+                        static_cast<std::streamsize>(iov[i].len));
+            }
+            return static_cast<bool>(o);
+        };
+        return api::roaring_bitmap_portable_serialize_stream(&roaring, writer,
+                                                             &out);
+    }
+
     /**
      * Read a bitmap from a serialized version. This is meant to be compatible
      * with the Java and Go versions.
@@ -559,6 +742,22 @@ public:
         return Roaring(r);
     }
 
+    /**
+     * Parallel version of readSafe: the containers are split into at most
+     * "partitions" ranges read by separate tasks, run by "executor" (see
+     * roaring_bitmap_portable_deserialize_parallel).
+     */
+    static Roaring readSafe(const char *buf, size_t maxbytes,
+                            size_t partitions, api::roaring_executor executor,
+                            void *executor_context) {
+        roaring_bitmap_t *r = api::roaring_bitmap_portable_deserialize_parallel(
+            buf, maxbytes, partitions, executor, executor_context);
+        if (r == NULL) {
+            ROARING_TERMINATE("failed alloc while reading");
+        }
+        return Roaring(r);
+    }
+
     /**
      * How many bytes are required to serialize this bitmap (meant to be
      * compatible with Java and Go versions)
@@ -585,6 +784,23 @@ public:
         return r;
     }
 
+    /**
+     * Read-only view of a bitmap in the portable format, see
+     * `roaring_bitmap_portable_deserialize_frozen()`. The buffer must outlive
+     * the returned bitmap.
+     */
+    static const Roaring portableDeserializeFrozen(const char *buf,
+                                                   size_t maxbytes) {
+        const roaring_bitmap_t *s =
+            api::roaring_bitmap_portable_deserialize_frozen(buf, maxbytes);
+        if (s == NULL) {
+            ROARING_TERMINATE("failed to read portable frozen bitmap");
+        }
+        Roaring r;
+        r.roaring = *s;
+        return r;
+    }
+
     void writeFrozen(char *buf) const {
         roaring_bitmap_frozen_serialize(&roaring, buf);
     }
@@ -685,6 +901,19 @@ public:
         return api::roaring_bitmap_get_copy_on_write(&roaring);
     }
 
+    /**
+     * Whether the intersections, unions and symmetric differences computed
+     * from this bitmap give their containers the most compact type, see
+     * roaring_bitmap_set_adaptive_containers.
+     */
+    void setAdaptiveContainers(bool val) {
+        api::roaring_bitmap_set_adaptive_containers(&roaring, val);
+    }
+
+    bool getAdaptiveContainers() const {
+        return api::roaring_bitmap_get_adaptive_containers(&roaring);
+    }
+
     /**
      * Computes the logical or (union) between "n" bitmaps (referenced by a
      * pointer).
@@ -707,6 +936,102 @@ public:
         return ans;
     }
 
+    /**
+     * Computes the logical and (intersection) between "n" bitmaps (referenced
+     * by a pointer). This avoids materializing the intermediate results of
+     * pairwise intersections.
+     */
+    static Roaring fastintersect(size_t n, const Roaring **inputs) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)roaring_malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL) {
+            ROARING_TERMINATE("failed memory alloc in fastintersect");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+
+        roaring_bitmap_t *c_ans = api::roaring_bitmap_and_many(n, x);
+        if (c_ans == NULL) {
+            roaring_free(x);
+            ROARING_TERMINATE("failed memory alloc in fastintersect");
+        }
+        Roaring ans(c_ans);
+        roaring_free(x);
+        return ans;
+    }
+
+    /**
+     * Computes the values present in at least "t" of "n" bitmaps (referenced
+     * by a pointer), see roaring_bitmap_threshold_many.
+     */
+    static Roaring fastthreshold(size_t n, const Roaring **inputs, uint32_t t) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)roaring_malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL) {
+            ROARING_TERMINATE("failed memory alloc in fastthreshold");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+
+        roaring_bitmap_t *c_ans = api::roaring_bitmap_threshold_many(n, x, t);
+        if (c_ans == NULL) {
+            roaring_free(x);
+            ROARING_TERMINATE("failed memory alloc in fastthreshold");
+        }
+        Roaring ans(c_ans);
+        roaring_free(x);
+        return ans;
+    }
+
+    /**
+     * Parallel version of fastunion: the key space is split into at most
+     * "partitions" ranges that are unioned by separate tasks, run by
+     * "executor" (see roaring_bitmap_or_many_parallel).
+     */
+    static Roaring fastunion(size_t n, const Roaring **inputs,
+                             size_t partitions, api::roaring_executor executor,
+                             void *executor_context) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)roaring_malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL) {
+            ROARING_TERMINATE("failed memory alloc in fastunion");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+
+        roaring_bitmap_t *c_ans = api::roaring_bitmap_or_many_parallel(
+            n, x, partitions, executor, executor_context);
+        if (c_ans == NULL) {
+            roaring_free(x);
+            ROARING_TERMINATE("failed memory alloc in fastunion");
+        }
+        Roaring ans(c_ans);
+        roaring_free(x);
+        return ans;
+    }
+
+    /**
+     * Parallel version of fastintersect, see the parallel fastunion.
+     */
+    static Roaring fastintersect(size_t n, const Roaring **inputs,
+                                 size_t partitions,
+                                 api::roaring_executor executor,
+                                 void *executor_context) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)roaring_malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL) {
+            ROARING_TERMINATE("failed memory alloc in fastintersect");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+
+        roaring_bitmap_t *c_ans = api::roaring_bitmap_and_many_parallel(
+            n, x, partitions, executor, executor_context);
+        if (c_ans == NULL) {
+            roaring_free(x);
+            ROARING_TERMINATE("failed memory alloc in fastintersect");
+        }
+        Roaring ans(c_ans);
+        roaring_free(x);
+        return ans;
+    }
+
     typedef RoaringSetBitForwardIterator const_iterator;
 
     /**
@@ -729,6 +1054,381 @@ public:
     roaring_bitmap_t roaring;
 };
 
+/**
+ * Rank index of a bitmap (see roaring_bitmap_rank_index_create()), making
+ * select, rank and pagination logarithmic in the number of containers. The
+ * index is a snapshot: after any modification of the bitmap, isValid()
+ * returns false and the queries fail (select() and rangeUint32Array() return
+ * false, rank() returns 0) until rebuild() is called. The bitmap must outlive
+ * the index.
+ */
+class RoaringRankIndex {
+public:
+    explicit RoaringRankIndex(const Roaring &r) : bitmap(&r) { rebuild(); }
+
+    RoaringRankIndex(RoaringRankIndex &&other) noexcept
+        : bitmap(other.bitmap), index(other.index) {
+        other.index = nullptr;
+    }
+
+    RoaringRankIndex(const RoaringRankIndex &) = delete;
+    RoaringRankIndex &operator=(const RoaringRankIndex &) = delete;
+
+    ~RoaringRankIndex() { api::roaring_rank_index_free(index); }
+
+    /**
+     * Recomputes the index after the bitmap was modified.
+     */
+    void rebuild() {
+        api::roaring_rank_index_free(index);
+        index = api::roaring_bitmap_rank_index_create(&bitmap->roaring);
+        if (index == nullptr) {
+            ROARING_TERMINATE("failed memory alloc in RoaringRankIndex");
+        }
+    }
+
+    /**
+     * Returns false if the bitmap was modified since the index was built.
+     */
+    bool isValid() const {
+        return api::roaring_rank_index_is_valid(&bitmap->roaring, index);
+    }
+
+    /**
+     * Same as Roaring::select().
+     */
+    bool select(uint32_t rnk, uint32_t *element) const {
+        return api::roaring_bitmap_select_indexed(&bitmap->roaring, index, rnk,
+                                                  element);
+    }
+
+    /**
+     * Same as Roaring::rank().
+     */
+    uint64_t rank(uint32_t x) const {
+        return api::roaring_bitmap_rank_indexed(&bitmap->roaring, index, x);
+    }
+
+    /**
+     * Same as Roaring::rangeUint32Array(). Returns false if the index is no
+     * longer valid.
+     */
+    bool rangeUint32Array(uint32_t *ans, size_t offset, size_t limit) const {
+        return api::roaring_bitmap_range_uint32_array_indexed(
+            &bitmap->roaring, index, offset, limit, ans);
+    }
+
+private:
+    const Roaring *bitmap;
+    api::roaring_rank_index_t *index = nullptr;
+};
+
+/**
+ * Leaf of a fused expression, see expr().
+ */
+class RoaringExprLeaf {
+public:
+    explicit RoaringExprLeaf(const Roaring &r) : bitmap(&r) {}
+
+    static constexpr size_t num_nodes = 1;
+
+    const api::roaring_expr_t *build(api::roaring_expr_t *&next) const {
+        api::roaring_expr_t *node = next++;
+        *node = api::roaring_expr_bitmap(&bitmap->roaring);
+        return node;
+    }
+
+private:
+    const Roaring *bitmap;
+};
+
+/**
+ * Operator node of a fused expression, see expr(). Converting it to Roaring
+ * evaluates the whole expression with roaring_expr_evaluate().
+ */
+template <api::roaring_expr_op_t Op, typename Left, typename Right>
+class RoaringExpr {
+public:
+    RoaringExpr(const Left &l, const Right &r) : left(l), right(r) {}
+
+    static constexpr size_t num_nodes = Left::num_nodes + Right::num_nodes + 1;
+
+    const api::roaring_expr_t *build(api::roaring_expr_t *&next) const {
+        api::roaring_expr_t *node = next++;
+        const api::roaring_expr_t *l = left.build(next);
+        const api::roaring_expr_t *r = right.build(next);
+        *node = api::roaring_expr_op(Op, l, r);
+        return node;
+    }
+
+    Roaring evaluate() const {
+        api::roaring_expr_t nodes[num_nodes];
+        api::roaring_expr_t *next = nodes;
+        api::roaring_bitmap_t *r = api::roaring_expr_evaluate(build(next));
+        if (r == NULL) {
+            ROARING_TERMINATE("failed materalization in expression");
+        }
+        return Roaring(r);
+    }
+
+    operator Roaring() const { return evaluate(); }
+
+private:
+    Left left;
+    Right right;
+};
+
+/**
+ * Maps the operands of the expression operators to expression nodes; only
+ * defined for Roaring and expressions.
+ */
+template <typename T>
+struct RoaringExprOperand;
+
+template <>
+struct RoaringExprOperand<Roaring> {
+    typedef RoaringExprLeaf type;
+    static constexpr bool is_expr = false;
+    static type wrap(const Roaring &r) { return type(r); }
+};
+
+template <>
+struct RoaringExprOperand<RoaringExprLeaf> {
+    typedef RoaringExprLeaf type;
+    static constexpr bool is_expr = true;
+    static const type &wrap(const type &e) { return e; }
+};
+
+template <api::roaring_expr_op_t Op, typename Left, typename Right>
+struct RoaringExprOperand<RoaringExpr<Op, Left, Right> > {
+    typedef RoaringExpr<Op, Left, Right> type;
+    static constexpr bool is_expr = true;
+    static const type &wrap(const type &e) { return e; }
+};
+
+template <api::roaring_expr_op_t Op, typename L, typename R>
+using RoaringExprOf = typename std::enable_if<
+    RoaringExprOperand<L>::is_expr || RoaringExprOperand<R>::is_expr,
+    RoaringExpr<Op, typename RoaringExprOperand<L>::type,
+                typename RoaringExprOperand<R>::type> >::type;
+
+/**
+ * Starts a fused expression: once a bitmap is wrapped with expr(), the
+ * operators &, |, ^ and - build an expression tree instead of computing a
+ * bitmap per operator, and the whole tree is evaluated key by key when it is
+ * converted to Roaring:
+ *
+ *     Roaring r = (expr(a) & b) | (expr(c) - d);
+ *
+ * Expressions refer to their bitmaps, which must outlive them.
+ */
+inline RoaringExprLeaf expr(const Roaring &r) { return RoaringExprLeaf(r); }
+
+template <typename L, typename R>
+inline RoaringExprOf<api::ROARING_EXPR_AND, L, R> operator&(const L &l,
+                                                          const R &r) {
+    return RoaringExprOf<api::ROARING_EXPR_AND, L, R>(
+        RoaringExprOperand<L>::wrap(l), RoaringExprOperand<R>::wrap(r));
+}
+
+template <typename L, typename R>
+inline RoaringExprOf<api::ROARING_EXPR_OR, L, R> operator|(const L &l,
+                                                         const R &r) {
+    return RoaringExprOf<api::ROARING_EXPR_OR, L, R>(
+        RoaringExprOperand<L>::wrap(l), RoaringExprOperand<R>::wrap(r));
+}
+
+template <typename L, typename R>
+inline RoaringExprOf<api::ROARING_EXPR_XOR, L, R> operator^(const L &l,
+                                                          const R &r) {
+    return RoaringExprOf<api::ROARING_EXPR_XOR, L, R>(
+        RoaringExprOperand<L>::wrap(l), RoaringExprOperand<R>::wrap(r));
+}
+
+template <typename L, typename R>
+inline RoaringExprOf<api::ROARING_EXPR_ANDNOT, L, R> operator-(const L &l,
+                                                             const R &r) {
+    return RoaringExprOf<api::ROARING_EXPR_ANDNOT, L, R>(
+        RoaringExprOperand<L>::wrap(l), RoaringExprOperand<R>::wrap(r));
+}
+
+class RoaringLazyIterator;
+
+/**
+ * Lazy union or intersection of bitmaps, whose values are computed as they
+ * are read, in increasing order (see roaring_lazy_iterator_t). It is a
+ * single-pass range, so reading the first values is cheap:
+ *
+ *     for (uint32_t v : RoaringLazy::unionOf(n, inputs)) {
+ *         if (++count == 1000) break;
+ *     }
+ *
+ * Lazy ranges compose: unionOf and intersectionOf also take other ranges.
+ */
+class RoaringLazy {
+public:
+    /**
+     * The values of a bitmap, which must outlive the range.
+     */
+    explicit RoaringLazy(const Roaring &r)
+        : RoaringLazy(api::roaring_lazy_iterator_create(&r.roaring)) {}
+
+    RoaringLazy(RoaringLazy &&other) noexcept : it(other.it) {
+        other.it = nullptr;
+    }
+
+    RoaringLazy &operator=(RoaringLazy &&other) noexcept {
+        std::swap(it, other.it);
+        return *this;
+    }
+
+    RoaringLazy(const RoaringLazy &) = delete;
+    RoaringLazy &operator=(const RoaringLazy &) = delete;
+
+    ~RoaringLazy() { api::roaring_lazy_iterator_free(it); }
+
+    /**
+     * The union of n bitmaps.
+     */
+    static RoaringLazy unionOf(size_t n, const Roaring **inputs) {
+        return many(n, inputs, api::roaring_lazy_iterator_or_many);
+    }
+
+    /**
+     * The intersection of n bitmaps.
+     */
+    static RoaringLazy intersectionOf(size_t n, const Roaring **inputs) {
+        return many(n, inputs, api::roaring_lazy_iterator_and_many);
+    }
+
+    /**
+     * The union of n lazy ranges, which are moved from.
+     */
+    static RoaringLazy unionOf(size_t n, RoaringLazy *inputs) {
+        return combine(n, inputs, api::roaring_lazy_iterator_or);
+    }
+
+    /**
+     * The intersection of n lazy ranges, which are moved from. The first one
+     * leads the leapfrog and should be the sparsest.
+     */
+    static RoaringLazy intersectionOf(size_t n, RoaringLazy *inputs) {
+        return combine(n, inputs, api::roaring_lazy_iterator_and);
+    }
+
+    bool hasValue() const { return api::roaring_lazy_iterator_has_value(it); }
+
+    uint32_t value() const { return api::roaring_lazy_iterator_value(it); }
+
+    /**
+     * Moves to the next value, returns false if there is none.
+     */
+    bool advance() { return api::roaring_lazy_iterator_advance(it); }
+
+    /**
+     * Moves to the first value >= val, returns false if there is none.
+     */
+    bool moveEqualOrLarger(uint32_t val) {
+        return api::roaring_lazy_iterator_move_equalorlarger(it, val);
+    }
+
+    /**
+     * Reads up to count values into buf, see roaring_lazy_iterator_read.
+     */
+    uint32_t read(uint32_t *buf, uint32_t count) {
+        return api::roaring_lazy_iterator_read(it, buf, count);
+    }
+
+    RoaringLazyIterator begin();
+    RoaringLazyIterator end();
+
+private:
+    explicit RoaringLazy(api::roaring_lazy_iterator_t *i) : it(i) {
+        if (it == nullptr) {
+            ROARING_TERMINATE("failed memory alloc in RoaringLazy");
+        }
+    }
+
+    typedef api::roaring_lazy_iterator_t *(*many_fn)(
+        size_t, const api::roaring_bitmap_t **);
+    typedef api::roaring_lazy_iterator_t *(*combine_fn)(
+        size_t, api::roaring_lazy_iterator_t **);
+
+    static RoaringLazy many(size_t n, const Roaring **inputs, many_fn fn) {
+        const api::roaring_bitmap_t **x =
+            (const api::roaring_bitmap_t **)roaring_malloc(
+                (n + 1) * sizeof(api::roaring_bitmap_t *));
+        if (x == nullptr) {
+            ROARING_TERMINATE("failed memory alloc in RoaringLazy");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+        api::roaring_lazy_iterator_t *i = fn(n, x);
+        roaring_free(x);
+        return RoaringLazy(i);
+    }
+
+    static RoaringLazy combine(size_t n, RoaringLazy *inputs, combine_fn fn) {
+        api::roaring_lazy_iterator_t **x =
+            (api::roaring_lazy_iterator_t **)roaring_malloc(
+                (n + 1) * sizeof(api::roaring_lazy_iterator_t *));
+        if (x == nullptr) {
+            ROARING_TERMINATE("failed memory alloc in RoaringLazy");
+        }
+        for (size_t k = 0; k < n; ++k) {
+            x[k] = inputs[k].it;  // ownership moves to the combination
+            inputs[k].it = nullptr;
+        }
+        api::roaring_lazy_iterator_t *i = fn(n, x);
+        roaring_free(x);
+        return RoaringLazy(i);
+    }
+
+    api::roaring_lazy_iterator_t *it;
+};
+
+/**
+ * Single-pass iterator over a RoaringLazy range.
+ */
+class RoaringLazyIterator final {
+public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef uint32_t value_type;
+    typedef int32_t difference_type;
+    typedef const uint32_t *pointer;
+    typedef uint32_t reference;
+
+    explicit RoaringLazyIterator(RoaringLazy *l = nullptr) : lazy(l) {}
+
+    uint32_t operator*() const { return lazy->value(); }
+
+    RoaringLazyIterator &operator++() {
+        lazy->advance();
+        return *this;
+    }
+
+    void operator++(int) { lazy->advance(); }
+
+    bool operator==(const RoaringLazyIterator &o) const {
+        if (atEnd() || o.atEnd()) return atEnd() == o.atEnd();
+        return lazy == o.lazy;
+    }
+
+    bool operator!=(const RoaringLazyIterator &o) const {
+        return !(*this == o);
+    }
+
+private:
+    bool atEnd() const { return lazy == nullptr || !lazy->hasValue(); }
+
+    RoaringLazy *lazy;
+};
+
+inline RoaringLazyIterator RoaringLazy::begin() {
+    return RoaringLazyIterator(this);
+}
+
+inline RoaringLazyIterator RoaringLazy::end() { return RoaringLazyIterator(); }
+
 /**
  * Used to go through the set bits. Not optimally fast, but convenient.
  */
@@ -2,6 +2,10 @@
  * A C++ header for 64-bit Roaring Bitmaps, 
  * implemented by way of a map of many
  * 32-bit Roaring Bitmaps.
+ *
+ * Roaring64Map keeps the 32-bit bitmaps in a std::map. Roaring64FlatMap has
+ * the same interface but keeps them in a sorted vector (SortedVectorMap),
+ * which is more compact and faster to search when there are many high keys.
  * 
  * Reference (format specification) :
  * https://github.com/RoaringBitmap/RoaringFormatSpec#extention-for-64-bit-implementations
@@ -20,10 +24,12 @@
 #include <map>
 #include <new>
 #include <numeric>
+#include <ostream>
 #include <queue>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "roaring.hh"
 
@@ -31,66 +37,270 @@ namespace roaring {
 
 using roaring::Roaring;
 
-class Roaring64MapSetBitForwardIterator;
-class Roaring64MapSetBitBiDirectionalIterator;
+/**
+ * A std::map-like container of (uint32_t, Roaring) pairs stored in a sorted
+ * vector. The keys are duplicated in their own array, so that lookups do a
+ * binary search over a compact array instead of chasing tree nodes, and there
+ * is no allocation per key. In exchange, inserting or erasing a key in the
+ * middle is linear in the number of keys: this suits bitmaps that are mostly
+ * built in increasing order.
+ *
+ * Only the part of the std::map interface used by BasicRoaring64Map is
+ * provided. Any insertion or erasure invalidates all iterators.
+ */
+class SortedVectorMap {
+public:
+    typedef uint32_t key_type;
+    typedef Roaring mapped_type;
+    typedef std::pair<uint32_t, Roaring> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef std::vector<value_type>::reverse_iterator reverse_iterator;
+    typedef std::vector<value_type>::const_reverse_iterator
+        const_reverse_iterator;
+    typedef size_t size_type;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    const_iterator cend() const { return entries.cend(); }
+    reverse_iterator rbegin() { return entries.rbegin(); }
+    reverse_iterator rend() { return entries.rend(); }
+    const_reverse_iterator crbegin() const { return entries.crbegin(); }
+    const_reverse_iterator crend() const { return entries.crend(); }
+
+    bool empty() const { return entries.empty(); }
+    size_type size() const { return entries.size(); }
+
+    void clear() {
+        keys.clear();
+        entries.clear();
+    }
+
+    void swap(SortedVectorMap &other) {
+        keys.swap(other.keys);
+        entries.swap(other.entries);
+    }
+
+    iterator lower_bound(uint32_t key) { return begin() + lowerIndex(key); }
+    const_iterator lower_bound(uint32_t key) const {
+        return begin() + lowerIndex(key);
+    }
+
+    iterator find(uint32_t key) {
+        size_t i = lowerIndex(key);
+        return (i < keys.size() && keys[i] == key) ? begin() + i : end();
+    }
+    const_iterator find(uint32_t key) const {
+        size_t i = lowerIndex(key);
+        return (i < keys.size() && keys[i] == key) ? begin() + i : end();
+    }
+
+    size_type count(uint32_t key) const { return find(key) == end() ? 0 : 1; }
+
+    /**
+     * The single-key insertions below (operator[], insert, emplace and
+     * emplace_hint) are linear in the number of keys after the new one, and
+     * amortized constant when appending past the largest key. To add many
+     * keys that are not all larger than the present ones, collect them and
+     * call the range insert() below once.
+     */
+    Roaring &operator[](uint32_t key) {
+        size_t i = lowerIndex(key);
+        if (i == keys.size() || keys[i] != key) {
+            insertAt(i, value_type(key, Roaring()));
+        }
+        return entries[i].second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type &value) {
+        return insertUnique(value);
+    }
+    std::pair<iterator, bool> insert(value_type &&value) {
+        return insertUnique(std::move(value));
+    }
+    std::pair<iterator, bool> emplace(value_type &&value) {
+        return insertUnique(std::move(value));
+    }
+    std::pair<iterator, bool> emplace(uint32_t key, Roaring &&value) {
+        return insertUnique(value_type(key, std::move(value)));
+    }
+
+    /**
+     * Inserts before 'hint' when that keeps the keys sorted (which makes
+     * appending at end() cheap), otherwise behaves like emplace().
+     */
+    iterator emplace_hint(const_iterator hint, uint32_t key, Roaring &&value) {
+        size_t i = hint - cbegin();
+        if ((i != 0 && keys[i - 1] >= key) ||
+            (i != keys.size() && keys[i] <= key)) {
+            return emplace(key, std::move(value)).first;
+        }
+        return insertAt(i, value_type(key, std::move(value)));
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        return emplace_hint(hint, value.first, std::move(value.second));
+    }
+
+    /**
+     * Inserts a range of entries, skipping the keys that are already present
+     * as std::map::insert does. Runs in linear time (plus sorting the range).
+     */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        auto by_key = [](const value_type &lhs, const value_type &rhs) {
+            return lhs.first < rhs.first;
+        };
+        auto same_key = [](const value_type &lhs, const value_type &rhs) {
+            return lhs.first == rhs.first;
+        };
+        const size_t old_size = entries.size();
+        entries.insert(entries.end(), first, last);
+        // Both sorts are stable: for a duplicated key, the entry that was
+        // already in the map comes first and is the one unique() keeps.
+        if (!std::is_sorted(entries.begin() + old_size, entries.end(),
+                            by_key)) {
+            std::stable_sort(entries.begin() + old_size, entries.end(),
+                             by_key);
+        }
+        std::inplace_merge(entries.begin(), entries.begin() + old_size,
+                           entries.end(), by_key);
+        entries.erase(std::unique(entries.begin(), entries.end(), same_key),
+                      entries.end());
+        rebuildKeys();
+    }
+
+    iterator erase(const_iterator pos) {
+        keys.erase(keys.begin() + (pos - cbegin()));
+        return entries.erase(pos);
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        keys.erase(keys.begin() + (first - cbegin()),
+                   keys.begin() + (last - cbegin()));
+        return entries.erase(first, last);
+    }
+
+    /**
+     * Erases all the entries satisfying 'pred' in a single pass.
+     */
+    template <typename Predicate>
+    void eraseIf(Predicate pred) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), pred),
+                      entries.end());
+        rebuildKeys();
+    }
+
+private:
+    std::vector<uint32_t> keys;
+    std::vector<value_type> entries;
+
+    size_t lowerIndex(uint32_t key) const {
+        return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insertUnique(V &&value) {
+        size_t i = lowerIndex(value.first);
+        if (i < keys.size() && keys[i] == value.first) {
+            return std::make_pair(begin() + i, false);
+        }
+        return std::make_pair(insertAt(i, std::forward<V>(value)), true);
+    }
+
+    template <typename V>
+    iterator insertAt(size_t i, V &&value) {
+        // Growing 'keys' first leaves nothing that can throw once 'entries'
+        // has been updated, so both arrays stay in sync.
+        if (keys.size() == keys.capacity()) {
+            keys.reserve(keys.empty() ? 4 : 2 * keys.size());
+        }
+        auto result = entries.insert(entries.begin() + i,
+                                     std::forward<V>(value));
+        keys.insert(keys.begin() + i, result->first);
+        return result;
+    }
+
+    void rebuildKeys() {
+        keys.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            keys[i] = entries[i].first;
+        }
+    }
+};
+
+template <typename Map>
+class BasicRoaring64MapSetBitForwardIterator;
+template <typename Map>
+class BasicRoaring64MapSetBitBiDirectionalIterator;
+template <typename Map>
+class BasicRoaring64MapRankIndex;
 
-class Roaring64Map {
+/**
+ * A 64-bit Roaring bitmap made of 32-bit Roaring bitmaps indexed by their
+ * high 32 bits. 'Map' is the associative container holding them, either
+ * std::map<uint32_t, Roaring> (see Roaring64Map) or SortedVectorMap (see
+ * Roaring64FlatMap).
+ */
+template <typename Map>
+class BasicRoaring64Map {
     typedef api::roaring_bitmap_t roaring_bitmap_t;
 
 public:
     /**
      * Create an empty bitmap
      */
-    Roaring64Map() = default;
+    BasicRoaring64Map() = default;
 
     /**
      * Construct a bitmap from a list of 32-bit integer values.
      */
-    Roaring64Map(size_t n, const uint32_t *data) { addMany(n, data); }
+    BasicRoaring64Map(size_t n, const uint32_t *data) { addMany(n, data); }
 
     /**
      * Construct a bitmap from a list of 64-bit integer values.
      */
-    Roaring64Map(size_t n, const uint64_t *data) { addMany(n, data); }
+    BasicRoaring64Map(size_t n, const uint64_t *data) { addMany(n, data); }
 
     /**
      * Construct a 64-bit map from a 32-bit one
      */
-    explicit Roaring64Map(const Roaring &r) { emplaceOrInsert(0, r); }
+    explicit BasicRoaring64Map(const Roaring &r) { emplaceOrInsert(0, r); }
 
     /**
      * Construct a 64-bit map from a 32-bit rvalue
      */
-    explicit Roaring64Map(Roaring &&r) { emplaceOrInsert(0, std::move(r)); }
+    explicit BasicRoaring64Map(Roaring &&r) { emplaceOrInsert(0, std::move(r)); }
 
     /**
      * Construct a roaring object from the C struct.
      *
      * Passing a NULL point is unsafe.
      */
-    explicit Roaring64Map(roaring_bitmap_t *s) {
+    explicit BasicRoaring64Map(roaring_bitmap_t *s) {
         emplaceOrInsert(0, Roaring(s));
     }
 
-    Roaring64Map(const Roaring64Map& r) = default;
+    BasicRoaring64Map(const BasicRoaring64Map& r) = default;
 
-    Roaring64Map(Roaring64Map&& r) noexcept = default;
+    BasicRoaring64Map(BasicRoaring64Map&& r) noexcept = default;
 
     /**
      * Copy assignment operator.
      */
-    Roaring64Map &operator=(const Roaring64Map &r) = default;
+    BasicRoaring64Map &operator=(const BasicRoaring64Map &r) = default;
 
     /**
      * Move assignment operator.
      */
-     Roaring64Map &operator=(Roaring64Map &&r) noexcept = default;
+     BasicRoaring64Map &operator=(BasicRoaring64Map &&r) noexcept = default;
 
     /**
      * Construct a bitmap from a list of uint64_t values.
      */
-    static Roaring64Map bitmapOf(size_t n...) {
-        Roaring64Map ans;
+    static BasicRoaring64Map bitmapOf(size_t n...) {
+        BasicRoaring64Map ans;
         va_list vl;
         va_start(vl, n);
         for (size_t i = 0; i < n; i++) {
@@ -104,8 +314,8 @@ public:
      * Construct a bitmap from a list of uint64_t values.
      * E.g., bitmapOfList({1,2,3}).
      */
-    static Roaring64Map bitmapOfList(std::initializer_list<uint64_t> l) {
-        Roaring64Map ans;
+    static BasicRoaring64Map bitmapOfList(std::initializer_list<uint64_t> l) {
+        BasicRoaring64Map ans;
         ans.addMany(l.size(), l.begin());
         return ans;
     }
@@ -234,7 +444,28 @@ public:
      * Adds 'n_args' values from the contiguous memory range starting at 'vals'.
      */
     void addMany(size_t n_args, const uint64_t *vals) {
-        // Potentially reduce outer map lookups by optimistically
+        // Batches that keep hopping between inner bitmaps, judging by their
+        // first addManyPartitionMin values, are first partitioned by their
+        // high 32 bits, so that each inner bitmap is looked up once and gets
+        // all its values in one addMany() call.
+        if (n_args >= addManyPartitionMin) {
+            size_t high_changes = 0;
+            for (size_t lcv = 1; lcv < addManyPartitionMin; lcv++) {
+                high_changes += highBytes(vals[lcv]) != highBytes(vals[lcv - 1]);
+            }
+            if (high_changes * addManyPartitionRun > addManyPartitionMin) {
+                for (size_t done = 0; done < n_args;) {
+                    size_t len = n_args - done;
+                    if (len > addManyPartitionChunk) {
+                        len = addManyPartitionChunk;
+                    }
+                    addManyPartitioned(len, vals + done);
+                    done += len;
+                }
+                return;
+            }
+        }
+        // Otherwise, potentially reduce outer map lookups by optimistically
         // assuming that adjacent values will belong to the same inner bitmap.
         Roaring *last_inner_bitmap = nullptr;
         uint32_t last_value_high = 0;
@@ -371,9 +602,6 @@ public:
         // iterator will not be equal to end()) because start_high <= the last
         // key in the map (thanks to the above if statement).
         auto start_iter = roarings.lower_bound(start_high);
-        // end_iter points to the first entry in the outer map with
-        // key >= end_high, if such a key exists. Otherwise, it equals end().
-        auto end_iter = roarings.lower_bound(end_high);
 
         // Note that the 'lower_bound' method will find the start and end slots,
         // if they exist; otherwise it will find the next-higher slots.
@@ -388,7 +616,8 @@ public:
         //    b. Otherwise, remove the closed interval [start_low, uint32_max]
         //       from that entry, advance start_iter, and fall through to step 2.
         // 2. Completely erase all slots in the half-open interval
-        //    [start_iter, end_iter)
+        //    [start_iter, end_iter), where end_iter points to the first entry
+        //    with key >= end_high (or end()).
         // 3. If the end point falls on an existing entry, remove the closed
         //    interval [0, end_high] from it.
 
@@ -396,7 +625,7 @@ public:
         if (start_iter->first == start_high) {
             auto &start_inner = start_iter->second;
             // 1a. if the end point falls on that same entry...
-            if (start_iter == end_iter) {
+            if (start_high == end_high) {
                 start_inner.removeRangeClosed(start_low, end_low);
                 eraseIfEmpty(start_iter);
                 return;
@@ -404,14 +633,16 @@ public:
 
             // 1b. Otherwise, remove the closed range [start_low, uint32_max]...
             start_inner.removeRangeClosed(start_low, uint32_max);
-            // Advance start_iter, but keep the old value so we can check the
-            // bitmap we just modified for emptiness and erase if it necessary.
-            auto temp = start_iter++;
-            eraseIfEmpty(temp);
+            // Advance start_iter, erasing the bitmap we just modified if it
+            // became empty.
+            start_iter = eraseIfEmpty(start_iter);
         }
 
         // 2. Completely erase all slots in the half-open interval...
-        roarings.erase(start_iter, end_iter);
+        // (end_iter is looked up only now: with SortedVectorMap, the erasure
+        // above invalidates iterators.)
+        auto end_iter =
+            roarings.erase(start_iter, roarings.lower_bound(end_high));
 
         // 3. If the end point falls on an existing entry...
         if (end_iter != roarings.end() && end_iter->first == end_high) {
@@ -464,12 +695,12 @@ public:
      * Check if value x is present
      */
     bool contains(uint32_t x) const {
-        return roarings.count(0) == 0 ? false : roarings.at(0).contains(x);
+        auto iter = roarings.find(0);
+        return iter != roarings.cend() && iter->second.contains(x);
     }
     bool contains(uint64_t x) const {
-        return roarings.count(highBytes(x)) == 0
-            ? false
-            : roarings.at(highBytes(x)).contains(lowBytes(x));
+        auto iter = roarings.find(highBytes(x));
+        return iter != roarings.cend() && iter->second.contains(lowBytes(x));
     }
 
     /**
@@ -477,7 +708,7 @@ public:
      * writing the result in the current bitmap. The provided bitmap is not
      * modified.
      */
-    Roaring64Map &operator&=(const Roaring64Map &other) {
+    BasicRoaring64Map &operator&=(const BasicRoaring64Map &other) {
         if (this == &other) {
             // ANDing *this with itself is a no-op.
             return *this;
@@ -495,37 +726,30 @@ public:
         //                                   erase self if result is empty.
         //
         // Because there is only work to do when a key is present in 'self', the
-        // main for loop iterates over entries in 'self'.
-
-        decltype(roarings.begin()) self_next;
-        for (auto self_iter = roarings.begin(); self_iter != roarings.end();
-             self_iter = self_next) {
-            // Do the 'next' operation now, so we don't have to worry about
-            // invalidation of self_iter down below with the 'erase' operation.
-            self_next = std::next(self_iter);
+        // main for loop iterates over entries in 'self'. Entries to be erased
+        // are emptied, then erased in a single pass at the end (erasing one
+        // at a time would be quadratic with SortedVectorMap).
 
-            auto self_key = self_iter->first;
-            auto &self_bitmap = self_iter->second;
+        for (auto &self_entry : roarings) {
+            auto self_key = self_entry.first;
+            auto &self_bitmap = self_entry.second;
 
             auto other_iter = other.roarings.find(self_key);
             if (other_iter == other.roarings.end()) {
                 // 'other' doesn't have self_key. In the logic table above,
                 // this reflects the case (self.present & other.absent).
                 // So, erase self.
-                roarings.erase(self_iter);
+                self_bitmap = Roaring();
                 continue;
             }
 
             // Both sides have self_key. In the logic table above, this reflects
             // the case (self.present & other.present). So, intersect self with
-            // other.
+            // other (if the intersection is empty, it gets erased below).
             const auto &other_bitmap = other_iter->second;
             self_bitmap &= other_bitmap;
-            if (self_bitmap.isEmpty()) {
-                // ...but if intersection is empty, remove it altogether.
-                roarings.erase(self_iter);
-            }
         }
+        eraseEmptyBitmaps(roarings);
         return *this;
     }
 
@@ -534,7 +758,7 @@ public:
      * bitmap, writing the result in the current bitmap. The provided bitmap
      * is not modified.
      */
-    Roaring64Map &operator-=(const Roaring64Map &other) {
+    BasicRoaring64Map &operator-=(const BasicRoaring64Map &other) {
         if (this == &other) {
             // Subtracting *this from itself results in the empty map.
             roarings.clear();
@@ -558,6 +782,7 @@ public:
 
         auto self_iter = roarings.begin();
         auto other_iter = other.roarings.cbegin();
+        bool emptied = false;
 
         while (self_iter != roarings.end() &&
                other_iter != other.roarings.cend()) {
@@ -583,15 +808,14 @@ public:
             auto &self_bitmap = self_iter->second;
             const auto &other_bitmap = other_iter->second;
             self_bitmap -= other_bitmap;
-
-            if (self_bitmap.isEmpty()) {
-                // ...but if subtraction is empty, remove it altogether.
-                self_iter = roarings.erase(self_iter);
-            } else {
-                ++self_iter;
-            }
+            // ...but if subtraction is empty, remove it altogether (below).
+            emptied = emptied || self_bitmap.isEmpty();
+            ++self_iter;
             ++other_iter;
         }
+        if (emptied) {
+            eraseEmptyBitmaps(roarings);
+        }
         return *this;
     }
 
@@ -602,7 +826,7 @@ public:
      *
      * See also the fastunion function to aggregate many bitmaps more quickly.
      */
-    Roaring64Map &operator|=(const Roaring64Map &other) {
+    BasicRoaring64Map &operator|=(const BasicRoaring64Map &other) {
         if (this == &other) {
             // ORing *this with itself is a no-op.
             return *this;
@@ -619,34 +843,31 @@ public:
         // present  present  not empty       self |= other
         //
         // Because there is only work to do when a key is present in 'other',
-        // the main for loop iterates over entries in 'other'.
+        // the main for loop iterates over entries in 'other'. The bitmaps
+        // missing from self are copied aside and inserted all at once, which
+        // SortedVectorMap does with a single merge.
 
+        std::vector<std::pair<uint32_t, Roaring>> missing;
         for (const auto &other_entry : other.roarings) {
             const auto &other_bitmap = other_entry.second;
 
-            // Try to insert other_bitmap into self at other_key. We take
-            // advantage of the fact that std::map::insert will not overwrite an
-            // existing entry.
-            auto insert_result = roarings.insert(other_entry);
-            auto self_iter = insert_result.first;
-            auto insert_happened = insert_result.second;
-            auto &self_bitmap = self_iter->second;
-
-            if (insert_happened) {
-                // Key was not present in self, so insert was performed above.
+            auto self_iter = roarings.find(other_entry.first);
+            if (self_iter == roarings.end()) {
                 // In the logic table above, this reflects the case
-                // (self.absent | other.present). Because the copy has already
-                // happened, thanks to the 'insert' operation above, we just
-                // need to set the copyOnWrite flag.
-                self_bitmap.setCopyOnWrite(copyOnWrite);
+                // (self.absent | other.present). Copy other and set the
+                // copyOnWrite flag.
+                missing.emplace_back(other_entry.first, other_bitmap);
+                missing.back().second.setCopyOnWrite(copyOnWrite);
                 continue;
             }
 
-            // Both sides have self_key, and the insert was not performed. In
-            // the logic table above, this reflects the case
-            // (self.present & other.present). So OR other into self.
-            self_bitmap |= other_bitmap;
+            // Both sides have self_key. In the logic table above, this
+            // reflects the case (self.present & other.present). So OR other
+            // into self.
+            self_iter->second |= other_bitmap;
         }
+        roarings.insert(std::make_move_iterator(missing.begin()),
+                        std::make_move_iterator(missing.end()));
         return *this;
     }
 
@@ -654,7 +875,7 @@ public:
      * Compute the XOR of the current bitmap and the provided bitmap, writing
      * the result in the current bitmap. The provided bitmap is not modified.
      */
-    Roaring64Map &operator^=(const Roaring64Map &other) {
+    BasicRoaring64Map &operator^=(const BasicRoaring64Map &other) {
         if (this == &other) {
             // XORing *this with itself results in the empty map.
             roarings.clear();
@@ -673,46 +894,44 @@ public:
         //                                   if result is empty.
         //
         // Because there is only work to do when a key is present in 'other',
-        // the main for loop iterates over entries in 'other'.
+        // the main for loop iterates over entries in 'other'. As in |=, the
+        // bitmaps missing from self are inserted all at once at the end.
 
+        std::vector<std::pair<uint32_t, Roaring>> missing;
+        bool emptied = false;
         for (const auto &other_entry : other.roarings) {
             const auto &other_bitmap = other_entry.second;
 
-            // Try to insert other_bitmap into self at other_key. We take
-            // advantage of the fact that std::map::insert will not overwrite an
-            // existing entry.
-            auto insert_result = roarings.insert(other_entry);
-            auto self_iter = insert_result.first;
-            auto insert_happened = insert_result.second;
-            auto &self_bitmap = self_iter->second;
-
-            if (insert_happened) {
-                // Key was not present in self, so insert was performed above.
+            auto self_iter = roarings.find(other_entry.first);
+            if (self_iter == roarings.end()) {
                 // In the logic table above, this reflects the case
-                // (self.absent ^ other.present). Because the copy has already
-                // happened, thanks to the 'insert' operation above, we just
-                // need to set the copyOnWrite flag.
-                self_bitmap.setCopyOnWrite(copyOnWrite);
+                // (self.absent ^ other.present). Copy other and set the
+                // copyOnWrite flag.
+                missing.emplace_back(other_entry.first, other_bitmap);
+                missing.back().second.setCopyOnWrite(copyOnWrite);
                 continue;
             }
 
-            // Both sides have self_key, and the insert was not performed. In
-            // the logic table above, this reflects the case
-            // (self.present ^ other.present). So XOR other into self.
+            // Both sides have self_key. In the logic table above, this
+            // reflects the case (self.present ^ other.present). So XOR other
+            // into self.
+            auto &self_bitmap = self_iter->second;
             self_bitmap ^= other_bitmap;
-
-            if (self_bitmap.isEmpty()) {
-                // ...but if intersection is empty, remove it altogether.
-                roarings.erase(self_iter);
-            }
+            // ...but if the result is empty, remove it altogether (below).
+            emptied = emptied || self_bitmap.isEmpty();
+        }
+        if (emptied) {
+            eraseEmptyBitmaps(roarings);
         }
+        roarings.insert(std::make_move_iterator(missing.begin()),
+                        std::make_move_iterator(missing.end()));
         return *this;
     }
 
     /**
      * Exchange the content of this bitmap with another.
      */
-    void swap(Roaring64Map &r) { roarings.swap(r.roarings); }
+    void swap(BasicRoaring64Map &r) { roarings.swap(r.roarings); }
 
     /**
      * Get the cardinality of the bitmap (number of elements).
@@ -733,7 +952,7 @@ public:
         return std::accumulate(
             roarings.cbegin(), roarings.cend(), (uint64_t)0,
             [](uint64_t previous,
-               const std::pair<const uint32_t, Roaring> &map_entry) {
+               const typename roarings_t::value_type &map_entry) {
                 return previous + map_entry.second.cardinality();
             });
     }
@@ -743,7 +962,7 @@ public:
      */
     bool isEmpty() const {
         return std::all_of(roarings.cbegin(), roarings.cend(),
-                           [](const std::pair<const uint32_t, Roaring> &map_entry) {
+                           [](const typename roarings_t::value_type &map_entry) {
                                return map_entry.second.isEmpty();
                            });
     }
@@ -760,7 +979,7 @@ public:
             ((uint64_t)(std::numeric_limits<uint32_t>::max)()) + 1
             ? std::all_of(
                 roarings.cbegin(), roarings.cend(),
-                [](const std::pair<const uint32_t, Roaring> &roaring_map_entry) {
+                [](const typename roarings_t::value_type &roaring_map_entry) {
                     // roarings within map are saturated if cardinality
                     // is uint32_t max + 1
                     return roaring_map_entry.second.cardinality() ==
@@ -774,7 +993,7 @@ public:
     /**
      * Returns true if the bitmap is subset of the other.
      */
-    bool isSubset(const Roaring64Map &r) const {
+    bool isSubset(const BasicRoaring64Map &r) const {
         for (const auto &map_entry : roarings) {
             if (map_entry.second.isEmpty()) {
                 continue;
@@ -793,7 +1012,7 @@ public:
      * Throws std::length_error in the special case where the bitmap is full
      * (cardinality() == 2^64). Check isFull() before calling to avoid exception.
      */
-    bool isStrictSubset(const Roaring64Map &r) const {
+    bool isStrictSubset(const BasicRoaring64Map &r) const {
         return isSubset(r) && cardinality() != r.cardinality();
     }
 
@@ -807,7 +1026,7 @@ public:
         // Annoyingly, VS 2017 marks std::accumulate() as [[nodiscard]]
         (void)std::accumulate(roarings.cbegin(), roarings.cend(), ans,
                               [](uint64_t *previous,
-                                 const std::pair<const uint32_t, Roaring> &map_entry) {
+                                 const typename roarings_t::value_type &map_entry) {
                                   for (uint32_t low_bits : map_entry.second)
                                       *previous++ =
                                           uniteBytes(map_entry.first, low_bits);
@@ -818,7 +1037,7 @@ public:
     /**
      * Return true if the two bitmaps contain the same elements.
      */
-    bool operator==(const Roaring64Map &r) const {
+    bool operator==(const BasicRoaring64Map &r) const {
         // we cannot use operator == on the map because either side may contain
         // empty Roaring Bitmaps
         auto lhs_iter = roarings.cbegin();
@@ -881,9 +1100,7 @@ public:
         // bitmap we are looking for, if it exists, will be at the first slot of
         // 'roarings'. If it does not exist, we have to create it.
         if (iter == roarings.end() || iter->first != 0) {
-            iter = roarings.emplace_hint(iter, std::piecewise_construct,
-                                         std::forward_as_tuple(0),
-                                         std::forward_as_tuple());
+            iter = roarings.emplace_hint(iter, 0, Roaring());
             auto &bitmap = iter->second;
             bitmap.setCopyOnWrite(copyOnWrite);
         }
@@ -937,16 +1154,14 @@ public:
         {
             auto &bitmap = current_iter->second;
             bitmap.flipClosed(start_low, uint32_max);
-            auto temp = current_iter++;
-            eraseIfEmpty(temp);
+            current_iter = eraseIfEmpty(current_iter);
         }
 
         // 2. Flip intermediate bitmaps completely.
         for (uint32_t i = 0; i != num_intermediate_bitmaps; ++i) {
             auto &bitmap = current_iter->second;
             bitmap.flipClosed(0, uint32_max);
-            auto temp = current_iter++;
-            eraseIfEmpty(temp);
+            current_iter = eraseIfEmpty(current_iter);
         }
 
         // 3. Partially flip the last bitmap.
@@ -962,7 +1177,7 @@ public:
     bool removeRunCompression() {
         return std::accumulate(
             roarings.begin(), roarings.end(), true,
-            [](bool previous, std::pair<const uint32_t, Roaring> &map_entry) {
+            [](bool previous, typename roarings_t::value_type &map_entry) {
                 return map_entry.second.removeRunCompression() && previous;
             });
     }
@@ -976,7 +1191,7 @@ public:
     bool runOptimize() {
         return std::accumulate(
             roarings.begin(), roarings.end(), true,
-            [](bool previous, std::pair<const uint32_t, Roaring> &map_entry) {
+            [](bool previous, typename roarings_t::value_type &map_entry) {
                 return map_entry.second.runOptimize() && previous;
             });
     }
@@ -987,17 +1202,15 @@ public:
      */
     size_t shrinkToFit() {
         size_t savedBytes = 0;
-        auto iter = roarings.begin();
-        while (iter != roarings.cend()) {
-            if (iter->second.isEmpty()) {
+        for (auto &map_entry : roarings) {
+            if (map_entry.second.isEmpty()) {
                 // empty Roarings are 84 bytes
                 savedBytes += 88;
-                roarings.erase(iter++);
             } else {
-                savedBytes += iter->second.shrinkToFit();
-                iter++;
+                savedBytes += map_entry.second.shrinkToFit();
             }
         }
+        eraseEmptyBitmaps(roarings);
         return savedBytes;
     }
 
@@ -1023,6 +1236,42 @@ public:
         }
     }
 
+    /**
+     * Calls f(value) for every value, in increasing order, with f inlined
+     * into the loop over each container, see Roaring::forEach.
+     */
+    template <class F>
+    void forEach(F &&f) const {
+        for (const auto &map_entry : roarings) {
+            const uint64_t high = uint64_t(map_entry.first) << 32;
+            map_entry.second.forEach(
+                [&f, high](uint32_t low) { f(high | low); });
+        }
+    }
+
+    /**
+     * Like forEach, but calls f(const uint64_t *values, size_t count) with
+     * the values in increasing order, up to 256 at a time.
+     */
+    template <class F>
+    void forEachBatch(F &&f) const {
+        struct batch_t {
+            size_t count;
+            uint64_t values[256];
+        } batch;
+        batch.count = 0;
+        forEach([&f, &batch](uint64_t value) {
+            batch.values[batch.count++] = value;
+            if (batch.count == 256) {
+                f(static_cast<const uint64_t *>(batch.values), batch.count);
+                batch.count = 0;
+            }
+        });
+        if (batch.count > 0) {
+            f(static_cast<const uint64_t *>(batch.values), batch.count);
+        }
+    }
+
     /**
      * Selects the value at index 'rank' in the bitmap, where the smallest value
      * is at index 0. If 'rank' < cardinality(), returns true with *element set
@@ -1090,7 +1339,7 @@ public:
         buf += sizeof(uint64_t);
         std::for_each(
             roarings.cbegin(), roarings.cend(),
-            [&buf, portable](const std::pair<const uint32_t, Roaring> &map_entry) {
+            [&buf, portable](const typename roarings_t::value_type &map_entry) {
                 // push map key
                 std::memcpy(buf, &map_entry.first, sizeof(uint32_t));
                 // ^-- Note: `*((uint32_t*)buf) = map_entry.first;` is undefined
@@ -1102,6 +1351,27 @@ public:
         return buf - orig;
     }
 
+    /**
+     * Write the portable serialization of the bitmap (the same bytes as
+     * write(buf, true)) to a stream, one inner bitmap at a time, without
+     * building it in memory first. Returns how many bytes were written, or 0
+     * if the stream went bad.
+     */
+    size_t write(std::ostream &out) const {
+        uint64_t map_size = roarings.size();
+        out.write(reinterpret_cast<const char *>(&map_size), sizeof(uint64_t));
+        size_t written = sizeof(uint64_t);
+        for (const auto &map_entry : roarings) {
+            if (!out) break;
+            out.write(reinterpret_cast<const char *>(&map_entry.first),
+                      sizeof(uint32_t));
+            size_t inner = map_entry.second.write(out);
+            if (inner == 0) return 0;
+            written += sizeof(uint32_t) + inner;
+        }
+        return out ? written : 0;
+    }
+
     /**
      * Read a bitmap from a serialized version. This is meant to be compatible
      * with the Java and Go versions.
@@ -1114,8 +1384,8 @@ public:
      * bytes could be read, possibly causing a buffer overflow. See also
      * readSafe.
      */
-    static Roaring64Map read(const char *buf, bool portable = true) {
-        Roaring64Map result;
+    static BasicRoaring64Map read(const char *buf, bool portable = true) {
+        BasicRoaring64Map result;
         // get map size
         uint64_t map_size;
         std::memcpy(&map_size, buf, sizeof(uint64_t));
@@ -1143,11 +1413,11 @@ public:
      * Setting the portable flag to false enable a custom format that can save
      * space compared to the portable format (e.g., for very sparse bitmaps).
      */
-    static Roaring64Map readSafe(const char *buf, size_t maxbytes) {
+    static BasicRoaring64Map readSafe(const char *buf, size_t maxbytes) {
         if (maxbytes < sizeof(uint64_t)) {
             ROARING_TERMINATE("ran out of bytes");
         }
-        Roaring64Map result;
+        BasicRoaring64Map result;
         uint64_t map_size;
         std::memcpy(&map_size, buf, sizeof(uint64_t));
         buf += sizeof(uint64_t);
@@ -1173,6 +1443,116 @@ public:
         return result;
     }
 
+    /**
+     * Parallel version of readSafe. The inner bitmaps are located first, then
+     * split into at most "partitions" groups of about the same number of
+     * bytes, each read by its own task run by "executor" (see
+     * roaring_bitmap_portable_deserialize_parallel). When there are fewer
+     * inner bitmaps than partitions, the containers of each inner bitmap are
+     * split instead.
+     */
+    static BasicRoaring64Map readSafe(const char *buf, size_t maxbytes,
+                                      size_t partitions,
+                                      api::roaring_executor executor,
+                                      void *executor_context) {
+        if (maxbytes < sizeof(uint64_t)) {
+            ROARING_TERMINATE("ran out of bytes");
+        }
+        uint64_t map_size;
+        std::memcpy(&map_size, buf, sizeof(uint64_t));
+        buf += sizeof(uint64_t);
+        maxbytes -= sizeof(uint64_t);
+
+        struct Inner {
+            uint32_t key;
+            const char *buf;
+            size_t size;
+            api::roaring_bitmap_t *bitmap;
+        };
+        std::vector<Inner> inners;
+        for (uint64_t lcv = 0; lcv < map_size; lcv++) {
+            if (maxbytes < sizeof(uint32_t)) {
+                ROARING_TERMINATE("ran out of bytes");
+            }
+            Inner inner;
+            std::memcpy(&inner.key, buf, sizeof(uint32_t));
+            buf += sizeof(uint32_t);
+            maxbytes -= sizeof(uint32_t);
+            inner.size =
+                api::roaring_bitmap_portable_deserialize_size(buf, maxbytes);
+            if (inner.size == 0) {
+                ROARING_TERMINATE("ran out of bytes");
+            }
+            inner.buf = buf;
+            inner.bitmap = nullptr;
+            buf += inner.size;
+            maxbytes -= inner.size;
+            inners.push_back(inner);
+        }
+
+        if (inners.size() < partitions) {
+            for (Inner &inner : inners) {
+                inner.bitmap = api::roaring_bitmap_portable_deserialize_parallel(
+                    inner.buf, inner.size, partitions, executor,
+                    executor_context);
+            }
+        } else {
+            struct Job {
+                std::vector<Inner> *inners;
+                std::vector<size_t> bounds;  // inner bitmaps of each task
+            } job;
+            job.inners = &inners;
+            size_t total = 0;
+            for (const Inner &inner : inners) total += inner.size;
+            size_t seen = 0;
+            job.bounds.push_back(0);
+            for (size_t i = 0; i < inners.size(); i++) {
+                seen += inners[i].size;
+                // close the current group once it has its share of the bytes
+                if (job.bounds.size() < partitions &&
+                    seen * partitions >= total * job.bounds.size()) {
+                    job.bounds.push_back(i + 1);
+                }
+            }
+            if (job.bounds.back() != inners.size()) {
+                job.bounds.push_back(inners.size());
+            }
+            auto task = [](void *arg, size_t index) {
+                Job *j = static_cast<Job *>(arg);
+                for (size_t i = j->bounds[index]; i < j->bounds[index + 1];
+                     i++) {
+                    Inner &inner = (*j->inners)[i];
+                    inner.bitmap = api::roaring_bitmap_portable_deserialize_safe(
+                        inner.buf, inner.size);
+                }
+            };
+            size_t n_tasks = job.bounds.size() - 1;
+            if (executor != nullptr) {
+                executor(executor_context, task, &job, n_tasks);
+            } else {
+                for (size_t i = 0; i < n_tasks; i++) task(&job, i);
+            }
+        }
+
+        bool failed = false;
+        for (const Inner &inner : inners) {
+            if (inner.bitmap == nullptr) failed = true;
+        }
+        if (failed) {
+            for (const Inner &inner : inners) {
+                if (inner.bitmap != nullptr) {
+                    api::roaring_bitmap_free(inner.bitmap);
+                }
+            }
+            ROARING_TERMINATE("failed alloc while reading");
+        }
+        BasicRoaring64Map result;
+        for (const Inner &inner : inners) {
+            result.emplaceOrInsert(inner.key, Roaring(inner.bitmap));
+        }
+        return result;
+    }
+
     /**
      * Return the number of bytes required to serialize this bitmap (meant to
      * be compatible with Java and Go versions)
@@ -1187,17 +1567,17 @@ public:
             roarings.cbegin(), roarings.cend(),
             sizeof(uint64_t) + roarings.size() * sizeof(uint32_t),
             [=](size_t previous,
-                const std::pair<const uint32_t, Roaring> &map_entry) {
+                const typename roarings_t::value_type &map_entry) {
                 // add in bytes used by each Roaring
                 return previous + map_entry.second.getSizeInBytes(portable);
             });
     }
 
-    static const Roaring64Map frozenView(const char *buf) {
+    static const BasicRoaring64Map frozenView(const char *buf) {
         // size of bitmap buffer and key
         const size_t metadata_size = sizeof(size_t) + sizeof(uint32_t);
 
-        Roaring64Map result;
+        BasicRoaring64Map result;
 
         // get map size
         uint64_t map_size;
@@ -1289,32 +1669,32 @@ public:
      * Computes the intersection between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator&(const Roaring64Map &o) const {
-        return Roaring64Map(*this) &= o;
+    BasicRoaring64Map operator&(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) &= o;
     }
 
     /**
      * Computes the difference between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator-(const Roaring64Map &o) const {
-        return Roaring64Map(*this) -= o;
+    BasicRoaring64Map operator-(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) -= o;
     }
 
     /**
      * Computes the union between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator|(const Roaring64Map &o) const {
-        return Roaring64Map(*this) |= o;
+    BasicRoaring64Map operator|(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) |= o;
     }
 
     /**
      * Computes the symmetric union between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator^(const Roaring64Map &o) const {
-        return Roaring64Map(*this) ^= o;
+    BasicRoaring64Map operator^(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) ^= o;
     }
 
     /**
@@ -1324,7 +1704,7 @@ public:
         if (copyOnWrite == val) return;
         copyOnWrite = val;
         std::for_each(roarings.begin(), roarings.end(),
-                      [=](std::pair<const uint32_t, Roaring> &map_entry) {
+                      [=](typename roarings_t::value_type &map_entry) {
                           map_entry.second.setCopyOnWrite(val);
                       });
     }
@@ -1362,7 +1742,7 @@ public:
      * Computes the logical or (union) between "n" bitmaps (referenced by a
      * pointer).
      */
-    static Roaring64Map fastunion(size_t n, const Roaring64Map **inputs) {
+    static BasicRoaring64Map fastunion(size_t n, const BasicRoaring64Map **inputs) {
         // The strategy here is to basically do a "group by" operation.
         // We group the input roarings by key, do a 32-bit
         // roaring_bitmap_or_many on each group, and collect the results.
@@ -1382,8 +1762,8 @@ public:
         // (i.e. pq_entry.iterator == pq_entry.end) it is not returned to the
         // priority queue.
         struct pq_entry {
-            roarings_t::const_iterator iterator;
-            roarings_t::const_iterator end;
+            typename roarings_t::const_iterator iterator;
+            typename roarings_t::const_iterator end;
         };
 
         // Custom comparator for the priority queue.
@@ -1425,7 +1805,7 @@ public:
         //       4. If current_iter != end_iter, reinsert the pair into the
         //          priority queue.
         //    C. Invoke the 32-bit roaring_bitmap_or_many() and add to result
-        Roaring64Map result;
+        BasicRoaring64Map result;
         while (!pq.empty()) {
             // Find the next key (the lowest key) in the priority queue.
             auto group_key = pq.top().iterator->first;
@@ -1483,10 +1863,12 @@ public:
         return result;
     }
 
-    friend class Roaring64MapSetBitForwardIterator;
-    friend class Roaring64MapSetBitBiDirectionalIterator;
-    typedef Roaring64MapSetBitForwardIterator const_iterator;
-    typedef Roaring64MapSetBitBiDirectionalIterator const_bidirectional_iterator;
+    friend class BasicRoaring64MapSetBitForwardIterator<Map>;
+    friend class BasicRoaring64MapSetBitBiDirectionalIterator<Map>;
+    friend class BasicRoaring64MapRankIndex<Map>;
+    typedef BasicRoaring64MapSetBitForwardIterator<Map> const_iterator;
+    typedef BasicRoaring64MapSetBitBiDirectionalIterator<Map>
+        const_bidirectional_iterator;
 
     /**
      * Returns an iterator that can be used to access the position of the set
@@ -1506,7 +1888,7 @@ public:
     const_iterator end() const;
 
 private:
-    typedef std::map<uint32_t, Roaring> roarings_t;
+    typedef Map roarings_t;
     roarings_t roarings{}; // The empty constructor silences warnings from pedantic static analyzers.
     bool copyOnWrite{false};
     static uint32_t highBytes(const uint64_t in) { return uint32_t(in >> 32); }
@@ -1544,6 +1926,56 @@ private:
         return bitmap;
     }
 
+    // Same policy as roaring_bitmap_add_many() for 32-bit values.
+    static const size_t addManyPartitionMin = 1024;
+    static const size_t addManyPartitionRun = 16;
+    static const size_t addManyPartitionChunk = 1 << 16;
+
+    /*
+     * Radix sorts the values by their high 32 bits, keeping the order of
+     * values sharing the same high bits, then adds each group of values to
+     * its inner bitmap at once.
+     */
+    void addManyPartitioned(size_t n_args, const uint64_t *vals) {
+        std::vector<uint64_t> buf1(n_args);
+        std::vector<uint64_t> buf2(n_args);
+        const uint64_t *src = vals;
+        uint64_t *dst = buf1.data();
+        for (int shift = 32; shift < 64; shift += 8) {
+            size_t counts[256] = {0};
+            for (size_t i = 0; i < n_args; i++) {
+                counts[(src[i] >> shift) & 0xFF]++;
+            }
+            if (counts[(src[0] >> shift) & 0xFF] == n_args) {
+                continue;  // all values have the same byte
+            }
+            size_t offset = 0;
+            for (size_t &count : counts) {
+                size_t c = count;
+                count = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < n_args; i++) {
+                dst[counts[(src[i] >> shift) & 0xFF]++] = src[i];
+            }
+            src = dst;
+            dst = (dst == buf1.data()) ? buf2.data() : buf1.data();
+        }
+        std::vector<uint32_t> lows;
+        lows.reserve(n_args);
+        size_t begin = 0;
+        while (begin < n_args) {
+            uint32_t high = highBytes(src[begin]);
+            lows.clear();
+            size_t end = begin;
+            for (; end < n_args && highBytes(src[end]) == high; end++) {
+                lows.push_back(lowBytes(src[end]));
+            }
+            lookupOrCreateInner(high).addMany(lows.size(), lows.data());
+            begin = end;
+        }
+    }
+
     /**
      * Prints the contents of the bitmap to a caller-provided sink function.
      */
@@ -1577,76 +2009,87 @@ private:
      * Roaring bitmaps if necessary. The interval must be valid and non-empty.
      * Returns an iterator to the bitmap at start_high.
      */
-    roarings_t::iterator ensureRangePopulated(uint32_t start_high,
-                                              uint32_t end_high) {
+    typename roarings_t::iterator ensureRangePopulated(uint32_t start_high,
+                                                       uint32_t end_high) {
         if (start_high > end_high) {
             ROARING_TERMINATE("Logic error: start_high > end_high");
         }
-        // next_populated_iter points to the first entry in the outer map with
+        // iter points to the first entry in the outer map with
         // key >= start_high, or end().
-        auto next_populated_iter = roarings.lower_bound(start_high);
+        auto iter = roarings.lower_bound(start_high);
 
+        // The missing slots get fresh bitmaps with the copy on write flag
+        // set. They are collected aside and inserted all at once, which
+        // SortedVectorMap does with a single merge instead of one insertion
+        // in the middle of its vector per slot.
+        std::vector<std::pair<uint32_t, Roaring>> missing;
         // Use uint64_t to avoid an infinite loop when end_high == uint32_max.
-        roarings_t::iterator start_iter{};  // Definitely assigned in loop.
         for (uint64_t slot = start_high; slot <= end_high; ++slot) {
-            roarings_t::iterator slot_iter;
-            if (next_populated_iter != roarings.end() &&
-                next_populated_iter->first == slot) {
-                // 'slot' index has caught up to next_populated_iter.
-                // Note it here and advance next_populated_iter.
-                slot_iter = next_populated_iter++;
-            } else {
-                // 'slot' index has not yet caught up to next_populated_iter.
-                // Make a fresh entry {key = 'slot', value = Roaring()}, insert
-                // it just prior to next_populated_iter, and set its copy
-                // on write flag. We take pains to use emplace_hint and
-                // piecewise_construct to minimize effort.
-                slot_iter = roarings.emplace_hint(
-                    next_populated_iter, std::piecewise_construct,
-                    std::forward_as_tuple(uint32_t(slot)),
-                    std::forward_as_tuple());
-                auto &bitmap = slot_iter->second;
-                bitmap.setCopyOnWrite(copyOnWrite);
-            }
-
-            // Make a note of the iterator of the starting slot. It will be
-            // needed for the return value.
-            if (slot == start_high) {
-                start_iter = slot_iter;
+            if (iter != roarings.end() && iter->first == slot) {
+                ++iter;
+                continue;
             }
+            missing.emplace_back(uint32_t(slot), Roaring());
+            missing.back().second.setCopyOnWrite(copyOnWrite);
         }
-        return start_iter;
+        roarings.insert(std::make_move_iterator(missing.begin()),
+                        std::make_move_iterator(missing.end()));
+        return roarings.lower_bound(start_high);
     }
 
     /**
-     * Erases the entry pointed to by 'iter' from the 'roarings' map. Warning:
-     * this invalidates 'iter'.
+     * Erases the entry pointed to by 'iter' from the 'roarings' map if its
+     * bitmap is empty. Returns the iterator following 'iter'. Warning: with
+     * SortedVectorMap, erasing invalidates all other iterators.
      */
-    void eraseIfEmpty(roarings_t::iterator iter) {
+    typename roarings_t::iterator eraseIfEmpty(
+        typename roarings_t::iterator iter) {
         const auto &bitmap = iter->second;
         if (bitmap.isEmpty()) {
-            roarings.erase(iter);
+            return roarings.erase(iter);
+        }
+        return std::next(iter);
+    }
+
+    /**
+     * Erases all the empty bitmaps from 'map'.
+     */
+    template <typename M>
+    static void eraseEmptyBitmaps(M &map) {
+        for (auto iter = map.begin(); iter != map.end();) {
+            if (iter->second.isEmpty()) {
+                iter = map.erase(iter);
+            } else {
+                ++iter;
+            }
         }
     }
+
+    static void eraseEmptyBitmaps(SortedVectorMap &map) {
+        map.eraseIf([](const SortedVectorMap::value_type &map_entry) {
+            return map_entry.second.isEmpty();
+        });
+    }
 };
 
 /**
  * Used to go through the set bits. Not optimally fast, but convenient.
  */
-class Roaring64MapSetBitForwardIterator {
+template <typename Map>
+class BasicRoaring64MapSetBitForwardIterator {
 public:
     typedef std::forward_iterator_tag iterator_category;
     typedef uint64_t *pointer;
     typedef uint64_t &reference;
     typedef uint64_t value_type;
     typedef int64_t difference_type;
-    typedef Roaring64MapSetBitForwardIterator type_of_iterator;
+    typedef BasicRoaring64MapSetBitForwardIterator type_of_iterator;
 
     /**
      * Provides the location of the set bit.
      */
     value_type operator*() const {
-        return Roaring64Map::uniteBytes(map_iter->first, i.current_value);
+        return BasicRoaring64Map<Map>::uniteBytes(map_iter->first, i.current_value);
     }
 
     bool operator<(const type_of_iterator &o) const {
@@ -1684,7 +2127,7 @@ public:
     }
 
     type_of_iterator operator++(int) {  // i++, must return orig. value
-        Roaring64MapSetBitForwardIterator orig(*this);
+        BasicRoaring64MapSetBitForwardIterator orig(*this);
         roaring_advance_uint32_iterator(&i);
         while (!i.has_value) {
             map_iter++;
@@ -1694,49 +2137,93 @@ public:
         return orig;
     }
 
-    bool move(const value_type& x) {
-        map_iter = p.lower_bound(Roaring64Map::highBytes(x));
-        if (map_iter != p.cend()) {
+    /**
+     * Moves the iterator to the first value equal to or larger than `x`.
+     * Returns false, leaving the iterator at the end, if there is none.
+     * Buckets of the map whose high 32 bits are below those of `x` are
+     * skipped without being visited.
+     */
+    bool moveEqualOrLarger(const value_type& x) {
+        const uint32_t high = BasicRoaring64Map<Map>::highBytes(x);
+        if (map_iter == map_end || map_iter->first != high) {
+            map_iter = p.lower_bound(high);
+            if (map_iter == map_end) return false;
             roaring_init_iterator(&map_iter->second.roaring, &i);
-            if (map_iter->first == Roaring64Map::highBytes(x)) {
-                if (roaring_move_uint32_iterator_equalorlarger(&i, Roaring64Map::lowBytes(x)))
-                    return true;
+        }
+        if (map_iter->first == high &&
+            !roaring_move_uint32_iterator_equalorlarger(
+                &i, BasicRoaring64Map<Map>::lowBytes(x))) {
+            i.has_value = false;
+        }
+        // The map may hold empty bitmaps, which are skipped like exhausted
+        // ones.
+        while (!i.has_value) {
+            map_iter++;
+            if (map_iter == map_end) return false;
+            roaring_init_iterator(&map_iter->second.roaring, &i);
+        }
+        return true;
+    }
+
+    bool move(const value_type& x) { return moveEqualOrLarger(x); }
+
+    /**
+     * Reads up to `n` values into `buf`, starting with the current one, and
+     * leaves the iterator on the value after the last one read. Returns the
+     * number of values read, which is less than `n` only when the iterator
+     * reaches the end. This is the 64-bit counterpart of
+     * `roaring_read_uint32_iterator()`.
+     */
+    size_t readBatch(uint64_t *buf, size_t n) {
+        const uint32_t chunk_size = 256;
+        uint32_t low_bits[chunk_size];
+        size_t count = 0;
+        while (count < n && map_iter != map_end) {
+            size_t wanted = n - count;
+            uint32_t chunk = wanted < chunk_size ? (uint32_t)wanted
+                                                 : chunk_size;
+            uint32_t read = roaring_read_uint32_iterator(&i, low_bits, chunk);
+            const uint64_t high = uint64_t(map_iter->first) << 32;
+            for (uint32_t k = 0; k < read; k++) {
+                buf[count + k] = high | low_bits[k];
+            }
+            count += read;
+            while (!i.has_value) {
                 map_iter++;
-                if (map_iter == map_end) return false;
+                if (map_iter == map_end) break;
                 roaring_init_iterator(&map_iter->second.roaring, &i);
             }
-            return true;
         }
-        return false;
+        return count;
     }
 
-    bool operator==(const Roaring64MapSetBitForwardIterator &o) const {
+    bool operator==(const BasicRoaring64MapSetBitForwardIterator &o) const {
         if (map_iter == map_end && o.map_iter == o.map_end) return true;
         if (o.map_iter == o.map_end) return false;
         return **this == *o;
     }
 
-    bool operator!=(const Roaring64MapSetBitForwardIterator &o) const {
+    bool operator!=(const BasicRoaring64MapSetBitForwardIterator &o) const {
         if (map_iter == map_end && o.map_iter == o.map_end) return false;
         if (o.map_iter == o.map_end) return true;
         return **this != *o;
     }
 
-    Roaring64MapSetBitForwardIterator &operator=(const Roaring64MapSetBitForwardIterator& r) {
+    BasicRoaring64MapSetBitForwardIterator &operator=(const BasicRoaring64MapSetBitForwardIterator& r) {
         map_iter = r.map_iter;
         map_end = r.map_end;
         i = r.i;
         return *this;
     }
 
-    Roaring64MapSetBitForwardIterator(const Roaring64MapSetBitForwardIterator& r)
+    BasicRoaring64MapSetBitForwardIterator(const BasicRoaring64MapSetBitForwardIterator& r)
         : p(r.p),
           map_iter(r.map_iter),
           map_end(r.map_end),
           i(r.i)
     {}
 
-    Roaring64MapSetBitForwardIterator(const Roaring64Map &parent,
+    BasicRoaring64MapSetBitForwardIterator(const BasicRoaring64Map<Map> &parent,
                                       bool exhausted = false)
         : p(parent.roarings), map_end(parent.roarings.cend()) {
         if (exhausted || parent.roarings.empty()) {
@@ -1753,25 +2240,32 @@ public:
     }
 
 protected:
-    const std::map<uint32_t, Roaring>& p;
-    std::map<uint32_t, Roaring>::const_iterator map_iter{}; // The empty constructor silences warnings from pedantic static analyzers.
-    std::map<uint32_t, Roaring>::const_iterator map_end{}; // The empty constructor silences warnings from pedantic static analyzers.
+    const Map& p;
+    typename Map::const_iterator map_iter{}; // The empty constructor silences warnings from pedantic static analyzers.
+    typename Map::const_iterator map_end{}; // The empty constructor silences warnings from pedantic static analyzers.
     api::roaring_uint32_iterator_t i{}; // The empty constructor silences warnings from pedantic static analyzers.
 };
 
-class Roaring64MapSetBitBiDirectionalIterator final :public Roaring64MapSetBitForwardIterator {
+template <typename Map>
+class BasicRoaring64MapSetBitBiDirectionalIterator
+    : public BasicRoaring64MapSetBitForwardIterator<Map> {
+    typedef BasicRoaring64MapSetBitForwardIterator<Map> base_type;
+    using base_type::map_iter;
+    using base_type::map_end;
+    using base_type::i;
+
 public:
-    explicit Roaring64MapSetBitBiDirectionalIterator(const Roaring64Map &parent,
+    explicit BasicRoaring64MapSetBitBiDirectionalIterator(const BasicRoaring64Map<Map> &parent,
                                                      bool exhausted = false)
-        : Roaring64MapSetBitForwardIterator(parent, exhausted), map_begin(parent.roarings.cbegin())
+        : base_type(parent, exhausted), map_begin(parent.roarings.cbegin())
     {}
 
-    Roaring64MapSetBitBiDirectionalIterator &operator=(const Roaring64MapSetBitForwardIterator& r) {
-        *(Roaring64MapSetBitForwardIterator*)this = r;
+    BasicRoaring64MapSetBitBiDirectionalIterator &operator=(const base_type& r) {
+        *(base_type*)this = r;
         return *this;
     }
 
-    Roaring64MapSetBitBiDirectionalIterator& operator--() { //  --i, must return dec.value
+    BasicRoaring64MapSetBitBiDirectionalIterator& operator--() { //  --i, must return dec.value
         if (map_iter == map_end) {
             --map_iter;
             roaring_init_iterator_last(&map_iter->second.roaring, &i);
@@ -1787,8 +2281,8 @@ public:
         return *this;
     }
 
-    Roaring64MapSetBitBiDirectionalIterator operator--(int) {  // i--, must return orig. value
-        Roaring64MapSetBitBiDirectionalIterator orig(*this);
+    BasicRoaring64MapSetBitBiDirectionalIterator operator--(int) {  // i--, must return orig. value
+        BasicRoaring64MapSetBitBiDirectionalIterator orig(*this);
         if (map_iter == map_end) {
             --map_iter;
             roaring_init_iterator_last(&map_iter->second.roaring, &i);
@@ -1805,17 +2299,270 @@ public:
     }
 
 protected:
-    std::map<uint32_t, Roaring>::const_iterator map_begin;
+    typename Map::const_iterator map_begin;
 };
 
-inline Roaring64MapSetBitForwardIterator Roaring64Map::begin() const {
-    return Roaring64MapSetBitForwardIterator(*this);
+/**
+ * Rank index of a 64-bit bitmap: the running total of the cardinalities of
+ * its inner bitmaps, and a RoaringRankIndex for each of them, so that
+ * select, rank and rangeUint64Array are logarithmic in the number of
+ * containers. The index is a snapshot: after the content of an inner bitmap
+ * changes, the queries involving it fail (select() returns false) until
+ * rebuild() is called. Adding or removing inner bitmaps is not detected, and
+ * using the index afterwards is undefined behavior. The bitmap must outlive
+ * the index.
+ */
+template <typename Map>
+class BasicRoaring64MapRankIndex {
+public:
+    explicit BasicRoaring64MapRankIndex(const BasicRoaring64Map<Map> &r)
+        : bitmap(&r) {
+        rebuild();
+    }
+
+    /**
+     * Recomputes the index after the bitmap was modified.
+     */
+    void rebuild() {
+        keys.clear();
+        cumulative.clear();
+        inner.clear();
+        keys.reserve(bitmap->roarings.size());
+        cumulative.reserve(bitmap->roarings.size());
+        inner.reserve(bitmap->roarings.size());
+        uint64_t total = 0;
+        for (const auto &map_entry : bitmap->roarings) {
+            if (map_entry.second.isEmpty()) {
+                continue;
+            }
+            total += map_entry.second.cardinality();
+            keys.push_back(map_entry.first);
+            cumulative.push_back(total);
+            inner.emplace_back(map_entry.second);
+        }
+    }
+
+    /**
+     * Same as BasicRoaring64Map::select().
+     */
+    bool select(uint64_t rank, uint64_t *element) const {
+        size_t i = std::upper_bound(cumulative.begin(), cumulative.end(),
+                                    rank) - cumulative.begin();
+        if (i == cumulative.size()) {
+            return false;
+        }
+        uint32_t low_bytes;
+        // rank - before(i) < cardinality of inner bitmap i <= 2^32, so this
+        // only fails if the index is stale
+        if (!inner[i].select((uint32_t)(rank - before(i)), &low_bytes)) {
+            return false;
+        }
+        *element = (uint64_t(keys[i]) << 32) | low_bytes;
+        return true;
+    }
+
+    /**
+     * Same as BasicRoaring64Map::rank().
+     */
+    uint64_t rank(uint64_t x) const {
+        uint32_t high = uint32_t(x >> 32);
+        size_t i = std::lower_bound(keys.begin(), keys.end(), high) -
+                   keys.begin();
+        if (i == keys.size() || keys[i] != high) {
+            return before(i);
+        }
+        return before(i) + inner[i].rank(uint32_t(x));
+    }
+
+    /**
+     * Writes up to `limit` values to `ans`, starting with the value of rank
+     * `offset`. Returns the number of values written.
+     */
+    size_t rangeUint64Array(uint64_t *ans, uint64_t offset,
+                            size_t limit) const {
+        size_t i = std::upper_bound(cumulative.begin(), cumulative.end(),
+                                    offset) - cumulative.begin();
+        size_t written = 0;
+        std::vector<uint32_t> buffer;
+        for (; i < cumulative.size() && written < limit; i++) {
+            uint64_t skip = offset > before(i) ? offset - before(i) : 0;
+            uint64_t count = std::min<uint64_t>(
+                cumulative[i] - before(i) - skip, limit - written);
+            buffer.resize(count);
+            if (!inner[i].rangeUint32Array(buffer.data(), skip, count)) {
+                break;  // stale index
+            }
+            uint64_t high = uint64_t(keys[i]) << 32;
+            for (uint32_t low : buffer) {
+                ans[written++] = high | low;
+            }
+        }
+        return written;
+    }
+
+private:
+    uint64_t before(size_t i) const { return i == 0 ? 0 : cumulative[i - 1]; }
+
+    const BasicRoaring64Map<Map> *bitmap;
+    std::vector<uint32_t> keys;
+    std::vector<uint64_t> cumulative;
+    std::vector<RoaringRankIndex> inner;
+};
+
+template <typename Map>
+inline BasicRoaring64MapSetBitForwardIterator<Map>
+BasicRoaring64Map<Map>::begin() const {
+    return BasicRoaring64MapSetBitForwardIterator<Map>(*this);
 }
 
-inline Roaring64MapSetBitForwardIterator Roaring64Map::end() const {
-    return Roaring64MapSetBitForwardIterator(*this, true);
+template <typename Map>
+inline BasicRoaring64MapSetBitForwardIterator<Map>
+BasicRoaring64Map<Map>::end() const {
+    return BasicRoaring64MapSetBitForwardIterator<Map>(*this, true);
 }
 
+/**
+ * 64-bit Roaring bitmap keeping its 32-bit bitmaps in a std::map.
+ *
+ * Roaring64Map and its iterators are classes deriving from the templates,
+ * rather than typedefs, so that existing code can keep forward declaring
+ * them. The factories, binary operators and compound assignments are
+ * redeclared to return a Roaring64Map; the other members come from
+ * BasicRoaring64Map and convert implicitly.
+ */
+class Roaring64Map : public BasicRoaring64Map<std::map<uint32_t, Roaring>> {
+    typedef BasicRoaring64Map<std::map<uint32_t, Roaring>> base_type;
+
+public:
+    using base_type::base_type;
+
+    Roaring64Map() = default;
+
+    Roaring64Map(const base_type &r) : base_type(r) {}
+
+    Roaring64Map(base_type &&r) noexcept : base_type(std::move(r)) {}
+
+    static Roaring64Map bitmapOf(size_t n...) {
+        Roaring64Map ans;
+        va_list vl;
+        va_start(vl, n);
+        for (size_t i = 0; i < n; i++) {
+            ans.add(va_arg(vl, uint64_t));
+        }
+        va_end(vl);
+        return ans;
+    }
+
+    static Roaring64Map bitmapOfList(std::initializer_list<uint64_t> l) {
+        return base_type::bitmapOfList(l);
+    }
+
+    static Roaring64Map read(const char *buf, bool portable = true) {
+        return base_type::read(buf, portable);
+    }
+
+    static Roaring64Map readSafe(const char *buf, size_t maxbytes) {
+        return base_type::readSafe(buf, maxbytes);
+    }
+
+    static Roaring64Map readSafe(const char *buf, size_t maxbytes,
+                                 size_t partitions,
+                                 api::roaring_executor executor,
+                                 void *executor_context) {
+        return base_type::readSafe(buf, maxbytes, partitions, executor,
+                                   executor_context);
+    }
+
+    static const Roaring64Map frozenView(const char *buf) {
+        return base_type::frozenView(buf);
+    }
+
+    using base_type::fastunion;
+
+    static Roaring64Map fastunion(size_t n, const Roaring64Map **inputs) {
+        std::vector<const base_type *> bases(inputs, inputs + n);
+        return base_type::fastunion(n, bases.data());
+    }
+
+    Roaring64Map operator&(const base_type &o) const {
+        return base_type::operator&(o);
+    }
+
+    Roaring64Map operator-(const base_type &o) const {
+        return base_type::operator-(o);
+    }
+
+    Roaring64Map operator|(const base_type &o) const {
+        return base_type::operator|(o);
+    }
+
+    Roaring64Map operator^(const base_type &o) const {
+        return base_type::operator^(o);
+    }
+
+    Roaring64Map &operator&=(const base_type &o) {
+        base_type::operator&=(o);
+        return *this;
+    }
+
+    Roaring64Map &operator-=(const base_type &o) {
+        base_type::operator-=(o);
+        return *this;
+    }
+
+    Roaring64Map &operator|=(const base_type &o) {
+        base_type::operator|=(o);
+        return *this;
+    }
+
+    Roaring64Map &operator^=(const base_type &o) {
+        base_type::operator^=(o);
+        return *this;
+    }
+};
+
+class Roaring64MapSetBitForwardIterator
+    : public BasicRoaring64MapSetBitForwardIterator<
+          std::map<uint32_t, Roaring>> {
+    typedef BasicRoaring64MapSetBitForwardIterator<std::map<uint32_t, Roaring>>
+        base_type;
+
+public:
+    using base_type::base_type;
+
+    Roaring64MapSetBitForwardIterator(const base_type &o) : base_type(o) {}
+};
+
+class Roaring64MapSetBitBiDirectionalIterator final
+    : public BasicRoaring64MapSetBitBiDirectionalIterator<
+          std::map<uint32_t, Roaring>> {
+    typedef BasicRoaring64MapSetBitBiDirectionalIterator<
+        std::map<uint32_t, Roaring>>
+        base_type;
+
+public:
+    using base_type::base_type;
+
+    Roaring64MapSetBitBiDirectionalIterator(const base_type &o)
+        : base_type(o) {}
+};
+
+typedef BasicRoaring64MapRankIndex<std::map<uint32_t, Roaring>>
+    Roaring64MapRankIndex;
+
+/**
+ * 64-bit Roaring bitmap keeping its 32-bit bitmaps in a SortedVectorMap: it
+ * has the same interface as Roaring64Map, uses less memory and looks up high
+ * keys faster, but inserting a new high key in the middle of the bitmap
+ * takes time linear in the number of high keys.
+ */
+typedef BasicRoaring64Map<SortedVectorMap> Roaring64FlatMap;
+typedef BasicRoaring64MapSetBitForwardIterator<SortedVectorMap>
+    Roaring64FlatMapSetBitForwardIterator;
+typedef BasicRoaring64MapSetBitBiDirectionalIterator<SortedVectorMap>
+    Roaring64FlatMapSetBitBiDirectionalIterator;
+typedef BasicRoaring64MapRankIndex<SortedVectorMap> Roaring64FlatMapRankIndex;
+
 }  // namespace roaring
 
 #endif /* INCLUDE_ROARING_64_MAP_HH_ */
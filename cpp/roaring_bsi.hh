@@ -0,0 +1,145 @@
+/**
+ * A C++ header for the bit-sliced index (roaring_bsi_t), which maps 32-bit
+ * rows to unsigned integer values and answers range predicates and
+ * aggregations with Roaring bitmaps.
+ */
+#ifndef INCLUDE_ROARING_BSI_HH_
+#define INCLUDE_ROARING_BSI_HH_
+
+#include <utility>
+
+#include "roaring.hh"
+
+#include <roaring/roaring_bsi.h>
+
+namespace roaring {
+
+/**
+ * Bit-sliced index over 32-bit rows. Queries take an optional found set:
+ * when given, only its rows are considered, otherwise all rows are.
+ */
+class RoaringBSI {
+public:
+    RoaringBSI() : bsi(api::roaring_bsi_create()) {
+        if (bsi == nullptr) {
+            ROARING_TERMINATE("failed memory alloc in constructor");
+        }
+    }
+
+    RoaringBSI(RoaringBSI &&other) noexcept : bsi(other.bsi) {
+        other.bsi = nullptr;
+    }
+
+    RoaringBSI &operator=(RoaringBSI &&other) noexcept {
+        std::swap(bsi, other.bsi);
+        return *this;
+    }
+
+    RoaringBSI(const RoaringBSI &) = delete;
+    RoaringBSI &operator=(const RoaringBSI &) = delete;
+
+    ~RoaringBSI() { api::roaring_bsi_free(bsi); }
+
+    /**
+     * Sets the value of a row, replacing its previous value if any.
+     */
+    void set(uint32_t row, uint64_t value) {
+        api::roaring_bsi_set(bsi, row, value);
+    }
+
+    /**
+     * Sets values[i] as the value of rows[i], for n distinct rows.
+     */
+    void setMany(size_t n, const uint32_t *rows, const uint64_t *values) {
+        api::roaring_bsi_set_many(bsi, n, rows, values);
+    }
+
+    /**
+     * Returns true and sets *value if the row has a value.
+     */
+    bool get(uint32_t row, uint64_t *value) const {
+        return api::roaring_bsi_get(bsi, row, value);
+    }
+
+    /**
+     * Removes the value of a row if present.
+     */
+    void remove(uint32_t row) { api::roaring_bsi_remove(bsi, row); }
+
+    /**
+     * Returns the number of rows that have a value.
+     */
+    uint64_t cardinality() const {
+        return api::roaring_bitmap_get_cardinality(api::roaring_bsi_rows(bsi));
+    }
+
+    /**
+     * Returns the number of bits of the largest value stored so far.
+     */
+    uint32_t bitDepth() const { return api::roaring_bsi_bit_depth(bsi); }
+
+    /**
+     * Returns the rows whose value compares to "value" with "op".
+     */
+    Roaring compare(api::roaring_bsi_op_t op, uint64_t value,
+                    const Roaring *foundSet = nullptr) const {
+        return wrap(api::roaring_bsi_compare(bsi, op, value, raw(foundSet)));
+    }
+
+    /**
+     * Returns the rows whose value is in the closed interval [min, max].
+     */
+    Roaring range(uint64_t min, uint64_t max,
+                  const Roaring *foundSet = nullptr) const {
+        return wrap(api::roaring_bsi_range(bsi, min, max, raw(foundSet)));
+    }
+
+    /**
+     * Returns the sum (modulo 2^64) of the values, and sets *count to the
+     * number of rows that have a value if count is not null.
+     */
+    uint64_t sum(const Roaring *foundSet = nullptr,
+                 uint64_t *count = nullptr) const {
+        return api::roaring_bsi_sum(bsi, raw(foundSet), count);
+    }
+
+    /**
+     * Sets *value to the smallest value, returns false if there is none.
+     */
+    bool min(uint64_t *value, const Roaring *foundSet = nullptr) const {
+        return api::roaring_bsi_min(bsi, raw(foundSet), value);
+    }
+
+    /**
+     * Sets *value to the largest value, returns false if there is none.
+     */
+    bool max(uint64_t *value, const Roaring *foundSet = nullptr) const {
+        return api::roaring_bsi_max(bsi, raw(foundSet), value);
+    }
+
+    /**
+     * Returns the k rows with the largest values; ties are broken in favor of
+     * the smallest rows.
+     */
+    Roaring topK(uint64_t k, const Roaring *foundSet = nullptr) const {
+        return wrap(api::roaring_bsi_top_k(bsi, k, raw(foundSet)));
+    }
+
+private:
+    static const api::roaring_bitmap_t *raw(const Roaring *r) {
+        return r == nullptr ? nullptr : &r->roaring;
+    }
+
+    static Roaring wrap(api::roaring_bitmap_t *r) {
+        if (r == nullptr) {
+            ROARING_TERMINATE("failed materalization in RoaringBSI");
+        }
+        return Roaring(r);
+    }
+
+    api::roaring_bsi_t *bsi;
+};
+
+}  // namespace roaring
+
+#endif  // INCLUDE_ROARING_BSI_HH_
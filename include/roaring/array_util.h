@@ -222,6 +222,24 @@ int32_t difference_vector16(const uint16_t *__restrict__ A, size_t s_a,
                             const uint16_t *__restrict__ B, size_t s_b,
                             uint16_t *C);
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/**
+ * A fast AVX-512 union function.
+ */
+uint32_t union_vector16_avx512(const uint16_t *__restrict__ set_1,
+                               uint32_t size_1,
+                               const uint16_t *__restrict__ set_2,
+                               uint32_t size_2, uint16_t *__restrict__ buffer);
+
+/**
+ * A fast AVX-512 XOR function.
+ */
+uint32_t xor_vector16_avx512(const uint16_t *__restrict__ array1,
+                             uint32_t length1,
+                             const uint16_t *__restrict__ array2,
+                             uint32_t length2, uint16_t *__restrict__ output);
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
+
 /**
  * Generic union function, returns just the cardinality.
  */
@@ -0,0 +1,132 @@
+#ifndef ART_ART_H
+#define ART_ART_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * This file contains an implementation of an Adaptive Radix Tree as described
+ * in https://db.in.tum.de/~leis/papers/ART.pdf.
+ *
+ * The ART contains the keys in _byte lexographical_ order.
+ *
+ * Other features:
+ *  * Fixed 48 bit key length: all keys are assumed to be be 48 bits in size.
+ *    This allows us to put the key and key prefixes directly in nodes, reducing
+ *    indirection at no additional memory overhead.
+ *  * Key compression: the only inner nodes created are at points where key
+ *    chunks _differ_. This means that if there are two entries with different
+ *    high 48 bits, then there is only one inner node containing the common key
+ *    prefix, and two leaves.
+ *  * Intrusive leaves: the leaf struct is included in user values. This removes
+ *    a layer of indirection.
+ */
+
+// Fixed length of keys in the ART. All keys are assumed to be of this length.
+#define ART_KEY_BYTES 6
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace internal {
+#endif
+
+typedef uint8_t art_key_chunk_t;
+typedef struct art_node_s art_node_t;
+
+// Values should be declared with `art_val_t` as the first member. Values are
+// owned by the caller; the ART only stores pointers to them.
+typedef struct art_val_s {
+    art_key_chunk_t key[ART_KEY_BYTES];
+} art_val_t;
+
+typedef struct art_s {
+    art_node_t *root;
+} art_t;
+
+/**
+ * Inserts the given key and value. The key is copied into `val->key`. If the
+ * key is already present the ART is left unchanged and `*existing` is set to
+ * the existing value; otherwise it is set to NULL. Returns false, leaving the
+ * ART unchanged, if an inner node cannot be allocated.
+ */
+bool art_insert(art_t *art, const art_key_chunk_t *key, art_val_t *val,
+                art_val_t **existing);
+
+/**
+ * Returns the value erased, NULL if not found.
+ */
+art_val_t *art_erase(art_t *art, const art_key_chunk_t *key);
+
+/**
+ * Returns the value associated with the given key, NULL if not found.
+ */
+art_val_t *art_find(const art_t *art, const art_key_chunk_t *key);
+
+/**
+ * Returns true if the ART is empty.
+ */
+bool art_is_empty(const art_t *art);
+
+/**
+ * Frees the nodes of the ART, but not the values, which remain owned by the
+ * caller.
+ */
+void art_free(art_t *art);
+
+/**
+ * Returns the size in bytes of the inner nodes of the ART, excluding values.
+ */
+size_t art_size_in_bytes(const art_t *art);
+
+/**
+ * Compares two keys, returns a negative, zero or positive value.
+ */
+int art_compare_keys(const art_key_chunk_t key1[],
+                     const art_key_chunk_t key2[]);
+
+// The path from the root to the current leaf: `frames[i]` is an inner node and
+// `indices[i]` the position of the child taken within it.
+typedef struct art_iterator_s {
+    art_val_t *value;  // NULL if the iterator is exhausted.
+    uint8_t depth;     // Number of inner nodes on the path.
+    art_node_t *frames[ART_KEY_BYTES];
+    int16_t indices[ART_KEY_BYTES];
+} art_iterator_t;
+
+/**
+ * Positions the iterator at the first (or last, when `first` is false) value
+ * of the ART. Returns false if the ART is empty.
+ */
+bool art_init_iterator(const art_t *art, art_iterator_t *iterator, bool first);
+
+/**
+ * Moves the iterator to the next value. Returns false and clears
+ * `iterator->value` if there is none.
+ */
+bool art_iterator_next(art_iterator_t *iterator);
+
+/**
+ * Moves the iterator to the previous value. Returns false and clears
+ * `iterator->value` if there is none.
+ */
+bool art_iterator_prev(art_iterator_t *iterator);
+
+/**
+ * Positions the iterator at the first value with a key equal to or greater
+ * than the given key. Returns false if there is none.
+ */
+bool art_iterator_lower_bound(const art_t *art, art_iterator_t *iterator,
+                              const art_key_chunk_t *key);
+
+/**
+ * Removes the value the iterator points to from the ART and moves the
+ * iterator to the next value. Returns the removed value, which remains owned
+ * by the caller.
+ */
+art_val_t *art_iterator_erase(art_t *art, art_iterator_t *iterator);
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace internal {
+#endif
+
+#endif
@@ -101,6 +101,23 @@ static inline bool array_container_full(const array_container_t *array) {
     return array->cardinality == array->capacity;
 }
 
+/* Returns the values of `arr' in [64 * word_index, 64 * word_index + 63] as
+ * a bitset word, starting at index `*pos', which is moved past them. Called
+ * with increasing word indexes, this streams the array as bitset words. */
+static inline uint64_t array_container_next_word(const array_container_t *arr,
+                                                 int32_t *pos,
+                                                 uint32_t word_index) {
+    uint64_t word = 0;
+    int32_t i = *pos;
+    while (i < arr->cardinality &&
+           (uint32_t)(arr->array[i] >> 6) == word_index) {
+        word |= UINT64_C(1) << (arr->array[i] & 63);
+        i++;
+    }
+    *pos = i;
+    return word;
+}
+
 
 /* Compute the union of `src_1' and `src_2' and write the result to `dst'
  * It is assumed that `dst' is distinct from both `src_1' and `src_2'. */
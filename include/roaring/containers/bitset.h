@@ -383,6 +383,30 @@ int bitset_container_andnot_nocard(const bitset_container_t *src_1,
                                    const bitset_container_t *src_2,
                                    bitset_container_t *dst);
 
+/* Compute the union, intersection or exclusive or of bitsets `src_1' and
+ * `src_2' into `dst' and return the cardinality, while also counting the
+ * runs of the result into `n_runs'. Used to pick the most compact container
+ * for the result without another pass over it. */
+int bitset_container_or_runs(const bitset_container_t *src_1,
+                             const bitset_container_t *src_2,
+                             bitset_container_t *dst, int32_t *n_runs);
+int bitset_container_and_runs(const bitset_container_t *src_1,
+                              const bitset_container_t *src_2,
+                              bitset_container_t *dst, int32_t *n_runs);
+int bitset_container_xor_runs(const bitset_container_t *src_1,
+                              const bitset_container_t *src_2,
+                              bitset_container_t *dst, int32_t *n_runs);
+
+/* Adds the cardinality and the runs of `word' to `card' and `n_runs', for a
+ * bitset written one word at a time. A run starts at every set bit whose
+ * predecessor is clear; `carry' holds the top bit of the previous word. */
+static inline void bitset_count_word_runs(uint64_t word, int32_t *card,
+                                          int32_t *n_runs, uint64_t *carry) {
+    *card += hamming(word);
+    *n_runs += hamming(word & ~((word << 1) | *carry));
+    *carry = word >> 63;
+}
+
 void bitset_container_offset(const bitset_container_t *c,
                              container_t **loc, container_t **hic,
                              uint16_t offset);
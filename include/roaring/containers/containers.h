@@ -59,7 +59,7 @@ extern "C" { namespace roaring { namespace internal {
 STRUCT_CONTAINER(shared_container_s) {
     container_t *container;
     uint8_t typecode;
-    uint32_t counter;  // to be managed atomically
+    croaring_refcount_t counter;  // to be managed atomically
 };
 
 typedef struct shared_container_s shared_container_t;
@@ -1584,6 +1584,160 @@ static inline container_t* container_xor(
     }
 }
 
+// Converts a freshly computed result to its most compact container type.
+static inline container_t *container_compact_result(
+    container_t *result, uint8_t *result_type
+){
+    if (result == NULL) return NULL;
+    return convert_run_optimize(result, *result_type, result_type);
+}
+
+/**
+ * Like container_and, container_or and container_xor, but the result is
+ * always the most compact of the three container types, as if it had gone
+ * through convert_run_optimize. The pairs whose result is built as a bitset
+ * (two bitsets; for unions and xors, an array or a run with a bitset, and
+ * two arrays holding more than DEFAULT_MAX_SIZE values together) go through
+ * kernels that count the runs of the result while computing it. The other
+ * results, which are arrays or runs, are converted right after the
+ * operation while they are still in cache.
+ */
+static inline container_t *container_and_adaptive(
+    const container_t *c1, uint8_t type1,
+    const container_t *c2, uint8_t type2,
+    uint8_t *result_type
+){
+    c1 = container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    if (PAIR_CONTAINER_TYPES(type1, type2) == CONTAINER_PAIR(BITSET,BITSET)) {
+        container_t *result = NULL;
+        *result_type = bitset_bitset_container_intersection_adaptive(
+                            const_CAST_bitset(c1),
+                            const_CAST_bitset(c2), &result);
+        return result;
+    }
+    return container_compact_result(
+        container_and(c1, type1, c2, type2, result_type), result_type);
+}
+
+static inline container_t *container_or_adaptive(
+    const container_t *c1, uint8_t type1,
+    const container_t *c2, uint8_t type2,
+    uint8_t *result_type
+){
+    c1 = container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    container_t *result = NULL;
+    switch (PAIR_CONTAINER_TYPES(type1, type2)) {
+        case CONTAINER_PAIR(BITSET,BITSET):
+            *result_type = bitset_bitset_container_union_adaptive(
+                                const_CAST_bitset(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(ARRAY,ARRAY):
+            if (const_CAST_array(c1)->cardinality +
+                    const_CAST_array(c2)->cardinality <= DEFAULT_MAX_SIZE) {
+                break;
+            }
+            *result_type = array_array_container_union_adaptive(
+                                const_CAST_array(c1),
+                                const_CAST_array(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(BITSET,ARRAY):
+            *result_type = array_bitset_container_union_adaptive(
+                                const_CAST_array(c2),
+                                const_CAST_bitset(c1), &result);
+            return result;
+
+        case CONTAINER_PAIR(ARRAY,BITSET):
+            *result_type = array_bitset_container_union_adaptive(
+                                const_CAST_array(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(BITSET,RUN):
+            if (run_container_is_full(const_CAST_run(c2))) {
+                break;  // copied as a full run
+            }
+            *result_type = run_bitset_container_union_adaptive(
+                                const_CAST_run(c2),
+                                const_CAST_bitset(c1), &result);
+            return result;
+
+        case CONTAINER_PAIR(RUN,BITSET):
+            if (run_container_is_full(const_CAST_run(c1))) {
+                break;  // copied as a full run
+            }
+            *result_type = run_bitset_container_union_adaptive(
+                                const_CAST_run(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        default:
+            break;
+    }
+    return container_compact_result(
+        container_or(c1, type1, c2, type2, result_type), result_type);
+}
+
+static inline container_t *container_xor_adaptive(
+    const container_t *c1, uint8_t type1,
+    const container_t *c2, uint8_t type2,
+    uint8_t *result_type
+){
+    c1 = container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    container_t *result = NULL;
+    switch (PAIR_CONTAINER_TYPES(type1, type2)) {
+        case CONTAINER_PAIR(BITSET,BITSET):
+            *result_type = bitset_bitset_container_xor_adaptive(
+                                const_CAST_bitset(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(ARRAY,ARRAY):
+            if (const_CAST_array(c1)->cardinality +
+                    const_CAST_array(c2)->cardinality <= DEFAULT_MAX_SIZE) {
+                break;
+            }
+            *result_type = array_array_container_xor_adaptive(
+                                const_CAST_array(c1),
+                                const_CAST_array(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(BITSET,ARRAY):
+            *result_type = array_bitset_container_xor_adaptive(
+                                const_CAST_array(c2),
+                                const_CAST_bitset(c1), &result);
+            return result;
+
+        case CONTAINER_PAIR(ARRAY,BITSET):
+            *result_type = array_bitset_container_xor_adaptive(
+                                const_CAST_array(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        case CONTAINER_PAIR(BITSET,RUN):
+            *result_type = run_bitset_container_xor_adaptive(
+                                const_CAST_run(c2),
+                                const_CAST_bitset(c1), &result);
+            return result;
+
+        case CONTAINER_PAIR(RUN,BITSET):
+            *result_type = run_bitset_container_xor_adaptive(
+                                const_CAST_run(c1),
+                                const_CAST_bitset(c2), &result);
+            return result;
+
+        default:
+            break;
+    }
+    return container_compact_result(
+        container_xor(c1, type1, c2, type2, result_type), result_type);
+}
+
 /* Applies an offset to the non-empty container 'c'.
  * The results are stored in new containers returned via 'lo' and 'hi', for the
  * low and high halves of the result (where the low half matches the original key
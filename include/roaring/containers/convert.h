@@ -32,6 +32,18 @@ array_container_t *array_container_from_bitset(const bitset_container_t *bits);
  */
 run_container_t *run_container_from_array(const array_container_t *c);
 
+/* Convert a bitset having `n_runs` runs into a run. The input container is
+ * not freed or modified. */
+run_container_t *run_container_from_bitset(const bitset_container_t *bc,
+                                           int32_t n_runs);
+
+/* convert a bitset having `n_runs` runs (see bitset_container_or_runs) into
+ * the most space efficient of the three container types.
+ * The container might be freed. */
+container_t *convert_bitset_to_compact_container(
+        bitset_container_t *bc, int32_t n_runs,
+        uint8_t *typecode_after);
+
 /* convert a run into either an array or a bitset
  * might free the container. This does not free the input run container. */
 container_t *convert_to_bitset_or_array_container(
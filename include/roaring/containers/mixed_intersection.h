@@ -46,6 +46,14 @@ bool bitset_bitset_container_intersection(const bitset_container_t *src_1,
                                           const bitset_container_t *src_2,
                                           container_t **dst);
 
+/* Compute the intersection of src_1 and src_2 and write the result to *dst
+ * (which has no container initially), as the most compact of the three
+ * container types: the runs are counted while computing. Returns the type
+ * of *dst. */
+int bitset_bitset_container_intersection_adaptive(
+        const bitset_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+
 /* Compute the intersection between src_1 and src_2 and write the result to
  * dst. It is allowed for dst to be equal to src_1. We assume that dst is a
  * valid container. */
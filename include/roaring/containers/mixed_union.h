@@ -19,6 +19,28 @@
 extern "C" { namespace roaring { namespace internal {
 #endif
 
+/* Compute the union of src_1 and src_2 and write the result to *dst
+ * (which has no container initially), as the most compact of the three
+ * container types: the runs are counted while computing. Returns the type
+ * of *dst. */
+int bitset_bitset_container_union_adaptive(
+        const bitset_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+
+/* Same as bitset_bitset_container_union_adaptive, for an array or a run
+ * container with a bitset, and for two arrays: the pairs whose union is
+ * computed as a bitset (for two arrays, when they hold more than
+ * DEFAULT_MAX_SIZE values together). */
+int array_bitset_container_union_adaptive(
+        const array_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+int run_bitset_container_union_adaptive(
+        const run_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+int array_array_container_union_adaptive(
+        const array_container_t *src_1, const array_container_t *src_2,
+        container_t **dst);
+
 /* Compute the union of src_1 and src_2 and write the result to
  * dst. It is allowed for src_2 to be dst.   */
 void array_bitset_container_union(const array_container_t *src_1,
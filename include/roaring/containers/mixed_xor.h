@@ -42,6 +42,28 @@ bool array_bitset_container_xor(
 void array_bitset_container_lazy_xor(const array_container_t *src_1,
                                      const bitset_container_t *src_2,
                                      bitset_container_t *dst);
+/* Compute the xor of src_1 and src_2 and write the result to *dst
+ * (which has no container initially), as the most compact of the three
+ * container types: the runs are counted while computing. Returns the type
+ * of *dst. */
+int bitset_bitset_container_xor_adaptive(
+        const bitset_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+
+/* Same as bitset_bitset_container_xor_adaptive, for an array or a run
+ * container with a bitset, and for two arrays: the pairs whose xor is
+ * computed as a bitset (for two arrays, when they hold more than
+ * DEFAULT_MAX_SIZE values together). */
+int array_bitset_container_xor_adaptive(
+        const array_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+int run_bitset_container_xor_adaptive(
+        const run_container_t *src_1, const bitset_container_t *src_2,
+        container_t **dst);
+int array_array_container_xor_adaptive(
+        const array_container_t *src_1, const array_container_t *src_2,
+        container_t **dst);
+
 /* Compute the xor of src_1 and src_2 and write the result to
  * dst (which has no container initially). Return value is
  * "dst is a bitset"
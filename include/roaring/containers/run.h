@@ -86,6 +86,33 @@ void run_container_free(run_container_t *run);
 /* Duplicate container */
 run_container_t *run_container_clone(const run_container_t *src);
 
+/* Returns the values of `run' in [64 * word_index, 64 * word_index + 63] as
+ * a bitset word, starting with the run at index `*pos', which is moved past
+ * the runs ending in that word. Called with increasing word indexes, this
+ * streams the runs as bitset words. */
+static inline uint64_t run_container_next_word(const run_container_t *run,
+                                               int32_t *pos,
+                                               uint32_t word_index) {
+    const uint32_t first = word_index * 64;
+    const uint32_t last = first + 63;
+    uint64_t word = 0;
+    while (*pos < run->n_runs) {
+        const uint32_t start = run->runs[*pos].value;
+        const uint32_t end = start + run->runs[*pos].length;
+        if (start > last) {
+            break;
+        }
+        const uint32_t lo = start > first ? start - first : 0;
+        const uint32_t hi = end < last ? end - first : 63;
+        word |= (~UINT64_C(0) << lo) & (~UINT64_C(0) >> (63 - hi));
+        if (end > last) {
+            break;  // the run goes on in the next word
+        }
+        (*pos)++;
+    }
+    return word;
+}
+
 /*
  * Effectively deletes the value at index index, repacking data.
  */
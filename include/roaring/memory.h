@@ -32,6 +32,63 @@ void roaring_free(void*);
 void* roaring_aligned_malloc(size_t, size_t);
 void roaring_aligned_free(void*);
 
+/**
+ * An arena is a bump allocator: allocations are carved out of large chunks
+ * and are only given back all at once, by `roaring_arena_reset()` or
+ * `roaring_arena_free()`. This makes short-lived bitmaps (e.g., per-request
+ * temporaries) much cheaper to build and to throw away.
+ *
+ * An arena is used by activating it on a thread: while it is active, all the
+ * allocations done by this library on that thread come from the arena.
+ * Freeing arena memory does nothing, whether or not the arena is active;
+ * memory obtained from the regular hooks is still freed normally. Bitmaps (or
+ * `Roaring` objects) living in an arena may be read and freed once the arena
+ * is deactivated, but not modified; after `roaring_arena_reset()` or
+ * `roaring_arena_free()` they must not be used at all. Copy what you need to
+ * keep (after deactivating the arena) before resetting it.
+ *
+ * Activations can be nested: while an inner arena is active, bitmaps living
+ * in the outer ones can still be read and freed. However, while an arena is
+ * active, only modify bitmaps living in it: modifying a heap bitmap, or one
+ * from an outer arena, gives it containers from the active arena, which
+ * dangle once that arena is reset.
+ *
+ * An arena belongs to the thread that created it: it must only be activated,
+ * and its memory freed, on that thread, and it is not thread-safe.
+ */
+typedef struct roaring_arena_s roaring_arena_t;
+
+/**
+ * Creates an arena whose first chunk holds `initial_capacity` bytes (the
+ * arena grows as needed). Returns NULL if the allocation fails.
+ */
+roaring_arena_t* roaring_arena_create(size_t initial_capacity);
+
+/**
+ * Releases all the memory handed out by the arena, in one step. The memory is
+ * kept (as a single chunk) for further allocations.
+ */
+void roaring_arena_reset(roaring_arena_t* arena);
+
+/**
+ * Frees the arena and all the memory it handed out. Must be called on the
+ * thread that created the arena, and deactivates it if it is active.
+ */
+void roaring_arena_free(roaring_arena_t* arena);
+
+/**
+ * Makes the current thread allocate from `arena`, or from the regular memory
+ * hooks if `arena` is NULL. Returns the arena that was active before, so that
+ * activations can be nested.
+ */
+roaring_arena_t* roaring_arena_activate(roaring_arena_t* arena);
+
+/**
+ * Returns the number of bytes handed out by the arena since it was created or
+ * last reset (including the bookkeeping of each allocation).
+ */
+size_t roaring_arena_used(const roaring_arena_t* arena);
+
 #ifdef __cplusplus
 }
 #endif
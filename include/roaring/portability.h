@@ -300,11 +300,13 @@ static inline int hamming(uint64_t x) {
   _Pragma(STRINGIFY(                                                           \
       clang attribute push(__attribute__((target(T))), apply_to = function)))
 #define CROARING_UNTARGET_REGION _Pragma("clang attribute pop")
+#define CROARING_UNTARGET_AVX512 _Pragma("clang attribute pop")
 #elif defined(__GNUC__)
 // GCC is easier
 #define CROARING_TARGET_REGION(T)                                                       \
   _Pragma("GCC push_options") _Pragma(STRINGIFY(GCC target(T)))
 #define CROARING_UNTARGET_REGION _Pragma("GCC pop_options")
+#define CROARING_UNTARGET_AVX512 _Pragma("GCC pop_options")
 #endif // clang then gcc
 
 #endif // CROARING_IS_X64
@@ -313,10 +315,18 @@ static inline int hamming(uint64_t x) {
 #ifndef CROARING_TARGET_REGION
 #define CROARING_TARGET_REGION(T)
 #define CROARING_UNTARGET_REGION
+#define CROARING_UNTARGET_AVX512
 #endif
 
 #define CROARING_TARGET_AVX2 CROARING_TARGET_REGION("avx2,bmi,pclmul,lzcnt")
 
+// The AVX-512 regions are closed with CROARING_UNTARGET_AVX512: when we build
+// for AVX2 (see below), CROARING_UNTARGET_REGION becomes a no-op but the
+// AVX-512 regions still need to be tagged.
+#define CROARING_TARGET_AVX512                                                  \
+  CROARING_TARGET_REGION("avx2,bmi,bmi2,pclmul,lzcnt,popcnt,avx512f,avx512dq," \
+                         "avx512bw,avx512vbmi2,avx512vpopcntdq")
+
 #ifdef __AVX2__
 // No need for runtime dispatching.
 // It is unnecessary and harmful to old clang to tag regions.
@@ -326,6 +336,151 @@ static inline int hamming(uint64_t x) {
 #define CROARING_UNTARGET_REGION
 #endif
 
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && \
+    defined(__AVX512VBMI2__) && defined(__AVX512VPOPCNTDQ__)
+// Building for AVX-512 directly, no region needs to be tagged.
+#undef CROARING_TARGET_AVX512
+#define CROARING_TARGET_AVX512
+#undef CROARING_UNTARGET_AVX512
+#define CROARING_UNTARGET_AVX512
+#endif
+
+// Our AVX-512 kernels need intrinsics for VBMI2 and VPOPCNTDQ
+// (Ice Lake), which older compilers lack.
+#if defined(CROARING_IS_X64) && !defined(CROARING_COMPILER_SUPPORTS_AVX512)
+#if defined(__clang__) && (__clang_major__ >= 8)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#elif defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 8)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#elif CROARING_REGULAR_VISUAL_STUDIO && (_MSC_VER >= 1920)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#endif
+#endif
+#ifndef CROARING_COMPILER_SUPPORTS_AVX512
+#define CROARING_COMPILER_SUPPORTS_AVX512 0
+#endif
+
+//
+// Reference counts of shared (copy-on-write) containers.
+//
+// By default we use C11 atomics in C, std::atomic in C++ and the Interlocked
+// intrinsics with Visual Studio in C mode, so that copy-on-write bitmaps
+// sharing containers can be copied and freed from different threads.
+// Build with ROARING_DISABLE_ATOMICS (or define CROARING_ATOMIC_IMPL to
+// CROARING_ATOMIC_IMPL_NONE) to go back to plain, non-thread-safe counters.
+//
+#define CROARING_ATOMIC_IMPL_NONE 1
+#define CROARING_ATOMIC_IMPL_CPP 2
+#define CROARING_ATOMIC_IMPL_C 3
+#define CROARING_ATOMIC_IMPL_C_WINDOWS 4
+
+#if !defined(CROARING_ATOMIC_IMPL) && defined(ROARING_DISABLE_ATOMICS)
+#define CROARING_ATOMIC_IMPL CROARING_ATOMIC_IMPL_NONE
+#endif
+
+#if !defined(CROARING_ATOMIC_IMPL)
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define CROARING_ATOMIC_IMPL CROARING_ATOMIC_IMPL_CPP
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+      !defined(__STDC_NO_ATOMICS__)
+#define CROARING_ATOMIC_IMPL CROARING_ATOMIC_IMPL_C
+#elif CROARING_REGULAR_VISUAL_STUDIO
+#define CROARING_ATOMIC_IMPL CROARING_ATOMIC_IMPL_C_WINDOWS
+#else
+#define CROARING_ATOMIC_IMPL CROARING_ATOMIC_IMPL_NONE
+#endif
+#endif // !defined(CROARING_ATOMIC_IMPL)
+
+#if CROARING_ATOMIC_IMPL == CROARING_ATOMIC_IMPL_CPP
+#include <atomic>
+typedef std::atomic<uint32_t> croaring_refcount_t;
+
+// Sets the count of a container that no other thread can see yet; it is
+// published later, along with the container, so relaxed suffices.
+static inline void croaring_refcount_init(croaring_refcount_t *val,
+                                          uint32_t count) {
+    val->store(count, std::memory_order_relaxed);
+}
+
+// Taking a new reference only requires that we already hold one: relaxed.
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+    val->fetch_add(1, std::memory_order_relaxed);
+}
+
+// Returns true when the last reference was released. Releasing publishes our
+// writes to whichever thread frees the container, which in turn acquires them.
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+    return val->fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+    return val->load(std::memory_order_acquire);
+}
+#elif CROARING_ATOMIC_IMPL == CROARING_ATOMIC_IMPL_C
+#include <stdatomic.h>
+typedef _Atomic(uint32_t) croaring_refcount_t;
+
+static inline void croaring_refcount_init(croaring_refcount_t *val,
+                                          uint32_t count) {
+    atomic_init(val, count);
+}
+
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+    atomic_fetch_add_explicit(val, 1, memory_order_relaxed);
+}
+
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+    return atomic_fetch_sub_explicit(val, 1, memory_order_acq_rel) == 1;
+}
+
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+    return atomic_load_explicit(val, memory_order_acquire);
+}
+#elif CROARING_ATOMIC_IMPL == CROARING_ATOMIC_IMPL_C_WINDOWS
+#include <intrin.h>
+// _InterlockedIncrement and _InterlockedDecrement are full barriers.
+typedef volatile long croaring_refcount_t;
+
+static inline void croaring_refcount_init(croaring_refcount_t *val,
+                                          uint32_t count) {
+    *val = (long)count;
+}
+
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+    _InterlockedIncrement(val);
+}
+
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+    return _InterlockedDecrement(val) == 0;
+}
+
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+    return (uint32_t)_InterlockedOr((croaring_refcount_t *)val, 0);
+}
+#elif CROARING_ATOMIC_IMPL == CROARING_ATOMIC_IMPL_NONE
+typedef uint32_t croaring_refcount_t;
+
+static inline void croaring_refcount_init(croaring_refcount_t *val,
+                                          uint32_t count) {
+    *val = count;
+}
+
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+    *val += 1;
+}
+
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+    *val -= 1;
+    return *val == 0;
+}
+
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+    return *val;
+}
+#else
+#error "Unknown atomic implementation"
+#endif
+
 
 // We need portability.h to be included first,
 // but we also always want isadetection.h to be
@@ -64,6 +64,17 @@ roaring_bitmap_t *roaring_bitmap_from_range(uint64_t min, uint64_t max,
  */
 roaring_bitmap_t *roaring_bitmap_of_ptr(size_t n_args, const uint32_t *vals);
 
+/**
+ * Creates a new bitmap from `n` values sorted in increasing order (duplicates
+ * are allowed). This is much faster than `roaring_bitmap_of_ptr()` on such
+ * input: each container is built in one pass, directly with its final type
+ * and size, as if `roaring_bitmap_run_optimize()` had been called.
+ *
+ * If the values turn out not to be sorted, the result is still correct but
+ * is built with `roaring_bitmap_of_ptr()`. Returns NULL on allocation failure.
+ */
+roaring_bitmap_t *roaring_bitmap_from_sorted(const uint32_t *vals, size_t n);
+
 /*
  * Whether you want to use copy-on-write.
  * Saves memory and avoids copies, but needs more care in a threaded context.
@@ -85,6 +96,30 @@ static inline void roaring_bitmap_set_copy_on_write(roaring_bitmap_t* r,
     }
 }
 
+/*
+ * Whether `roaring_bitmap_and()`, `roaring_bitmap_or()` and
+ * `roaring_bitmap_xor()` should give each computed container of their result
+ * its most compact type, as `roaring_bitmap_run_optimize()` would, rather
+ * than the type the operation happens to produce. Applies when either input
+ * has the flag, and carries over to the result. Containers copied unchanged
+ * from one input keep their type. Off by default.
+ *
+ * This costs a little time per operation, but saves a separate
+ * `roaring_bitmap_run_optimize()` pass, and memory, on results that are kept.
+ */
+static inline bool roaring_bitmap_get_adaptive_containers(
+    const roaring_bitmap_t* r) {
+    return r->high_low_container.flags & ROARING_FLAG_ADAPTIVE;
+}
+static inline void roaring_bitmap_set_adaptive_containers(roaring_bitmap_t* r,
+                                                          bool adaptive) {
+    if (adaptive) {
+        r->high_low_container.flags |= ROARING_FLAG_ADAPTIVE;
+    } else {
+        r->high_low_container.flags &= ~ROARING_FLAG_ADAPTIVE;
+    }
+}
+
 roaring_bitmap_t *roaring_bitmap_add_offset(const roaring_bitmap_t *bm,
                                             int64_t offset);
 /**
@@ -178,6 +213,17 @@ uint64_t roaring_bitmap_xor_cardinality(const roaring_bitmap_t *r1,
 void roaring_bitmap_and_inplace(roaring_bitmap_t *r1,
                                 const roaring_bitmap_t *r2);
 
+/**
+ * Compute the intersection of 'number' bitmaps.
+ * The keys of all bitmaps are intersected before any container is touched,
+ * and the containers of each common key are intersected from the smallest to
+ * the largest. This is typically faster than chaining `roaring_bitmap_and()`
+ * and it does not materialize intermediate bitmaps.
+ * Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bitmap_and_many(size_t number,
+                                          const roaring_bitmap_t **rs);
+
 /**
  * Computes the union between two bitmaps and returns new bitmap. The caller is
  * responsible for memory management.
@@ -208,6 +254,54 @@ roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
 roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
                                               const roaring_bitmap_t **rs);
 
+/**
+ * Parallel version of `roaring_bitmap_or_many()`.
+ *
+ * The 16-bit key space is split into (at most) `partitions` ranges holding
+ * roughly the same number of containers. Each range is unioned by its own
+ * task, and the per-range results are concatenated without copying the
+ * containers. The tasks are run by `executor`, which is given
+ * `executor_context`; if `executor` is NULL, they run one after the other on
+ * the calling thread.
+ *
+ * The inputs must not be modified while the function runs. They are only
+ * read, even when copy-on-write is enabled: the tasks copy the containers
+ * they need instead of sharing them, so the result never shares containers
+ * with the inputs. Returns NULL if an allocation fails. Caller is responsible
+ * for freeing the result.
+ */
+roaring_bitmap_t *roaring_bitmap_or_many_parallel(size_t number,
+                                                  const roaring_bitmap_t **rs,
+                                                  size_t partitions,
+                                                  roaring_executor executor,
+                                                  void *executor_context);
+
+/**
+ * Parallel version of `roaring_bitmap_and_many()`, see
+ * `roaring_bitmap_or_many_parallel()`.
+ */
+roaring_bitmap_t *roaring_bitmap_and_many_parallel(size_t number,
+                                                   const roaring_bitmap_t **rs,
+                                                   size_t partitions,
+                                                   roaring_executor executor,
+                                                   void *executor_context);
+
+/**
+ * Compute the values present in at least `t` of the `number` bitmaps, e.g.
+ * for fuzzy matching. With `t <= 1` this is `roaring_bitmap_or_many()`, with
+ * `t == number` it is `roaring_bitmap_and_many()`, and with `t > number` the
+ * result is empty.
+ *
+ * Keys held by fewer than `t` bitmaps are skipped. For the other keys, array
+ * and run containers are counted by merging their boundaries, and bitset
+ * containers with bit-sliced counters.
+ *
+ * Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **rs,
+                                                uint32_t t);
+
 /**
  * Computes the symmetric difference (xor) between two bitmaps
  * and returns new bitmap. The caller is responsible for memory management.
@@ -252,6 +346,71 @@ void roaring_bitmap_andnot_inplace(roaring_bitmap_t *r1,
  *                                                const roaring_bitmap_t **rs);
  */
 
+/**
+ * Operators of a `roaring_expr_t` node.
+ */
+typedef enum roaring_expr_op_e {
+    ROARING_EXPR_BITMAP = 0,  // leaf
+    ROARING_EXPR_AND,
+    ROARING_EXPR_OR,
+    ROARING_EXPR_XOR,
+    ROARING_EXPR_ANDNOT
+} roaring_expr_op_t;
+
+/**
+ * A node of a Boolean expression over bitmaps, such as `(A & B) | (C - D)`.
+ * Leaves have `op == ROARING_EXPR_BITMAP` and refer to `bitmap`, the other
+ * nodes apply `op` to `left` and `right`. Nodes belong to the caller and are
+ * typically built on the stack:
+ * ```
+ * roaring_expr_t a = roaring_expr_bitmap(A), b = roaring_expr_bitmap(B);
+ * roaring_expr_t c = roaring_expr_bitmap(C), d = roaring_expr_bitmap(D);
+ * roaring_expr_t ab = roaring_expr_op(ROARING_EXPR_AND, &a, &b);
+ * roaring_expr_t cd = roaring_expr_op(ROARING_EXPR_ANDNOT, &c, &d);
+ * roaring_expr_t root = roaring_expr_op(ROARING_EXPR_OR, &ab, &cd);
+ * roaring_bitmap_t *result = roaring_expr_evaluate(&root);
+ * ```
+ */
+typedef struct roaring_expr_s {
+    roaring_expr_op_t op;
+    const roaring_bitmap_t *bitmap;
+    const struct roaring_expr_s *left;
+    const struct roaring_expr_s *right;
+} roaring_expr_t;
+
+static inline roaring_expr_t roaring_expr_bitmap(const roaring_bitmap_t *r) {
+    roaring_expr_t e;
+    e.op = ROARING_EXPR_BITMAP;
+    e.bitmap = r;
+    e.left = e.right = NULL;
+    return e;
+}
+
+static inline roaring_expr_t roaring_expr_op(roaring_expr_op_t op,
+                                             const roaring_expr_t *left,
+                                             const roaring_expr_t *right) {
+    roaring_expr_t e;
+    e.op = op;
+    e.bitmap = NULL;
+    e.left = left;
+    e.right = right;
+    return e;
+}
+
+/**
+ * Evaluates an expression tree and returns the result as a new bitmap,
+ * without materializing a bitmap per operator. The tree is evaluated one
+ * 16-bit key at a time: only keys that can be in the result are visited (the
+ * keys of both sides of an AND, of the left side of an ANDNOT), the right
+ * side of an AND or ANDNOT is skipped when the left side is empty for that
+ * key, and intermediate containers are updated in place and recycled.
+ *
+ * Returns NULL if the tree is malformed (a NULL bitmap or child, an unknown
+ * operator) or if an allocation fails. Caller is responsible for freeing the
+ * result.
+ */
+roaring_bitmap_t *roaring_expr_evaluate(const roaring_expr_t *expr);
+
 /**
  * Frees the memory.
  */
@@ -393,6 +552,28 @@ bool roaring_bitmap_contains_bulk(const roaring_bitmap_t *r,
                                   roaring_bulk_context_t *context,
                                   uint32_t val);
 
+/**
+ * Tests the membership of the `n` values in `vals` at once: bit `i % 64` of
+ * `out_mask[i / 64]` is set if and only if `vals[i]` is in the bitmap.
+ * `out_mask` must have room for `(n + 63) / 64` words.
+ *
+ * Any order of values is supported, but values with the same "key" (high 16
+ * bits of the value) should be consecutive, and are best sorted, for speed.
+ */
+void roaring_bitmap_contains_many(const roaring_bitmap_t *r,
+                                  const uint32_t *vals, size_t n,
+                                  uint64_t *out_mask);
+
+/**
+ * Copies to `out` the values of `vals` that are in the bitmap, in their
+ * original order, and returns how many there are. `out` must have room for
+ * `n` values; it may be `vals` itself. The same remarks on the order of
+ * values as for `roaring_bitmap_contains_many()` apply.
+ */
+size_t roaring_bitmap_filter_array(const roaring_bitmap_t *r,
+                                   const uint32_t *vals, size_t n,
+                                   uint32_t *out);
+
 /**
  * Get the cardinality of the bitmap (number of elements).
  */
@@ -521,6 +702,71 @@ roaring_bitmap_t *roaring_bitmap_portable_deserialize_safe(const char *buf,
 size_t roaring_bitmap_portable_deserialize_size(const char *buf,
                                                 size_t maxbytes);
 
+/**
+ * Parallel version of `roaring_bitmap_portable_deserialize_safe()`, for large
+ * bitmaps. After a pass over the container headers, the containers are split
+ * into (at most) `partitions` ranges of about the same number of bytes, each
+ * allocated and read by its own task. The tasks are run by `executor`, which
+ * is given `executor_context`; if `executor` is NULL, they run one after the
+ * other on the calling thread.
+ *
+ * Returns NULL if the input is invalid or an allocation fails.
+ */
+roaring_bitmap_t *roaring_bitmap_portable_deserialize_parallel(
+    const char *buf, size_t maxbytes, size_t partitions,
+    roaring_executor executor, void *executor_context);
+
+/**
+ * Incremental decoder of the portable format, for input that arrives in
+ * pieces (sockets, decompressors...). Containers are built as soon as their
+ * bytes arrive, so there is no need to buffer the whole serialized bitmap.
+ * The input is validated as in `roaring_bitmap_portable_deserialize_safe()`.
+ *
+ *     roaring_portable_decoder_t *d = roaring_portable_decoder_create();
+ *     roaring_decoder_status_t status = ROARING_DECODER_NEED_MORE;
+ *     while (status == ROARING_DECODER_NEED_MORE && (n = read(...)) > 0) {
+ *         status = roaring_portable_decoder_feed(d, chunk, n, NULL);
+ *     }
+ *     roaring_bitmap_t *r = roaring_portable_decoder_finish(d);
+ *     roaring_portable_decoder_free(d);
+ */
+typedef struct roaring_portable_decoder_s roaring_portable_decoder_t;
+
+typedef enum roaring_decoder_status_e {
+    ROARING_DECODER_NEED_MORE,  // the bitmap is not complete yet
+    ROARING_DECODER_DONE,       // see `roaring_portable_decoder_finish()`
+    ROARING_DECODER_ERROR       // invalid input or failed allocation
+} roaring_decoder_status_t;
+
+/**
+ * Returns a new decoder, or NULL if the allocation fails. Client is
+ * responsible for calling `roaring_portable_decoder_free()`.
+ */
+roaring_portable_decoder_t *roaring_portable_decoder_create(void);
+
+/**
+ * Frees the decoder, and the partially decoded bitmap if any.
+ */
+void roaring_portable_decoder_free(roaring_portable_decoder_t *d);
+
+/**
+ * Feeds the next `len` bytes of input, of any size. Once the bitmap is
+ * complete, the decoder stops consuming input: `*consumed` (if not NULL) is
+ * set to the number of bytes used, the rest belongs to whatever follows the
+ * bitmap. After an error, the decoder only returns `ROARING_DECODER_ERROR`.
+ */
+roaring_decoder_status_t roaring_portable_decoder_feed(
+    roaring_portable_decoder_t *d, const char *buf, size_t len,
+    size_t *consumed);
+
+/**
+ * Returns the decoded bitmap once `roaring_portable_decoder_feed()` returned
+ * `ROARING_DECODER_DONE`, NULL otherwise. The caller owns the bitmap, and the
+ * decoder is ready for the next one.
+ */
+roaring_bitmap_t *roaring_portable_decoder_finish(
+    roaring_portable_decoder_t *d);
+
 /**
  * How many bytes are required to serialize this bitmap.
  *
@@ -541,6 +787,36 @@ size_t roaring_bitmap_portable_size_in_bytes(const roaring_bitmap_t *r);
  */
 size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *r, char *buf);
 
+/**
+ * Write a bitmap in the same format as `roaring_bitmap_portable_serialize()`,
+ * without materializing it: the output is handed to `writer` in order, a
+ * bounded batch of chunks at a time. Container payloads are passed straight
+ * from the bitmap's memory, so peak memory does not grow with the bitmap.
+ *
+ * Returns how many bytes were written, which matches
+ * `roaring_bitmap_portable_size_in_bytes(r)`, or 0 if `writer` failed.
+ */
+size_t roaring_bitmap_portable_serialize_stream(const roaring_bitmap_t *r,
+                                                roaring_writev_fn writer,
+                                                void *context);
+
+#if ROARING_HAS_WRITEV
+/**
+ * A `roaring_writev_fn` writing to a file descriptor with `writev`;
+ * `context` points to the `int` descriptor. Partial writes and interrupted
+ * calls are retried.
+ */
+bool roaring_fd_writev(void *context, const roaring_iovec_t *iov,
+                       size_t iovcnt);
+
+/**
+ * Streams the portable serialization of the bitmap to a file descriptor, see
+ * `roaring_bitmap_portable_serialize_stream()`. Returns how many bytes were
+ * written, or 0 on an I/O error (with `errno` set).
+ */
+size_t roaring_bitmap_portable_serialize_fd(const roaring_bitmap_t *r, int fd);
+#endif
+
 /*
  * "Frozen" serialization format imitates memory layout of roaring_bitmap_t.
  * Deserialized bitmap is a constant view of the underlying buffer.
@@ -585,6 +861,26 @@ void roaring_bitmap_frozen_serialize(const roaring_bitmap_t *r, char *buf);
 const roaring_bitmap_t *roaring_bitmap_frozen_view(const char *buf,
                                                    size_t length);
 
+/**
+ * Creates constant bitmap that is a view of a buffer written in the portable
+ * format, e.g. by `roaring_bitmap_portable_serialize()` or by the Java and Go
+ * implementations, reading at most `maxbytes` bytes. In case of failure, NULL
+ * is returned.
+ *
+ * Unlike `roaring_bitmap_portable_deserialize_safe()`, the containers are not
+ * copied: only a small index of keys and container headers is allocated, and
+ * the container data is referenced in place. This makes it suitable for
+ * memory-mapped files. No alignment is required of `buf`, but a container
+ * whose data is not naturally aligned in the buffer (8 bytes for bitsets, 2
+ * bytes otherwise) is copied.
+ *
+ * Bitmap returned by this function can be used in all readonly contexts.
+ * Bitmap must be freed as usual, by calling roaring_bitmap_free().
+ * Underlying buffer must not be freed or modified while it backs any bitmaps.
+ */
+const roaring_bitmap_t *roaring_bitmap_portable_deserialize_frozen(
+    const char *buf, size_t maxbytes);
+
 /**
  * Iterate over the bitmap elements. The function iterator is called once for
  * all the values with ptr (can be NULL) as the second parameter of each call.
@@ -604,6 +900,17 @@ bool roaring_iterate(const roaring_bitmap_t *r, roaring_iterator iterator,
 bool roaring_iterate64(const roaring_bitmap_t *r, roaring_iterator64 iterator,
                        uint64_t high_bits, void *ptr);
 
+/**
+ * Calls `visitor` once per container, in increasing key order, with a view
+ * of its raw contents (see `roaring_container_span_t`); shared containers
+ * are unwrapped. This lets callers write their own loops for each container
+ * type (e.g. vectorized) instead of paying for a call per value.
+ *
+ * Returns true if the visitor returned true for every container.
+ */
+bool roaring_visit_containers(const roaring_bitmap_t *r,
+                              roaring_container_visitor visitor, void *ptr);
+
 /**
  * Return true if the two bitmaps contain the same elements.
  */
@@ -722,6 +1029,72 @@ bool roaring_bitmap_select(const roaring_bitmap_t *r, uint32_t rank,
  */
 uint64_t roaring_bitmap_rank(const roaring_bitmap_t *r, uint32_t x);
 
+/**
+ * A rank index holds the running total of the container cardinalities of a
+ * bitmap, so that `roaring_bitmap_select_indexed()`,
+ * `roaring_bitmap_rank_indexed()` and
+ * `roaring_bitmap_range_uint32_array_indexed()` find their container by
+ * binary search instead of summing the cardinalities of all the containers
+ * before it. This helps on bitmaps with many containers, e.g. for deep
+ * pagination.
+ *
+ * The index is a snapshot taken by `roaring_bitmap_rank_index_create()`. It
+ * is neither built lazily nor updated: any modification of the bitmap, even
+ * adding or removing a single value, invalidates it, and it must then be
+ * freed and created again. Each bitmap counts its modifications, so the
+ * indexed functions detect an invalidated index and fail (returning false, or
+ * 0 for `roaring_bitmap_rank_indexed()`); `roaring_rank_index_is_valid()`
+ * tells whether an index can still be used. The counter wraps around after
+ * 2^32 modifications.
+ */
+typedef struct roaring_rank_index_s roaring_rank_index_t;
+
+/**
+ * Creates the rank index of a bitmap, in time linear in the number of
+ * containers. Returns NULL on allocation failure. The caller is responsible
+ * for calling `roaring_rank_index_free()`.
+ */
+roaring_rank_index_t *roaring_bitmap_rank_index_create(
+    const roaring_bitmap_t *r);
+
+/**
+ * Returns true if `index` was created from `r` and `r` was not modified
+ * since.
+ */
+bool roaring_rank_index_is_valid(const roaring_bitmap_t *r,
+                                 const roaring_rank_index_t *index);
+
+/**
+ * Frees a rank index.
+ */
+void roaring_rank_index_free(roaring_rank_index_t *index);
+
+/**
+ * Same as `roaring_bitmap_select()`, using the rank index of `r`. Returns
+ * false if the index is invalid.
+ */
+bool roaring_bitmap_select_indexed(const roaring_bitmap_t *r,
+                                   const roaring_rank_index_t *index,
+                                   uint32_t rank, uint32_t *element);
+
+/**
+ * Same as `roaring_bitmap_rank()`, using the rank index of `r`. Returns 0 if
+ * the index is invalid.
+ */
+uint64_t roaring_bitmap_rank_indexed(const roaring_bitmap_t *r,
+                                     const roaring_rank_index_t *index,
+                                     uint32_t x);
+
+/**
+ * Same as `roaring_bitmap_range_uint32_array()`, using the rank index of `r`
+ * to seek to `offset`. The values are then read directly into `ans`, so this
+ * does not allocate memory. Returns false, without writing to `ans`, if the
+ * index is invalid.
+ */
+bool roaring_bitmap_range_uint32_array_indexed(
+    const roaring_bitmap_t *r, const roaring_rank_index_t *index,
+    size_t offset, size_t limit, uint32_t *ans);
+
 /**
  * Returns the smallest value in the set, or UINT32_MAX if the set is empty.
  */
@@ -850,6 +1223,145 @@ void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it);
 uint32_t roaring_read_uint32_iterator(roaring_uint32_iterator_t *it,
                                       uint32_t* buf, uint32_t count);
 
+/**
+ * Lazy iterators go through the union or the intersection of many bitmaps in
+ * increasing order, computing only the values that are read. Reading the
+ * first N values costs in proportion to N (and to the number of inputs), not
+ * to the size of the inputs:
+ *
+ *     roaring_lazy_iterator_t *it = roaring_lazy_iterator_or_many(n, rs);
+ *     uint32_t top[100];
+ *     uint32_t count = roaring_lazy_iterator_read(it, top, 100);
+ *     roaring_lazy_iterator_free(it);
+ *
+ * They compose: the union or intersection of other lazy iterators is itself
+ * a lazy iterator. Unions merge their inputs with a heap, intersections
+ * leapfrog them with `roaring_lazy_iterator_move_equalorlarger()`. As with
+ * `roaring_uint32_iterator_t`, the bitmaps must not be modified meanwhile.
+ */
+typedef struct roaring_lazy_iterator_s roaring_lazy_iterator_t;
+
+/**
+ * Returns a lazy iterator over the values of a bitmap, or NULL if the
+ * allocation fails. Caller is responsible for calling
+ * `roaring_lazy_iterator_free()`.
+ */
+roaring_lazy_iterator_t *roaring_lazy_iterator_create(
+    const roaring_bitmap_t *r);
+
+/**
+ * Returns a lazy iterator over the union of the (non-NULL) `inputs`, which it
+ * takes ownership of: they are freed along with it, or right away if the
+ * allocation fails (the function then returns NULL).
+ */
+roaring_lazy_iterator_t *roaring_lazy_iterator_or(
+    size_t number, roaring_lazy_iterator_t **inputs);
+
+/**
+ * Returns a lazy iterator over the intersection of the `inputs`, see
+ * `roaring_lazy_iterator_or()`. The first input leads the leapfrog, so it
+ * should be the sparsest one.
+ */
+roaring_lazy_iterator_t *roaring_lazy_iterator_and(
+    size_t number, roaring_lazy_iterator_t **inputs);
+
+/**
+ * Returns a lazy iterator over the union of `number` bitmaps, or NULL if an
+ * allocation fails.
+ */
+roaring_lazy_iterator_t *roaring_lazy_iterator_or_many(
+    size_t number, const roaring_bitmap_t **rs);
+
+/**
+ * Returns a lazy iterator over the intersection of `number` bitmaps (empty if
+ * there are none), or NULL if an allocation fails.
+ */
+roaring_lazy_iterator_t *roaring_lazy_iterator_and_many(
+    size_t number, const roaring_bitmap_t **rs);
+
+/**
+ * Frees the iterator and its inputs.
+ */
+void roaring_lazy_iterator_free(roaring_lazy_iterator_t *it);
+
+/**
+ * Returns true if the iterator points to a value.
+ */
+bool roaring_lazy_iterator_has_value(const roaring_lazy_iterator_t *it);
+
+/**
+ * Returns the value the iterator points to, if it has one.
+ */
+uint32_t roaring_lazy_iterator_value(const roaring_lazy_iterator_t *it);
+
+/**
+ * Moves to the next value. Returns true if there is one.
+ */
+bool roaring_lazy_iterator_advance(roaring_lazy_iterator_t *it);
+
+/**
+ * Moves to the first value >= `val`, never backwards. Returns true if there
+ * is one.
+ */
+bool roaring_lazy_iterator_move_equalorlarger(roaring_lazy_iterator_t *it,
+                                              uint32_t val);
+
+/**
+ * Reads up to `count` values into `buf`, starting with the current one, and
+ * leaves the iterator on the next value, like `roaring_read_uint32_iterator()`.
+ * Returns the number of values read, less than `count` only if the iterator
+ * is drained.
+ */
+uint32_t roaring_lazy_iterator_read(roaring_lazy_iterator_t *it,
+                                    uint32_t *buf, uint32_t count);
+
+/**
+ * Iterate over the bitmap as maximal intervals of consecutive values: the
+ * function iterator is called with each [start, end) in increasing order.
+ * Runs are passed on as they are, bitsets are scanned a word at a time, and
+ * intervals that continue across containers are merged. Far cheaper than
+ * `roaring_iterate()` on bitmaps made of long runs.
+ *
+ * Returns true if the roaring_range_iterator returned true throughout.
+ */
+bool roaring_iterate_ranges(const roaring_bitmap_t *r,
+                            roaring_range_iterator iterator, void *ptr);
+
+/**
+ * Iterator over the maximal intervals of consecutive values of a bitmap,
+ * the pull counterpart of `roaring_iterate_ranges()`:
+ *
+ *     roaring_uint32_range_iterator_t i;
+ *     roaring_init_range_iterator(r, &i);
+ *     while (i.has_value) {
+ *         // values in [i.start, i.end)
+ *         roaring_advance_range_iterator(&i);
+ *     }
+ *
+ * As with `roaring_uint32_iterator_t`, the bitmap must not change meanwhile.
+ */
+typedef struct roaring_uint32_range_iterator_s {
+    const roaring_bitmap_t *parent;  // owner
+    int32_t container_index;  // container where the next interval starts
+    uint32_t position;  // in that container: run index, array index or bit
+
+    bool has_value;
+    uint32_t start;
+    uint64_t end;  // exclusive, may be 2^32
+} roaring_uint32_range_iterator_t;
+
+/**
+ * Initialize the iterator on the first interval of the bitmap, if any, in
+ * which case `it->has_value` is true.
+ */
+void roaring_init_range_iterator(const roaring_bitmap_t *r,
+                                 roaring_uint32_range_iterator_t *it);
+
+/**
+ * Move to the next interval. Returns `it->has_value`.
+ */
+bool roaring_advance_range_iterator(roaring_uint32_range_iterator_t *it);
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace api {
 #endif
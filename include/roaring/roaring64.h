@@ -0,0 +1,355 @@
+/*
+ * A 64-bit Roaring bitmap in C. The upper 48 bits of each value index an
+ * adaptive radix tree whose leaves hold the same containers as the 32-bit
+ * bitmaps, so the container code is shared between both.
+ */
+
+#ifndef ROARING64_H
+#define ROARING64_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <roaring/memory.h>
+#include <roaring/portability.h>
+#include <roaring/roaring_types.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+typedef struct roaring64_bitmap_s roaring64_bitmap_t;
+typedef struct roaring64_iterator_s roaring64_iterator_t;
+
+/**
+ * Dynamically allocates a new bitmap (initially empty).
+ * Returns NULL if the allocation fails.
+ * Client is responsible for calling `roaring64_bitmap_free()`.
+ */
+roaring64_bitmap_t *roaring64_bitmap_create(void);
+
+/**
+ * Frees the bitmap and all of its containers.
+ */
+void roaring64_bitmap_free(roaring64_bitmap_t *r);
+
+/**
+ * Returns a copy of a bitmap, or NULL if an allocation fails.
+ */
+roaring64_bitmap_t *roaring64_bitmap_copy(const roaring64_bitmap_t *r);
+
+/**
+ * Creates a new bitmap from a list of values.
+ */
+roaring64_bitmap_t *roaring64_bitmap_of_ptr(size_t n_args,
+                                            const uint64_t *vals);
+
+/**
+ * Adds the value to the bitmap.
+ */
+void roaring64_bitmap_add(roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Adds the value to the bitmap. Returns true if a new value was added, false
+ * if the value already existed.
+ */
+bool roaring64_bitmap_add_checked(roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Adds `n_args` values from `vals`. This is faster than repeatedly calling
+ * `roaring64_bitmap_add()`, especially when consecutive values share their
+ * upper 48 bits.
+ */
+void roaring64_bitmap_add_many(roaring64_bitmap_t *r, size_t n_args,
+                               const uint64_t *vals);
+
+/**
+ * Adds all values in the closed interval [min, max].
+ */
+void roaring64_bitmap_add_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                       uint64_t max);
+
+/**
+ * Removes a value from the bitmap if present.
+ */
+void roaring64_bitmap_remove(roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Removes a value from the bitmap if present, returns true if the value was
+ * removed and false if the value was not present.
+ */
+bool roaring64_bitmap_remove_checked(roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Removes all values in the closed interval [min, max].
+ */
+void roaring64_bitmap_remove_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                          uint64_t max);
+
+/**
+ * Returns true if the provided value is present.
+ */
+bool roaring64_bitmap_contains(const roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Returns the number of values in the bitmap.
+ */
+uint64_t roaring64_bitmap_get_cardinality(const roaring64_bitmap_t *r);
+
+/**
+ * Returns true if the bitmap is empty.
+ */
+bool roaring64_bitmap_is_empty(const roaring64_bitmap_t *r);
+
+/**
+ * Returns the smallest value in the set, or UINT64_MAX if the set is empty.
+ */
+uint64_t roaring64_bitmap_minimum(const roaring64_bitmap_t *r);
+
+/**
+ * Returns the largest value in the set, or 0 if empty.
+ */
+uint64_t roaring64_bitmap_maximum(const roaring64_bitmap_t *r);
+
+/**
+ * Returns the number of integers that are smaller or equal to `val`.
+ */
+uint64_t roaring64_bitmap_rank(const roaring64_bitmap_t *r, uint64_t val);
+
+/**
+ * Selects the element at index `rank` where the smallest element is at index
+ * 0. If the size of the bitmap is strictly greater than rank, then this
+ * function returns true and sets element to the element of given rank.
+ * Otherwise, it returns false.
+ */
+bool roaring64_bitmap_select(const roaring64_bitmap_t *r, uint64_t rank,
+                             uint64_t *element);
+
+/**
+ * Converts containers to run containers where that saves space. Returns true
+ * if the result has at least one run container.
+ */
+bool roaring64_bitmap_run_optimize(roaring64_bitmap_t *r);
+
+/**
+ * Returns the number of bytes used by the bitmap in memory.
+ */
+size_t roaring64_bitmap_size_in_bytes(const roaring64_bitmap_t *r);
+
+/**
+ * Returns true if the two bitmaps contain the same elements.
+ */
+bool roaring64_bitmap_equals(const roaring64_bitmap_t *r1,
+                             const roaring64_bitmap_t *r2);
+
+/**
+ * Returns true if all the elements of r1 are also in r2.
+ */
+bool roaring64_bitmap_is_subset(const roaring64_bitmap_t *r1,
+                                const roaring64_bitmap_t *r2);
+
+/**
+ * Computes the intersection between two bitmaps and returns new bitmap. The
+ * caller is responsible for free-ing the result.
+ */
+roaring64_bitmap_t *roaring64_bitmap_and(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2);
+
+/**
+ * Computes the size of the intersection between two bitmaps.
+ */
+uint64_t roaring64_bitmap_and_cardinality(const roaring64_bitmap_t *r1,
+                                          const roaring64_bitmap_t *r2);
+
+/**
+ * In-place version of `roaring64_bitmap_and()`, modifies `r1`.
+ */
+void roaring64_bitmap_and_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2);
+
+/**
+ * Computes the union between two bitmaps and returns new bitmap. The caller is
+ * responsible for free-ing the result.
+ */
+roaring64_bitmap_t *roaring64_bitmap_or(const roaring64_bitmap_t *r1,
+                                        const roaring64_bitmap_t *r2);
+
+/**
+ * In-place version of `roaring64_bitmap_or()`, modifies `r1`.
+ */
+void roaring64_bitmap_or_inplace(roaring64_bitmap_t *r1,
+                                 const roaring64_bitmap_t *r2);
+
+/**
+ * Computes the symmetric difference (xor) between two bitmaps and returns a
+ * new bitmap. The caller is responsible for free-ing the result.
+ */
+roaring64_bitmap_t *roaring64_bitmap_xor(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2);
+
+/**
+ * In-place version of `roaring64_bitmap_xor()`, modifies `r1`. `r1` and `r2`
+ * must be distinct bitmaps.
+ */
+void roaring64_bitmap_xor_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2);
+
+/**
+ * Computes the difference (andnot) between two bitmaps and returns a new
+ * bitmap. The caller is responsible for free-ing the result.
+ */
+roaring64_bitmap_t *roaring64_bitmap_andnot(const roaring64_bitmap_t *r1,
+                                            const roaring64_bitmap_t *r2);
+
+/**
+ * In-place version of `roaring64_bitmap_andnot()`, modifies `r1`. `r1` and
+ * `r2` must be distinct bitmaps.
+ */
+void roaring64_bitmap_andnot_inplace(roaring64_bitmap_t *r1,
+                                     const roaring64_bitmap_t *r2);
+
+/**
+ * Iterate over the bitmap elements in increasing order. The function
+ * `iterator` is called once for all the values with `ptr` (can be NULL) as the
+ * second parameter of each call.
+ *
+ * Returns true if the iterator returned true throughout (so that all data
+ * points were necessarily visited).
+ */
+bool roaring64_bitmap_iterate(const roaring64_bitmap_t *r,
+                              roaring_iterator64 iterator, void *ptr);
+
+/**
+ * Convert the bitmap to a sorted array `out`.
+ *
+ * Caller is responsible to ensure that there is enough memory allocated, e.g.
+ * ```
+ * out = malloc(roaring64_bitmap_get_cardinality(bitmap) * sizeof(uint64_t));
+ * ```
+ */
+void roaring64_bitmap_to_uint64_array(const roaring64_bitmap_t *r,
+                                      uint64_t *out);
+
+/**
+ * How many bytes are required to serialize this bitmap in the portable format
+ * shared with `Roaring64Map`.
+ */
+size_t roaring64_bitmap_portable_size_in_bytes(const roaring64_bitmap_t *r);
+
+/**
+ * Write a bitmap to a buffer in the portable format shared with
+ * `Roaring64Map`: the number of 32-bit buckets as a uint64, then for each
+ * bucket its upper 32 bits as a uint32 followed by a portable 32-bit bitmap.
+ * Returns how many bytes were written, which is
+ * `roaring64_bitmap_portable_size_in_bytes()`.
+ */
+size_t roaring64_bitmap_portable_serialize(const roaring64_bitmap_t *r,
+                                           char *buf);
+
+/**
+ * Write a bitmap in the same format as `roaring64_bitmap_portable_serialize()`
+ * through `writer`, a bounded batch of chunks at a time, with container
+ * payloads passed straight from the bitmap's memory. Returns how many bytes
+ * were written, or 0 if `writer` failed. See
+ * `roaring_bitmap_portable_serialize_stream()`; `roaring_fd_writev` writes to
+ * a file descriptor.
+ */
+size_t roaring64_bitmap_portable_serialize_stream(const roaring64_bitmap_t *r,
+                                                  roaring_writev_fn writer,
+                                                  void *context);
+
+/**
+ * Read a bitmap written by `roaring64_bitmap_portable_serialize()` or
+ * `Roaring64Map::write()`, reading at most `maxbytes` bytes. Returns NULL if
+ * the input is invalid or truncated, or if an allocation fails.
+ */
+roaring64_bitmap_t *roaring64_bitmap_portable_deserialize_safe(
+    const char *buf, size_t maxbytes);
+
+/**
+ * Create an iterator object that can be used to iterate through the values.
+ * If there is a value, then this iterator points to the first value and
+ * `roaring64_iterator_has_value()` returns true. Returns NULL if the
+ * allocation fails. The caller is responsible for calling
+ * `roaring64_iterator_free()`.
+ *
+ * As with `roaring_uint32_iterator_t`, modifying the bitmap invalidates the
+ * iterator.
+ */
+roaring64_iterator_t *roaring64_iterator_create(const roaring64_bitmap_t *r);
+
+/**
+ * Like `roaring64_iterator_create()`, but the iterator points to the last
+ * value.
+ */
+roaring64_iterator_t *roaring64_iterator_create_last(
+    const roaring64_bitmap_t *r);
+
+/**
+ * Re-initializes an existing iterator to point to the first value of `r`.
+ */
+void roaring64_iterator_reinit(const roaring64_bitmap_t *r,
+                               roaring64_iterator_t *it);
+
+/**
+ * Creates a copy of the iterator, or returns NULL if the allocation fails.
+ * The caller is responsible for calling `roaring64_iterator_free()` on it.
+ */
+roaring64_iterator_t *roaring64_iterator_copy(const roaring64_iterator_t *it);
+
+/**
+ * Free the iterator.
+ */
+void roaring64_iterator_free(roaring64_iterator_t *it);
+
+/**
+ * Returns true if the iterator currently points to a value.
+ */
+bool roaring64_iterator_has_value(const roaring64_iterator_t *it);
+
+/**
+ * Returns the value the iterator currently points to. Only valid if
+ * `roaring64_iterator_has_value()` returns true.
+ */
+uint64_t roaring64_iterator_value(const roaring64_iterator_t *it);
+
+/**
+ * Advance the iterator. Returns true if there is a new value. Advancing an
+ * iterator that points before the first value moves it to the first value.
+ */
+bool roaring64_iterator_advance(roaring64_iterator_t *it);
+
+/**
+ * Decrement the iterator. Returns true if there is a new value. Decrementing
+ * an iterator that points past the last value moves it to the last value.
+ */
+bool roaring64_iterator_previous(roaring64_iterator_t *it);
+
+/**
+ * Move the iterator to the first value >= `val`. Returns true if there is
+ * such a value.
+ */
+bool roaring64_iterator_move_equalorlarger(roaring64_iterator_t *it,
+                                           uint64_t val);
+
+/**
+ * Reads up to `count` values from the iterator into `buf`, starting with the
+ * current value. Returns the number of values read, which is smaller than
+ * `count` only when the iterator is exhausted. After the call the iterator
+ * points to the value following the last one read.
+ */
+uint64_t roaring64_iterator_read(roaring64_iterator_t *it, uint64_t *buf,
+                                 uint64_t count);
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
+
+#endif  /* ROARING64_H */
+
+#ifdef __cplusplus
+    #if !defined(ROARING_API_NOT_IN_GLOBAL_NAMESPACE)
+        using namespace ::roaring::api;
+    #endif
+#endif
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <roaring/containers/containers.h>  // get_writable_copy_if_shared()
 #include <roaring/array_util.h>
@@ -13,6 +14,9 @@ extern "C" { namespace roaring {
 
 // Note: in pure C++ code, you should avoid putting `using` in header files
 using api::roaring_array_t;
+using api::roaring_executor;
+using api::roaring_iovec_t;
+using api::roaring_writev_fn;
 
 namespace internal {
 #endif
@@ -210,6 +214,107 @@ bool ra_range_uint32_array(const roaring_array_t *ra, size_t offset, size_t limi
  */
 size_t ra_portable_serialize(const roaring_array_t *ra, char *buf);
 
+enum {
+    RA_STREAM_MAX_IOV = 64,
+    RA_STREAM_STAGING_BYTES = 4096
+};
+
+/**
+ * State of a streaming serialization: a batch of at most RA_STREAM_MAX_IOV
+ * chunks handed to the writer at once. Container payloads are referenced in
+ * place, small header fields are copied to the staging buffer.
+ */
+typedef struct ra_stream_s {
+    roaring_writev_fn writer;
+    void *context;
+    size_t iovcnt;
+    size_t staged;   // bytes of staging in use
+    size_t written;  // total bytes queued so far
+    bool failed;
+    roaring_iovec_t iov[RA_STREAM_MAX_IOV];
+    char staging[RA_STREAM_STAGING_BYTES];
+} ra_stream_t;
+
+void ra_stream_init(ra_stream_t *s, roaring_writev_fn writer, void *context);
+
+/**
+ * Queues a copy of len bytes, which may be reused as soon as this returns.
+ */
+void ra_stream_copy(ra_stream_t *s, const void *data, size_t len);
+
+/**
+ * Queues a reference to len bytes, which must stay valid until the next
+ * ra_stream_flush.
+ */
+void ra_stream_ref(ra_stream_t *s, const void *data, size_t len);
+
+/**
+ * Hands the queued chunks to the writer. Returns false if this or any earlier
+ * write failed.
+ */
+bool ra_stream_flush(ra_stream_t *s);
+
+/**
+ * Queues the same bytes as ra_portable_serialize, in chunks, without
+ * flushing. Check s->failed or the result of ra_stream_flush afterwards.
+ */
+void ra_portable_serialize_stream(const roaring_array_t *ra, ra_stream_t *s);
+
+/**
+ * Header of a portable bitmap, as read by ra_portable_header_parse(). The
+ * run flags and the keys and cardinalities point into the serialized bytes,
+ * which need not be aligned: read them with the accessors below.
+ */
+typedef struct ra_portable_header_s {
+    int32_t size;           // number of containers
+    const char *run_flags;  // one bit per container, NULL without runs
+    const char *keyscards;  // key and cardinality - 1 of each container
+    size_t bytes;           // length of the header: the containers follow
+} ra_portable_header_t;
+
+/**
+ * Parses the header of a portable bitmap from the first `maxbytes` bytes of
+ * `buf`: the cookie, the number of containers, the run flags, the keys and
+ * cardinalities, and the container offsets, which are skipped (they are not
+ * written below NO_OFFSET_THRESHOLD containers when there are runs).
+ * Returns false if the header is invalid, in which case header->bytes is 0,
+ * or if it does not fit in `maxbytes`, in which case header->bytes is the
+ * number of bytes needed to go on, so that a streaming reader knows how much
+ * more to read.
+ */
+bool ra_portable_header_parse(const char *buf, size_t maxbytes,
+                              ra_portable_header_t *header);
+
+static inline uint16_t ra_portable_header_key(
+        const ra_portable_header_t *header, int32_t k) {
+    uint16_t key;
+    memcpy(&key, header->keyscards + 4 * (size_t)k, sizeof(key));
+    return key;
+}
+
+static inline uint32_t ra_portable_header_card(
+        const ra_portable_header_t *header, int32_t k) {
+    uint16_t card_minus_one;
+    memcpy(&card_minus_one, header->keyscards + 4 * (size_t)k + 2,
+           sizeof(card_minus_one));
+    return card_minus_one + UINT32_C(1);
+}
+
+/**
+ * Type of container k once read: a run if its run flag is set, otherwise a
+ * bitset or an array depending on its cardinality.
+ */
+static inline uint8_t ra_portable_header_typecode(
+        const ra_portable_header_t *header, int32_t k) {
+    if (header->run_flags != NULL &&
+        (header->run_flags[k / 8] & (1 << (k % 8))) != 0) {
+        return RUN_CONTAINER_TYPE;
+    }
+    return ra_portable_header_card(header, k) > DEFAULT_MAX_SIZE
+               ? BITSET_CONTAINER_TYPE
+               : ARRAY_CONTAINER_TYPE;
+}
+
 /**
  * read a bitmap from a serialized version. This is meant to be compatible
  * with the Java and Go versions.
@@ -220,6 +325,17 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf);
  */
 bool ra_portable_deserialize(roaring_array_t *ra, const char *buf, const size_t maxbytes, size_t * readbytes);
 
+/**
+ * Same as ra_portable_deserialize, but the containers are allocated and read
+ * by (at most) `partitions` tasks run by `executor` (sequentially if it is
+ * NULL), each handling a range of about the same number of bytes.
+ */
+bool ra_portable_deserialize_parallel(roaring_array_t *ra, const char *buf,
+                                      const size_t maxbytes, size_t *readbytes,
+                                      size_t partitions,
+                                      roaring_executor executor,
+                                      void *executor_context);
+
 /**
  * Quickly checks whether there is a serialized bitmap at the pointer,
  * not exceeding size "maxbytes" in bytes. This function does not allocate
@@ -259,6 +375,14 @@ static inline void ra_unshare_container_at_index(roaring_array_t *ra,
                                                     &ra->typecodes[i]);
 }
 
+/**
+ * Records that the content of the array may have changed, so that snapshots
+ * such as rank indexes can tell they are stale.
+ */
+static inline void ra_bump_version(roaring_array_t *ra) {
+    ra->version++;
+}
+
 /**
  * remove at index i, sliding over all entries after i
  */
@@ -0,0 +1,144 @@
+/*
+ * A bit-sliced index (BSI) mapping 32-bit rows to unsigned integer values,
+ * stored as one roaring bitmap per bit of the values. Range predicates and
+ * aggregations restricted to a set of rows are answered with a few bitmap
+ * operations per bit instead of a scan of the values.
+ */
+
+#ifndef ROARING_BSI_H
+#define ROARING_BSI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <roaring/roaring.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+typedef struct roaring_bsi_s roaring_bsi_t;
+
+/**
+ * Comparisons supported by `roaring_bsi_compare()`.
+ */
+typedef enum roaring_bsi_op_e {
+    ROARING_BSI_LT,
+    ROARING_BSI_LE,
+    ROARING_BSI_EQ,
+    ROARING_BSI_NEQ,
+    ROARING_BSI_GE,
+    ROARING_BSI_GT
+} roaring_bsi_op_t;
+
+/**
+ * Dynamically allocates a new index (initially empty). Returns NULL if the
+ * allocation fails. Client is responsible for calling `roaring_bsi_free()`.
+ */
+roaring_bsi_t *roaring_bsi_create(void);
+
+/**
+ * Frees the index and all of its bitmaps.
+ */
+void roaring_bsi_free(roaring_bsi_t *bsi);
+
+/**
+ * Sets the value of a row, replacing its previous value if any.
+ */
+void roaring_bsi_set(roaring_bsi_t *bsi, uint32_t row, uint64_t value);
+
+/**
+ * Sets the values of `n` rows at once: `values[i]` becomes the value of
+ * `rows[i]`, replacing its previous value if any. The rows must be distinct.
+ * This is much faster than repeatedly calling `roaring_bsi_set()`.
+ */
+void roaring_bsi_set_many(roaring_bsi_t *bsi, size_t n, const uint32_t *rows,
+                          const uint64_t *values);
+
+/**
+ * Returns true and sets `*value` if the row has a value, false otherwise.
+ */
+bool roaring_bsi_get(const roaring_bsi_t *bsi, uint32_t row, uint64_t *value);
+
+/**
+ * Removes the value of a row if present.
+ */
+void roaring_bsi_remove(roaring_bsi_t *bsi, uint32_t row);
+
+/**
+ * Returns the rows that have a value. The bitmap belongs to the index and is
+ * only valid until the index is modified.
+ */
+const roaring_bitmap_t *roaring_bsi_rows(const roaring_bsi_t *bsi);
+
+/**
+ * Returns the number of bits of the largest value stored so far, which is the
+ * number of bitmaps ("slices") in the index.
+ */
+uint32_t roaring_bsi_bit_depth(const roaring_bsi_t *bsi);
+
+/**
+ * Returns the rows of `found_set` whose value compares to `value` with `op`,
+ * e.g. the rows with a value < 10 for `ROARING_BSI_LT`. Rows without a value
+ * never match. If `found_set` is NULL, all rows are considered.
+ *
+ * Returns NULL if an allocation fails. Caller is responsible for freeing the
+ * result.
+ */
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi,
+                                      roaring_bsi_op_t op, uint64_t value,
+                                      const roaring_bitmap_t *found_set);
+
+/**
+ * Returns the rows of `found_set` whose value is in the closed interval
+ * [min, max]. See `roaring_bsi_compare()`.
+ */
+roaring_bitmap_t *roaring_bsi_range(const roaring_bsi_t *bsi, uint64_t min,
+                                    uint64_t max,
+                                    const roaring_bitmap_t *found_set);
+
+/**
+ * Returns the sum (modulo 2^64) of the values of the rows of `found_set`, and
+ * sets `*count` to the number of those rows that have a value if `count` is
+ * not NULL. If `found_set` is NULL, all rows are considered.
+ */
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *found_set, uint64_t *count);
+
+/**
+ * Sets `*value` to the smallest value of the rows of `found_set` (all rows if
+ * NULL). Returns false if none of these rows has a value.
+ */
+bool roaring_bsi_min(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *found_set, uint64_t *value);
+
+/**
+ * Sets `*value` to the largest value of the rows of `found_set` (all rows if
+ * NULL). Returns false if none of these rows has a value.
+ */
+bool roaring_bsi_max(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *found_set, uint64_t *value);
+
+/**
+ * Returns the `k` rows of `found_set` (all rows if NULL) with the largest
+ * values, or all of them if there are fewer than `k`. Among rows with the same
+ * value, those with the smallest row numbers are kept.
+ *
+ * Returns NULL if an allocation fails. Caller is responsible for freeing the
+ * result.
+ */
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi, uint64_t k,
+                                    const roaring_bitmap_t *found_set);
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
+
+#endif  /* ROARING_BSI_H */
+
+#ifdef __cplusplus
+    #if !defined(ROARING_API_NOT_IN_GLOBAL_NAMESPACE)
+        using namespace ::roaring::api;
+    #endif
+#endif
@@ -6,6 +6,7 @@
 #define ROARING_TYPES_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -36,6 +37,7 @@ extern "C" { namespace roaring { namespace api {
 
 #define ROARING_FLAG_COW UINT8_C(0x1)
 #define ROARING_FLAG_FROZEN UINT8_C(0x2)
+#define ROARING_FLAG_ADAPTIVE UINT8_C(0x4)
 
 /**
  * Roaring arrays are array-based key-value pairs having containers as values
@@ -54,12 +56,103 @@ typedef struct roaring_array_s {
     uint16_t *keys;
     uint8_t *typecodes;
     uint8_t flags;
+    uint32_t version;  // bumped by every modification, see rank indexes
 } roaring_array_t;
 
 
 typedef bool (*roaring_iterator)(uint32_t value, void *param);
 typedef bool (*roaring_iterator64)(uint64_t value, void *param);
 
+/**
+ * Receives the interval [start, end) of consecutive values; `end` may be
+ * 2^32, hence the 64 bits.
+ */
+typedef bool (*roaring_range_iterator)(uint32_t start, uint64_t end,
+                                       void *param);
+
+/**
+ * A run of consecutive values [value, value + length], laid out like the
+ * runs of run containers.
+ */
+typedef struct roaring_rle16_s {
+    uint16_t value;
+    uint16_t length;
+} roaring_rle16_t;
+
+typedef enum roaring_span_type_e {
+    ROARING_SPAN_BITSET = 1,
+    ROARING_SPAN_ARRAY = 2,
+    ROARING_SPAN_RUN = 3
+} roaring_span_type_t;
+
+/**
+ * Read-only view of one container of a bitmap: the values `key << 16 | low`
+ * for the 16-bit `low` values held by the container. Exactly one of the
+ * pointers is set, depending on `type`:
+ *
+ * - ROARING_SPAN_BITSET: `words` has 1024 words, bit `low` is set for each
+ *   value (`length` is 1024);
+ * - ROARING_SPAN_ARRAY: `array` holds `length` sorted values;
+ * - ROARING_SPAN_RUN: `runs` holds `length` sorted, disjoint runs.
+ *
+ * The spans point into the bitmap and are only valid while it is unchanged.
+ */
+typedef struct roaring_container_span_s {
+    uint16_t key;
+    roaring_span_type_t type;
+    uint32_t cardinality;
+    uint32_t length;
+    const uint64_t *words;
+    const uint16_t *array;
+    const roaring_rle16_t *runs;
+} roaring_container_span_t;
+
+typedef bool (*roaring_container_visitor)(const roaring_container_span_t *span,
+                                          void *param);
+
+/**
+ * A unit of work handed to a `roaring_executor`: processes part `index`.
+ */
+typedef void (*roaring_task)(void *arg, size_t index);
+
+/**
+ * Runs `task(arg, i)` for every i in [0, count), possibly concurrently (for
+ * instance on a thread pool), and returns once all the calls have returned.
+ * `context` is passed through unchanged from the caller. The tasks touch
+ * disjoint data, so they can run in any order.
+ */
+typedef void (*roaring_executor)(void *context, roaring_task task, void *arg,
+                                 size_t count);
+
+/**
+ * A chunk of serialized output: `len` bytes starting at `base`. The layout
+ * matches POSIX `struct iovec` field for field.
+ */
+typedef struct roaring_iovec_s {
+    const void *base;
+    size_t len;
+} roaring_iovec_t;
+
+/**
+ * Receives the next `iovcnt` chunks of a streaming serialization, to be
+ * written in order (e.g. with a single `writev`). The chunks may point into
+ * the bitmap's own memory and are only valid for the duration of the call.
+ * `context` is passed through unchanged from the caller. Returns false to
+ * abort the serialization.
+ */
+typedef bool (*roaring_writev_fn)(void *context, const roaring_iovec_t *iov,
+                                  size_t iovcnt);
+
+/**
+ * Set when the file descriptor writers, built on POSIX `writev`, are
+ * available.
+ */
+#if defined(__unix__) || defined(__APPLE__)
+#define ROARING_HAS_WRITEV 1
+#else
+#define ROARING_HAS_WRITEV 0
+#endif
+
 /**
 *  (For advanced users.)
 * The roaring_statistics_t can be used to collect detailed statistics about
@@ -987,7 +987,9 @@ size_t union_uint16(const uint16_t *set_1, size_t size_1, const uint16_t *set_2,
     size_t pos = 0, idx_1 = 0, idx_2 = 0;
 
     if (0 == size_2) {
-        memmove(buffer, set_1, size_1 * sizeof(uint16_t));
+        if (0 != size_1) {
+            memmove(buffer, set_1, size_1 * sizeof(uint16_t));
+        }
         return size_1;
     }
     if (0 == size_1) {
@@ -1763,6 +1765,288 @@ CROARING_UNTARGET_REGION
 
 #endif  // CROARING_IS_X64
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/**
+ * Start of the AVX-512 16-bit array code
+ *
+ * These kernels work on blocks of 32 uint16 values (one ZMM register). Union
+ * and XOR merge blocks with a bitonic network. Results are packed with
+ * VPCOMPRESSW and written with a masked store, so the output never needs
+ * slack beyond the actual result.
+ */
+
+// lane indices for reversing a vector of 32 uint16 values
+static const uint16_t avx512_reverse16_idx[32] = {
+    31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16,
+    15, 14, 13, 12, 11, 10, 9,  8,  7,  6,  5,  4,  3,  2,  1,  0};
+
+// lane indices for shifting newval up by one (resp. two) lanes, pulling the
+// last lane(s) of old in at the bottom, used with _mm512_permutex2var_epi16
+static const uint16_t avx512_shift1_idx[32] = {
+    63, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30};
+static const uint16_t avx512_shift2_idx[32] = {
+    62, 63, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13,
+    14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29};
+
+CROARING_TARGET_AVX512
+// writes the lanes of v selected by mask contiguously to out, returns how
+// many values were written
+static inline int avx512_store_compressed16(__m512i v, __mmask32 mask,
+                                            uint16_t *out) {
+    int n = _mm_popcnt_u32(mask);
+    _mm512_mask_storeu_epi16(out, (__mmask32)((UINT64_C(1) << n) - 1),
+                             _mm512_maskz_compress_epi16(mask, v));
+    return n;
+}
+
+// one step of a bitonic merge: compare each lane with the lane at distance
+// d, keeping the minimum in the lower lane
+#define AVX512_BITONIC_STEP(x, shuffled, highlanes)                   \
+    x = _mm512_mask_blend_epi16(highlanes, _mm512_min_epu16(x, shuffled), \
+                                _mm512_max_epu16(x, shuffled))
+
+// sorts a bitonic sequence of 32 values
+//
+// The shuffles and rotates below use their zero-masked forms with a full
+// mask: GCC 12 implements the unmasked ones on top of _mm512_undefined_*(),
+// which trips -Wmaybe-uninitialized, and both compile to the same instruction.
+static inline __m512i avx512_bitonic_clean16(__m512i x) {
+    __m512i p;
+    p = _mm512_maskz_shuffle_i64x2(0xFF, x, x, _MM_SHUFFLE(1, 0, 3, 2));
+    AVX512_BITONIC_STEP(x, p, 0xFFFF0000);
+    p = _mm512_maskz_shuffle_i64x2(0xFF, x, x, _MM_SHUFFLE(2, 3, 0, 1));
+    AVX512_BITONIC_STEP(x, p, 0xFF00FF00);
+    p = _mm512_maskz_shuffle_epi32(0xFFFF, x, _MM_PERM_BADC);
+    AVX512_BITONIC_STEP(x, p, 0xF0F0F0F0);
+    p = _mm512_maskz_shuffle_epi32(0xFFFF, x, _MM_PERM_CDAB);
+    AVX512_BITONIC_STEP(x, p, 0xCCCCCCCC);
+    p = _mm512_maskz_rol_epi32(0xFFFF, x, 16);
+    AVX512_BITONIC_STEP(x, p, 0xAAAAAAAA);
+    return x;
+}
+#undef AVX512_BITONIC_STEP
+
+// Assuming that vInput1 and vInput2 are sorted, produces a sorted output going
+// from vecMin all the way to vecMax (the AVX-512 counterpart of sse_merge)
+static inline void avx512_merge(__m512i vInput1, __m512i vInput2,
+                                __m512i *vecMin, __m512i *vecMax) {
+    __m512i rev = _mm512_loadu_si512((const void *)avx512_reverse16_idx);
+    __m512i reversed = _mm512_permutexvar_epi16(rev, vInput2);
+    *vecMin = avx512_bitonic_clean16(_mm512_min_epu16(vInput1, reversed));
+    *vecMax = avx512_bitonic_clean16(_mm512_max_epu16(vInput1, reversed));
+}
+
+// write vector new, while omitting repeated values assuming that previously
+// written vector was "old"
+static inline int avx512_store_unique(__m512i old, __m512i newval,
+                                      uint16_t *output) {
+    __m512i shift1 = _mm512_loadu_si512((const void *)avx512_shift1_idx);
+    __m512i vecTmp = _mm512_permutex2var_epi16(newval, shift1, old);
+    __mmask32 repeated = _mm512_cmpeq_epi16_mask(vecTmp, newval);
+    return avx512_store_compressed16(newval, ~repeated, output);
+}
+
+// conditionally stores the last value of old as well as all but the last
+// value of newval, skipping values that appear twice
+static inline int avx512_store_unique_xor(__m512i old, __m512i newval,
+                                          uint16_t *output) {
+    __m512i shift1 = _mm512_loadu_si512((const void *)avx512_shift1_idx);
+    __m512i shift2 = _mm512_loadu_si512((const void *)avx512_shift2_idx);
+    __m512i vecTmp1 = _mm512_permutex2var_epi16(newval, shift2, old);
+    __m512i vecTmp2 = _mm512_permutex2var_epi16(newval, shift1, old);
+    __mmask32 equalleft = _mm512_cmpeq_epi16_mask(vecTmp2, vecTmp1);
+    __mmask32 equalright = _mm512_cmpeq_epi16_mask(vecTmp2, newval);
+    return avx512_store_compressed16(vecTmp2, ~(equalleft | equalright),
+                                     output);
+}
+
+// a one-pass AVX-512 union algorithm
+// This function may not be safe if array1 == output or array2 == output.
+uint32_t union_vector16_avx512(const uint16_t *__restrict__ array1,
+                               uint32_t length1,
+                               const uint16_t *__restrict__ array2,
+                               uint32_t length2,
+                               uint16_t *__restrict__ output) {
+    if ((length1 < 32) || (length2 < 32)) {
+        return (uint32_t)union_uint16(array1, length1, array2, length2, output);
+    }
+    __m512i vA, vB, V, vecMin, vecMax;
+    __m512i laststore;
+    uint16_t *initoutput = output;
+    uint32_t len1 = length1 / 32;
+    uint32_t len2 = length2 / 32;
+    uint32_t pos1 = 0;
+    uint32_t pos2 = 0;
+    // we start the machine
+    vA = _mm512_loadu_si512((const void *)(array1 + 32 * pos1));
+    pos1++;
+    vB = _mm512_loadu_si512((const void *)(array2 + 32 * pos2));
+    pos2++;
+    avx512_merge(vA, vB, &vecMin, &vecMax);
+    laststore = _mm512_set1_epi16(-1);
+    output += avx512_store_unique(laststore, vecMin, output);
+    laststore = vecMin;
+    if ((pos1 < len1) && (pos2 < len2)) {
+        uint16_t curA, curB;
+        curA = array1[32 * pos1];
+        curB = array2[32 * pos2];
+        while (true) {
+            if (curA <= curB) {
+                V = _mm512_loadu_si512((const void *)(array1 + 32 * pos1));
+                pos1++;
+                if (pos1 < len1) {
+                    curA = array1[32 * pos1];
+                } else {
+                    break;
+                }
+            } else {
+                V = _mm512_loadu_si512((const void *)(array2 + 32 * pos2));
+                pos2++;
+                if (pos2 < len2) {
+                    curB = array2[32 * pos2];
+                } else {
+                    break;
+                }
+            }
+            avx512_merge(V, vecMax, &vecMin, &vecMax);
+            output += avx512_store_unique(laststore, vecMin, output);
+            laststore = vecMin;
+        }
+        avx512_merge(V, vecMax, &vecMin, &vecMax);
+        output += avx512_store_unique(laststore, vecMin, output);
+        laststore = vecMin;
+    }
+    // we finish the rest off using a scalar algorithm
+    //
+    // copy the small end on a tmp buffer
+    uint32_t len = (uint32_t)(output - initoutput);
+    uint16_t buffer[64];
+    uint32_t leftoversize = avx512_store_unique(laststore, vecMax, buffer);
+    if (pos1 == len1) {
+        memcpy(buffer + leftoversize, array1 + 32 * pos1,
+               (length1 - 32 * len1) * sizeof(uint16_t));
+        leftoversize += length1 - 32 * len1;
+        qsort(buffer, leftoversize, sizeof(uint16_t), uint16_compare);
+
+        leftoversize = unique(buffer, leftoversize);
+        len += (uint32_t)union_uint16(buffer, leftoversize, array2 + 32 * pos2,
+                                      length2 - 32 * pos2, output);
+    } else {
+        memcpy(buffer + leftoversize, array2 + 32 * pos2,
+               (length2 - 32 * len2) * sizeof(uint16_t));
+        leftoversize += length2 - 32 * len2;
+        qsort(buffer, leftoversize, sizeof(uint16_t), uint16_compare);
+        leftoversize = unique(buffer, leftoversize);
+        len += (uint32_t)union_uint16(buffer, leftoversize, array1 + 32 * pos1,
+                                      length1 - 32 * pos1, output);
+    }
+    return len;
+}
+
+// a one-pass AVX-512 xor algorithm
+uint32_t xor_vector16_avx512(const uint16_t *__restrict__ array1,
+                             uint32_t length1,
+                             const uint16_t *__restrict__ array2,
+                             uint32_t length2,
+                             uint16_t *__restrict__ output) {
+    if ((length1 < 32) || (length2 < 32)) {
+        return xor_uint16(array1, length1, array2, length2, output);
+    }
+    __m512i vA, vB, V, vecMin, vecMax;
+    __m512i laststore;
+    uint16_t *initoutput = output;
+    uint32_t len1 = length1 / 32;
+    uint32_t len2 = length2 / 32;
+    uint32_t pos1 = 0;
+    uint32_t pos2 = 0;
+    // we start the machine
+    vA = _mm512_loadu_si512((const void *)(array1 + 32 * pos1));
+    pos1++;
+    vB = _mm512_loadu_si512((const void *)(array2 + 32 * pos2));
+    pos2++;
+    avx512_merge(vA, vB, &vecMin, &vecMax);
+    laststore = _mm512_set1_epi16(-1);
+    uint16_t buffer[65];
+    output += avx512_store_unique_xor(laststore, vecMin, output);
+
+    laststore = vecMin;
+    if ((pos1 < len1) && (pos2 < len2)) {
+        uint16_t curA, curB;
+        curA = array1[32 * pos1];
+        curB = array2[32 * pos2];
+        while (true) {
+            if (curA <= curB) {
+                V = _mm512_loadu_si512((const void *)(array1 + 32 * pos1));
+                pos1++;
+                if (pos1 < len1) {
+                    curA = array1[32 * pos1];
+                } else {
+                    break;
+                }
+            } else {
+                V = _mm512_loadu_si512((const void *)(array2 + 32 * pos2));
+                pos2++;
+                if (pos2 < len2) {
+                    curB = array2[32 * pos2];
+                } else {
+                    break;
+                }
+            }
+            avx512_merge(V, vecMax, &vecMin, &vecMax);
+            output += avx512_store_unique_xor(laststore, vecMin, output);
+            laststore = vecMin;
+        }
+        avx512_merge(V, vecMax, &vecMin, &vecMax);
+        output += avx512_store_unique_xor(laststore, vecMin, output);
+        laststore = vecMin;
+    }
+    uint32_t len = (uint32_t)(output - initoutput);
+
+    // we finish the rest off using a scalar algorithm
+    int leftoversize = avx512_store_unique_xor(laststore, vecMax, buffer);
+    uint16_t maxvalues[32];
+    _mm512_storeu_si512((void *)maxvalues, vecMax);
+    uint16_t vec31 = maxvalues[31];
+    uint16_t vec30 = maxvalues[30];
+    if (vec31 != vec30) buffer[leftoversize++] = vec31;
+    if (pos1 == len1) {
+        memcpy(buffer + leftoversize, array1 + 32 * pos1,
+               (length1 - 32 * len1) * sizeof(uint16_t));
+        leftoversize += length1 - 32 * len1;
+        if (leftoversize == 0) {  // trivial case
+            memcpy(output, array2 + 32 * pos2,
+                   (length2 - 32 * pos2) * sizeof(uint16_t));
+            len += (length2 - 32 * pos2);
+        } else {
+            qsort(buffer, leftoversize, sizeof(uint16_t), uint16_compare);
+            leftoversize = unique_xor(buffer, leftoversize);
+            len += xor_uint16(buffer, leftoversize, array2 + 32 * pos2,
+                              length2 - 32 * pos2, output);
+        }
+    } else {
+        memcpy(buffer + leftoversize, array2 + 32 * pos2,
+               (length2 - 32 * len2) * sizeof(uint16_t));
+        leftoversize += length2 - 32 * len2;
+        if (leftoversize == 0) {  // trivial case
+            memcpy(output, array1 + 32 * pos1,
+                   (length1 - 32 * pos1) * sizeof(uint16_t));
+            len += (length1 - 32 * pos1);
+        } else {
+            qsort(buffer, leftoversize, sizeof(uint16_t), uint16_compare);
+            leftoversize = unique_xor(buffer, leftoversize);
+            len += xor_uint16(buffer, leftoversize, array1 + 32 * pos1,
+                              length1 - 32 * pos1, output);
+        }
+    }
+    return len;
+}
+CROARING_UNTARGET_AVX512
+/**
+ * End of the AVX-512 16-bit array code
+ */
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
+
 size_t union_uint32(const uint32_t *set_1, size_t size_1, const uint32_t *set_2,
                     size_t size_2, uint32_t *buffer) {
     size_t pos = 0, idx_1 = 0, idx_2 = 0;
@@ -1860,6 +2144,18 @@ size_t union_uint32_card(const uint32_t *set_1, size_t size_1,
 
 size_t fast_union_uint16(const uint16_t *set_1, size_t size_1, const uint16_t *set_2,
                     size_t size_2, uint16_t *buffer) {
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if( croaring_avx512() ) {
+        // compute union with smallest array first
+      if (size_1 < size_2) {
+        return union_vector16_avx512(set_1, (uint32_t)size_1,
+                                          set_2, (uint32_t)size_2, buffer);
+      } else {
+        return union_vector16_avx512(set_2, (uint32_t)size_2,
+                                          set_1, (uint32_t)size_1, buffer);
+      }
+    }
+#endif
 #ifdef CROARING_IS_X64
     if( croaring_avx2() ) {
         // compute union with smallest array first
@@ -0,0 +1,907 @@
+#include <assert.h>
+#include <string.h>
+
+#include <roaring/art/art.h>
+#include <roaring/memory.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace internal {
+#endif
+
+#define ART_NODE4_TYPE 0
+#define ART_NODE16_TYPE 1
+#define ART_NODE48_TYPE 2
+#define ART_NODE256_TYPE 3
+
+// Marks an empty slot in the child index of a Node48.
+#define ART_NODE48_EMPTY_VAL 48
+
+// Leaves are tagged pointers to caller-owned values: the low bit is set so
+// that leaves can be told apart from inner nodes without dereferencing them.
+#define IS_LEAF(p) (((uintptr_t)(p)&1))
+#define SET_LEAF(p) ((art_node_t *)((uintptr_t)(p) | 1))
+#define CAST_LEAF(p) ((art_val_t *)((uintptr_t)(p) & ~(uintptr_t)1))
+
+typedef uint8_t art_typecode_t;
+
+// Header shared by all inner nodes. The prefix holds the key chunks that all
+// children have in common below the parent; a leaf can sit right below the
+// root, so the prefix is at most one chunk shorter than a key.
+typedef struct art_inner_node_s {
+    art_typecode_t typecode;
+    uint8_t prefix_size;
+    art_key_chunk_t prefix[ART_KEY_BYTES - 1];
+} art_inner_node_t;
+
+// Node4: key[i] corresponds with children[i]. Keys are sorted.
+typedef struct art_node4_s {
+    art_inner_node_t base;
+    uint8_t count;
+    art_key_chunk_t keys[4];
+    art_node_t *children[4];
+} art_node4_t;
+
+// Node16: key[i] corresponds with children[i]. Keys are sorted.
+typedef struct art_node16_s {
+    art_inner_node_t base;
+    uint8_t count;
+    art_key_chunk_t keys[16];
+    art_node_t *children[16];
+} art_node16_t;
+
+// Node48: key[i] corresponds with children[key[i]] if key[i] !=
+// ART_NODE48_EMPTY_VAL. Keys are naturally sorted due to direct indexing.
+typedef struct art_node48_s {
+    art_inner_node_t base;
+    uint8_t count;
+    uint8_t keys[256];
+    art_node_t *children[48];
+} art_node48_t;
+
+// Node256: children[i] is directly indexed by key chunk. A child is present if
+// children[i] != NULL.
+typedef struct art_node256_s {
+    art_inner_node_t base;
+    uint16_t count;
+    art_node_t *children[256];
+} art_node256_t;
+
+#define CAST_NODE(p) ((art_inner_node_t *)(p))
+
+static inline art_typecode_t art_get_type(const art_node_t *node) {
+    return ((const art_inner_node_t *)node)->typecode;
+}
+
+static inline void art_init_inner_node(art_inner_node_t *node,
+                                       art_typecode_t typecode,
+                                       const art_key_chunk_t prefix[],
+                                       uint8_t prefix_size) {
+    node->typecode = typecode;
+    node->prefix_size = prefix_size;
+    memcpy(node->prefix, prefix, prefix_size);
+}
+
+// Returns the number of leading key chunks the two keys have in common,
+// comparing at most `max_length` chunks.
+static inline uint8_t art_common_prefix(const art_key_chunk_t key1[],
+                                        const art_key_chunk_t key2[],
+                                        uint8_t max_length) {
+    uint8_t offset = 0;
+    while (offset < max_length && key1[offset] == key2[offset]) {
+        offset++;
+    }
+    return offset;
+}
+
+int art_compare_keys(const art_key_chunk_t key1[],
+                     const art_key_chunk_t key2[]) {
+    return memcmp(key1, key2, ART_KEY_BYTES);
+}
+
+// The node constructors return NULL if the allocation fails.
+static art_node4_t *art_node4_create(const art_key_chunk_t prefix[],
+                                     uint8_t prefix_size) {
+    art_node4_t *node = (art_node4_t *)roaring_malloc(sizeof(art_node4_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    art_init_inner_node(&node->base, ART_NODE4_TYPE, prefix, prefix_size);
+    node->count = 0;
+    return node;
+}
+
+static art_node16_t *art_node16_create(const art_key_chunk_t prefix[],
+                                       uint8_t prefix_size) {
+    art_node16_t *node = (art_node16_t *)roaring_malloc(sizeof(art_node16_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    art_init_inner_node(&node->base, ART_NODE16_TYPE, prefix, prefix_size);
+    node->count = 0;
+    return node;
+}
+
+static art_node48_t *art_node48_create(const art_key_chunk_t prefix[],
+                                       uint8_t prefix_size) {
+    art_node48_t *node = (art_node48_t *)roaring_malloc(sizeof(art_node48_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    art_init_inner_node(&node->base, ART_NODE48_TYPE, prefix, prefix_size);
+    node->count = 0;
+    memset(node->keys, ART_NODE48_EMPTY_VAL, sizeof(node->keys));
+    memset(node->children, 0, sizeof(node->children));
+    return node;
+}
+
+static art_node256_t *art_node256_create(const art_key_chunk_t prefix[],
+                                         uint8_t prefix_size) {
+    art_node256_t *node =
+        (art_node256_t *)roaring_malloc(sizeof(art_node256_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    art_init_inner_node(&node->base, ART_NODE256_TYPE, prefix, prefix_size);
+    node->count = 0;
+    memset(node->children, 0, sizeof(node->children));
+    return node;
+}
+
+static art_node_t *art_find_child(const art_inner_node_t *node,
+                                  art_key_chunk_t key_chunk) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE: {
+            const art_node4_t *n = (const art_node4_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == key_chunk) return n->children[i];
+            }
+            return NULL;
+        }
+        case ART_NODE16_TYPE: {
+            const art_node16_t *n = (const art_node16_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == key_chunk) return n->children[i];
+            }
+            return NULL;
+        }
+        case ART_NODE48_TYPE: {
+            const art_node48_t *n = (const art_node48_t *)node;
+            uint8_t val_idx = n->keys[key_chunk];
+            if (val_idx == ART_NODE48_EMPTY_VAL) return NULL;
+            return n->children[val_idx];
+        }
+        case ART_NODE256_TYPE:
+            return ((const art_node256_t *)node)->children[key_chunk];
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+// Replaces the child with the given key chunk, which must exist.
+static void art_replace_child(art_inner_node_t *node, art_key_chunk_t key_chunk,
+                              art_node_t *new_child) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE: {
+            art_node4_t *n = (art_node4_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == key_chunk) n->children[i] = new_child;
+            }
+            return;
+        }
+        case ART_NODE16_TYPE: {
+            art_node16_t *n = (art_node16_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == key_chunk) n->children[i] = new_child;
+            }
+            return;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            n->children[n->keys[key_chunk]] = new_child;
+            return;
+        }
+        case ART_NODE256_TYPE:
+            ((art_node256_t *)node)->children[key_chunk] = new_child;
+            return;
+        default:
+            assert(false);
+    }
+}
+
+static art_node_t *art_node_insert_child(art_inner_node_t *node,
+                                         art_key_chunk_t key_chunk,
+                                         art_node_t *child);
+
+// Inserts into a node with sorted keys and room to spare.
+static void art_sorted_insert(uint8_t *count, art_key_chunk_t keys[],
+                              art_node_t *children[], art_key_chunk_t key_chunk,
+                              art_node_t *child) {
+    uint8_t idx = 0;
+    while (idx < *count && keys[idx] < key_chunk) {
+        idx++;
+    }
+    memmove(keys + idx + 1, keys + idx, (*count - idx) * sizeof(keys[0]));
+    memmove(children + idx + 1, children + idx,
+            (*count - idx) * sizeof(children[0]));
+    keys[idx] = key_chunk;
+    children[idx] = child;
+    (*count)++;
+}
+
+static art_node_t *art_node4_insert(art_node4_t *node, art_key_chunk_t key_chunk,
+                                    art_node_t *child) {
+    if (node->count < 4) {
+        art_sorted_insert(&node->count, node->keys, node->children, key_chunk,
+                          child);
+        return (art_node_t *)node;
+    }
+    art_node16_t *new_node =
+        art_node16_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return NULL;
+    }
+    memcpy(new_node->keys, node->keys, 4 * sizeof(node->keys[0]));
+    memcpy(new_node->children, node->children, 4 * sizeof(node->children[0]));
+    new_node->count = 4;
+    roaring_free(node);
+    return art_node_insert_child(&new_node->base, key_chunk, child);
+}
+
+static art_node_t *art_node16_insert(art_node16_t *node,
+                                     art_key_chunk_t key_chunk,
+                                     art_node_t *child) {
+    if (node->count < 16) {
+        art_sorted_insert(&node->count, node->keys, node->children, key_chunk,
+                          child);
+        return (art_node_t *)node;
+    }
+    art_node48_t *new_node =
+        art_node48_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < 16; i++) {
+        new_node->keys[node->keys[i]] = i;
+        new_node->children[i] = node->children[i];
+    }
+    new_node->count = 16;
+    roaring_free(node);
+    return art_node_insert_child(&new_node->base, key_chunk, child);
+}
+
+static art_node_t *art_node48_insert(art_node48_t *node,
+                                     art_key_chunk_t key_chunk,
+                                     art_node_t *child) {
+    if (node->count < 48) {
+        uint8_t val_idx = 0;
+        while (node->children[val_idx] != NULL) {
+            val_idx++;
+        }
+        node->keys[key_chunk] = val_idx;
+        node->children[val_idx] = child;
+        node->count++;
+        return (art_node_t *)node;
+    }
+    art_node256_t *new_node =
+        art_node256_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < 256; i++) {
+        uint8_t val_idx = node->keys[i];
+        if (val_idx != ART_NODE48_EMPTY_VAL) {
+            new_node->children[i] = node->children[val_idx];
+        }
+    }
+    new_node->count = 48;
+    roaring_free(node);
+    return art_node_insert_child(&new_node->base, key_chunk, child);
+}
+
+static art_node_t *art_node256_insert(art_node256_t *node,
+                                      art_key_chunk_t key_chunk,
+                                      art_node_t *child) {
+    node->children[key_chunk] = child;
+    node->count++;
+    return (art_node_t *)node;
+}
+
+// Inserts a child whose key chunk is not yet present. The node may grow into
+// a larger node type, in which case the new node is returned and the old one
+// freed. Returns NULL, leaving the node unchanged, if growing it fails.
+static art_node_t *art_node_insert_child(art_inner_node_t *node,
+                                         art_key_chunk_t key_chunk,
+                                         art_node_t *child) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+            return art_node4_insert((art_node4_t *)node, key_chunk, child);
+        case ART_NODE16_TYPE:
+            return art_node16_insert((art_node16_t *)node, key_chunk, child);
+        case ART_NODE48_TYPE:
+            return art_node48_insert((art_node48_t *)node, key_chunk, child);
+        case ART_NODE256_TYPE:
+            return art_node256_insert((art_node256_t *)node, key_chunk, child);
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+// Removes the child at position `idx` of a node with sorted keys.
+static void art_sorted_erase(uint8_t *count, art_key_chunk_t keys[],
+                             art_node_t *children[], uint8_t idx) {
+    memmove(keys + idx, keys + idx + 1, (*count - idx - 1) * sizeof(keys[0]));
+    memmove(children + idx, children + idx + 1,
+            (*count - idx - 1) * sizeof(children[0]));
+    (*count)--;
+}
+
+static art_node_t *art_node4_erase(art_node4_t *node,
+                                   art_key_chunk_t key_chunk) {
+    uint8_t idx = 0;
+    while (idx < node->count && node->keys[idx] != key_chunk) {
+        idx++;
+    }
+    if (idx == node->count) {
+        return (art_node_t *)node;
+    }
+    art_sorted_erase(&node->count, node->keys, node->children, idx);
+    if (node->count > 1) {
+        return (art_node_t *)node;
+    }
+    // Only one child remains: replace this node with it. An inner child takes
+    // over our prefix and the key chunk that led to it.
+    art_node_t *remaining = node->children[0];
+    if (!IS_LEAF(remaining)) {
+        art_inner_node_t *inner = CAST_NODE(remaining);
+        uint8_t prefix_size = node->base.prefix_size + 1 + inner->prefix_size;
+        assert(prefix_size < ART_KEY_BYTES);
+        memmove(inner->prefix + node->base.prefix_size + 1, inner->prefix,
+                inner->prefix_size);
+        memcpy(inner->prefix, node->base.prefix, node->base.prefix_size);
+        inner->prefix[node->base.prefix_size] = node->keys[0];
+        inner->prefix_size = prefix_size;
+    }
+    roaring_free(node);
+    return remaining;
+}
+
+static art_node_t *art_node16_erase(art_node16_t *node,
+                                    art_key_chunk_t key_chunk) {
+    uint8_t idx = 0;
+    while (idx < node->count && node->keys[idx] != key_chunk) {
+        idx++;
+    }
+    if (idx == node->count) {
+        return (art_node_t *)node;
+    }
+    art_sorted_erase(&node->count, node->keys, node->children, idx);
+    if (node->count > 3) {
+        return (art_node_t *)node;
+    }
+    art_node4_t *new_node =
+        art_node4_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return (art_node_t *)node;  // shrinking is optional
+    }
+    memcpy(new_node->keys, node->keys, node->count * sizeof(node->keys[0]));
+    memcpy(new_node->children, node->children,
+           node->count * sizeof(node->children[0]));
+    new_node->count = node->count;
+    roaring_free(node);
+    return (art_node_t *)new_node;
+}
+
+static art_node_t *art_node48_erase(art_node48_t *node,
+                                    art_key_chunk_t key_chunk) {
+    uint8_t val_idx = node->keys[key_chunk];
+    if (val_idx == ART_NODE48_EMPTY_VAL) {
+        return (art_node_t *)node;
+    }
+    node->keys[key_chunk] = ART_NODE48_EMPTY_VAL;
+    node->children[val_idx] = NULL;
+    node->count--;
+    if (node->count > 12) {
+        return (art_node_t *)node;
+    }
+    art_node16_t *new_node =
+        art_node16_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return (art_node_t *)node;  // shrinking is optional
+    }
+    for (size_t i = 0; i < 256; i++) {
+        val_idx = node->keys[i];
+        if (val_idx != ART_NODE48_EMPTY_VAL) {
+            new_node->keys[new_node->count] = (art_key_chunk_t)i;
+            new_node->children[new_node->count] = node->children[val_idx];
+            new_node->count++;
+        }
+    }
+    roaring_free(node);
+    return (art_node_t *)new_node;
+}
+
+static art_node_t *art_node256_erase(art_node256_t *node,
+                                     art_key_chunk_t key_chunk) {
+    if (node->children[key_chunk] == NULL) {
+        return (art_node_t *)node;
+    }
+    node->children[key_chunk] = NULL;
+    node->count--;
+    if (node->count > 37) {
+        return (art_node_t *)node;
+    }
+    art_node48_t *new_node =
+        art_node48_create(node->base.prefix, node->base.prefix_size);
+    if (new_node == NULL) {
+        return (art_node_t *)node;  // shrinking is optional
+    }
+    for (size_t i = 0; i < 256; i++) {
+        if (node->children[i] != NULL) {
+            new_node->keys[i] = new_node->count;
+            new_node->children[new_node->count] = node->children[i];
+            new_node->count++;
+        }
+    }
+    roaring_free(node);
+    return (art_node_t *)new_node;
+}
+
+// Removes the child with the given key chunk. The node may shrink into a
+// smaller node type, or be replaced by its only remaining child; the old node
+// is freed in both cases.
+static art_node_t *art_node_erase_child(art_inner_node_t *node,
+                                        art_key_chunk_t key_chunk) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+            return art_node4_erase((art_node4_t *)node, key_chunk);
+        case ART_NODE16_TYPE:
+            return art_node16_erase((art_node16_t *)node, key_chunk);
+        case ART_NODE48_TYPE:
+            return art_node48_erase((art_node48_t *)node, key_chunk);
+        case ART_NODE256_TYPE:
+            return art_node256_erase((art_node256_t *)node, key_chunk);
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+// Inserts the leaf below `node`, whose children all share `key[0..depth)`.
+// Returns the node that should replace `node` in its parent, or NULL, leaving
+// the tree unchanged, if an inner node cannot be allocated.
+static art_node_t *art_insert_at(art_node_t *node, const art_key_chunk_t *key,
+                                 uint8_t depth, art_node_t *new_leaf,
+                                 art_val_t **existing) {
+    if (IS_LEAF(node)) {
+        art_val_t *leaf = CAST_LEAF(node);
+        uint8_t common = art_common_prefix(leaf->key + depth, key + depth,
+                                           ART_KEY_BYTES - depth);
+        if (depth + common == ART_KEY_BYTES) {
+            *existing = leaf;
+            return node;
+        }
+        // Split the leaf: the new inner node holds the common part of both
+        // keys, and branches at the first chunk that differs.
+        art_node4_t *new_node = art_node4_create(key + depth, common);
+        if (new_node == NULL) {
+            return NULL;
+        }
+        art_node4_insert(new_node, leaf->key[depth + common], node);
+        art_node4_insert(new_node, key[depth + common], new_leaf);
+        return (art_node_t *)new_node;
+    }
+    art_inner_node_t *inner = CAST_NODE(node);
+    uint8_t common =
+        art_common_prefix(inner->prefix, key + depth, inner->prefix_size);
+    if (common < inner->prefix_size) {
+        // Split the prefix: the new inner node takes the common part, and the
+        // existing node keeps what follows the chunk at which the keys differ.
+        art_node4_t *new_node = art_node4_create(inner->prefix, common);
+        if (new_node == NULL) {
+            return NULL;
+        }
+        art_key_chunk_t old_chunk = inner->prefix[common];
+        inner->prefix_size = inner->prefix_size - common - 1;
+        memmove(inner->prefix, inner->prefix + common + 1, inner->prefix_size);
+        art_node4_insert(new_node, old_chunk, node);
+        art_node4_insert(new_node, key[depth + common], new_leaf);
+        return (art_node_t *)new_node;
+    }
+    depth += inner->prefix_size;
+    art_node_t *child = art_find_child(inner, key[depth]);
+    if (child == NULL) {
+        return art_node_insert_child(inner, key[depth], new_leaf);
+    }
+    art_node_t *new_child =
+        art_insert_at(child, key, depth + 1, new_leaf, existing);
+    if (new_child == NULL) {
+        return NULL;
+    }
+    if (new_child != child) {
+        art_replace_child(inner, key[depth], new_child);
+    }
+    return node;
+}
+
+bool art_insert(art_t *art, const art_key_chunk_t *key, art_val_t *val,
+                art_val_t **existing) {
+    art_node_t *leaf = SET_LEAF(val);
+    *existing = NULL;
+    if (art->root == NULL) {
+        memcpy(val->key, key, ART_KEY_BYTES);
+        art->root = leaf;
+        return true;
+    }
+    art_node_t *new_root = art_insert_at(art->root, key, 0, leaf, existing);
+    if (new_root == NULL) {
+        return false;
+    }
+    art->root = new_root;
+    if (*existing == NULL) {
+        memcpy(val->key, key, ART_KEY_BYTES);
+    }
+    return true;
+}
+
+// Erases the key below `node`. Returns the node that should replace `node` in
+// its parent, NULL if it became empty.
+static art_node_t *art_erase_at(art_node_t *node, const art_key_chunk_t *key,
+                                uint8_t depth, art_val_t **erased) {
+    if (IS_LEAF(node)) {
+        art_val_t *leaf = CAST_LEAF(node);
+        if (art_compare_keys(leaf->key, key) != 0) {
+            return node;
+        }
+        *erased = leaf;
+        return NULL;
+    }
+    art_inner_node_t *inner = CAST_NODE(node);
+    if (art_common_prefix(inner->prefix, key + depth, inner->prefix_size) <
+        inner->prefix_size) {
+        return node;
+    }
+    depth += inner->prefix_size;
+    art_node_t *child = art_find_child(inner, key[depth]);
+    if (child == NULL) {
+        return node;
+    }
+    art_node_t *new_child = art_erase_at(child, key, depth + 1, erased);
+    if (new_child == child) {
+        return node;
+    }
+    if (new_child != NULL) {
+        art_replace_child(inner, key[depth], new_child);
+        return node;
+    }
+    return art_node_erase_child(inner, key[depth]);
+}
+
+art_val_t *art_erase(art_t *art, const art_key_chunk_t *key) {
+    if (art->root == NULL) {
+        return NULL;
+    }
+    art_val_t *erased = NULL;
+    art->root = art_erase_at(art->root, key, 0, &erased);
+    return erased;
+}
+
+art_val_t *art_find(const art_t *art, const art_key_chunk_t *key) {
+    art_node_t *node = art->root;
+    uint8_t depth = 0;
+    while (node != NULL) {
+        if (IS_LEAF(node)) {
+            art_val_t *leaf = CAST_LEAF(node);
+            return art_compare_keys(leaf->key, key) == 0 ? leaf : NULL;
+        }
+        const art_inner_node_t *inner = CAST_NODE(node);
+        if (art_common_prefix(inner->prefix, key + depth, inner->prefix_size) <
+            inner->prefix_size) {
+            return NULL;
+        }
+        depth += inner->prefix_size;
+        node = art_find_child(inner, key[depth]);
+        depth++;
+    }
+    return NULL;
+}
+
+bool art_is_empty(const art_t *art) { return art->root == NULL; }
+
+static void art_free_node(art_node_t *node) {
+    if (IS_LEAF(node)) {
+        return;
+    }
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE: {
+            art_node4_t *n = (art_node4_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                art_free_node(n->children[i]);
+            }
+            break;
+        }
+        case ART_NODE16_TYPE: {
+            art_node16_t *n = (art_node16_t *)node;
+            for (uint8_t i = 0; i < n->count; i++) {
+                art_free_node(n->children[i]);
+            }
+            break;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            for (uint8_t i = 0; i < 48; i++) {
+                if (n->children[i] != NULL) art_free_node(n->children[i]);
+            }
+            break;
+        }
+        case ART_NODE256_TYPE: {
+            art_node256_t *n = (art_node256_t *)node;
+            for (size_t i = 0; i < 256; i++) {
+                if (n->children[i] != NULL) art_free_node(n->children[i]);
+            }
+            break;
+        }
+        default:
+            assert(false);
+    }
+    roaring_free(node);
+}
+
+void art_free(art_t *art) {
+    if (art->root != NULL) {
+        art_free_node(art->root);
+        art->root = NULL;
+    }
+}
+
+// Returns the position of the next child after `index`, -1 if there is none.
+// Positions are indices into the sorted key arrays of Node4 and Node16, and
+// key chunks for Node48 and Node256.
+static int art_next_index(const art_node_t *node, int index) {
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE:
+            index++;
+            return index < ((const art_node4_t *)node)->count ? index : -1;
+        case ART_NODE16_TYPE:
+            index++;
+            return index < ((const art_node16_t *)node)->count ? index : -1;
+        case ART_NODE48_TYPE: {
+            const art_node48_t *n = (const art_node48_t *)node;
+            for (index++; index < 256; index++) {
+                if (n->keys[index] != ART_NODE48_EMPTY_VAL) return index;
+            }
+            return -1;
+        }
+        case ART_NODE256_TYPE: {
+            const art_node256_t *n = (const art_node256_t *)node;
+            for (index++; index < 256; index++) {
+                if (n->children[index] != NULL) return index;
+            }
+            return -1;
+        }
+        default:
+            assert(false);
+            return -1;
+    }
+}
+
+// Returns the position of the previous child before `index`, -1 if there is
+// none. Passing 256 returns the last child.
+static int art_prev_index(const art_node_t *node, int index) {
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE: {
+            int count = ((const art_node4_t *)node)->count;
+            return (index > count ? count : index) - 1;
+        }
+        case ART_NODE16_TYPE: {
+            int count = ((const art_node16_t *)node)->count;
+            return (index > count ? count : index) - 1;
+        }
+        case ART_NODE48_TYPE: {
+            const art_node48_t *n = (const art_node48_t *)node;
+            for (index--; index >= 0; index--) {
+                if (n->keys[index] != ART_NODE48_EMPTY_VAL) return index;
+            }
+            return -1;
+        }
+        case ART_NODE256_TYPE: {
+            const art_node256_t *n = (const art_node256_t *)node;
+            for (index--; index >= 0; index--) {
+                if (n->children[index] != NULL) return index;
+            }
+            return -1;
+        }
+        default:
+            assert(false);
+            return -1;
+    }
+}
+
+static art_node_t *art_child_at(const art_node_t *node, int index) {
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE:
+            return ((const art_node4_t *)node)->children[index];
+        case ART_NODE16_TYPE:
+            return ((const art_node16_t *)node)->children[index];
+        case ART_NODE48_TYPE: {
+            const art_node48_t *n = (const art_node48_t *)node;
+            return n->children[n->keys[index]];
+        }
+        case ART_NODE256_TYPE:
+            return ((const art_node256_t *)node)->children[index];
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+static art_key_chunk_t art_key_at(const art_node_t *node, int index) {
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE:
+            return ((const art_node4_t *)node)->keys[index];
+        case ART_NODE16_TYPE:
+            return ((const art_node16_t *)node)->keys[index];
+        default:
+            return (art_key_chunk_t)index;
+    }
+}
+
+// Returns the position of the first child with a key chunk equal to or
+// greater than the given one, -1 if there is none.
+static int art_lower_bound_index(const art_node_t *node,
+                                 art_key_chunk_t key_chunk) {
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE: {
+            const art_node4_t *n = (const art_node4_t *)node;
+            for (int i = 0; i < n->count; i++) {
+                if (n->keys[i] >= key_chunk) return i;
+            }
+            return -1;
+        }
+        case ART_NODE16_TYPE: {
+            const art_node16_t *n = (const art_node16_t *)node;
+            for (int i = 0; i < n->count; i++) {
+                if (n->keys[i] >= key_chunk) return i;
+            }
+            return -1;
+        }
+        default:
+            return art_next_index(node, (int)key_chunk - 1);
+    }
+}
+
+// Follows the first (or last) children from `node` down to a leaf, pushing
+// the inner nodes visited onto the iterator's path.
+static bool art_iterator_descend(art_iterator_t *iterator, art_node_t *node,
+                                 bool first) {
+    while (!IS_LEAF(node)) {
+        int index = first ? art_next_index(node, -1) : art_prev_index(node, 256);
+        iterator->frames[iterator->depth] = node;
+        iterator->indices[iterator->depth] = (int16_t)index;
+        iterator->depth++;
+        node = art_child_at(node, index);
+    }
+    iterator->value = CAST_LEAF(node);
+    return true;
+}
+
+bool art_init_iterator(const art_t *art, art_iterator_t *iterator, bool first) {
+    iterator->depth = 0;
+    if (art->root == NULL) {
+        iterator->value = NULL;
+        return false;
+    }
+    return art_iterator_descend(iterator, art->root, first);
+}
+
+static bool art_iterator_move(art_iterator_t *iterator, bool forward) {
+    while (iterator->depth > 0) {
+        art_node_t *node = iterator->frames[iterator->depth - 1];
+        int index = iterator->indices[iterator->depth - 1];
+        index = forward ? art_next_index(node, index)
+                        : art_prev_index(node, index);
+        if (index >= 0) {
+            iterator->indices[iterator->depth - 1] = (int16_t)index;
+            return art_iterator_descend(iterator, art_child_at(node, index),
+                                        forward);
+        }
+        iterator->depth--;
+    }
+    iterator->value = NULL;
+    return false;
+}
+
+bool art_iterator_next(art_iterator_t *iterator) {
+    return art_iterator_move(iterator, true);
+}
+
+bool art_iterator_prev(art_iterator_t *iterator) {
+    return art_iterator_move(iterator, false);
+}
+
+bool art_iterator_lower_bound(const art_t *art, art_iterator_t *iterator,
+                              const art_key_chunk_t *key) {
+    iterator->depth = 0;
+    iterator->value = NULL;
+    art_node_t *node = art->root;
+    if (node == NULL) {
+        return false;
+    }
+    uint8_t depth = 0;
+    while (true) {
+        if (IS_LEAF(node)) {
+            art_val_t *leaf = CAST_LEAF(node);
+            if (art_compare_keys(leaf->key, key) >= 0) {
+                iterator->value = leaf;
+                return true;
+            }
+            return art_iterator_next(iterator);
+        }
+        const art_inner_node_t *inner = CAST_NODE(node);
+        int cmp = memcmp(inner->prefix, key + depth, inner->prefix_size);
+        if (cmp > 0) {
+            // Everything below this node is greater than the key.
+            return art_iterator_descend(iterator, node, true);
+        }
+        if (cmp < 0) {
+            // Everything below this node is smaller than the key.
+            return art_iterator_next(iterator);
+        }
+        depth += inner->prefix_size;
+        int index = art_lower_bound_index(node, key[depth]);
+        if (index < 0) {
+            return art_iterator_next(iterator);
+        }
+        iterator->frames[iterator->depth] = node;
+        iterator->indices[iterator->depth] = (int16_t)index;
+        iterator->depth++;
+        node = art_child_at(node, index);
+        if (art_key_at(iterator->frames[iterator->depth - 1], index) >
+            key[depth]) {
+            return art_iterator_descend(iterator, node, true);
+        }
+        depth++;
+    }
+}
+
+art_val_t *art_iterator_erase(art_t *art, art_iterator_t *iterator) {
+    art_val_t *value = iterator->value;
+    if (value == NULL) {
+        return NULL;
+    }
+    art_key_chunk_t key[ART_KEY_BYTES];
+    memcpy(key, value->key, ART_KEY_BYTES);
+    art_erase(art, key);
+    art_iterator_lower_bound(art, iterator, key);
+    return value;
+}
+
+static size_t art_node_size_in_bytes(const art_node_t *node) {
+    if (IS_LEAF(node)) {
+        return 0;
+    }
+    size_t size = 0;
+    for (int index = art_next_index(node, -1); index >= 0;
+         index = art_next_index(node, index)) {
+        size += art_node_size_in_bytes(art_child_at(node, index));
+    }
+    switch (art_get_type(node)) {
+        case ART_NODE4_TYPE:
+            return size + sizeof(art_node4_t);
+        case ART_NODE16_TYPE:
+            return size + sizeof(art_node16_t);
+        case ART_NODE48_TYPE:
+            return size + sizeof(art_node48_t);
+        default:
+            return size + sizeof(art_node256_t);
+    }
+}
+
+size_t art_size_in_bytes(const art_t *art) {
+    return art->root == NULL ? 0 : art_node_size_in_bytes(art->root);
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace internal {
+#endif
@@ -608,6 +608,96 @@ size_t bitset_extract_setbits_avx2(const uint64_t *words, size_t length,
 CROARING_UNTARGET_REGION
 #endif  // CROARING_IS_X64
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+CROARING_TARGET_AVX512
+size_t bitset_extract_setbits_avx512(const uint64_t *words, size_t length,
+                                     uint32_t *out, size_t outcapacity,
+                                     uint32_t base) {
+    uint32_t *initout = out;
+    uint32_t *safeout = out + outcapacity;
+    __m512i baseVec = _mm512_add_epi32(
+        _mm512_set1_epi32(base),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15));
+    __m512i add16 = _mm512_set1_epi32(16);
+    __m512i incVec = _mm512_set1_epi32(64);
+    size_t i = 0;
+    for (; (i < length) && (out + 64 <= safeout); ++i) {
+        uint64_t w = words[i];
+        if (w == 0) {
+            baseVec = _mm512_add_epi32(baseVec, incVec);
+        } else {
+            for (int k = 0; k < 4; ++k) {
+                __mmask16 mask = (__mmask16)w;
+                w >>= 16;
+                __m512i vec = _mm512_maskz_compress_epi32(mask, baseVec);
+                _mm512_storeu_si512((__m512i *)out, vec);
+                out += _mm_popcnt_u32(mask);
+                baseVec = _mm512_add_epi32(baseVec, add16);
+            }
+        }
+    }
+    base += i * 64;
+    for (; (i < length) && (out < safeout); ++i) {
+        uint64_t w = words[i];
+        while ((w != 0) && (out < safeout)) {
+            uint64_t t = w & (~w + 1);
+            int r = __builtin_ctzll(w);
+            uint32_t val = r + base;
+            memcpy(out, &val, sizeof(uint32_t));
+            out++;
+            w ^= t;
+        }
+        base += 64;
+    }
+    return out - initout;
+}
+
+size_t bitset_extract_setbits_avx512_uint16(const uint64_t *words,
+                                            size_t length, uint16_t *out,
+                                            size_t outcapacity, uint16_t base) {
+    uint16_t *initout = out;
+    uint16_t *safeout = out + outcapacity;
+    __m512i baseVec = _mm512_add_epi16(
+        _mm512_set1_epi16(base),
+        _mm512_set_epi16(31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+                         18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4,
+                         3, 2, 1, 0));
+    __m512i add32 = _mm512_set1_epi16(32);
+    __m512i incVec = _mm512_set1_epi16(64);
+    size_t i = 0;
+    for (; (i < length) && (out + 64 <= safeout); ++i) {
+        uint64_t w = words[i];
+        if (w == 0) {
+            baseVec = _mm512_add_epi16(baseVec, incVec);
+        } else {
+            for (int k = 0; k < 2; ++k) {
+                __mmask32 mask = (__mmask32)w;
+                w >>= 32;
+                __m512i vec = _mm512_maskz_compress_epi16(mask, baseVec);
+                _mm512_storeu_si512((__m512i *)out, vec);
+                out += _mm_popcnt_u32(mask);
+                baseVec = _mm512_add_epi16(baseVec, add32);
+            }
+        }
+    }
+    base += (uint16_t)(i * 64);
+    for (; (i < length) && (out < safeout); ++i) {
+        uint64_t w = words[i];
+        while ((w != 0) && (out < safeout)) {
+            uint64_t t = w & (~w + 1);
+            int r = __builtin_ctzll(w);
+            *out = r + base;
+            out++;
+            w ^= t;
+        }
+        base += 64;
+    }
+    return out - initout;
+}
+CROARING_UNTARGET_AVX512
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
+
 size_t bitset_extract_setbits(const uint64_t *words, size_t length,
                               uint32_t *out, uint32_t base) {
     int outpos = 0;
@@ -230,8 +230,20 @@ static inline int _scalar_bitset_container_compute_cardinality(const bitset_cont
   }
   return sum;
 }
+#if CROARING_COMPILER_SUPPORTS_AVX512
+#ifndef WORDS_IN_AVX512_REG
+#define WORDS_IN_AVX512_REG sizeof(__m512i) / sizeof(uint64_t)
+#endif
+#endif
 /* Get the number of bits set (force computation) */
 int bitset_container_compute_cardinality(const bitset_container_t *bitset) {
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if( croaring_avx512() ) {
+      return (int) avx512_vpopcount(
+        (const __m512i *)bitset->words,
+        BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG));
+    }
+#endif
     if( croaring_avx2() ) {
       return (int) avx2_harley_seal_popcount256(
         (const __m256i *)bitset->words,
@@ -446,6 +458,78 @@ CROARING_TARGET_AVX2
 AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_REGION)
 CROARING_UNTARGET_REGION
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/* The AVX-512 versions process a full cache line per instruction. */
+#define AVX512_BITSET_CONTAINER_FN(opname, avx512_intrinsic)                   \
+  static inline int _avx512_bitset_container_##opname##_nocard(                \
+      const bitset_container_t *src_1, const bitset_container_t *src_2,        \
+      bitset_container_t *dst) {                                               \
+    const __m512i *__restrict__ words_1 = (const __m512i *)src_1->words;       \
+    const __m512i *__restrict__ words_2 = (const __m512i *)src_2->words;       \
+    __m512i *out = (__m512i *)dst->words;                                      \
+    for (size_t i = 0;                                                         \
+         i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG);           \
+         i += 4) {                                                             \
+      _mm512_storeu_si512(out + i,                                             \
+          avx512_intrinsic(_mm512_loadu_si512(words_2 + i),                    \
+                           _mm512_loadu_si512(words_1 + i)));                  \
+      _mm512_storeu_si512(out + i + 1,                                         \
+          avx512_intrinsic(_mm512_loadu_si512(words_2 + i + 1),                \
+                           _mm512_loadu_si512(words_1 + i + 1)));              \
+      _mm512_storeu_si512(out + i + 2,                                         \
+          avx512_intrinsic(_mm512_loadu_si512(words_2 + i + 2),                \
+                           _mm512_loadu_si512(words_1 + i + 2)));              \
+      _mm512_storeu_si512(out + i + 3,                                         \
+          avx512_intrinsic(_mm512_loadu_si512(words_2 + i + 3),                \
+                           _mm512_loadu_si512(words_1 + i + 3)));              \
+    }                                                                          \
+    dst->cardinality = BITSET_UNKNOWN_CARDINALITY;                             \
+    return dst->cardinality;                                                   \
+  }                                                                            \
+  /* next, a version that updates cardinality*/                                \
+  static inline int _avx512_bitset_container_##opname(                         \
+      const bitset_container_t *src_1, const bitset_container_t *src_2,        \
+      bitset_container_t *dst) {                                               \
+    const __m512i *__restrict__ words_1 = (const __m512i *)src_1->words;       \
+    const __m512i *__restrict__ words_2 = (const __m512i *)src_2->words;       \
+    __m512i *out = (__m512i *)dst->words;                                      \
+    dst->cardinality = (int32_t)avx512_vpopcount_andstore_##opname(           \
+        words_2, words_1, out,                                                 \
+        BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG));               \
+    return dst->cardinality;                                                   \
+  }                                                                            \
+  /* next, a version that just computes the cardinality*/                      \
+  static inline int _avx512_bitset_container_##opname##_justcard(              \
+      const bitset_container_t *src_1, const bitset_container_t *src_2) {      \
+    const __m512i *__restrict__ data1 = (const __m512i *)src_1->words;         \
+    const __m512i *__restrict__ data2 = (const __m512i *)src_2->words;         \
+    return (int)avx512_vpopcount_##opname(                                     \
+        data2, data1, BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG)); \
+  }
+
+// we duplicate the function because other containers use the "or" term, makes API more consistent
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(or,    _mm512_or_si512)
+CROARING_UNTARGET_AVX512
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(union, _mm512_or_si512)
+CROARING_UNTARGET_AVX512
+
+// we duplicate the function because other containers use the "intersection" term, makes API more consistent
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(and,          _mm512_and_si512)
+CROARING_UNTARGET_AVX512
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(intersection, _mm512_and_si512)
+CROARING_UNTARGET_AVX512
+
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(xor,    _mm512_xor_si512)
+CROARING_UNTARGET_AVX512
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(andnot, avx512_andnot_si512)
+CROARING_UNTARGET_AVX512
+#endif // CROARING_COMPILER_SUPPORTS_AVX512
 
 #define SCALAR_BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic,            \
                                    neon_intrinsic)                             \
@@ -505,6 +589,43 @@ SCALAR_BITSET_CONTAINER_FN(xor,    ^,  _mm256_xor_si256,    veorq_u64)
 SCALAR_BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
 
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+#define BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic, neon_intrinsic)   \
+  int bitset_container_##opname(const bitset_container_t *src_1,               \
+                                const bitset_container_t *src_2,               \
+                                bitset_container_t *dst) {                     \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname(src_1, src_2, dst);             \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname(src_1, src_2, dst);               \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname(src_1, src_2, dst);             \
+    }                                                                          \
+  }                                                                            \
+  int bitset_container_##opname##_nocard(const bitset_container_t *src_1,      \
+                                         const bitset_container_t *src_2,      \
+                                         bitset_container_t *dst) {            \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname##_nocard(src_1, src_2, dst);    \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname##_nocard(src_1, src_2, dst);      \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname##_nocard(src_1, src_2, dst);    \
+    }                                                                          \
+  }                                                                            \
+  int bitset_container_##opname##_justcard(const bitset_container_t *src_1,    \
+                                           const bitset_container_t *src_2) {  \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname##_justcard(src_1, src_2);       \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname##_justcard(src_1, src_2);         \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname##_justcard(src_1, src_2);       \
+    }                                                                          \
+  }
+
+#else // CROARING_COMPILER_SUPPORTS_AVX512
+
 #define BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic, neon_intrinsic)   \
   int bitset_container_##opname(const bitset_container_t *src_1,               \
                                 const bitset_container_t *src_2,               \
@@ -534,7 +655,7 @@ SCALAR_BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
     }                                                                          \
   }
 
-
+#endif // CROARING_COMPILER_SUPPORTS_AVX512
 
 #elif defined(USENEON)
 
@@ -685,12 +806,44 @@ BITSET_CONTAINER_FN(xor,    ^,  _mm256_xor_si256,    veorq_u64)
 BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
 // clang-format On
 
+/* Computes a binary operation on bitset1 and bitset2 into bitsetout, counting
+   the runs of the result in the same pass. */
+#define BITSET_CONTAINER_RUNS_FN(opname, opsymbol)                            \
+int bitset_container_##opname##_runs(const bitset_container_t *src_1,         \
+                                     const bitset_container_t *src_2,         \
+                                     bitset_container_t *dst,                 \
+                                     int32_t *n_runs) {                       \
+    const uint64_t * __restrict__ words_1 = src_1->words;                     \
+    const uint64_t * __restrict__ words_2 = src_2->words;                     \
+    uint64_t *out = dst->words;                                               \
+    int32_t sum = 0;                                                          \
+    int32_t runs = 0;                                                         \
+    uint64_t carry = 0;                                                       \
+    for (size_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {             \
+        const uint64_t word = words_1[i] opsymbol (words_2[i]);               \
+        out[i] = word;                                                        \
+        bitset_count_word_runs(word, &sum, &runs, &carry);                    \
+    }                                                                         \
+    dst->cardinality = sum;                                                   \
+    *n_runs = runs;                                                           \
+    return dst->cardinality;                                                  \
+}
+
+BITSET_CONTAINER_RUNS_FN(or,  |)
+BITSET_CONTAINER_RUNS_FN(and, &)
+BITSET_CONTAINER_RUNS_FN(xor, ^)
+
 
 int bitset_container_to_uint32_array(
     uint32_t *out,
     const bitset_container_t *bc,
     uint32_t base
 ){
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if(( croaring_avx512() ) &&  (bc->cardinality >= 8192))  // heuristic
+		return (int) bitset_extract_setbits_avx512(bc->words,
+                BITSET_CONTAINER_SIZE_IN_WORDS, out, bc->cardinality, base);
+#endif
 #ifdef CROARING_IS_X64
     if(( croaring_avx2() ) &&  (bc->cardinality >= 8192))  // heuristic
 		return (int) bitset_extract_setbits_avx2(bc->words,
@@ -820,8 +973,8 @@ static inline bool _avx2_bitset_container_equals(const bitset_container_t *conta
     const __m256i *ptr1 = (const __m256i*)container1->words;
     const __m256i *ptr2 = (const __m256i*)container2->words;
     for (size_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS*sizeof(uint64_t)/32; i++) {
-      __m256i r1 = _mm256_load_si256(ptr1+i);
-      __m256i r2 = _mm256_load_si256(ptr2+i);
+      __m256i r1 = _mm256_loadu_si256(ptr1+i);
+      __m256i r2 = _mm256_loadu_si256(ptr2+i);
       int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(r1, r2));
       if ((uint32_t)mask != UINT32_MAX) {
           return false;
@@ -137,7 +137,7 @@ container_t *get_copy_of_container(
         shared_container_t *shared_container;
         if (*typecode == SHARED_CONTAINER_TYPE) {
             shared_container = CAST_shared(c);
-            shared_container->counter += 1;
+            croaring_refcount_inc(&shared_container->counter);
             return shared_container;
         }
         assert(*typecode != SHARED_CONTAINER_TYPE);
@@ -150,7 +150,7 @@ container_t *get_copy_of_container(
         shared_container->container = c;
         shared_container->typecode = *typecode;
 
-        shared_container->counter = 2;
+        croaring_refcount_init(&shared_container->counter, 2);
         *typecode = SHARED_CONTAINER_TYPE;
 
         return shared_container;
@@ -188,26 +188,33 @@ container_t *container_clone(const container_t *c, uint8_t typecode) {
 container_t *shared_container_extract_copy(
     shared_container_t *sc, uint8_t *typecode
 ){
-    assert(sc->counter > 0);
+    assert(croaring_refcount_get(&sc->counter) > 0);
     assert(sc->typecode != SHARED_CONTAINER_TYPE);
-    sc->counter--;
     *typecode = sc->typecode;
     container_t *answer;
-    if (sc->counter == 0) {
+    if (croaring_refcount_get(&sc->counter) == 1) {
+        // We hold the only reference: nobody else can take a new one.
         answer = sc->container;
         sc->container = NULL;  // paranoid
         roaring_free(sc);
     } else {
+        // Clone before letting go of our reference, otherwise another owner
+        // could take the container over and modify it while we copy it.
         answer = container_clone(sc->container, *typecode);
+        if (croaring_refcount_dec(&sc->counter)) {
+            // the other owners let go in the meantime
+            container_free(sc->container, sc->typecode);
+            sc->container = NULL;  // paranoid
+            roaring_free(sc);
+        }
     }
     assert(*typecode != SHARED_CONTAINER_TYPE);
     return answer;
 }
 
 void shared_container_free(shared_container_t *container) {
-    assert(container->counter > 0);
-    container->counter--;
-    if (container->counter == 0) {
+    assert(croaring_refcount_get(&container->counter) > 0);
+    if (croaring_refcount_dec(&container->counter)) {
         assert(container->typecode != SHARED_CONTAINER_TYPE);
         container_free(container->container, container->typecode);
         container->container = NULL;  // paranoid
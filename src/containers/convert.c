@@ -51,6 +51,14 @@ array_container_t *array_container_from_bitset(const bitset_container_t *bits) {
     //  sse version ends up being slower here
     // (bitset_extract_setbits_sse_uint16)
     // because of the sparsity of the data
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if (croaring_avx512()) {
+        bitset_extract_setbits_avx512_uint16(bits->words,
+                BITSET_CONTAINER_SIZE_IN_WORDS, result->array,
+                bits->cardinality, 0);
+        return result;
+    }
+#endif
     bitset_extract_setbits_uint16(bits->words, BITSET_CONTAINER_SIZE_IN_WORDS,
                                   result->array, 0);
     return result;
@@ -195,6 +203,72 @@ container_t *convert_run_to_efficient_container_and_free(
 // TODO: split into run-  array-  and bitset-  subfunctions for sanity;
 // a few function calls won't really matter.
 
+// bitset to runcontainer (ported from Java  RunContainer(
+// BitmapContainer bc, int nbrRuns))
+run_container_t *run_container_from_bitset(const bitset_container_t *bc,
+                                           int32_t n_runs) {
+    run_container_t *answer = run_container_create_given_capacity(n_runs);
+
+    int long_ctr = 0;
+    uint64_t cur_word = bc->words[0];
+    while (true) {
+        while (cur_word == UINT64_C(0) &&
+               long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
+            cur_word = bc->words[++long_ctr];
+
+        if (cur_word == UINT64_C(0)) {
+            return answer;
+        }
+
+        int local_run_start = __builtin_ctzll(cur_word);
+        int run_start = local_run_start + 64 * long_ctr;
+        uint64_t cur_word_with_1s = cur_word | (cur_word - 1);
+
+        int run_end = 0;
+        while (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF) &&
+               long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
+            cur_word_with_1s = bc->words[++long_ctr];
+
+        if (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF)) {
+            run_end = 64 + long_ctr * 64;  // exclusive, I guess
+            add_run(answer, run_start, run_end - 1);
+            return answer;
+        }
+        int local_run_end = __builtin_ctzll(~cur_word_with_1s);
+        run_end = local_run_end + long_ctr * 64;
+        add_run(answer, run_start, run_end - 1);
+        cur_word = cur_word_with_1s & (cur_word_with_1s + 1);
+    }
+}
+
+container_t *convert_bitset_to_compact_container(
+    bitset_container_t *bc, int32_t n_runs,
+    uint8_t *typecode_after
+){
+    int32_t card = bc->cardinality;
+    int32_t size_as_run_container =
+        run_container_serialized_size_in_bytes(n_runs);
+    // arrays are only allowed up to DEFAULT_MAX_SIZE values
+    int32_t size_as_other_container =
+        (card <= DEFAULT_MAX_SIZE)
+            ? array_container_serialized_size_in_bytes(card)
+            : bitset_container_serialized_size_in_bytes();
+    if (n_runs > 0 && size_as_run_container < size_as_other_container) {
+        run_container_t *answer = run_container_from_bitset(bc, n_runs);
+        bitset_container_free(bc);
+        *typecode_after = RUN_CONTAINER_TYPE;
+        return answer;
+    }
+    if (card <= DEFAULT_MAX_SIZE) {
+        array_container_t *answer = array_container_from_bitset(bc);
+        bitset_container_free(bc);
+        *typecode_after = ARRAY_CONTAINER_TYPE;
+        return answer;
+    }
+    *typecode_after = BITSET_CONTAINER_TYPE;
+    return bc;
+}
+
 container_t *convert_run_optimize(
     container_t *c, uint8_t typecode_original,
     uint8_t *typecode_after
@@ -256,45 +330,11 @@ container_t *convert_run_optimize(
             *typecode_after = BITSET_CONTAINER_TYPE;
             return c;
         }
-        // bitset to runcontainer (ported from Java  RunContainer(
-        // BitmapContainer bc, int nbrRuns))
         assert(n_runs > 0);  // no empty bitmaps
-        run_container_t *answer = run_container_create_given_capacity(n_runs);
-
-        int long_ctr = 0;
-        uint64_t cur_word = c_qua_bitset->words[0];
-        while (true) {
-            while (cur_word == UINT64_C(0) &&
-                   long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
-                cur_word = c_qua_bitset->words[++long_ctr];
-
-            if (cur_word == UINT64_C(0)) {
-                bitset_container_free(c_qua_bitset);
-                *typecode_after = RUN_CONTAINER_TYPE;
-                return answer;
-            }
-
-            int local_run_start = __builtin_ctzll(cur_word);
-            int run_start = local_run_start + 64 * long_ctr;
-            uint64_t cur_word_with_1s = cur_word | (cur_word - 1);
-
-            int run_end = 0;
-            while (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF) &&
-                   long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
-                cur_word_with_1s = c_qua_bitset->words[++long_ctr];
-
-            if (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF)) {
-                run_end = 64 + long_ctr * 64;  // exclusive, I guess
-                add_run(answer, run_start, run_end - 1);
-                bitset_container_free(c_qua_bitset);
-                *typecode_after = RUN_CONTAINER_TYPE;
-                return answer;
-            }
-            int local_run_end = __builtin_ctzll(~cur_word_with_1s);
-            run_end = local_run_end + long_ctr * 64;
-            add_run(answer, run_start, run_end - 1);
-            cur_word = cur_word_with_1s & (cur_word_with_1s + 1);
-        }
+        run_container_t *answer =
+            run_container_from_bitset(c_qua_bitset, n_runs);
+        bitset_container_free(c_qua_bitset);
+        *typecode_after = RUN_CONTAINER_TYPE;
         return answer;
     } else {
         assert(false);
@@ -5,6 +5,7 @@
 
 #include <roaring/array_util.h>
 #include <roaring/bitset_util.h>
+#include <roaring/containers/containers.h>
 #include <roaring/containers/convert.h>
 #include <roaring/containers/mixed_intersection.h>
 
@@ -325,6 +326,22 @@ bool bitset_bitset_container_intersection(
     return false;  // not a bitset
 }
 
+int bitset_bitset_container_intersection_adaptive(
+    const bitset_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t n_runs;
+    bitset_container_and_runs(src_1, src_2, ans, &n_runs);
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
 bool bitset_bitset_container_intersection_inplace(
     bitset_container_t *src_1, const bitset_container_t *src_2,
     container_t **dst
@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include <roaring/bitset_util.h>
+#include <roaring/containers/containers.h>
 #include <roaring/containers/convert.h>
 #include <roaring/containers/mixed_union.h>
 #include <roaring/containers/perfparameters.h>
@@ -15,6 +16,94 @@
 extern "C" { namespace roaring { namespace internal {
 #endif
 
+int bitset_bitset_container_union_adaptive(
+    const bitset_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t n_runs;
+    bitset_container_or_runs(src_1, src_2, ans, &n_runs);
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+/* The other pairs whose union is computed as a bitset: the result is built
+ * one word at a time from the words of the bitset and those streamed from
+ * the array or run container, while counting its cardinality and runs. */
+int array_bitset_container_union_adaptive(
+    const array_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word =
+            src_2->words[i] | array_container_next_word(src_1, &pos, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+int run_bitset_container_union_adaptive(
+    const run_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word =
+            src_2->words[i] | run_container_next_word(src_1, &pos, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+int array_array_container_union_adaptive(
+    const array_container_t *src_1, const array_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos_1 = 0, pos_2 = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word = array_container_next_word(src_1, &pos_1, i) |
+                              array_container_next_word(src_2, &pos_2, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
 /* Compute the union of src_1 and src_2 and write the result to
  * dst.  */
 void array_bitset_container_union(const array_container_t *src_1,
@@ -225,6 +314,13 @@ bool array_array_container_inplace_union(
               array_container_grow(src_1, ourbitset->cardinality, false);
             }
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+            if (croaring_avx512()) {
+                bitset_extract_setbits_avx512_uint16(ourbitset->words,
+                        BITSET_CONTAINER_SIZE_IN_WORDS, src_1->array,
+                        ourbitset->cardinality, 0);
+            } else
+#endif
             bitset_extract_setbits_uint16(ourbitset->words, BITSET_CONTAINER_SIZE_IN_WORDS,
                                   src_1->array, 0);
             src_1->cardinality =  ourbitset->cardinality;
@@ -268,6 +268,94 @@ bool bitset_bitset_container_xor(
     }
 }
 
+int bitset_bitset_container_xor_adaptive(
+    const bitset_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t n_runs;
+    bitset_container_xor_runs(src_1, src_2, ans, &n_runs);
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+/* The other pairs whose xor is computed as a bitset: the result is built
+ * one word at a time from the words of the bitset and those streamed from
+ * the array or run container, while counting its cardinality and runs. */
+int array_bitset_container_xor_adaptive(
+    const array_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word =
+            src_2->words[i] ^ array_container_next_word(src_1, &pos, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+int run_bitset_container_xor_adaptive(
+    const run_container_t *src_1, const bitset_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word =
+            src_2->words[i] ^ run_container_next_word(src_1, &pos, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
+int array_array_container_xor_adaptive(
+    const array_container_t *src_1, const array_container_t *src_2,
+    container_t **dst
+){
+    bitset_container_t *ans = bitset_container_create();
+    if (ans == NULL) {
+        *dst = NULL;
+        return BITSET_CONTAINER_TYPE;
+    }
+    int32_t pos_1 = 0, pos_2 = 0, card = 0, n_runs = 0;
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        const uint64_t word = array_container_next_word(src_1, &pos_1, i) ^
+                              array_container_next_word(src_2, &pos_2, i);
+        ans->words[i] = word;
+        bitset_count_word_runs(word, &card, &n_runs, &carry);
+    }
+    ans->cardinality = card;
+    uint8_t typecode;
+    *dst = convert_bitset_to_compact_container(ans, n_runs, &typecode);
+    return typecode;
+}
+
 /* Compute the xor of src_1 and src_2 and write the result to
  * dst (which has no container initially).  It will modify src_1
  * to be dst if the result is a bitset.  Otherwise, it will
@@ -1,5 +1,8 @@
 #include <roaring/memory.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 // without the following, we get lots of warnings about posix_memalign
 #ifndef __cplusplus
@@ -44,26 +47,255 @@ void roaring_init_memory_hook(roaring_memory_t memory_hook) {
     global_memory_hook = memory_hook;
 }
 
+/*
+ * Arenas.
+ *
+ * Every allocation is preceded by a header recording its size, so that
+ * roaring_realloc can copy the old content. The header keeps the payload
+ * aligned like malloc would.
+ */
+#if defined(__cplusplus)
+#define ROARING_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define ROARING_THREAD_LOCAL __declspec(thread)
+#else
+#define ROARING_THREAD_LOCAL _Thread_local
+#endif
+
+enum { ARENA_HEADER_SIZE = 16, ARENA_MIN_CHUNK_SIZE = 4096 };
+
+typedef struct roaring_arena_chunk_s {
+    struct roaring_arena_chunk_s *next;
+    size_t capacity;
+    size_t used;
+    char *data;
+} roaring_arena_chunk_t;
+
+struct roaring_arena_s {
+    roaring_arena_chunk_t *chunks;  // the current chunk comes first
+    size_t used;
+    char *last;  // most recent allocation, can be resized in place
+    struct roaring_arena_s *next;  // next arena of the same thread
+};
+
+static ROARING_THREAD_LOCAL roaring_arena_t *active_arena = NULL;
+
+// The arenas created on this thread and not yet freed, so that their memory
+// is recognized whether or not they are active (e.g., when an outer arena's
+// bitmap is freed while an inner one is active, or after deactivation).
+static ROARING_THREAD_LOCAL roaring_arena_t *thread_arenas = NULL;
+
+static roaring_arena_chunk_t *arena_new_chunk(size_t capacity) {
+    roaring_arena_chunk_t *chunk = (roaring_arena_chunk_t *)
+        global_memory_hook.malloc(sizeof(roaring_arena_chunk_t) + capacity);
+    if (chunk == NULL) return NULL;
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->data = (char *)(chunk + 1);
+    return chunk;
+}
+
+roaring_arena_t *roaring_arena_create(size_t initial_capacity) {
+    roaring_arena_t *arena =
+        (roaring_arena_t *)global_memory_hook.malloc(sizeof(roaring_arena_t));
+    if (arena == NULL) return NULL;
+    if (initial_capacity < ARENA_MIN_CHUNK_SIZE) {
+        initial_capacity = ARENA_MIN_CHUNK_SIZE;
+    }
+    arena->chunks = arena_new_chunk(initial_capacity);
+    if (arena->chunks == NULL) {
+        global_memory_hook.free(arena);
+        return NULL;
+    }
+    arena->used = 0;
+    arena->last = NULL;
+    arena->next = thread_arenas;
+    thread_arenas = arena;
+    return arena;
+}
+
+void roaring_arena_reset(roaring_arena_t *arena) {
+    roaring_arena_chunk_t *chunk = arena->chunks;
+    if (chunk->next != NULL) {
+        // coalesce into one chunk that can hold everything next time, or
+        // keep the current (largest) chunk if that allocation fails
+        size_t total = 0;
+        for (; chunk != NULL; chunk = chunk->next) total += chunk->capacity;
+        roaring_arena_chunk_t *kept = arena_new_chunk(total);
+        chunk = arena->chunks;
+        if (kept == NULL) {
+            kept = chunk;
+            chunk = chunk->next;
+            kept->next = NULL;
+        }
+        while (chunk != NULL) {
+            roaring_arena_chunk_t *next = chunk->next;
+            global_memory_hook.free(chunk);
+            chunk = next;
+        }
+        arena->chunks = kept;
+    }
+    arena->chunks->used = 0;
+    arena->used = 0;
+    arena->last = NULL;
+}
+
+void roaring_arena_free(roaring_arena_t *arena) {
+    if (arena == NULL) return;
+    if (active_arena == arena) active_arena = NULL;
+    for (roaring_arena_t **link = &thread_arenas; *link != NULL;
+         link = &(*link)->next) {
+        if (*link == arena) {
+            *link = arena->next;
+            break;
+        }
+    }
+    roaring_arena_chunk_t *chunk = arena->chunks;
+    while (chunk != NULL) {
+        roaring_arena_chunk_t *next = chunk->next;
+        global_memory_hook.free(chunk);
+        chunk = next;
+    }
+    global_memory_hook.free(arena);
+}
+
+roaring_arena_t *roaring_arena_activate(roaring_arena_t *arena) {
+    roaring_arena_t *previous = active_arena;
+    active_arena = arena;
+    return previous;
+}
+
+size_t roaring_arena_used(const roaring_arena_t *arena) {
+    return arena->used;
+}
+
+static bool arena_owns(const roaring_arena_t *arena, const void *p) {
+    for (const roaring_arena_chunk_t *chunk = arena->chunks; chunk != NULL;
+         chunk = chunk->next) {
+        if (((const char *)p >= chunk->data) &&
+            ((const char *)p < chunk->data + chunk->capacity)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The arena of this thread that handed out p, if any.
+static roaring_arena_t *arena_owner(const void *p) {
+    if ((p == NULL) || (thread_arenas == NULL)) return NULL;
+    if ((active_arena != NULL) && arena_owns(active_arena, p)) {
+        return active_arena;
+    }
+    for (roaring_arena_t *arena = thread_arenas; arena != NULL;
+         arena = arena->next) {
+        if ((arena != active_arena) && arena_owns(arena, p)) return arena;
+    }
+    return NULL;
+}
+
+static inline size_t arena_payload_size(const void *p) {
+    size_t size;
+    memcpy(&size, (const char *)p - ARENA_HEADER_SIZE, sizeof(size));
+    return size;
+}
+
+// alignment must be a power of two, at least ARENA_HEADER_SIZE
+static void *arena_allocate(roaring_arena_t *arena, size_t size,
+                            size_t alignment) {
+    roaring_arena_chunk_t *chunk = arena->chunks;
+    uintptr_t start = (uintptr_t)(chunk->data + chunk->used);
+    uintptr_t payload = (start + ARENA_HEADER_SIZE + alignment - 1) &
+                        ~(uintptr_t)(alignment - 1);
+    if (payload + size > (uintptr_t)(chunk->data + chunk->capacity)) {
+        size_t needed = size + ARENA_HEADER_SIZE + alignment;
+        size_t capacity = 2 * chunk->capacity;
+        if (capacity < needed) capacity = needed;
+        roaring_arena_chunk_t *fresh = arena_new_chunk(capacity);
+        if (fresh == NULL) return NULL;
+        fresh->next = chunk;
+        arena->chunks = chunk = fresh;
+        start = (uintptr_t)chunk->data;
+        payload = (start + ARENA_HEADER_SIZE + alignment - 1) &
+                  ~(uintptr_t)(alignment - 1);
+    }
+    memcpy((char *)payload - ARENA_HEADER_SIZE, &size, sizeof(size));
+    size_t consumed = (size_t)(payload + size - start);
+    chunk->used += consumed;
+    arena->used += consumed;
+    arena->last = (char *)payload;
+    return (void *)payload;
+}
+
+static void *arena_reallocate(roaring_arena_t *arena, void *p,
+                              size_t new_sz) {
+    size_t old_sz = arena_payload_size(p);
+    roaring_arena_chunk_t *chunk = arena->chunks;
+    if ((p == arena->last) &&
+        ((char *)p + new_sz <= chunk->data + chunk->capacity)) {
+        // the most recent allocation grows or shrinks in place
+        chunk->used = (size_t)((char *)p + new_sz - chunk->data);
+        arena->used = arena->used - old_sz + new_sz;
+        memcpy((char *)p - ARENA_HEADER_SIZE, &new_sz, sizeof(new_sz));
+        return p;
+    }
+    void *answer = arena_allocate(arena, new_sz, ARENA_HEADER_SIZE);
+    if (answer != NULL) {
+        memcpy(answer, p, old_sz < new_sz ? old_sz : new_sz);
+    }
+    return answer;
+}
+
 void* roaring_malloc(size_t n) {
+    if (active_arena != NULL) {
+        return arena_allocate(active_arena, n, ARENA_HEADER_SIZE);
+    }
     return global_memory_hook.malloc(n);
 }
 
 void* roaring_realloc(void* p, size_t new_sz) {
+    if ((active_arena != NULL) && (p == NULL)) {
+        return arena_allocate(active_arena, new_sz, ARENA_HEADER_SIZE);
+    }
+    // arena memory stays in the arena it came from
+    roaring_arena_t *owner = arena_owner(p);
+    if (owner != NULL) {
+        return arena_reallocate(owner, p, new_sz);
+    }
     return global_memory_hook.realloc(p, new_sz);
 }
 
 void* roaring_calloc(size_t n_elements, size_t element_size) {
+    if (active_arena != NULL) {
+        size_t size = n_elements * element_size;
+        if ((element_size != 0) && (size / element_size != n_elements)) {
+            return NULL;  // overflow
+        }
+        void *answer = arena_allocate(active_arena, size, ARENA_HEADER_SIZE);
+        if (answer != NULL) memset(answer, 0, size);
+        return answer;
+    }
     return global_memory_hook.calloc(n_elements, element_size);
 }
 
 void roaring_free(void* p) {
+    if (arena_owner(p) != NULL) {
+        return;  // released by roaring_arena_reset
+    }
     global_memory_hook.free(p);
 }
 
 void* roaring_aligned_malloc(size_t alignment, size_t size) {
+    if (active_arena != NULL) {
+        if (alignment < ARENA_HEADER_SIZE) alignment = ARENA_HEADER_SIZE;
+        return arena_allocate(active_arena, size, alignment);
+    }
     return global_memory_hook.aligned_malloc(alignment, size);
 }
 
 void roaring_aligned_free(void* p) {
+    if (arena_owner(p) != NULL) {
+        return;  // released by roaring_arena_reset
+    }
     global_memory_hook.aligned_free(p);
 }
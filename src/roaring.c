@@ -12,6 +12,11 @@
 #include <roaring/bitset_util.h>
 #include <roaring/array_util.h>
 
+#if ROARING_HAS_WRITEV
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+
 #ifdef __cplusplus
 using namespace ::roaring::internal;
 
@@ -23,6 +28,10 @@ extern "C" { namespace roaring { namespace api {
 
 extern inline bool roaring_bitmap_get_copy_on_write(const roaring_bitmap_t* r);
 extern inline void roaring_bitmap_set_copy_on_write(roaring_bitmap_t* r, bool cow);
+extern inline bool roaring_bitmap_get_adaptive_containers(
+    const roaring_bitmap_t* r);
+extern inline void roaring_bitmap_set_adaptive_containers(roaring_bitmap_t* r,
+                                                          bool adaptive);
 
 static inline bool is_cow(const roaring_bitmap_t *r) {
     return r->high_low_container.flags & ROARING_FLAG_COW;
@@ -30,6 +39,9 @@ static inline bool is_cow(const roaring_bitmap_t *r) {
 static inline bool is_frozen(const roaring_bitmap_t *r) {
     return r->high_low_container.flags & ROARING_FLAG_FROZEN;
 }
+static inline bool is_adaptive(const roaring_bitmap_t *r) {
+    return r->high_low_container.flags & ROARING_FLAG_ADAPTIVE;
+}
 
 // this is like roaring_bitmap_add, but it populates pointer arguments in such a
 // way
@@ -117,8 +129,172 @@ static inline void add_bulk_impl(roaring_bitmap_t *r,
     }
 }
 
+// Sorts the `n` values of `in` with a least-significant-byte-first radix
+// sort, skipping the passes where all values have the same byte. `buf1` and
+// `buf2` must hold `n` values each; the result is in one of them.
+static uint32_t *radix_sort_uint32(const uint32_t *in, size_t n,
+                                   uint32_t *buf1, uint32_t *buf2) {
+    size_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        uint32_t v = in[i];
+        counts[0][v & 0xFF]++;
+        counts[1][(v >> 8) & 0xFF]++;
+        counts[2][(v >> 16) & 0xFF]++;
+        counts[3][v >> 24]++;
+    }
+    const uint32_t *src = in;
+    uint32_t *dst = buf1;
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = 8 * pass;
+        size_t *c = counts[pass];
+        if (c[(src[0] >> shift) & 0xFF] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t count = c[b];
+            c[b] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[c[(src[i] >> shift) & 0xFF]++] = src[i];
+        }
+        src = dst;
+        dst = (dst == buf1) ? buf2 : buf1;
+    }
+    if (src == in) {
+        memcpy(buf1, in, n * sizeof(uint32_t));
+        return buf1;
+    }
+    return (uint32_t *)src;
+}
+
+// Adds the `m` distinct sorted values `lows` to the container of `key`,
+// creating it if needed, with the container type that adding them one by one
+// gives: arrays turn into bitsets past DEFAULT_MAX_SIZE values, bitsets and
+// runs keep their type. Returns false if memory could not be allocated.
+static bool add_many_sorted_lows(roaring_array_t *ra, uint16_t key,
+                                 uint16_t *lows, int32_t m) {
+    array_container_t view;  // the values to add, as an array container
+    view.cardinality = m;
+    view.capacity = m;
+    view.array = lows;
+    int32_t i = ra_get_index(ra, key);
+    if (i < 0) {
+        container_t *c;
+        uint8_t typecode;
+        if (m <= DEFAULT_MAX_SIZE) {
+            c = array_container_create_given_capacity(m);
+            if (c != NULL) {
+                array_container_copy(&view, CAST_array(c));
+            }
+            typecode = ARRAY_CONTAINER_TYPE;
+        } else {
+            c = bitset_container_from_array(&view);
+            typecode = BITSET_CONTAINER_TYPE;
+        }
+        if (c == NULL) {
+            return false;
+        }
+        ra_insert_new_key_value_at(ra, -i - 1, key, c, typecode);
+        return true;
+    }
+    ra_unshare_container_at_index(ra, (uint16_t)i);
+    uint8_t typecode;
+    container_t *c = ra_get_container_at_index(ra, (uint16_t)i, &typecode);
+    if (typecode == BITSET_CONTAINER_TYPE) {
+        array_bitset_container_union(&view, CAST_bitset(c), CAST_bitset(c));
+        return true;
+    }
+    if (typecode == RUN_CONTAINER_TYPE) {
+        array_run_container_inplace_union(&view, CAST_run(c));
+        return true;
+    }
+    container_t *result;
+    bool is_bitset =
+        array_array_container_inplace_union(CAST_array(c), &view, &result);
+    if (result == NULL) {
+        return !is_bitset;  // done in place, unless the allocation failed
+    }
+    if (result != c) {
+        array_container_free(CAST_array(c));
+        ra_set_container_at_index(
+            ra, i, result,
+            is_bitset ? BITSET_CONTAINER_TYPE : ARRAY_CONTAINER_TYPE);
+    }
+    return true;
+}
+
+// Adds a batch of values in no particular order: they are radix sorted into
+// scratch buffers, then the values of each 16-bit key are deduplicated into
+// the spare buffer and merged into the container of that key. Returns false
+// if memory could not be allocated, in which case some of the values may
+// have been added.
+static bool add_many_partitioned(roaring_bitmap_t *r, size_t n,
+                                 const uint32_t *vals) {
+    uint32_t *scratch = (uint32_t *)roaring_malloc(2 * n * sizeof(uint32_t));
+    if (scratch == NULL) {
+        return false;
+    }
+    uint32_t *sorted = radix_sort_uint32(vals, n, scratch, scratch + n);
+    uint16_t *lows = (uint16_t *)(sorted == scratch ? scratch + n : scratch);
+    bool ok = true;
+    size_t begin = 0;
+    while (ok && begin < n) {
+        const uint32_t high = sorted[begin] >> 16;
+        int32_t m = 0;
+        size_t end = begin;
+        for (; end < n && (sorted[end] >> 16) == high; end++) {
+            const uint16_t low = (uint16_t)sorted[end];
+            if (m == 0 || lows[m - 1] != low) {
+                lows[m++] = low;
+            }
+        }
+        ok = add_many_sorted_lows(&r->high_low_container, (uint16_t)high,
+                                  lows, m);
+        begin = end;
+    }
+    roaring_free(scratch);
+    return ok;
+}
+
+// Batches of at least ADD_MANY_PARTITION_MIN values whose first
+// ADD_MANY_PARTITION_MIN values change their 16-bit key more often than once
+// every ADD_MANY_PARTITION_RUN values go through add_many_partitioned(), in
+// chunks of ADD_MANY_PARTITION_CHUNK values to keep the scratch buffers in
+// cache.
+enum {
+    ADD_MANY_PARTITION_MIN = 1024,
+    ADD_MANY_PARTITION_RUN = 16,
+    ADD_MANY_PARTITION_CHUNK = 1 << 16
+};
+
 void roaring_bitmap_add_many(roaring_bitmap_t *r, size_t n_args,
                              const uint32_t *vals) {
+    ra_bump_version(&r->high_low_container);
+    if (n_args >= ADD_MANY_PARTITION_MIN) {
+        size_t key_changes = 0;
+        for (size_t i = 1; i < ADD_MANY_PARTITION_MIN; i++) {
+            key_changes += ((vals[i] ^ vals[i - 1]) >> 16) != 0;
+        }
+        if (key_changes * ADD_MANY_PARTITION_RUN > ADD_MANY_PARTITION_MIN) {
+            size_t done = 0;
+            while (done < n_args) {
+                size_t len = n_args - done;
+                if (len > ADD_MANY_PARTITION_CHUNK) {
+                    len = ADD_MANY_PARTITION_CHUNK;
+                }
+                if (!add_many_partitioned(r, len, vals + done)) {
+                    break;  // the generic path adds this chunk again
+                }
+                done += len;
+            }
+            vals += done;
+            n_args -= done;
+        }
+    }
+
     uint32_t val;
     const uint32_t *start = vals;
     const uint32_t *end = vals + n_args;
@@ -143,6 +319,7 @@ void roaring_bitmap_add_many(roaring_bitmap_t *r, size_t n_args,
 
 void roaring_bitmap_add_bulk(roaring_bitmap_t *r,
                              roaring_bulk_context_t *context, uint32_t val) {
+    ra_bump_version(&r->high_low_container);
     add_bulk_impl(r, context, val);
 }
 
@@ -174,12 +351,365 @@ bool roaring_bitmap_contains_bulk(const roaring_bitmap_t *r,
     return container_contains(context->container, val & 0xFFFF, context->typecode);
 }
 
+// Returns the index of the first element >= `val` in the sorted `array`,
+// between `start` and `card`. The search is branchless down to a block of 16
+// elements, which is then counted with a loop compilers vectorize.
+static inline int32_t array_lower_bound(const uint16_t *array, int32_t start,
+                                        int32_t card, uint16_t val) {
+    const uint16_t *base = array + start;
+    int32_t n = card - start;
+    while (n > 16) {
+        int32_t half = n >> 1;
+        base = (base[half] < val) ? base + half : base;
+        n -= half;
+    }
+    int32_t pos = 0;
+    for (int32_t i = 0; i < n; i++) {
+        pos += base[i] < val;
+    }
+    return (int32_t)(base - array) + pos;
+}
+
+// Returns the index of the first run ending at or after `val` in `runs`,
+// between `start` and `n_runs`, with the same branchless search.
+static inline int32_t run_lower_bound(const rle16_t *runs, int32_t start,
+                                      int32_t n_runs, uint16_t val) {
+    const rle16_t *base = runs + start;
+    int32_t n = n_runs - start;
+    while (n > 16) {
+        int32_t half = n >> 1;
+        base = ((uint32_t)base[half].value + base[half].length < val)
+                   ? base + half : base;
+        n -= half;
+    }
+    int32_t pos = 0;
+    for (int32_t i = 0; i < n; i++) {
+        pos += (uint32_t)base[i].value + base[i].length < val;
+    }
+    return (int32_t)(base - runs) + pos;
+}
+
+// Sets the bit of `mask` at position `i + k`, or `pos[k]` if `pos` is not
+// NULL, for each value `vals[k]` that is in container `c`. All `n` values
+// share the key of the container. A run of increasing probes resumes its
+// search where the previous probe stopped.
+static void container_contains_many(const container_t *c, uint8_t typecode,
+                                    const uint32_t *vals, size_t n,
+                                    uint64_t *mask, size_t i,
+                                    const uint32_t *pos) {
+    c = container_unwrap_shared(c, &typecode);
+    for (size_t k = 0; k < n;) {
+        // Each block of up to 64 probes gets its bits in `bits` first.
+        size_t block_end = n - k < 64 ? n : k + 64;
+        uint64_t bits = 0;
+        switch (typecode) {
+            case BITSET_CONTAINER_TYPE: {
+                const uint64_t *words = const_CAST_bitset(c)->words;
+                for (size_t b = 0; k + b < block_end; b++) {
+                    uint16_t low = (uint16_t)vals[k + b];
+                    bits |= ((words[low >> 6] >> (low & 63)) & 1) << b;
+                }
+                break;
+            }
+            case ARRAY_CONTAINER_TYPE: {
+                const array_container_t *ac = const_CAST_array(c);
+                int32_t p = 0;
+                uint16_t prev = 0;
+                for (size_t b = 0; k + b < block_end; b++) {
+                    uint16_t low = (uint16_t)vals[k + b];
+                    if (low < prev) p = 0;
+                    p = array_lower_bound(ac->array, p, ac->cardinality, low);
+                    uint64_t bit = (p < ac->cardinality) &&
+                                   (ac->array[p] == low);
+                    bits |= bit << b;
+                    prev = low;
+                }
+                break;
+            }
+            case RUN_CONTAINER_TYPE: {
+                const run_container_t *rc = const_CAST_run(c);
+                int32_t r = 0;
+                uint16_t prev = 0;
+                for (size_t b = 0; k + b < block_end; b++) {
+                    uint16_t low = (uint16_t)vals[k + b];
+                    if (low < prev) r = 0;
+                    r = run_lower_bound(rc->runs, r, rc->n_runs, low);
+                    uint64_t bit = (r < rc->n_runs) &&
+                                   (rc->runs[r].value <= low);
+                    bits |= bit << b;
+                    prev = low;
+                }
+                break;
+            }
+            default:
+                assert(false);
+                __builtin_unreachable();
+        }
+        while (bits != 0) {
+            size_t b = k + __builtin_ctzll(bits);
+            size_t target = (pos != NULL) ? pos[b] : i + b;
+            mask[target >> 6] |= UINT64_C(1) << (target & 63);
+            bits &= bits - 1;
+        }
+        k = block_end;
+    }
+}
+
+// Tests the probes `vals[0..n)` against the containers of `ra`, one run of
+// equal keys at a time. The containers are looked up from the position of
+// the previous one, `*idx`, when keys increase.
+static void contains_many_grouped(const roaring_array_t *ra,
+                                  const uint32_t *vals, size_t n,
+                                  uint64_t *mask, const uint32_t *pos,
+                                  int32_t *idx) {
+    size_t i = 0;
+    while (i < n) {
+        uint16_t key = vals[i] >> 16;
+        size_t end = i + 1;
+        while (end < n && (vals[end] >> 16) == key) {
+            end++;
+        }
+        int32_t start_idx = -1;
+        if (*idx >= 0 && *idx < ra->size && ra->keys[*idx] < key) {
+            start_idx = *idx;
+        }
+        int32_t k = ra_advance_until(ra, key, start_idx);
+        if (k < ra->size && ra->keys[k] == key) {
+            container_contains_many(ra->containers[k], ra->typecodes[k],
+                                    vals + i, end - i, mask, i,
+                                    pos == NULL ? NULL : pos + i);
+            *idx = k;
+        }
+        i = end;
+    }
+}
+
+// Probes whose key changes more than once every CONTAINS_MANY_PARTITION_RUN
+// values on average are first partitioned by key, CONTAINS_MANY_CHUNK values
+// at a time, so that each container is visited once per chunk.
+enum {
+    CONTAINS_MANY_PARTITION_MIN = 1024,
+    CONTAINS_MANY_PARTITION_RUN = 16,
+    CONTAINS_MANY_CHUNK = 1 << 16
+};
+
+// Stable radix sort of the `n` probes by key, two bytes at a time, keeping
+// their original positions alongside. Returns false on allocation failure.
+static bool contains_many_partitioned(const roaring_array_t *ra,
+                                      const uint32_t *vals, size_t n,
+                                      uint64_t *mask) {
+    uint32_t *scratch = (uint32_t *)roaring_malloc(4 * n * sizeof(uint32_t));
+    if (scratch == NULL) {
+        return false;
+    }
+    uint32_t *vals_out[2] = {scratch, scratch + n};
+    uint32_t *pos_out[2] = {scratch + 2 * n, scratch + 3 * n};
+    const uint32_t *src_vals = vals;
+    const uint32_t *src_pos = NULL;
+    int out = 0;
+    for (int shift = 16; shift < 32; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; i++) {
+            counts[(src_vals[i] >> shift) & 0xFF]++;
+        }
+        if (counts[(src_vals[0] >> shift) & 0xFF] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t count = counts[b];
+            counts[b] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t dst = counts[(src_vals[i] >> shift) & 0xFF]++;
+            vals_out[out][dst] = src_vals[i];
+            pos_out[out][dst] = (src_pos == NULL) ? (uint32_t)i : src_pos[i];
+        }
+        src_vals = vals_out[out];
+        src_pos = pos_out[out];
+        out ^= 1;
+    }
+    int32_t idx = -1;
+    contains_many_grouped(ra, src_vals, n, mask, src_pos, &idx);
+    roaring_free(scratch);
+    return true;
+}
+
+// Fills `mask`, which must be zeroed, for the `n` probes in `vals`. `idx`
+// carries the position of the last container visited between calls.
+static void contains_many_impl(const roaring_array_t *ra, const uint32_t *vals,
+                               size_t n, uint64_t *mask, int32_t *idx) {
+    if (n >= CONTAINS_MANY_PARTITION_MIN) {
+        size_t key_changes = 0;
+        for (size_t i = 1; i < n; i++) {
+            key_changes += ((vals[i] ^ vals[i - 1]) >> 16) != 0;
+        }
+        if (key_changes * CONTAINS_MANY_PARTITION_RUN > n &&
+            contains_many_partitioned(ra, vals, n, mask)) {
+            return;
+        }
+    }
+    contains_many_grouped(ra, vals, n, mask, NULL, idx);
+}
+
+void roaring_bitmap_contains_many(const roaring_bitmap_t *r,
+                                  const uint32_t *vals, size_t n,
+                                  uint64_t *out_mask) {
+    memset(out_mask, 0, ((n + 63) / 64) * sizeof(uint64_t));
+    int32_t idx = -1;
+    for (size_t base = 0; base < n; base += CONTAINS_MANY_CHUNK) {
+        size_t len = n - base;
+        if (len > CONTAINS_MANY_CHUNK) len = CONTAINS_MANY_CHUNK;
+        // CONTAINS_MANY_CHUNK is a multiple of 64
+        contains_many_impl(&r->high_low_container, vals + base, len,
+                           out_mask + base / 64, &idx);
+    }
+}
+
+size_t roaring_bitmap_filter_array(const roaring_bitmap_t *r,
+                                   const uint32_t *vals, size_t n,
+                                   uint32_t *out) {
+    // Probes go through a mask one chunk at a time, which is then compacted.
+    uint64_t mask[CONTAINS_MANY_CHUNK / 64];
+    int32_t idx = -1;
+    size_t count = 0;
+    for (size_t base = 0; base < n; base += CONTAINS_MANY_CHUNK) {
+        size_t len = n - base;
+        if (len > CONTAINS_MANY_CHUNK) len = CONTAINS_MANY_CHUNK;
+        size_t num_words = (len + 63) / 64;
+        memset(mask, 0, num_words * sizeof(uint64_t));
+        contains_many_impl(&r->high_low_container, vals + base, len, mask,
+                           &idx);
+        for (size_t w = 0; w < num_words; w++) {
+            uint64_t word = mask[w];
+            while (word != 0) {
+                size_t k = base + 64 * w + __builtin_ctzll(word);
+                out[count++] = vals[k];
+                word &= word - 1;
+            }
+        }
+    }
+    return count;
+}
+
 roaring_bitmap_t *roaring_bitmap_of_ptr(size_t n_args, const uint32_t *vals) {
     roaring_bitmap_t *answer = roaring_bitmap_create();
     roaring_bitmap_add_many(answer, n_args, vals);
     return answer;
 }
 
+// Builds the container holding `vals[0..len)`, which share their high 16 bits
+// and are sorted. `card` and `n_runs` count the distinct values and the runs
+// of consecutive values. The container type is chosen as in
+// convert_run_to_efficient_container() and allocated at its final size.
+static container_t *container_from_sorted(const uint32_t *vals, size_t len,
+                                          int32_t card, int32_t n_runs,
+                                          uint8_t *typecode) {
+    int32_t size_as_run = run_container_serialized_size_in_bytes(n_runs);
+    int32_t size_as_bitset = bitset_container_serialized_size_in_bytes();
+    int32_t size_as_array = array_container_serialized_size_in_bytes(card);
+    int32_t min_size_non_run =
+        size_as_bitset < size_as_array ? size_as_bitset : size_as_array;
+    if (size_as_run <= min_size_non_run) {
+        run_container_t *run = run_container_create_given_capacity(n_runs);
+        if (run == NULL) return NULL;
+        rle16_t *runs = run->runs;
+        uint16_t start = (uint16_t)vals[0];
+        uint16_t last = start;
+        for (size_t i = 1; i < len; i++) {
+            uint16_t v = (uint16_t)vals[i];
+            if (v > last + 1) {
+                *runs++ = MAKE_RLE16(start, last - start);
+                start = v;
+            }
+            last = v;
+        }
+        *runs = MAKE_RLE16(start, last - start);
+        run->n_runs = n_runs;
+        *typecode = RUN_CONTAINER_TYPE;
+        return run;
+    }
+    if (card <= DEFAULT_MAX_SIZE) {
+        array_container_t *array = array_container_create_given_capacity(card);
+        if (array == NULL) return NULL;
+        uint16_t *out = array->array;
+        if ((size_t)card == len) {
+            // no duplicates: a plain narrowing copy, which compilers vectorize
+            for (size_t i = 0; i < len; i++) {
+                out[i] = (uint16_t)vals[i];
+            }
+        } else {
+            out[0] = (uint16_t)vals[0];
+            int32_t pos = 1;
+            for (size_t i = 1; i < len; i++) {
+                if (vals[i] != vals[i - 1]) {
+                    out[pos++] = (uint16_t)vals[i];
+                }
+            }
+        }
+        array->cardinality = card;
+        *typecode = ARRAY_CONTAINER_TYPE;
+        return array;
+    }
+    bitset_container_t *bitset = bitset_container_create();
+    if (bitset == NULL) return NULL;
+    uint64_t *words = bitset->words;
+    size_t i = 0;
+    while (i < len) {
+        // fill whole runs at once
+        uint32_t start = vals[i] & 0xFFFF;
+        uint32_t last = start;
+        for (i++; i < len && (vals[i] & 0xFFFF) <= last + 1; i++) {
+            last = vals[i] & 0xFFFF;
+        }
+        bitset_set_lenrange(words, start, last - start);
+    }
+    bitset->cardinality = card;
+    *typecode = BITSET_CONTAINER_TYPE;
+    return bitset;
+}
+
+roaring_bitmap_t *roaring_bitmap_from_sorted(const uint32_t *vals, size_t n) {
+    uint32_t capacity = 0;
+    if (n > 0 && vals[0] <= vals[n - 1]) {
+        capacity = (vals[n - 1] >> 16) - (vals[0] >> 16) + 1;
+        if (n < capacity) capacity = (uint32_t)n;
+    }
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(capacity);
+    if (answer == NULL) return NULL;
+    size_t begin = 0;
+    while (begin < n) {
+        // One pass over the chunk counts its values and runs, and checks that
+        // the input is indeed sorted.
+        uint32_t key = vals[begin] >> 16;
+        int32_t card = 1;
+        int32_t n_runs = 1;
+        size_t end = begin + 1;
+        for (; end < n && (vals[end] >> 16) == key; end++) {
+            uint32_t prev = vals[end - 1];
+            if (vals[end] < prev) break;
+            card += (vals[end] != prev);
+            n_runs += (vals[end] > prev + 1);
+        }
+        if (end < n && vals[end] < vals[end - 1]) {
+            // not sorted after all: fall back on the generic path
+            roaring_bitmap_free(answer);
+            return roaring_bitmap_of_ptr(n, vals);
+        }
+        uint8_t typecode;
+        container_t *c = container_from_sorted(vals + begin, end - begin, card,
+                                               n_runs, &typecode);
+        if (c == NULL) {
+            roaring_bitmap_free(answer);
+            return NULL;
+        }
+        ra_append(&answer->high_low_container, (uint16_t)key, c, typecode);
+        begin = end;
+    }
+    return answer;
+}
+
 roaring_bitmap_t *roaring_bitmap_of(size_t n_args, ...) {
     // todo: could be greatly optimized but we do not expect this call to ever
     // include long lists
@@ -234,6 +764,7 @@ roaring_bitmap_t *roaring_bitmap_from_range(uint64_t min, uint64_t max,
 }
 
 void roaring_bitmap_add_range_closed(roaring_bitmap_t *r, uint32_t min, uint32_t max) {
+    ra_bump_version(&r->high_low_container);
     if (min > max) {
         return;
     }
@@ -284,6 +815,7 @@ void roaring_bitmap_add_range_closed(roaring_bitmap_t *r, uint32_t min, uint32_t
 }
 
 void roaring_bitmap_remove_range_closed(roaring_bitmap_t *r, uint32_t min, uint32_t max) {
+    ra_bump_version(&r->high_low_container);
     if (min > max) {
         return;
     }
@@ -350,7 +882,8 @@ void roaring_bitmap_printf_describe(const roaring_bitmap_t *r) {
         if (ra->typecodes[i] == SHARED_CONTAINER_TYPE) {
             printf(
                 "(shared count = %" PRIu32 " )",
-                    CAST_shared(ra->containers[i])->counter);
+                    croaring_refcount_get(
+                        &CAST_shared(ra->containers[i])->counter));
         }
 
         if (i + 1 < ra->size) {
@@ -443,12 +976,15 @@ roaring_bitmap_t *roaring_bitmap_copy(const roaring_bitmap_t *r) {
         return NULL;
     }
     roaring_bitmap_set_copy_on_write(ans, is_cow(r));
+    roaring_bitmap_set_adaptive_containers(ans, is_adaptive(r));
     return ans;
 }
 
 bool roaring_bitmap_overwrite(roaring_bitmap_t *dest,
                                      const roaring_bitmap_t *src) {
+    ra_bump_version(&dest->high_low_container);
     roaring_bitmap_set_copy_on_write(dest, is_cow(src));
+    roaring_bitmap_set_adaptive_containers(dest, is_adaptive(src));
     return ra_overwrite(&src->high_low_container, &dest->high_low_container,
                         is_cow(src));
 }
@@ -461,10 +997,12 @@ void roaring_bitmap_free(const roaring_bitmap_t *r) {
 }
 
 void roaring_bitmap_clear(roaring_bitmap_t *r) {
+  ra_bump_version(&r->high_low_container);
   ra_reset(&r->high_low_container);
 }
 
 void roaring_bitmap_add(roaring_bitmap_t *r, uint32_t val) {
+    ra_bump_version(&r->high_low_container);
     roaring_array_t *ra = &r->high_low_container;
 
     const uint16_t hb = val >> 16;
@@ -493,6 +1031,7 @@ void roaring_bitmap_add(roaring_bitmap_t *r, uint32_t val) {
 }
 
 bool roaring_bitmap_add_checked(roaring_bitmap_t *r, uint32_t val) {
+    ra_bump_version(&r->high_low_container);
     const uint16_t hb = val >> 16;
     const int i = ra_get_index(&r->high_low_container, hb);
     uint8_t typecode;
@@ -533,6 +1072,7 @@ bool roaring_bitmap_add_checked(roaring_bitmap_t *r, uint32_t val) {
 }
 
 void roaring_bitmap_remove(roaring_bitmap_t *r, uint32_t val) {
+    ra_bump_version(&r->high_low_container);
     const uint16_t hb = val >> 16;
     const int i = ra_get_index(&r->high_low_container, hb);
     uint8_t typecode;
@@ -558,6 +1098,7 @@ void roaring_bitmap_remove(roaring_bitmap_t *r, uint32_t val) {
 }
 
 bool roaring_bitmap_remove_checked(roaring_bitmap_t *r, uint32_t val) {
+    ra_bump_version(&r->high_low_container);
     const uint16_t hb = val >> 16;
     const int i = ra_get_index(&r->high_low_container, hb);
     uint8_t typecode;
@@ -596,6 +1137,7 @@ bool roaring_bitmap_remove_checked(roaring_bitmap_t *r, uint32_t val) {
 
 void roaring_bitmap_remove_many(roaring_bitmap_t *r, size_t n_args,
                                 const uint32_t *vals) {
+    ra_bump_version(&r->high_low_container);
     if (n_args == 0 || r->high_low_container.size == 0) {
         return;
     }
@@ -637,6 +1179,8 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
     uint32_t neededcap = length1 > length2 ? length2 : length1;
     roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(neededcap);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) || is_cow(x2));
+    const bool adaptive = is_adaptive(x1) || is_adaptive(x2);
+    roaring_bitmap_set_adaptive_containers(answer, adaptive);
 
     int pos1 = 0, pos2 = 0;
 
@@ -650,7 +1194,10 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
                                     &x1->high_low_container, pos1, &type1);
             container_t *c2 = ra_get_container_at_index(
                                     &x2->high_low_container, pos2, &type2);
-            container_t *c = container_and(c1, type1, c2, type2, &result_type);
+            container_t *c =
+                adaptive
+                    ? container_and_adaptive(c1, type1, c2, type2, &result_type)
+                    : container_and(c1, type1, c2, type2, &result_type);
 
             if (container_nonzero_cardinality(c, result_type)) {
                 ra_append(&answer->high_low_container, s1, c, result_type);
@@ -707,9 +1254,641 @@ roaring_bitmap_t *roaring_bitmap_xor_many(size_t number,
     return answer;
 }
 
+/**
+ * Compute the intersection of 'number' bitmaps.
+ *
+ * The keys are intersected first: we walk the keys of the bitmap having the
+ * fewest containers and gallop through the keys of the other bitmaps. Only
+ * then do we intersect the containers for the surviving keys, starting with
+ * the smallest containers so that intermediate results stay small and we can
+ * bail out as soon as one of them is empty.
+ */
+roaring_bitmap_t *roaring_bitmap_and_many(size_t number,
+                                          const roaring_bitmap_t **x) {
+    if (number == 0) {
+        return roaring_bitmap_create();
+    }
+    if (number == 1) {
+        return roaring_bitmap_copy(x[0]);
+    }
+    if (number == 2) {
+        return roaring_bitmap_and(x[0], x[1]);
+    }
+    size_t smallest = 0;
+    bool cow = false;
+    for (size_t i = 0; i < number; i++) {
+        if (x[i]->high_low_container.size <
+            x[smallest]->high_low_container.size) {
+            smallest = i;
+        }
+        cow = cow || is_cow(x[i]);
+    }
+    const roaring_array_t *ra0 = &x[smallest]->high_low_container;
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(ra0->size);
+    if (answer == NULL) {
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(answer, cow);
+    if (ra0->size == 0) {
+        return answer;
+    }
+
+    // 'others' holds the remaining bitmaps, 'positions' their current index
+    const roaring_array_t **others = (const roaring_array_t **)roaring_malloc(
+        (number - 1) * sizeof(const roaring_array_t *));
+    int32_t *positions =
+        (int32_t *)roaring_malloc((number - 1) * sizeof(int32_t));
+    container_t **cs =
+        (container_t **)roaring_malloc(number * sizeof(container_t *));
+    uint8_t *types = (uint8_t *)roaring_malloc(number * sizeof(uint8_t));
+    int32_t *cards = (int32_t *)roaring_malloc(number * sizeof(int32_t));
+    if (!others || !positions || !cs || !types || !cards) {
+        roaring_free(others);
+        roaring_free(positions);
+        roaring_free(cs);
+        roaring_free(types);
+        roaring_free(cards);
+        roaring_bitmap_free(answer);
+        return NULL;
+    }
+    size_t n_others = 0;
+    for (size_t i = 0; i < number; i++) {
+        if (i == smallest) continue;
+        others[n_others] = &x[i]->high_low_container;
+        positions[n_others] = 0;
+        n_others++;
+    }
+
+    int32_t pos0 = 0;
+    while (pos0 < ra0->size) {
+        const uint16_t key = ra0->keys[pos0];
+        uint16_t mismatch = key;
+        bool exhausted = false;
+        for (size_t i = 0; i < n_others; i++) {
+            const roaring_array_t *ra = others[i];
+            int32_t pos = positions[i];
+            if (pos < ra->size && ra->keys[pos] < key) {
+                pos = ra_advance_until(ra, key, pos);
+                positions[i] = pos;
+            }
+            if (pos >= ra->size) {
+                exhausted = true;
+                break;
+            }
+            if (ra->keys[pos] != key) {
+                mismatch = ra->keys[pos];
+                break;
+            }
+        }
+        if (exhausted) break;
+        if (mismatch != key) {
+            // mismatch > key: no bitmap can hold keys in between
+            pos0 = ra_advance_until(ra0, mismatch, pos0);
+            continue;
+        }
+
+        // every bitmap has this key: sort containers by cardinality
+        cs[0] = ra_get_container_at_index(ra0, pos0, &types[0]);
+        cards[0] = container_get_cardinality(cs[0], types[0]);
+        for (size_t i = 0; i < n_others; i++) {
+            uint8_t type;
+            container_t *c = ra_get_container_at_index(
+                                    others[i], positions[i], &type);
+            int32_t card = container_get_cardinality(c, type);
+            size_t j = i + 1;
+            while (j > 0 && cards[j - 1] > card) {
+                cs[j] = cs[j - 1];
+                types[j] = types[j - 1];
+                cards[j] = cards[j - 1];
+                j--;
+            }
+            cs[j] = c;
+            types[j] = type;
+            cards[j] = card;
+        }
+
+        uint8_t result_type;
+        container_t *c = container_and(cs[0], types[0], cs[1], types[1],
+                                       &result_type);
+        for (size_t i = 2; i < number; i++) {
+            if (!container_nonzero_cardinality(c, result_type)) break;
+            uint8_t new_type;
+            container_t *c2 =
+                container_iand(c, result_type, cs[i], types[i], &new_type);
+            if (c2 != c) {
+                container_free(c, result_type);
+            }
+            c = c2;
+            result_type = new_type;
+        }
+        if (container_nonzero_cardinality(c, result_type)) {
+            ra_append(&answer->high_low_container, key, c, result_type);
+        } else {
+            container_free(c, result_type);
+        }
+        for (size_t i = 0; i < n_others; i++) {
+            positions[i]++;
+        }
+        pos0++;
+    }
+
+    roaring_free(others);
+    roaring_free(positions);
+    roaring_free(cs);
+    roaring_free(types);
+    roaring_free(cards);
+    return answer;
+}
+
+/*
+ * threshold_many: for each key held by at least t bitmaps, the containers are
+ * counted either with a sweep over the boundaries of their runs (arrays are
+ * runs of length 1), or with bit-sliced counters when bitsets are involved or
+ * there are too many boundaries.
+ */
+enum {
+    // largest number of run boundaries for which we sweep
+    THRESHOLD_MANY_SWEEP_MAX_EVENTS = 2 * DEFAULT_MAX_SIZE
+};
+
+typedef struct threshold_many_s {
+    uint32_t t;
+    int n_planes;     // bit i of the count of a value is in planes[i]
+    uint64_t *planes;  // n_planes bitsets
+    int32_t lo, hi;   // words of the planes that are not zero
+    uint32_t *events;  // 3 * THRESHOLD_MANY_SWEEP_MAX_EVENTS values
+} threshold_many_t;
+
+// Adds the bits of x to the counters of word w, with a chain of half adders:
+// the carry ripples up the planes until it is zero. This is not a carry-save
+// (Harley-Seal) tree; each word is added on its own.
+static inline void threshold_add_word(threshold_many_t *tm, int32_t w,
+                                      uint64_t x) {
+    uint64_t *p = tm->planes + w;
+    while (x != 0) {
+        uint64_t carry = p[0] & x;
+        p[0] ^= x;
+        x = carry;
+        p += BITSET_CONTAINER_SIZE_IN_WORDS;
+    }
+}
+
+static void threshold_add_container(threshold_many_t *tm, const container_t *c,
+                                    uint8_t type) {
+    int32_t lo, hi;
+    if (type == BITSET_CONTAINER_TYPE) {
+        const uint64_t *words = const_CAST_bitset(c)->words;
+        for (int32_t w = 0; w < BITSET_CONTAINER_SIZE_IN_WORDS; w++) {
+            if (words[w] != 0) threshold_add_word(tm, w, words[w]);
+        }
+        lo = 0;
+        hi = BITSET_CONTAINER_SIZE_IN_WORDS;
+    } else if (type == ARRAY_CONTAINER_TYPE) {
+        const array_container_t *ac = const_CAST_array(c);
+        for (int32_t i = 0; i < ac->cardinality; i++) {
+            uint16_t v = ac->array[i];
+            threshold_add_word(tm, v >> 6, UINT64_C(1) << (v & 63));
+        }
+        lo = ac->array[0] >> 6;
+        hi = (ac->array[ac->cardinality - 1] >> 6) + 1;
+    } else {
+        const run_container_t *rc = const_CAST_run(c);
+        for (int32_t i = 0; i < rc->n_runs; i++) {
+            uint32_t start = rc->runs[i].value;
+            uint32_t end = start + rc->runs[i].length;
+            int32_t w = start >> 6;
+            uint64_t mask = ~UINT64_C(0) << (start & 63);
+            for (; w < (int32_t)(end >> 6); w++) {
+                threshold_add_word(tm, w, mask);
+                mask = ~UINT64_C(0);
+            }
+            mask &= ~UINT64_C(0) >> (63 - (end & 63));
+            threshold_add_word(tm, w, mask);
+        }
+        lo = rc->runs[0].value >> 6;
+        hi = ((rc->runs[rc->n_runs - 1].value +
+               rc->runs[rc->n_runs - 1].length) >> 6) + 1;
+    }
+    if (lo < tm->lo) tm->lo = lo;
+    if (hi > tm->hi) tm->hi = hi;
+}
+
+// Values whose counter is at least t, and clears the counters.
+static container_t *threshold_from_planes(threshold_many_t *tm,
+                                          uint8_t *type) {
+    bitset_container_t *bc = bitset_container_create();
+    if (bc == NULL) return NULL;
+    int32_t card = 0;
+    for (int32_t w = tm->lo; w < tm->hi; w++) {
+        uint64_t gt = 0, eq = ~UINT64_C(0);
+        for (int j = tm->n_planes - 1; j >= 0; j--) {
+            uint64_t *p = tm->planes + j * BITSET_CONTAINER_SIZE_IN_WORDS + w;
+            if ((tm->t >> j) & 1) {
+                eq &= *p;
+            } else {
+                gt |= eq & *p;
+                eq &= ~*p;
+            }
+            *p = 0;
+        }
+        bc->words[w] = gt | eq;
+        card += hamming(gt | eq);
+    }
+    tm->lo = BITSET_CONTAINER_SIZE_IN_WORDS;
+    tm->hi = 0;
+    bc->cardinality = card;
+    if (card > DEFAULT_MAX_SIZE) {
+        *type = BITSET_CONTAINER_TYPE;
+        return bc;
+    }
+    container_t *c = NULL;
+    if (card > 0) {
+        c = array_container_from_bitset(bc);
+        *type = ARRAY_CONTAINER_TYPE;
+    }
+    bitset_container_free(bc);
+    return c;
+}
+
+// Sweeps over the sorted boundaries of the runs: an event is the position
+// where a run starts (shifted left by one) or where it ends, plus one.
+static container_t *threshold_sweep(threshold_many_t *tm,
+                                    container_t **cs, uint8_t *types,
+                                    size_t count, int32_t n_events,
+                                    uint8_t *type) {
+    uint32_t *events = tm->events;
+    int32_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (types[i] == ARRAY_CONTAINER_TYPE) {
+            const array_container_t *ac = const_CAST_array(cs[i]);
+            for (int32_t k = 0; k < ac->cardinality; k++) {
+                events[n++] = (uint32_t)ac->array[k] << 1;
+                events[n++] = (((uint32_t)ac->array[k] + 1) << 1) | 1;
+            }
+        } else {
+            const run_container_t *rc = const_CAST_run(cs[i]);
+            for (int32_t k = 0; k < rc->n_runs; k++) {
+                uint32_t start = rc->runs[k].value;
+                events[n++] = start << 1;
+                events[n++] =
+                    ((start + rc->runs[k].length + 1) << 1) | 1;
+            }
+        }
+    }
+    assert(n == n_events);
+    uint32_t *sorted =
+        radix_sort_uint32(events, n, events + n_events, events + 2 * n_events);
+
+    run_container_t *rc = run_container_create_given_capacity(n / 2);
+    if (rc == NULL) return NULL;
+    int32_t cover = 0;
+    uint32_t start = 0;
+    bool in_run = false;
+    for (int32_t i = 0; i < n;) {
+        uint32_t pos = sorted[i] >> 1;
+        for (; i < n && (sorted[i] >> 1) == pos; i++) {
+            cover += (sorted[i] & 1) ? -1 : 1;
+        }
+        if (!in_run && cover >= (int32_t)tm->t) {
+            start = pos;
+            in_run = true;
+        } else if (in_run && cover < (int32_t)tm->t) {
+            rc->runs[rc->n_runs++] = MAKE_RLE16(start, pos - 1 - start);
+            in_run = false;
+        }
+    }
+    if (rc->n_runs == 0) {
+        run_container_free(rc);
+        return NULL;
+    }
+    container_t *c = convert_run_to_efficient_container(rc, type);
+    if (c != rc) run_container_free(rc);
+    return c;
+}
+
+/**
+ * Compute the values present in at least 't' of 'number' bitmaps.
+ *
+ * The keys are merged across bitmaps, and keys present in fewer than 't'
+ * bitmaps are skipped without looking at their containers.
+ */
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **x,
+                                                uint32_t t) {
+    if (t > number) {
+        return roaring_bitmap_create();
+    }
+    if (t <= 1) {
+        return roaring_bitmap_or_many(number, x);
+    }
+    if (t == number) {
+        return roaring_bitmap_and_many(number, x);
+    }
+    bool cow = false;
+    for (size_t i = 0; i < number; i++) {
+        cow = cow || is_cow(x[i]);
+    }
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (answer == NULL) {
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(answer, cow);
+
+    threshold_many_t tm;
+    tm.t = t;
+    tm.n_planes = 0;
+    while (tm.n_planes < 64 && (number >> tm.n_planes) != 0) tm.n_planes++;
+    tm.planes = (uint64_t *)roaring_aligned_malloc(
+        32, tm.n_planes * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    tm.lo = BITSET_CONTAINER_SIZE_IN_WORDS;
+    tm.hi = 0;
+    tm.events = (uint32_t *)roaring_malloc(
+        3 * THRESHOLD_MANY_SWEEP_MAX_EVENTS * sizeof(uint32_t));
+    int32_t *positions = (int32_t *)roaring_malloc(number * sizeof(int32_t));
+    container_t **cs =
+        (container_t **)roaring_malloc(number * sizeof(container_t *));
+    uint8_t *types = (uint8_t *)roaring_malloc(number * sizeof(uint8_t));
+    if (!tm.planes || !tm.events || !positions || !cs || !types) {
+        roaring_aligned_free(tm.planes);
+        roaring_free(tm.events);
+        roaring_free(positions);
+        roaring_free(cs);
+        roaring_free(types);
+        roaring_bitmap_free(answer);
+        return NULL;
+    }
+    memset(tm.planes, 0,
+           tm.n_planes * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    memset(positions, 0, number * sizeof(int32_t));
+
+    while (true) {
+        // smallest remaining key, and how many bitmaps hold it
+        uint32_t key = UINT32_MAX;
+        size_t count = 0;
+        size_t remaining = 0;
+        for (size_t i = 0; i < number; i++) {
+            const roaring_array_t *ra = &x[i]->high_low_container;
+            if (positions[i] >= ra->size) continue;
+            remaining++;
+            uint32_t k = ra->keys[positions[i]];
+            if (k < key) {
+                key = k;
+                count = 0;
+            }
+            if (k == key) count++;
+        }
+        if (remaining < t) break;
+
+        size_t n_cs = 0;
+        bool has_bitset = false;
+        int32_t n_events = 0;
+        for (size_t i = 0; i < number; i++) {
+            const roaring_array_t *ra = &x[i]->high_low_container;
+            if (positions[i] >= ra->size || ra->keys[positions[i]] != key) {
+                continue;
+            }
+            if (count >= t) {
+                uint8_t type = ra->typecodes[positions[i]];
+                const container_t *c =
+                    container_unwrap_shared(ra->containers[positions[i]], &type);
+                cs[n_cs] = (container_t *)c;
+                types[n_cs] = type;
+                n_cs++;
+                if (type == BITSET_CONTAINER_TYPE) {
+                    has_bitset = true;
+                } else if (!has_bitset &&
+                           n_events <= THRESHOLD_MANY_SWEEP_MAX_EVENTS) {
+                    n_events += 2 * (type == ARRAY_CONTAINER_TYPE
+                                         ? const_CAST_array(c)->cardinality
+                                         : const_CAST_run(c)->n_runs);
+                }
+            }
+            positions[i]++;
+        }
+        if (count < t) continue;
+
+        uint8_t result_type = 0;
+        container_t *c;
+        if (!has_bitset && n_events <= THRESHOLD_MANY_SWEEP_MAX_EVENTS) {
+            c = threshold_sweep(&tm, cs, types, n_cs, n_events, &result_type);
+        } else {
+            for (size_t i = 0; i < n_cs; i++) {
+                threshold_add_container(&tm, cs[i], types[i]);
+            }
+            c = threshold_from_planes(&tm, &result_type);
+        }
+        if (c != NULL) {
+            ra_append(&answer->high_low_container, (uint16_t)key, c,
+                      result_type);
+        }
+    }
+
+    roaring_aligned_free(tm.planes);
+    roaring_free(tm.events);
+    roaring_free(positions);
+    roaring_free(cs);
+    roaring_free(types);
+    return answer;
+}
+
+/*
+ * Parallel or_many/and_many: the key space is cut into ranges and each task
+ * runs the sequential algorithm on read-only views restricted to its range.
+ * With copy-on-write, copying or unioning a bitmap turns the containers of
+ * its source into shared containers in place, which would write to the
+ * inputs from several threads. So the views are never copy-on-write, and
+ * they get their own container and typecode arrays in which the shared
+ * containers of the inputs are unwrapped: the tasks then clone what they
+ * keep and never touch the inputs.
+ */
+typedef struct parallel_many_s {
+    size_t number;
+    const roaring_bitmap_t **x;
+    const uint32_t *bounds;  // range i covers keys [bounds[i], bounds[i+1])
+    roaring_bitmap_t **results;
+    bool intersection;
+} parallel_many_t;
+
+// first index in ra whose key is at least 'key' (which may be 65536)
+static inline int32_t ra_lower_bound(const roaring_array_t *ra, uint32_t key) {
+    if (key > UINT16_MAX) return ra->size;
+    int32_t i = ra_get_index(ra, (uint16_t)key);
+    return (i >= 0) ? i : -i - 1;
+}
+
+static void parallel_many_task(void *arg, size_t index) {
+    parallel_many_t *job = (parallel_many_t *)arg;
+    size_t n_containers = 0;
+    for (size_t i = 0; i < job->number; i++) {
+        const roaring_array_t *ra = &job->x[i]->high_low_container;
+        n_containers += ra_lower_bound(ra, job->bounds[index + 1]) -
+                        ra_lower_bound(ra, job->bounds[index]);
+    }
+    roaring_bitmap_t *views = (roaring_bitmap_t *)roaring_malloc(
+        job->number * sizeof(roaring_bitmap_t));
+    const roaring_bitmap_t **pointers = (const roaring_bitmap_t **)
+        roaring_malloc(job->number * sizeof(roaring_bitmap_t *));
+    container_t **containers = (container_t **)roaring_malloc(
+        (n_containers + 1) * sizeof(container_t *));
+    uint8_t *typecodes = (uint8_t *)roaring_malloc(n_containers + 1);
+    if (!views || !pointers || !containers || !typecodes) {
+        roaring_free(views);
+        roaring_free(pointers);
+        roaring_free(containers);
+        roaring_free(typecodes);
+        job->results[index] = NULL;
+        return;
+    }
+    size_t count = 0;
+    size_t used = 0;
+    for (size_t i = 0; i < job->number; i++) {
+        const roaring_array_t *ra = &job->x[i]->high_low_container;
+        int32_t begin = ra_lower_bound(ra, job->bounds[index]);
+        int32_t end = ra_lower_bound(ra, job->bounds[index + 1]);
+        if ((begin == end) && !job->intersection) continue;
+        // the view shares the keys and containers of the input, it is never
+        // freed
+        roaring_array_t *view = &views[count].high_low_container;
+        view->size = end - begin;
+        view->allocation_size = end - begin;
+        view->containers = containers + used;
+        view->keys = ra->keys + begin;
+        view->typecodes = typecodes + used;
+        view->flags = ra->flags & ~ROARING_FLAG_COW;
+        view->version = 0;
+        for (int32_t j = begin; j < end; j++, used++) {
+            uint8_t type = ra->typecodes[j];
+            containers[used] =
+                (container_t *)container_unwrap_shared(ra->containers[j], &type);
+            typecodes[used] = type;
+        }
+        pointers[count] = &views[count];
+        count++;
+    }
+    job->results[index] = job->intersection
+                              ? roaring_bitmap_and_many(count, pointers)
+                              : roaring_bitmap_or_many(count, pointers);
+    roaring_free(views);
+    roaring_free(pointers);
+    roaring_free(containers);
+    roaring_free(typecodes);
+}
+
+static roaring_bitmap_t *roaring_bitmap_many_parallel(
+    size_t number, const roaring_bitmap_t **x, size_t partitions,
+    roaring_executor executor, void *executor_context, bool intersection) {
+    if (partitions < 2 || number < 2) {
+        return intersection ? roaring_bitmap_and_many(number, x)
+                            : roaring_bitmap_or_many(number, x);
+    }
+    // Balance the ranges by number of containers, using a coarse histogram
+    // of the keys (64 keys per bucket).
+    enum { BUCKET_SHIFT = 6, BUCKETS = (1 << 16) >> BUCKET_SHIFT };
+    uint32_t *histogram =
+        (uint32_t *)roaring_calloc(BUCKETS, sizeof(uint32_t));
+    if (histogram == NULL) return NULL;
+    uint64_t total = 0;
+    for (size_t i = 0; i < number; i++) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        for (int32_t j = 0; j < ra->size; j++) {
+            histogram[ra->keys[j] >> BUCKET_SHIFT]++;
+        }
+        total += ra->size;
+    }
+    if (partitions > BUCKETS) partitions = BUCKETS;
+    uint32_t *bounds =
+        (uint32_t *)roaring_malloc((partitions + 1) * sizeof(uint32_t));
+    roaring_bitmap_t **results = (roaring_bitmap_t **)roaring_calloc(
+        partitions, sizeof(roaring_bitmap_t *));
+    if (!bounds || !results) {
+        roaring_free(histogram);
+        roaring_free(bounds);
+        roaring_free(results);
+        return NULL;
+    }
+    size_t n_ranges = 0;
+    bounds[0] = 0;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < BUCKETS; b++) {
+        seen += histogram[b];
+        // close the current range once it has its share of the containers
+        if ((n_ranges + 1 < partitions) &&
+            (seen * partitions >= total * (n_ranges + 1)) && (seen > 0)) {
+            bounds[++n_ranges] = (b + 1) << BUCKET_SHIFT;
+        }
+    }
+    bounds[++n_ranges] = 1 << 16;
+    roaring_free(histogram);
+
+    parallel_many_t job;
+    job.number = number;
+    job.x = x;
+    job.bounds = bounds;
+    job.results = results;
+    job.intersection = intersection;
+    if (executor != NULL) {
+        executor(executor_context, parallel_many_task, &job, n_ranges);
+    } else {
+        for (size_t i = 0; i < n_ranges; i++) {
+            parallel_many_task(&job, i);
+        }
+    }
+
+    bool failed = false;
+    bool cow = false;
+    for (size_t i = 0; i < number; i++) {
+        cow = cow || is_cow(x[i]);
+    }
+    int32_t n_containers = 0;
+    for (size_t i = 0; i < n_ranges; i++) {
+        if (results[i] == NULL) {
+            failed = true;
+        } else {
+            n_containers += results[i]->high_low_container.size;
+        }
+    }
+    roaring_bitmap_t *answer =
+        failed ? NULL : roaring_bitmap_create_with_capacity(n_containers);
+    for (size_t i = 0; i < n_ranges; i++) {
+        if (results[i] == NULL) continue;
+        if (answer == NULL) {
+            roaring_bitmap_free(results[i]);
+            continue;
+        }
+        roaring_array_t *ra = &results[i]->high_low_container;
+        // the containers move to the answer, only the keys are copied
+        ra_append_move_range(&answer->high_low_container, ra, 0, ra->size);
+        ra_clear_without_containers(ra);
+        roaring_free(results[i]);
+    }
+    if (answer != NULL) roaring_bitmap_set_copy_on_write(answer, cow);
+    roaring_free(bounds);
+    roaring_free(results);
+    return answer;
+}
+
+roaring_bitmap_t *roaring_bitmap_or_many_parallel(size_t number,
+                                                  const roaring_bitmap_t **x,
+                                                  size_t partitions,
+                                                  roaring_executor executor,
+                                                  void *executor_context) {
+    return roaring_bitmap_many_parallel(number, x, partitions, executor,
+                                        executor_context, false);
+}
+
+roaring_bitmap_t *roaring_bitmap_and_many_parallel(size_t number,
+                                                   const roaring_bitmap_t **x,
+                                                   size_t partitions,
+                                                   roaring_executor executor,
+                                                   void *executor_context) {
+    return roaring_bitmap_many_parallel(number, x, partitions, executor,
+                                        executor_context, true);
+}
+
 // inplace and (modifies its first argument).
 void roaring_bitmap_and_inplace(roaring_bitmap_t *x1,
                                 const roaring_bitmap_t *x2) {
+    ra_bump_version(&x1->high_low_container);
     if (x1 == x2) return;
     int pos1 = 0, pos2 = 0, intersection_size = 0;
     const int length1 = ra_get_size(&x1->high_low_container);
@@ -785,6 +1964,8 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
     roaring_bitmap_t *answer =
         roaring_bitmap_create_with_capacity(length1 + length2);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) || is_cow(x2));
+    const bool adaptive = is_adaptive(x1) || is_adaptive(x2);
+    roaring_bitmap_set_adaptive_containers(answer, adaptive);
     int pos1 = 0, pos2 = 0;
     uint8_t type1, type2;
     uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
@@ -795,7 +1976,10 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
                                     &x1->high_low_container, pos1, &type1);
             container_t *c2 = ra_get_container_at_index(
                                     &x2->high_low_container, pos2, &type2);
-            container_t *c = container_or(c1, type1, c2, type2, &result_type);
+            container_t *c =
+                adaptive
+                    ? container_or_adaptive(c1, type1, c2, type2, &result_type)
+                    : container_or(c1, type1, c2, type2, &result_type);
 
             // since we assume that the initial containers are non-empty, the
             // result here
@@ -852,6 +2036,7 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
 // inplace or (modifies its first argument).
 void roaring_bitmap_or_inplace(roaring_bitmap_t *x1,
                                const roaring_bitmap_t *x2) {
+    ra_bump_version(&x1->high_low_container);
     uint8_t result_type = 0;
     int length1 = x1->high_low_container.size;
     const int length2 = x2->high_low_container.size;
@@ -936,6 +2121,8 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
     roaring_bitmap_t *answer =
         roaring_bitmap_create_with_capacity(length1 + length2);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) || is_cow(x2));
+    const bool adaptive = is_adaptive(x1) || is_adaptive(x2);
+    roaring_bitmap_set_adaptive_containers(answer, adaptive);
     int pos1 = 0, pos2 = 0;
     uint8_t type1, type2;
     uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
@@ -946,7 +2133,10 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
                                     &x1->high_low_container, pos1, &type1);
             container_t *c2 = ra_get_container_at_index(
                                     &x2->high_low_container, pos2, &type2);
-            container_t *c = container_xor(c1, type1, c2, type2, &result_type);
+            container_t *c =
+                adaptive
+                    ? container_xor_adaptive(c1, type1, c2, type2, &result_type)
+                    : container_xor(c1, type1, c2, type2, &result_type);
 
             if (container_nonzero_cardinality(c, result_type)) {
                 ra_append(&answer->high_low_container, s1, c, result_type);
@@ -1003,6 +2193,7 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
 
 void roaring_bitmap_xor_inplace(roaring_bitmap_t *x1,
                                 const roaring_bitmap_t *x2) {
+    ra_bump_version(&x1->high_low_container);
     assert(x1 != x2);
     uint8_t result_type = 0;
     int length1 = x1->high_low_container.size;
@@ -1157,6 +2348,7 @@ roaring_bitmap_t *roaring_bitmap_andnot(const roaring_bitmap_t *x1,
 
 void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
                                    const roaring_bitmap_t *x2) {
+    ra_bump_version(&x1->high_low_container);
     assert(x1 != x2);
 
     uint8_t result_type = 0;
@@ -1442,6 +2634,25 @@ roaring_bitmap_t *roaring_bitmap_portable_deserialize_safe(const char *buf, size
     return ans;
 }
 
+roaring_bitmap_t *roaring_bitmap_portable_deserialize_parallel(
+    const char *buf, size_t maxbytes, size_t partitions,
+    roaring_executor executor, void *executor_context) {
+    roaring_bitmap_t *ans =
+        (roaring_bitmap_t *)roaring_malloc(sizeof(roaring_bitmap_t));
+    if (ans == NULL) {
+        return NULL;
+    }
+    size_t bytesread;
+    if (!ra_portable_deserialize_parallel(&ans->high_low_container, buf,
+                                          maxbytes, &bytesread, partitions,
+                                          executor, executor_context)) {
+        roaring_free(ans);
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(ans, false);
+    return ans;
+}
+
 roaring_bitmap_t *roaring_bitmap_portable_deserialize(const char *buf) {
     return roaring_bitmap_portable_deserialize_safe(buf, SIZE_MAX);
 }
@@ -1457,6 +2668,59 @@ size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *r,
     return ra_portable_serialize(&r->high_low_container, buf);
 }
 
+size_t roaring_bitmap_portable_serialize_stream(const roaring_bitmap_t *r,
+                                                roaring_writev_fn writer,
+                                                void *context) {
+    ra_stream_t s;
+    ra_stream_init(&s, writer, context);
+    ra_portable_serialize_stream(&r->high_low_container, &s);
+    return ra_stream_flush(&s) ? s.written : 0;
+}
+
+#if ROARING_HAS_WRITEV
+bool roaring_fd_writev(void *context, const roaring_iovec_t *iov,
+                       size_t iovcnt) {
+    int fd = *(const int *)context;
+    struct iovec vec[RA_STREAM_MAX_IOV];
+    while (iovcnt > 0) {
+        size_t n = iovcnt < (size_t)RA_STREAM_MAX_IOV ? iovcnt
+                                                  : (size_t)RA_STREAM_MAX_IOV;
+        for (size_t i = 0; i < n; i++) {
+            vec[i].iov_base = (void *)iov[i].base;
+            vec[i].iov_len = iov[i].len;
+        }
+        struct iovec *first = vec;
+        size_t left = n;
+        while (left > 0) {
+            ssize_t done = writev(fd, first, (int)left);
+            if (done < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            // skip what was written, resuming inside a partial chunk
+            size_t skip = (size_t)done;
+            while (left > 0 && skip >= first->iov_len) {
+                skip -= first->iov_len;
+                first++;
+                left--;
+            }
+            if (left > 0) {
+                first->iov_base = (char *)first->iov_base + skip;
+                first->iov_len -= skip;
+            }
+        }
+        iov += n;
+        iovcnt -= n;
+    }
+    return true;
+}
+
+size_t roaring_bitmap_portable_serialize_fd(const roaring_bitmap_t *r,
+                                            int fd) {
+    return roaring_bitmap_portable_serialize_stream(r, roaring_fd_writev, &fd);
+}
+#endif
+
 roaring_bitmap_t *roaring_bitmap_deserialize(const void *buf) {
     const char *bufaschar = (const char *)buf;
     if (bufaschar[0] == CROARING_SERIALIZATION_ARRAY_UINT32) {
@@ -1510,6 +2774,46 @@ bool roaring_iterate64(const roaring_bitmap_t *r, roaring_iterator64 iterator,
     return true;
 }
 
+bool roaring_visit_containers(const roaring_bitmap_t *r,
+                              roaring_container_visitor visitor, void *ptr) {
+    const roaring_array_t *ra = &r->high_low_container;
+    roaring_container_span_t span;
+
+    for (int i = 0; i < ra->size; ++i) {
+        uint8_t type = ra->typecodes[i];
+        const container_t *c = container_unwrap_shared(ra->containers[i], &type);
+        span.key = ra->keys[i];
+        span.words = NULL;
+        span.array = NULL;
+        span.runs = NULL;
+        switch (type) {
+            case BITSET_CONTAINER_TYPE:
+                span.type = ROARING_SPAN_BITSET;
+                span.cardinality = const_CAST_bitset(c)->cardinality;
+                span.length = BITSET_CONTAINER_SIZE_IN_WORDS;
+                span.words = const_CAST_bitset(c)->words;
+                break;
+            case ARRAY_CONTAINER_TYPE:
+                span.type = ROARING_SPAN_ARRAY;
+                span.cardinality = const_CAST_array(c)->cardinality;
+                span.length = span.cardinality;
+                span.array = const_CAST_array(c)->array;
+                break;
+            default:
+                assert(type == RUN_CONTAINER_TYPE);
+                span.type = ROARING_SPAN_RUN;
+                span.cardinality = run_container_cardinality(const_CAST_run(c));
+                span.length = const_CAST_run(c)->n_runs;
+                span.runs = (const roaring_rle16_t *)const_CAST_run(c)->runs;
+                break;
+        }
+        if (!visitor(&span, ptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /****
 * begin roaring_uint32_iterator_t
 *****/
@@ -1933,6 +3237,122 @@ void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it) { roaring_free(
 * end of roaring_uint32_iterator_t
 *****/
 
+// Finds the interval [*start, *end) of the container starting at *position
+// (see roaring_uint32_range_iterator_t) and moves *position past it.
+// Returns false when the container has no more values.
+static bool container_next_range(const container_t *c, uint8_t type,
+                                 uint32_t *position, uint32_t *start,
+                                 uint32_t *end) {
+    c = container_unwrap_shared(c, &type);
+    uint32_t pos = *position;
+    switch (type) {
+        case BITSET_CONTAINER_TYPE: {
+            const uint64_t *words = const_CAST_bitset(c)->words;
+            uint32_t w = pos / 64;
+            if (w >= BITSET_CONTAINER_SIZE_IN_WORDS) return false;
+            uint64_t word = words[w] & (UINT64_MAX << (pos % 64));
+            while (word == 0) {
+                if (++w == BITSET_CONTAINER_SIZE_IN_WORDS) return false;
+                word = words[w];
+            }
+            *start = w * 64 + __builtin_ctzll(word);
+            // the interval ends at the next clear bit
+            word = ~words[w] & (UINT64_MAX << (*start % 64));
+            while (word == 0) {
+                if (++w == BITSET_CONTAINER_SIZE_IN_WORDS) break;
+                word = ~words[w];
+            }
+            *end = (w == BITSET_CONTAINER_SIZE_IN_WORDS)
+                       ? (UINT32_C(1) << 16)
+                       : w * 64 + __builtin_ctzll(word);
+            *position = *end;
+            return true;
+        }
+        case ARRAY_CONTAINER_TYPE: {
+            const array_container_t *ac = const_CAST_array(c);
+            if (pos >= (uint32_t)ac->cardinality) return false;
+            *start = ac->array[pos];
+            *end = *start + 1;
+            for (pos++; pos < (uint32_t)ac->cardinality &&
+                        ac->array[pos] == *end; pos++) {
+                (*end)++;
+            }
+            *position = pos;
+            return true;
+        }
+        default: {
+            assert(type == RUN_CONTAINER_TYPE);
+            const run_container_t *rc = const_CAST_run(c);
+            if (pos >= (uint32_t)rc->n_runs) return false;
+            *start = rc->runs[pos].value;
+            *end = *start + rc->runs[pos].length + 1;
+            *position = pos + 1;
+            return true;
+        }
+    }
+}
+
+// Next interval of the bitmap without merging across containers.
+static bool range_iterator_next(roaring_uint32_range_iterator_t *it,
+                                uint32_t *start, uint64_t *end) {
+    const roaring_array_t *ra = &it->parent->high_low_container;
+    while (it->container_index < ra->size) {
+        uint32_t s, e;
+        if (container_next_range(ra->containers[it->container_index],
+                                 ra->typecodes[it->container_index],
+                                 &it->position, &s, &e)) {
+            uint32_t highbits = (uint32_t)ra->keys[it->container_index] << 16;
+            *start = highbits | s;
+            *end = (uint64_t)highbits + e;
+            return true;
+        }
+        it->container_index++;
+        it->position = 0;
+    }
+    return false;
+}
+
+void roaring_init_range_iterator(const roaring_bitmap_t *r,
+                                 roaring_uint32_range_iterator_t *it) {
+    it->parent = r;
+    it->container_index = 0;
+    it->position = 0;
+    roaring_advance_range_iterator(it);
+}
+
+bool roaring_advance_range_iterator(roaring_uint32_range_iterator_t *it) {
+    it->has_value = range_iterator_next(it, &it->start, &it->end);
+    // an interval that reaches the end of its container may go on in the
+    // next one
+    while (it->has_value && (it->end & 0xFFFF) == 0 &&
+           it->end < (UINT64_C(1) << 32)) {
+        int32_t container_index = it->container_index;
+        uint32_t position = it->position;
+        uint32_t start;
+        uint64_t end;
+        if (!range_iterator_next(it, &start, &end) || start != it->end) {
+            // not adjacent, leave it for the next call
+            it->container_index = container_index;
+            it->position = position;
+            break;
+        }
+        it->end = end;
+    }
+    return it->has_value;
+}
+
+bool roaring_iterate_ranges(const roaring_bitmap_t *r,
+                            roaring_range_iterator iterator, void *ptr) {
+    roaring_uint32_range_iterator_t it;
+    for (roaring_init_range_iterator(r, &it); it.has_value;
+         roaring_advance_range_iterator(&it)) {
+        if (!iterator(it.start, it.end, ptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool roaring_bitmap_equals(const roaring_bitmap_t *r1,
                            const roaring_bitmap_t *r2) {
     const roaring_array_t *ra1 = &r1->high_low_container;
@@ -2152,6 +3572,7 @@ roaring_bitmap_t *roaring_bitmap_flip(const roaring_bitmap_t *x1,
 
 void roaring_bitmap_flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
                                  uint64_t range_end) {
+    ra_bump_version(&x1->high_low_container);
     if (range_start >= range_end) {
         return;  // empty range
     }
@@ -2393,6 +3814,7 @@ roaring_bitmap_t *roaring_bitmap_lazy_or(const roaring_bitmap_t *x1,
 void roaring_bitmap_lazy_or_inplace(roaring_bitmap_t *x1,
                                     const roaring_bitmap_t *x2,
                                     const bool bitsetconversion) {
+    ra_bump_version(&x1->high_low_container);
     uint8_t result_type = 0;
     int length1 = x1->high_low_container.size;
     const int length2 = x2->high_low_container.size;
@@ -2556,6 +3978,7 @@ roaring_bitmap_t *roaring_bitmap_lazy_xor(const roaring_bitmap_t *x1,
 
 void roaring_bitmap_lazy_xor_inplace(roaring_bitmap_t *x1,
                                      const roaring_bitmap_t *x2) {
+    ra_bump_version(&x1->high_low_container);
     assert(x1 != x2);
     uint8_t result_type = 0;
     int length1 = x1->high_low_container.size;
@@ -2638,6 +4061,7 @@ void roaring_bitmap_lazy_xor_inplace(roaring_bitmap_t *x1,
 }
 
 void roaring_bitmap_repair_after_lazy(roaring_bitmap_t *r) {
+    ra_bump_version(&r->high_low_container);
     roaring_array_t *ra = &r->high_low_container;
 
     for (int i = 0; i < ra->size; ++i) {
@@ -2733,6 +4157,138 @@ bool roaring_bitmap_select(const roaring_bitmap_t *bm, uint32_t rank,
         return false;
 }
 
+struct roaring_rank_index_s {
+    // cumulative_cardinalities[i] is the number of values in containers 0..i
+    uint64_t *cumulative_cardinalities;
+    int32_t size;
+    uint32_t version;  // high_low_container.version when the index was built
+};
+
+roaring_rank_index_t *roaring_bitmap_rank_index_create(
+    const roaring_bitmap_t *r) {
+    const roaring_array_t *ra = &r->high_low_container;
+    roaring_rank_index_t *index =
+        (roaring_rank_index_t *)roaring_malloc(sizeof(roaring_rank_index_t));
+    if (index == NULL) {
+        return NULL;
+    }
+    index->size = ra->size;
+    index->version = ra->version;
+    index->cumulative_cardinalities =
+        (uint64_t *)roaring_malloc(ra->size * sizeof(uint64_t));
+    if (index->cumulative_cardinalities == NULL && ra->size > 0) {
+        roaring_free(index);
+        return NULL;
+    }
+    uint64_t total = 0;
+    for (int32_t i = 0; i < ra->size; i++) {
+        total += container_get_cardinality(ra->containers[i],
+                                           ra->typecodes[i]);
+        index->cumulative_cardinalities[i] = total;
+    }
+    return index;
+}
+
+bool roaring_rank_index_is_valid(const roaring_bitmap_t *r,
+                                 const roaring_rank_index_t *index) {
+    return index->size == r->high_low_container.size &&
+           index->version == r->high_low_container.version;
+}
+
+void roaring_rank_index_free(roaring_rank_index_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    roaring_free(index->cumulative_cardinalities);
+    roaring_free(index);
+}
+
+// Returns the number of values in the containers before container `i`.
+static inline uint64_t rank_index_before(const roaring_rank_index_t *index,
+                                         int32_t i) {
+    return (i == 0) ? 0 : index->cumulative_cardinalities[i - 1];
+}
+
+// Returns the index of the container holding the value of rank `rank`, or
+// `index->size` if the bitmap is too small.
+static int32_t rank_index_find(const roaring_rank_index_t *index,
+                               uint64_t rank) {
+    int32_t low = 0;
+    int32_t high = index->size;
+    while (low < high) {
+        int32_t middle = (low + high) >> 1;
+        if (index->cumulative_cardinalities[middle] <= rank) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool roaring_bitmap_select_indexed(const roaring_bitmap_t *bm,
+                                   const roaring_rank_index_t *index,
+                                   uint32_t rank, uint32_t *element) {
+    if (!roaring_rank_index_is_valid(bm, index)) {
+        return false;
+    }
+    int32_t i = rank_index_find(index, rank);
+    if (i == index->size) {
+        return false;
+    }
+    uint32_t start_rank = (uint32_t)rank_index_before(index, i);
+    bool valid = container_select(bm->high_low_container.containers[i],
+                                  bm->high_low_container.typecodes[i],
+                                  &start_rank, rank, element);
+    if (!valid) {
+        return false;
+    }
+    *element |= ((uint32_t)bm->high_low_container.keys[i]) << 16;
+    return true;
+}
+
+uint64_t roaring_bitmap_rank_indexed(const roaring_bitmap_t *bm,
+                                     const roaring_rank_index_t *index,
+                                     uint32_t x) {
+    if (!roaring_rank_index_is_valid(bm, index)) {
+        return 0;
+    }
+    int32_t i = ra_get_index(&bm->high_low_container, x >> 16);
+    if (i < 0) {
+        return rank_index_before(index, -i - 1);
+    }
+    return rank_index_before(index, i) +
+           container_rank(bm->high_low_container.containers[i],
+                          bm->high_low_container.typecodes[i], x & 0xFFFF);
+}
+
+bool roaring_bitmap_range_uint32_array_indexed(
+    const roaring_bitmap_t *bm, const roaring_rank_index_t *index,
+    size_t offset, size_t limit, uint32_t *ans) {
+    if (!roaring_rank_index_is_valid(bm, index)) {
+        return false;
+    }
+    if (index->size == 0 || limit == 0 ||
+        offset >= index->cumulative_cardinalities[index->size - 1]) {
+        return true;
+    }
+    uint32_t first;
+    roaring_bitmap_select_indexed(bm, index, (uint32_t)offset, &first);
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(bm, &it);
+    roaring_move_uint32_iterator_equalorlarger(&it, first);
+    while (limit > 0) {
+        uint32_t count = limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit;
+        uint32_t read = roaring_read_uint32_iterator(&it, ans, count);
+        if (read < count) {
+            break;
+        }
+        ans += read;
+        limit -= read;
+    }
+    return true;
+}
+
 bool roaring_bitmap_intersect(const roaring_bitmap_t *x1,
                                      const roaring_bitmap_t *x2) {
     const int length1 = x1->high_low_container.size,
@@ -3139,6 +4695,7 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
     roaring_bitmap_t *rb = (roaring_bitmap_t *)
             arena_alloc(&arena, sizeof(roaring_bitmap_t));
     rb->high_low_container.flags = ROARING_FLAG_FROZEN;
+    rb->high_low_container.version = 0;
     rb->high_low_container.allocation_size = num_containers;
     rb->high_low_container.size = num_containers;
     rb->high_low_container.keys = (uint16_t *)keys;
@@ -3194,6 +4751,165 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
     return rb;
 }
 
+const roaring_bitmap_t *
+roaring_bitmap_portable_deserialize_frozen(const char *buf, size_t maxbytes) {
+    ra_portable_header_t header;
+    if (!ra_portable_header_parse(buf, maxbytes, &header)) {
+        return NULL;
+    }
+    const int32_t size = header.size;
+    const char *payload = buf + header.bytes;
+
+    // First pass: validate the container payloads and work out how much of
+    // them must be copied because they are not suitably aligned.
+    size_t remaining = maxbytes - (size_t)(payload - buf);
+    const char *p = payload;
+    size_t copied_words = 0;
+    size_t copied_uint16 = 0;
+    for (int32_t k = 0; k < size; ++k) {
+        uint32_t thiscard = ra_portable_header_card(&header, k);
+        uint8_t typecode = ra_portable_header_typecode(&header, k);
+        if (typecode == RUN_CONTAINER_TYPE) {
+            if (remaining < sizeof(uint16_t)) {
+                return NULL;
+            }
+            uint16_t n_runs;
+            memcpy(&n_runs, p, sizeof(uint16_t));
+            p += sizeof(uint16_t);
+            remaining -= sizeof(uint16_t);
+            if (remaining < n_runs * sizeof(rle16_t)) {
+                return NULL;
+            }
+            if ((uintptr_t)p % sizeof(uint16_t) != 0) {
+                copied_uint16 += 2 * (size_t)n_runs;
+            }
+            p += n_runs * sizeof(rle16_t);
+            remaining -= n_runs * sizeof(rle16_t);
+        } else if (typecode == BITSET_CONTAINER_TYPE) {
+            size_t num_bytes =
+                BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+            if (remaining < num_bytes) {
+                return NULL;
+            }
+            if ((uintptr_t)p % sizeof(uint64_t) != 0) {
+                copied_words += BITSET_CONTAINER_SIZE_IN_WORDS;
+            }
+            p += num_bytes;
+            remaining -= num_bytes;
+        } else {
+            if (remaining < thiscard * sizeof(uint16_t)) {
+                return NULL;
+            }
+            if ((uintptr_t)p % sizeof(uint16_t) != 0) {
+                copied_uint16 += thiscard;
+            }
+            p += thiscard * sizeof(uint16_t);
+            remaining -= thiscard * sizeof(uint16_t);
+        }
+    }
+
+    // One slot per container, large enough for any of the container structs.
+    size_t container_size = sizeof(bitset_container_t);
+    if (sizeof(array_container_t) > container_size) {
+        container_size = sizeof(array_container_t);
+    }
+    if (sizeof(run_container_t) > container_size) {
+        container_size = sizeof(run_container_t);
+    }
+    container_size = (container_size + sizeof(uint64_t) - 1) &
+                     ~(sizeof(uint64_t) - 1);
+
+    size_t alloc_size = 0;
+    alloc_size += sizeof(roaring_bitmap_t);
+    alloc_size += size * sizeof(container_t*);
+    alloc_size += size * container_size;
+    alloc_size += copied_words * sizeof(uint64_t);
+    alloc_size += copied_uint16 * sizeof(uint16_t);
+    alloc_size += size * sizeof(uint16_t);  // keys
+    alloc_size += size * sizeof(uint8_t);   // typecodes
+
+    char *arena = (char *)roaring_malloc(alloc_size);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    roaring_bitmap_t *rb = (roaring_bitmap_t *)
+            arena_alloc(&arena, sizeof(roaring_bitmap_t));
+    rb->high_low_container.flags = ROARING_FLAG_FROZEN;
+    rb->high_low_container.version = 0;
+    rb->high_low_container.allocation_size = size;
+    rb->high_low_container.size = size;
+    // Same layout constraint as in roaring_bitmap_frozen_view(): the C++
+    // wrapper finds the arena just before high_low_container.containers.
+    rb->high_low_container.containers =
+        (container_t **)arena_alloc(&arena, sizeof(container_t*) * size);
+    char *container_zone = (char *)arena_alloc(&arena, size * container_size);
+    uint64_t *word_zone = (uint64_t *)
+            arena_alloc(&arena, copied_words * sizeof(uint64_t));
+    uint16_t *uint16_zone = (uint16_t *)
+            arena_alloc(&arena, copied_uint16 * sizeof(uint16_t));
+    rb->high_low_container.keys = (uint16_t *)
+            arena_alloc(&arena, size * sizeof(uint16_t));
+    rb->high_low_container.typecodes = (uint8_t *)
+            arena_alloc(&arena, size * sizeof(uint8_t));
+
+    // Second pass: the payloads have been validated, build the containers.
+    p = payload;
+    for (int32_t k = 0; k < size; ++k) {
+        rb->high_low_container.keys[k] = ra_portable_header_key(&header, k);
+        uint32_t thiscard = ra_portable_header_card(&header, k);
+        uint8_t typecode = ra_portable_header_typecode(&header, k);
+        container_t *c = (container_t *)(container_zone + k * container_size);
+        if (typecode == RUN_CONTAINER_TYPE) {
+            run_container_t *run = (run_container_t *)c;
+            uint16_t n_runs;
+            memcpy(&n_runs, p, sizeof(uint16_t));
+            p += sizeof(uint16_t);
+            size_t num_bytes = n_runs * sizeof(rle16_t);
+            run->n_runs = n_runs;
+            run->capacity = n_runs;
+            if ((uintptr_t)p % sizeof(uint16_t) != 0) {
+                memcpy(uint16_zone, p, num_bytes);
+                run->runs = (rle16_t *)uint16_zone;
+                uint16_zone += 2 * (size_t)n_runs;
+            } else {
+                run->runs = (rle16_t *)p;
+            }
+            p += num_bytes;
+        } else if (typecode == BITSET_CONTAINER_TYPE) {
+            bitset_container_t *bitset = (bitset_container_t *)c;
+            size_t num_bytes =
+                BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+            bitset->cardinality = thiscard;
+            if ((uintptr_t)p % sizeof(uint64_t) != 0) {
+                memcpy(word_zone, p, num_bytes);
+                bitset->words = word_zone;
+                word_zone += BITSET_CONTAINER_SIZE_IN_WORDS;
+            } else {
+                bitset->words = (uint64_t *)p;
+            }
+            p += num_bytes;
+        } else {
+            array_container_t *array = (array_container_t *)c;
+            size_t num_bytes = thiscard * sizeof(uint16_t);
+            array->cardinality = thiscard;
+            array->capacity = thiscard;
+            if ((uintptr_t)p % sizeof(uint16_t) != 0) {
+                memcpy(uint16_zone, p, num_bytes);
+                array->array = uint16_zone;
+                uint16_zone += thiscard;
+            } else {
+                array->array = (uint16_t *)p;
+            }
+            p += num_bytes;
+        }
+        rb->high_low_container.typecodes[k] = typecode;
+        rb->high_low_container.containers[k] = c;
+    }
+
+    return rb;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring {
 #endif
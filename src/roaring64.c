@@ -0,0 +1,1138 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring64.h>
+#include <roaring/roaring_array.h>
+
+#include <roaring/art/art.h>
+#include <roaring/containers/containers.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+// A leaf of the ART: the container holding the values whose upper 48 bits are
+// the key of the leaf. Leaves are never empty.
+typedef struct roaring64_leaf_s {
+    art_val_t _pad;
+    uint8_t typecode;
+    container_t *container;
+} leaf_t;
+
+struct roaring64_bitmap_s {
+    art_t art;
+};
+
+struct roaring64_iterator_s {
+    const roaring64_bitmap_t *parent;
+    art_iterator_t art_it;
+    uint64_t high48;  // Key of the current leaf, shifted into place.
+
+    // A one-container bitmap viewing the current leaf, so that iteration
+    // within the container reuses the 32-bit iterator.
+    roaring_bitmap_t view;
+    uint16_t view_key;
+    uint8_t view_typecode;
+    container_t *view_container;
+    roaring_uint32_iterator_t container_it;
+
+    bool has_value;
+    // When there is no value: true if the iterator went past the last value,
+    // false if it went before the first one.
+    bool saturated_forward;
+};
+
+// Splits the value into the 48-bit big-endian ART key and the low 16 bits
+// handled by the container.
+static inline uint16_t split_key(uint64_t key, uint8_t high48_out[]) {
+    uint64_t tmp = key >> 16;
+    for (int i = ART_KEY_BYTES - 1; i >= 0; i--) {
+        high48_out[i] = (uint8_t)tmp;
+        tmp >>= 8;
+    }
+    return (uint16_t)key;
+}
+
+static inline uint64_t combine_key(const uint8_t high48[], uint16_t low16) {
+    uint64_t result = 0;
+    for (int i = 0; i < ART_KEY_BYTES; i++) {
+        result = (result << 8) | high48[i];
+    }
+    return (result << 16) | low16;
+}
+
+// Returns NULL if the allocation fails, the container is left to the caller.
+static inline leaf_t *create_leaf(container_t *container, uint8_t typecode) {
+    leaf_t *leaf = (leaf_t *)roaring_malloc(sizeof(leaf_t));
+    if (leaf == NULL) {
+        return NULL;
+    }
+    leaf->container = container;
+    leaf->typecode = typecode;
+    return leaf;
+}
+
+static inline void free_leaf(leaf_t *leaf) {
+    container_free(leaf->container, leaf->typecode);
+    roaring_free(leaf);
+}
+
+// Takes ownership of the container, which may be NULL if creating it failed.
+// Returns false, after freeing the container, if an allocation failed.
+static inline bool insert_leaf(roaring64_bitmap_t *r, const uint8_t *high48,
+                               container_t *container, uint8_t typecode) {
+    if (container == NULL) {
+        return false;
+    }
+    leaf_t *leaf = create_leaf(container, typecode);
+    if (leaf == NULL) {
+        container_free(container, typecode);
+        return false;
+    }
+    art_val_t *existing;
+    if (!art_insert(&r->art, high48, (art_val_t *)leaf, &existing)) {
+        free_leaf(leaf);
+        return false;
+    }
+    assert(existing == NULL);
+    (void)existing;
+    return true;
+}
+
+// Replaces the container of the leaf, freeing the old one if it changed.
+static inline void replace_container(leaf_t *leaf, container_t *container,
+                                     uint8_t typecode) {
+    if (container != leaf->container) {
+        container_free(leaf->container, leaf->typecode);
+        leaf->container = container;
+    }
+    leaf->typecode = typecode;
+}
+
+// Erases the leaf at the iterator position and moves the iterator past it.
+static inline void erase_leaf_at(roaring64_bitmap_t *r, art_iterator_t *it) {
+    free_leaf((leaf_t *)art_iterator_erase(&r->art, it));
+}
+
+roaring64_bitmap_t *roaring64_bitmap_create(void) {
+    roaring64_bitmap_t *r =
+        (roaring64_bitmap_t *)roaring_malloc(sizeof(roaring64_bitmap_t));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->art.root = NULL;
+    return r;
+}
+
+void roaring64_bitmap_free(roaring64_bitmap_t *r) {
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        leaf_t *leaf = (leaf_t *)it.value;
+        art_iterator_next(&it);
+        free_leaf(leaf);
+    }
+    art_free(&r->art);
+    roaring_free(r);
+}
+
+roaring64_bitmap_t *roaring64_bitmap_copy(const roaring64_bitmap_t *r) {
+    roaring64_bitmap_t *result = roaring64_bitmap_create();
+    if (result == NULL) {
+        return NULL;
+    }
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        leaf_t *leaf = (leaf_t *)it.value;
+        if (!insert_leaf(result, leaf->_pad.key,
+                         container_clone(leaf->container, leaf->typecode),
+                         leaf->typecode)) {
+            roaring64_bitmap_free(result);
+            return NULL;
+        }
+        art_iterator_next(&it);
+    }
+    return result;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_of_ptr(size_t n_args,
+                                            const uint64_t *vals) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    if (r == NULL) {
+        return NULL;
+    }
+    roaring64_bitmap_add_many(r, n_args, vals);
+    return r;
+}
+
+// Returns the leaf for the given key, creating one with an empty array
+// container if needed, or NULL if an allocation fails. The caller must make
+// the container non-empty.
+static leaf_t *get_or_create_leaf(roaring64_bitmap_t *r,
+                                  const uint8_t *high48) {
+    leaf_t *leaf = (leaf_t *)art_find(&r->art, high48);
+    if (leaf == NULL) {
+        container_t *container = array_container_create();
+        if (container == NULL) {
+            return NULL;
+        }
+        leaf = create_leaf(container, ARRAY_CONTAINER_TYPE);
+        if (leaf == NULL) {
+            container_free(container, ARRAY_CONTAINER_TYPE);
+            return NULL;
+        }
+        art_val_t *existing;
+        if (!art_insert(&r->art, high48, (art_val_t *)leaf, &existing)) {
+            free_leaf(leaf);
+            return NULL;
+        }
+    }
+    return leaf;
+}
+
+static inline void add_to_leaf(leaf_t *leaf, uint16_t low16) {
+    uint8_t typecode2;
+    container_t *container2 =
+        container_add(leaf->container, low16, leaf->typecode, &typecode2);
+    replace_container(leaf, container2, typecode2);
+}
+
+void roaring64_bitmap_add(roaring64_bitmap_t *r, uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    leaf_t *leaf = get_or_create_leaf(r, high48);
+    if (leaf != NULL) {
+        add_to_leaf(leaf, low16);
+    }
+}
+
+bool roaring64_bitmap_add_checked(roaring64_bitmap_t *r, uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    leaf_t *leaf = (leaf_t *)art_find(&r->art, high48);
+    if (leaf != NULL &&
+        container_contains(leaf->container, low16, leaf->typecode)) {
+        return false;
+    }
+    if (leaf == NULL) {
+        leaf = get_or_create_leaf(r, high48);
+        if (leaf == NULL) {
+            return false;
+        }
+    }
+    add_to_leaf(leaf, low16);
+    return true;
+}
+
+void roaring64_bitmap_add_many(roaring64_bitmap_t *r, size_t n_args,
+                               const uint64_t *vals) {
+    leaf_t *leaf = NULL;
+    uint64_t prev_high = 0;
+    for (size_t i = 0; i < n_args; i++) {
+        uint8_t high48[ART_KEY_BYTES];
+        uint16_t low16 = split_key(vals[i], high48);
+        if (leaf == NULL || (vals[i] >> 16) != prev_high) {
+            leaf = get_or_create_leaf(r, high48);
+            if (leaf == NULL) {
+                return;
+            }
+            prev_high = vals[i] >> 16;
+        }
+        add_to_leaf(leaf, low16);
+    }
+}
+
+// Adds [min, max] to the container with the given key. Returns false if an
+// allocation fails.
+static bool add_range_closed_at(roaring64_bitmap_t *r, const uint8_t *high48,
+                                uint16_t min, uint16_t max) {
+    leaf_t *leaf = (leaf_t *)art_find(&r->art, high48);
+    uint8_t typecode2;
+    if (leaf == NULL) {
+        container_t *container =
+            container_range_of_ones(min, (uint32_t)max + 1, &typecode2);
+        return insert_leaf(r, high48, container, typecode2);
+    }
+    container_t *container2 = container_add_range(
+        leaf->container, leaf->typecode, min, max, &typecode2);
+    replace_container(leaf, container2, typecode2);
+    return true;
+}
+
+void roaring64_bitmap_add_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                       uint64_t max) {
+    if (min > max) {
+        return;
+    }
+    uint64_t min_high = min >> 16;
+    uint64_t max_high = max >> 16;
+    uint8_t high48[ART_KEY_BYTES];
+    for (uint64_t high = min_high;; high++) {
+        split_key(high << 16, high48);
+        uint16_t lo = high == min_high ? (uint16_t)min : 0;
+        uint16_t hi = high == max_high ? (uint16_t)max : 0xFFFF;
+        if (!add_range_closed_at(r, high48, lo, hi) || high == max_high) {
+            break;
+        }
+    }
+}
+
+bool roaring64_bitmap_remove_checked(roaring64_bitmap_t *r, uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    leaf_t *leaf = (leaf_t *)art_find(&r->art, high48);
+    if (leaf == NULL ||
+        !container_contains(leaf->container, low16, leaf->typecode)) {
+        return false;
+    }
+    uint8_t typecode2;
+    container_t *container2 =
+        container_remove(leaf->container, low16, leaf->typecode, &typecode2);
+    replace_container(leaf, container2, typecode2);
+    if (!container_nonzero_cardinality(leaf->container, leaf->typecode)) {
+        art_erase(&r->art, high48);
+        free_leaf(leaf);
+    }
+    return true;
+}
+
+void roaring64_bitmap_remove(roaring64_bitmap_t *r, uint64_t val) {
+    roaring64_bitmap_remove_checked(r, val);
+}
+
+void roaring64_bitmap_remove_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                          uint64_t max) {
+    if (min > max) {
+        return;
+    }
+    uint8_t min_high48[ART_KEY_BYTES];
+    uint8_t max_high48[ART_KEY_BYTES];
+    uint16_t min_low16 = split_key(min, min_high48);
+    uint16_t max_low16 = split_key(max, max_high48);
+    art_iterator_t it;
+    art_iterator_lower_bound(&r->art, &it, min_high48);
+    while (it.value != NULL &&
+           art_compare_keys(it.value->key, max_high48) <= 0) {
+        leaf_t *leaf = (leaf_t *)it.value;
+        uint16_t lo = art_compare_keys(leaf->_pad.key, min_high48) == 0
+                          ? min_low16 : 0;
+        uint16_t hi = art_compare_keys(leaf->_pad.key, max_high48) == 0
+                          ? max_low16 : 0xFFFF;
+        uint8_t typecode2;
+        container_t *container2 = container_remove_range(
+            leaf->container, leaf->typecode, lo, hi, &typecode2);
+        if (container2 == NULL) {
+            erase_leaf_at(r, &it);
+            continue;
+        }
+        replace_container(leaf, container2, typecode2);
+        art_iterator_next(&it);
+    }
+}
+
+bool roaring64_bitmap_contains(const roaring64_bitmap_t *r, uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    const leaf_t *leaf = (const leaf_t *)art_find(&r->art, high48);
+    return leaf != NULL &&
+           container_contains(leaf->container, low16, leaf->typecode);
+}
+
+uint64_t roaring64_bitmap_get_cardinality(const roaring64_bitmap_t *r) {
+    uint64_t cardinality = 0;
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf = (const leaf_t *)it.value;
+        cardinality += container_get_cardinality(leaf->container,
+                                                 leaf->typecode);
+        art_iterator_next(&it);
+    }
+    return cardinality;
+}
+
+bool roaring64_bitmap_is_empty(const roaring64_bitmap_t *r) {
+    return art_is_empty(&r->art);
+}
+
+uint64_t roaring64_bitmap_minimum(const roaring64_bitmap_t *r) {
+    art_iterator_t it;
+    if (!art_init_iterator(&r->art, &it, /*first=*/true)) {
+        return UINT64_MAX;
+    }
+    const leaf_t *leaf = (const leaf_t *)it.value;
+    return combine_key(leaf->_pad.key,
+                       container_minimum(leaf->container, leaf->typecode));
+}
+
+uint64_t roaring64_bitmap_maximum(const roaring64_bitmap_t *r) {
+    art_iterator_t it;
+    if (!art_init_iterator(&r->art, &it, /*first=*/false)) {
+        return 0;
+    }
+    const leaf_t *leaf = (const leaf_t *)it.value;
+    return combine_key(leaf->_pad.key,
+                       container_maximum(leaf->container, leaf->typecode));
+}
+
+uint64_t roaring64_bitmap_rank(const roaring64_bitmap_t *r, uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    uint64_t rank = 0;
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf = (const leaf_t *)it.value;
+        int cmp = art_compare_keys(leaf->_pad.key, high48);
+        if (cmp > 0) {
+            break;
+        }
+        if (cmp == 0) {
+            return rank + container_rank(leaf->container, leaf->typecode,
+                                         low16);
+        }
+        rank += container_get_cardinality(leaf->container, leaf->typecode);
+        art_iterator_next(&it);
+    }
+    return rank;
+}
+
+bool roaring64_bitmap_select(const roaring64_bitmap_t *r, uint64_t rank,
+                             uint64_t *element) {
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf = (const leaf_t *)it.value;
+        uint64_t cardinality =
+            container_get_cardinality(leaf->container, leaf->typecode);
+        if (rank < cardinality) {
+            uint32_t start_rank = 0;
+            uint32_t low16 = 0;
+            bool found = container_select(leaf->container, leaf->typecode,
+                                          &start_rank, (uint32_t)rank, &low16);
+            assert(found);
+            (void)found;
+            *element = combine_key(leaf->_pad.key, (uint16_t)low16);
+            return true;
+        }
+        rank -= cardinality;
+        art_iterator_next(&it);
+    }
+    return false;
+}
+
+bool roaring64_bitmap_run_optimize(roaring64_bitmap_t *r) {
+    bool answer = false;
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        leaf_t *leaf = (leaf_t *)it.value;
+        uint8_t typecode_after;
+        leaf->container = convert_run_optimize(leaf->container, leaf->typecode,
+                                               &typecode_after);
+        leaf->typecode = typecode_after;
+        if (typecode_after == RUN_CONTAINER_TYPE) {
+            answer = true;
+        }
+        art_iterator_next(&it);
+    }
+    return answer;
+}
+
+size_t roaring64_bitmap_size_in_bytes(const roaring64_bitmap_t *r) {
+    size_t size = sizeof(roaring64_bitmap_t) + art_size_in_bytes(&r->art);
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf = (const leaf_t *)it.value;
+        size += sizeof(leaf_t) +
+                container_size_in_bytes(leaf->container, leaf->typecode);
+        art_iterator_next(&it);
+    }
+    return size;
+}
+
+bool roaring64_bitmap_equals(const roaring64_bitmap_t *r1,
+                             const roaring64_bitmap_t *r2) {
+    art_iterator_t it1, it2;
+    art_init_iterator(&r1->art, &it1, /*first=*/true);
+    art_init_iterator(&r2->art, &it2, /*first=*/true);
+    while (it1.value != NULL && it2.value != NULL) {
+        const leaf_t *leaf1 = (const leaf_t *)it1.value;
+        const leaf_t *leaf2 = (const leaf_t *)it2.value;
+        if (art_compare_keys(leaf1->_pad.key, leaf2->_pad.key) != 0 ||
+            !container_equals(leaf1->container, leaf1->typecode,
+                              leaf2->container, leaf2->typecode)) {
+            return false;
+        }
+        art_iterator_next(&it1);
+        art_iterator_next(&it2);
+    }
+    return it1.value == NULL && it2.value == NULL;
+}
+
+bool roaring64_bitmap_is_subset(const roaring64_bitmap_t *r1,
+                                const roaring64_bitmap_t *r2) {
+    art_iterator_t it;
+    art_init_iterator(&r1->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf1 = (const leaf_t *)it.value;
+        const leaf_t *leaf2 = (const leaf_t *)art_find(&r2->art, it.value->key);
+        if (leaf2 == NULL ||
+            !container_is_subset(leaf1->container, leaf1->typecode,
+                                 leaf2->container, leaf2->typecode)) {
+            return false;
+        }
+        art_iterator_next(&it);
+    }
+    return true;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_and(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *result = roaring64_bitmap_create();
+    if (result == NULL) {
+        return NULL;
+    }
+    bool is_ok = true;
+    art_iterator_t it1, it2;
+    art_init_iterator(&r1->art, &it1, /*first=*/true);
+    art_init_iterator(&r2->art, &it2, /*first=*/true);
+    while (is_ok && it1.value != NULL && it2.value != NULL) {
+        int cmp = art_compare_keys(it1.value->key, it2.value->key);
+        if (cmp < 0) {
+            art_iterator_lower_bound(&r1->art, &it1, it2.value->key);
+        } else if (cmp > 0) {
+            art_iterator_lower_bound(&r2->art, &it2, it1.value->key);
+        } else {
+            const leaf_t *leaf1 = (const leaf_t *)it1.value;
+            const leaf_t *leaf2 = (const leaf_t *)it2.value;
+            uint8_t result_type;
+            container_t *c =
+                container_and(leaf1->container, leaf1->typecode,
+                              leaf2->container, leaf2->typecode, &result_type);
+            if (container_nonzero_cardinality(c, result_type)) {
+                is_ok = insert_leaf(result, leaf1->_pad.key, c, result_type);
+            } else {
+                container_free(c, result_type);
+            }
+            art_iterator_next(&it1);
+            art_iterator_next(&it2);
+        }
+    }
+    if (!is_ok) {
+        roaring64_bitmap_free(result);
+        return NULL;
+    }
+    return result;
+}
+
+uint64_t roaring64_bitmap_and_cardinality(const roaring64_bitmap_t *r1,
+                                          const roaring64_bitmap_t *r2) {
+    uint64_t answer = 0;
+    art_iterator_t it1, it2;
+    art_init_iterator(&r1->art, &it1, /*first=*/true);
+    art_init_iterator(&r2->art, &it2, /*first=*/true);
+    while (it1.value != NULL && it2.value != NULL) {
+        int cmp = art_compare_keys(it1.value->key, it2.value->key);
+        if (cmp < 0) {
+            art_iterator_lower_bound(&r1->art, &it1, it2.value->key);
+        } else if (cmp > 0) {
+            art_iterator_lower_bound(&r2->art, &it2, it1.value->key);
+        } else {
+            const leaf_t *leaf1 = (const leaf_t *)it1.value;
+            const leaf_t *leaf2 = (const leaf_t *)it2.value;
+            answer += container_and_cardinality(
+                leaf1->container, leaf1->typecode, leaf2->container,
+                leaf2->typecode);
+            art_iterator_next(&it1);
+            art_iterator_next(&it2);
+        }
+    }
+    return answer;
+}
+
+void roaring64_bitmap_and_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2) {
+    if (r1 == r2) return;
+    art_iterator_t it;
+    art_init_iterator(&r1->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        leaf_t *leaf1 = (leaf_t *)it.value;
+        const leaf_t *leaf2 = (const leaf_t *)art_find(&r2->art, it.value->key);
+        if (leaf2 == NULL) {
+            erase_leaf_at(r1, &it);
+            continue;
+        }
+        uint8_t result_type;
+        container_t *c =
+            container_iand(leaf1->container, leaf1->typecode, leaf2->container,
+                           leaf2->typecode, &result_type);
+        replace_container(leaf1, c, result_type);
+        if (!container_nonzero_cardinality(c, result_type)) {
+            erase_leaf_at(r1, &it);
+            continue;
+        }
+        art_iterator_next(&it);
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_or(const roaring64_bitmap_t *r1,
+                                        const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *result = roaring64_bitmap_create();
+    if (result == NULL) {
+        return NULL;
+    }
+    bool is_ok = true;
+    art_iterator_t it1, it2;
+    art_init_iterator(&r1->art, &it1, /*first=*/true);
+    art_init_iterator(&r2->art, &it2, /*first=*/true);
+    while (is_ok && (it1.value != NULL || it2.value != NULL)) {
+        int cmp = it1.value == NULL   ? 1
+                  : it2.value == NULL ? -1
+                  : art_compare_keys(it1.value->key, it2.value->key);
+        const leaf_t *leaf1 = (const leaf_t *)it1.value;
+        const leaf_t *leaf2 = (const leaf_t *)it2.value;
+        if (cmp < 0) {
+            is_ok = insert_leaf(
+                result, leaf1->_pad.key,
+                container_clone(leaf1->container, leaf1->typecode),
+                leaf1->typecode);
+            art_iterator_next(&it1);
+        } else if (cmp > 0) {
+            is_ok = insert_leaf(
+                result, leaf2->_pad.key,
+                container_clone(leaf2->container, leaf2->typecode),
+                leaf2->typecode);
+            art_iterator_next(&it2);
+        } else {
+            uint8_t result_type;
+            container_t *c =
+                container_or(leaf1->container, leaf1->typecode,
+                             leaf2->container, leaf2->typecode, &result_type);
+            is_ok = insert_leaf(result, leaf1->_pad.key, c, result_type);
+            art_iterator_next(&it1);
+            art_iterator_next(&it2);
+        }
+    }
+    if (!is_ok) {
+        roaring64_bitmap_free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void roaring64_bitmap_or_inplace(roaring64_bitmap_t *r1,
+                                 const roaring64_bitmap_t *r2) {
+    if (r1 == r2) return;
+    art_iterator_t it;
+    art_init_iterator(&r2->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf2 = (const leaf_t *)it.value;
+        leaf_t *leaf1 = (leaf_t *)art_find(&r1->art, it.value->key);
+        if (leaf1 == NULL) {
+            if (!insert_leaf(r1, leaf2->_pad.key,
+                             container_clone(leaf2->container, leaf2->typecode),
+                             leaf2->typecode)) {
+                return;
+            }
+        } else {
+            uint8_t result_type;
+            container_t *c =
+                container_ior(leaf1->container, leaf1->typecode,
+                              leaf2->container, leaf2->typecode, &result_type);
+            replace_container(leaf1, c, result_type);
+        }
+        art_iterator_next(&it);
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_xor(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *result = roaring64_bitmap_create();
+    if (result == NULL) {
+        return NULL;
+    }
+    bool is_ok = true;
+    art_iterator_t it1, it2;
+    art_init_iterator(&r1->art, &it1, /*first=*/true);
+    art_init_iterator(&r2->art, &it2, /*first=*/true);
+    while (is_ok && (it1.value != NULL || it2.value != NULL)) {
+        int cmp = it1.value == NULL   ? 1
+                  : it2.value == NULL ? -1
+                  : art_compare_keys(it1.value->key, it2.value->key);
+        const leaf_t *leaf1 = (const leaf_t *)it1.value;
+        const leaf_t *leaf2 = (const leaf_t *)it2.value;
+        if (cmp < 0) {
+            is_ok = insert_leaf(
+                result, leaf1->_pad.key,
+                container_clone(leaf1->container, leaf1->typecode),
+                leaf1->typecode);
+            art_iterator_next(&it1);
+        } else if (cmp > 0) {
+            is_ok = insert_leaf(
+                result, leaf2->_pad.key,
+                container_clone(leaf2->container, leaf2->typecode),
+                leaf2->typecode);
+            art_iterator_next(&it2);
+        } else {
+            uint8_t result_type;
+            container_t *c =
+                container_xor(leaf1->container, leaf1->typecode,
+                              leaf2->container, leaf2->typecode, &result_type);
+            if (container_nonzero_cardinality(c, result_type)) {
+                is_ok = insert_leaf(result, leaf1->_pad.key, c, result_type);
+            } else {
+                container_free(c, result_type);
+            }
+            art_iterator_next(&it1);
+            art_iterator_next(&it2);
+        }
+    }
+    if (!is_ok) {
+        roaring64_bitmap_free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void roaring64_bitmap_xor_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2) {
+    assert(r1 != r2);
+    art_iterator_t it;
+    art_init_iterator(&r2->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf2 = (const leaf_t *)it.value;
+        leaf_t *leaf1 = (leaf_t *)art_find(&r1->art, it.value->key);
+        if (leaf1 == NULL) {
+            if (!insert_leaf(r1, leaf2->_pad.key,
+                             container_clone(leaf2->container, leaf2->typecode),
+                             leaf2->typecode)) {
+                return;
+            }
+        } else {
+            // container_ixor() frees the first container when it returns a
+            // new one.
+            uint8_t result_type;
+            leaf1->container =
+                container_ixor(leaf1->container, leaf1->typecode,
+                               leaf2->container, leaf2->typecode, &result_type);
+            leaf1->typecode = result_type;
+            if (!container_nonzero_cardinality(leaf1->container,
+                                               leaf1->typecode)) {
+                art_erase(&r1->art, leaf2->_pad.key);
+                free_leaf(leaf1);
+            }
+        }
+        art_iterator_next(&it);
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_andnot(const roaring64_bitmap_t *r1,
+                                            const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *result = roaring64_bitmap_create();
+    if (result == NULL) {
+        return NULL;
+    }
+    bool is_ok = true;
+    art_iterator_t it;
+    art_init_iterator(&r1->art, &it, /*first=*/true);
+    while (is_ok && it.value != NULL) {
+        const leaf_t *leaf1 = (const leaf_t *)it.value;
+        const leaf_t *leaf2 = (const leaf_t *)art_find(&r2->art, it.value->key);
+        if (leaf2 == NULL) {
+            is_ok = insert_leaf(
+                result, leaf1->_pad.key,
+                container_clone(leaf1->container, leaf1->typecode),
+                leaf1->typecode);
+        } else {
+            uint8_t result_type;
+            container_t *c = container_andnot(leaf1->container,
+                                              leaf1->typecode, leaf2->container,
+                                              leaf2->typecode, &result_type);
+            if (container_nonzero_cardinality(c, result_type)) {
+                is_ok = insert_leaf(result, leaf1->_pad.key, c, result_type);
+            } else {
+                container_free(c, result_type);
+            }
+        }
+        art_iterator_next(&it);
+    }
+    if (!is_ok) {
+        roaring64_bitmap_free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void roaring64_bitmap_andnot_inplace(roaring64_bitmap_t *r1,
+                                     const roaring64_bitmap_t *r2) {
+    assert(r1 != r2);
+    art_iterator_t it;
+    art_init_iterator(&r1->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        leaf_t *leaf1 = (leaf_t *)it.value;
+        const leaf_t *leaf2 = (const leaf_t *)art_find(&r2->art, it.value->key);
+        if (leaf2 != NULL) {
+            // container_iandnot() frees the first container when it returns a
+            // new one.
+            uint8_t result_type;
+            leaf1->container = container_iandnot(
+                leaf1->container, leaf1->typecode, leaf2->container,
+                leaf2->typecode, &result_type);
+            leaf1->typecode = result_type;
+            if (!container_nonzero_cardinality(leaf1->container,
+                                               leaf1->typecode)) {
+                erase_leaf_at(r1, &it);
+                continue;
+            }
+        }
+        art_iterator_next(&it);
+    }
+}
+
+bool roaring64_bitmap_iterate(const roaring64_bitmap_t *r,
+                              roaring_iterator64 iterator, void *ptr) {
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        const leaf_t *leaf = (const leaf_t *)it.value;
+        if (!container_iterate64(leaf->container, leaf->typecode, 0, iterator,
+                                 combine_key(leaf->_pad.key, 0), ptr)) {
+            return false;
+        }
+        art_iterator_next(&it);
+    }
+    return true;
+}
+
+void roaring64_bitmap_to_uint64_array(const roaring64_bitmap_t *r,
+                                      uint64_t *out) {
+    roaring64_iterator_t it;
+    roaring64_iterator_reinit(r, &it);
+    roaring64_iterator_read(&it, out, UINT64_MAX);
+}
+
+// Collects the containers of the consecutive leaves sharing the upper 32 bits
+// of the current leaf into `bucket`, which does not own them, and moves the
+// iterator past them. Returns those upper 32 bits.
+static uint32_t fill_bucket(art_iterator_t *it, roaring_array_t *bucket) {
+    const uint8_t *first_key = it->value->key;
+    uint32_t high32 = (uint32_t)(combine_key(first_key, 0) >> 32);
+    bucket->size = 0;
+    while (it->value != NULL &&
+           (uint32_t)(combine_key(it->value->key, 0) >> 32) == high32) {
+        const leaf_t *leaf = (const leaf_t *)it->value;
+        uint16_t key16 = (uint16_t)(leaf->_pad.key[4] << 8 | leaf->_pad.key[5]);
+        ra_append(bucket, key16, leaf->container, leaf->typecode);
+        art_iterator_next(it);
+    }
+    return high32;
+}
+
+size_t roaring64_bitmap_portable_size_in_bytes(const roaring64_bitmap_t *r) {
+    size_t size = sizeof(uint64_t);
+    roaring_array_t bucket;
+    ra_init(&bucket);
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        fill_bucket(&it, &bucket);
+        size += sizeof(uint32_t) + ra_portable_size_in_bytes(&bucket);
+    }
+    ra_clear_without_containers(&bucket);
+    return size;
+}
+
+size_t roaring64_bitmap_portable_serialize(const roaring64_bitmap_t *r,
+                                           char *buf) {
+    char *initbuf = buf;
+    uint64_t bucket_count = 0;
+    buf += sizeof(uint64_t);  // filled in below, once known
+    roaring_array_t bucket;
+    ra_init(&bucket);
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL) {
+        uint32_t high32 = fill_bucket(&it, &bucket);
+        memcpy(buf, &high32, sizeof(uint32_t));
+        buf += sizeof(uint32_t);
+        buf += ra_portable_serialize(&bucket, buf);
+        bucket_count++;
+    }
+    ra_clear_without_containers(&bucket);
+    memcpy(initbuf, &bucket_count, sizeof(uint64_t));
+    return buf - initbuf;
+}
+
+size_t roaring64_bitmap_portable_serialize_stream(const roaring64_bitmap_t *r,
+                                                  roaring_writev_fn writer,
+                                                  void *context) {
+    // The bucket count comes first, so count the distinct upper 32 bits
+    // before streaming anything.
+    uint64_t bucket_count = 0;
+    art_iterator_t it;
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    uint32_t prev_high32 = 0;
+    while (it.value != NULL) {
+        uint32_t high32 = (uint32_t)(combine_key(it.value->key, 0) >> 32);
+        if (bucket_count == 0 || high32 != prev_high32) {
+            bucket_count++;
+            prev_high32 = high32;
+        }
+        art_iterator_next(&it);
+    }
+
+    ra_stream_t s;
+    ra_stream_init(&s, writer, context);
+    ra_stream_copy(&s, &bucket_count, sizeof(uint64_t));
+    roaring_array_t bucket;
+    ra_init(&bucket);
+    art_init_iterator(&r->art, &it, /*first=*/true);
+    while (it.value != NULL && !s.failed) {
+        uint32_t high32 = fill_bucket(&it, &bucket);
+        ra_stream_copy(&s, &high32, sizeof(uint32_t));
+        // only the container payloads are referenced, the bucket's own
+        // arrays are copied, so the bucket can be refilled right away
+        ra_portable_serialize_stream(&bucket, &s);
+    }
+    ra_clear_without_containers(&bucket);
+    return ra_stream_flush(&s) ? s.written : 0;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_portable_deserialize_safe(
+    const char *buf, size_t maxbytes) {
+    if (maxbytes < sizeof(uint64_t)) {
+        return NULL;
+    }
+    uint64_t bucket_count;
+    memcpy(&bucket_count, buf, sizeof(uint64_t));
+    buf += sizeof(uint64_t);
+    maxbytes -= sizeof(uint64_t);
+
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    if (r == NULL) {
+        return NULL;
+    }
+    for (uint64_t i = 0; i < bucket_count; i++) {
+        if (maxbytes < sizeof(uint32_t)) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+        uint32_t high32;
+        memcpy(&high32, buf, sizeof(uint32_t));
+        buf += sizeof(uint32_t);
+        maxbytes -= sizeof(uint32_t);
+
+        roaring_array_t bucket;
+        size_t bytesread;
+        if (!ra_portable_deserialize(&bucket, buf, maxbytes, &bytesread)) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+        buf += bytesread;
+        maxbytes -= bytesread;
+
+        // Move the containers into leaves. A key seen twice means the input
+        // is corrupt.
+        bool is_ok = true;
+        for (int32_t j = 0; j < bucket.size; j++) {
+            uint8_t high48[ART_KEY_BYTES];
+            split_key(((uint64_t)high32 << 32) |
+                          ((uint64_t)bucket.keys[j] << 16),
+                      high48);
+            leaf_t *leaf = is_ok ? create_leaf(bucket.containers[j],
+                                               bucket.typecodes[j])
+                                 : NULL;
+            art_val_t *existing;
+            if (leaf == NULL) {
+                container_free(bucket.containers[j], bucket.typecodes[j]);
+                is_ok = false;
+            } else if (!art_insert(&r->art, high48, (art_val_t *)leaf,
+                                   &existing) ||
+                       existing != NULL) {
+                free_leaf(leaf);
+                is_ok = false;
+            }
+        }
+        ra_clear_without_containers(&bucket);
+        if (!is_ok) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+    }
+    return r;
+}
+
+// Points the iterator at the current leaf of its ART iterator, positioned at
+// the first (or last) value of the leaf's container.
+static bool iterator_load_leaf(roaring64_iterator_t *it, bool first) {
+    const leaf_t *leaf = (const leaf_t *)it->art_it.value;
+    if (leaf == NULL) {
+        it->has_value = false;
+        it->saturated_forward = first;
+        return false;
+    }
+    it->high48 = combine_key(leaf->_pad.key, 0);
+    it->view_key = 0;
+    it->view_container = leaf->container;
+    it->view_typecode = leaf->typecode;
+    if (first) {
+        roaring_init_iterator(&it->view, &it->container_it);
+    } else {
+        roaring_init_iterator_last(&it->view, &it->container_it);
+    }
+    it->has_value = true;
+    return true;
+}
+
+static void iterator_init_view(roaring64_iterator_t *it) {
+    roaring_array_t *ra = &it->view.high_low_container;
+    ra->size = 1;
+    ra->allocation_size = 1;
+    ra->keys = &it->view_key;
+    ra->containers = &it->view_container;
+    ra->typecodes = &it->view_typecode;
+    ra->flags = 0;
+    ra->version = 0;
+    it->container_it.parent = &it->view;
+}
+
+static void iterator_init(const roaring64_bitmap_t *r, roaring64_iterator_t *it,
+                          bool first) {
+    it->parent = r;
+    iterator_init_view(it);
+    art_init_iterator(&r->art, &it->art_it, first);
+    iterator_load_leaf(it, first);
+    if (!it->has_value) {
+        it->saturated_forward = true;
+    }
+}
+
+roaring64_iterator_t *roaring64_iterator_create(const roaring64_bitmap_t *r) {
+    roaring64_iterator_t *it =
+        (roaring64_iterator_t *)roaring_malloc(sizeof(roaring64_iterator_t));
+    if (it == NULL) {
+        return NULL;
+    }
+    iterator_init(r, it, /*first=*/true);
+    return it;
+}
+
+roaring64_iterator_t *roaring64_iterator_create_last(
+    const roaring64_bitmap_t *r) {
+    roaring64_iterator_t *it =
+        (roaring64_iterator_t *)roaring_malloc(sizeof(roaring64_iterator_t));
+    if (it == NULL) {
+        return NULL;
+    }
+    iterator_init(r, it, /*first=*/false);
+    return it;
+}
+
+void roaring64_iterator_reinit(const roaring64_bitmap_t *r,
+                               roaring64_iterator_t *it) {
+    iterator_init(r, it, /*first=*/true);
+}
+
+roaring64_iterator_t *roaring64_iterator_copy(const roaring64_iterator_t *it) {
+    roaring64_iterator_t *new_it =
+        (roaring64_iterator_t *)roaring_malloc(sizeof(roaring64_iterator_t));
+    if (new_it == NULL) {
+        return NULL;
+    }
+    memcpy(new_it, it, sizeof(*it));
+    // The view points into the iterator itself.
+    iterator_init_view(new_it);
+    return new_it;
+}
+
+void roaring64_iterator_free(roaring64_iterator_t *it) { roaring_free(it); }
+
+bool roaring64_iterator_has_value(const roaring64_iterator_t *it) {
+    return it->has_value;
+}
+
+uint64_t roaring64_iterator_value(const roaring64_iterator_t *it) {
+    return it->high48 | it->container_it.current_value;
+}
+
+bool roaring64_iterator_advance(roaring64_iterator_t *it) {
+    if (!it->has_value) {
+        if (it->saturated_forward) {
+            return false;
+        }
+        art_init_iterator(&it->parent->art, &it->art_it, /*first=*/true);
+        return iterator_load_leaf(it, /*first=*/true);
+    }
+    if (roaring_advance_uint32_iterator(&it->container_it)) {
+        return true;
+    }
+    art_iterator_next(&it->art_it);
+    return iterator_load_leaf(it, /*first=*/true);
+}
+
+bool roaring64_iterator_previous(roaring64_iterator_t *it) {
+    if (!it->has_value) {
+        if (!it->saturated_forward) {
+            return false;
+        }
+        art_init_iterator(&it->parent->art, &it->art_it, /*first=*/false);
+        return iterator_load_leaf(it, /*first=*/false);
+    }
+    if (roaring_previous_uint32_iterator(&it->container_it)) {
+        return true;
+    }
+    art_iterator_prev(&it->art_it);
+    return iterator_load_leaf(it, /*first=*/false);
+}
+
+bool roaring64_iterator_move_equalorlarger(roaring64_iterator_t *it,
+                                           uint64_t val) {
+    uint8_t high48[ART_KEY_BYTES];
+    uint16_t low16 = split_key(val, high48);
+    art_iterator_lower_bound(&it->parent->art, &it->art_it, high48);
+    if (!iterator_load_leaf(it, /*first=*/true)) {
+        return false;
+    }
+    if (art_compare_keys(it->art_it.value->key, high48) > 0) {
+        return true;
+    }
+    if (roaring_move_uint32_iterator_equalorlarger(&it->container_it, low16)) {
+        return true;
+    }
+    art_iterator_next(&it->art_it);
+    return iterator_load_leaf(it, /*first=*/true);
+}
+
+uint64_t roaring64_iterator_read(roaring64_iterator_t *it, uint64_t *buf,
+                                 uint64_t count) {
+    uint32_t low_buf[1024];
+    uint64_t consumed = 0;
+    while (it->has_value && consumed < count) {
+        uint64_t wanted = count - consumed;
+        if (wanted > 1024) {
+            wanted = 1024;
+        }
+        uint32_t n = roaring_read_uint32_iterator(&it->container_it, low_buf,
+                                                  (uint32_t)wanted);
+        for (uint32_t i = 0; i < n; i++) {
+            buf[consumed + i] = it->high48 | low_buf[i];
+        }
+        consumed += n;
+        if (!it->container_it.has_value) {
+            art_iterator_next(&it->art_it);
+            iterator_load_leaf(it, /*first=*/true);
+        }
+    }
+    return consumed;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
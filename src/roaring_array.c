@@ -110,6 +110,21 @@ void ra_init(roaring_array_t *new_ra) {
     new_ra->allocation_size = 0;
     new_ra->size = 0;
     new_ra->flags = 0;
+    new_ra->version = 0;
+}
+
+// Turns the container at index i into a shared container (unless it is one
+// already) and returns a new reference to it. The source array is only
+// written when the container was not shared yet: once all containers of a
+// copy-on-write bitmap are shared, it can be copied from several threads.
+static inline container_t *ra_get_shared_copy(const roaring_array_t *sa,
+                                              int32_t i) {
+    container_t *c = get_copy_of_container(sa->containers[i],
+                                           &sa->typecodes[i], true);
+    if (c != sa->containers[i]) {
+        sa->containers[i] = c;
+    }
+    return c;
 }
 
 bool ra_overwrite(const roaring_array_t *source, roaring_array_t *dest,
@@ -129,8 +144,7 @@ bool ra_overwrite(const roaring_array_t *source, roaring_array_t *dest,
     // we go through the containers, turning them into shared containers...
     if (copy_on_write) {
         for (int32_t i = 0; i < dest->size; ++i) {
-            source->containers[i] = get_copy_of_container(
-                source->containers[i], &source->typecodes[i], copy_on_write);
+            ra_get_shared_copy(source, i);
         }
         // we do a shallow copy to the other bitmap
         memcpy(dest->containers, source->containers,
@@ -219,9 +233,7 @@ void ra_append_copy(roaring_array_t *ra, const roaring_array_t *sa,
     ra->keys[pos] = sa->keys[index];
     // the shared container will be in two bitmaps
     if (copy_on_write) {
-        sa->containers[index] = get_copy_of_container(
-            sa->containers[index], &sa->typecodes[index], copy_on_write);
-        ra->containers[pos] = sa->containers[index];
+        ra->containers[pos] = ra_get_shared_copy(sa, index);
         ra->typecodes[pos] = sa->typecodes[index];
     } else {
         ra->containers[pos] =
@@ -247,9 +259,7 @@ void ra_append_copy_range(roaring_array_t *ra, const roaring_array_t *sa,
         const int32_t pos = ra->size;
         ra->keys[pos] = sa->keys[i];
         if (copy_on_write) {
-            sa->containers[i] = get_copy_of_container(
-                sa->containers[i], &sa->typecodes[i], copy_on_write);
-            ra->containers[pos] = sa->containers[i];
+            ra->containers[pos] = ra_get_shared_copy(sa, i);
             ra->typecodes[pos] = sa->typecodes[i];
         } else {
             ra->containers[pos] =
@@ -293,9 +303,7 @@ void ra_append_range(roaring_array_t *ra, roaring_array_t *sa,
         const int32_t pos = ra->size;
         ra->keys[pos] = sa->keys[i];
         if (copy_on_write) {
-            sa->containers[i] = get_copy_of_container(
-                sa->containers[i], &sa->typecodes[i], copy_on_write);
-            ra->containers[pos] = sa->containers[i];
+            ra->containers[pos] = ra_get_shared_copy(sa, i);
             ra->typecodes[pos] = sa->typecodes[i];
         } else {
             ra->containers[pos] =
@@ -547,7 +555,7 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
     uint32_t startOffset = 0;
     bool hasrun = ra_has_run_container(ra);
     if (hasrun) {
-        uint32_t cookie = SERIAL_COOKIE | ((ra->size - 1) << 16);
+        uint32_t cookie = SERIAL_COOKIE | ((uint32_t)(ra->size - 1) << 16);
         memcpy(buf, &cookie, sizeof(cookie));
         buf += sizeof(cookie);
         uint32_t s = (ra->size + 7) / 8;
@@ -603,155 +611,240 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
     return buf - initbuf;
 }
 
-// Quickly checks whether there is a serialized bitmap at the pointer,
-// not exceeding size "maxbytes" in bytes. This function does not allocate
-// memory dynamically.
-//
-// This function returns 0 if and only if no valid bitmap is found.
-// Otherwise, it returns how many bytes are occupied.
-//
-size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes) {
-    size_t bytestotal = sizeof(int32_t);// for cookie
-    if(bytestotal > maxbytes) return 0;
-    uint32_t cookie;
-    memcpy(&cookie, buf, sizeof(int32_t));
-    buf += sizeof(uint32_t);
-    if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
-        cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
-        return 0;
+void ra_stream_init(ra_stream_t *s, roaring_writev_fn writer, void *context) {
+    s->writer = writer;
+    s->context = context;
+    s->iovcnt = 0;
+    s->staged = 0;
+    s->written = 0;
+    s->failed = false;
+}
+
+bool ra_stream_flush(ra_stream_t *s) {
+    if (!s->failed && s->iovcnt > 0) {
+        s->failed = !s->writer(s->context, s->iov, s->iovcnt);
     }
-    int32_t size;
+    s->iovcnt = 0;
+    s->staged = 0;
+    return !s->failed;
+}
 
-    if ((cookie & 0xFFFF) == SERIAL_COOKIE)
-        size = (cookie >> 16) + 1;
-    else {
-        bytestotal += sizeof(int32_t);
-        if(bytestotal > maxbytes) return 0;
-        memcpy(&size, buf, sizeof(int32_t));
-        buf += sizeof(uint32_t);
+void ra_stream_copy(ra_stream_t *s, const void *data, size_t len) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        if (s->staged == RA_STREAM_STAGING_BYTES) {
+            ra_stream_flush(s);
+        }
+        char *dst = s->staging + s->staged;
+        // consecutive copies grow the same chunk; a chunk ending inside the
+        // staging buffer past its start can only be a staged one
+        roaring_iovec_t *last = s->iovcnt > 0 ? &s->iov[s->iovcnt - 1] : NULL;
+        bool extend = s->staged > 0 && last != NULL &&
+                      (const char *)last->base + last->len == dst;
+        if (!extend && s->iovcnt == RA_STREAM_MAX_IOV) {
+            ra_stream_flush(s);
+            continue;
+        }
+        size_t n = RA_STREAM_STAGING_BYTES - s->staged;
+        if (n > len) n = len;
+        memcpy(dst, p, n);
+        if (extend) {
+            last->len += n;
+        } else {
+            s->iov[s->iovcnt].base = dst;
+            s->iov[s->iovcnt].len = n;
+            s->iovcnt++;
+        }
+        s->staged += n;
+        s->written += n;
+        p += n;
+        len -= n;
     }
-    if (size > (1<<16)) {
-       return 0; // logically impossible
+}
+
+void ra_stream_ref(ra_stream_t *s, const void *data, size_t len) {
+    if (len == 0) return;
+    if (s->iovcnt == RA_STREAM_MAX_IOV) {
+        ra_stream_flush(s);
     }
-    char *bitmapOfRunContainers = NULL;
-    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
+    s->iov[s->iovcnt].base = data;
+    s->iov[s->iovcnt].len = len;
+    s->iovcnt++;
+    s->written += len;
+}
+
+void ra_portable_serialize_stream(const roaring_array_t *ra, ra_stream_t *s) {
+    uint32_t startOffset = 0;
+    bool hasrun = ra_has_run_container(ra);
     if (hasrun) {
-        int32_t s = (size + 7) / 8;
-        bytestotal += s;
-        if(bytestotal > maxbytes) return 0;
-        bitmapOfRunContainers = (char *)buf;
-        buf += s;
+        uint32_t cookie = SERIAL_COOKIE | ((uint32_t)(ra->size - 1) << 16);
+        ra_stream_copy(s, &cookie, sizeof(cookie));
+        uint32_t runbytes = (ra->size + 7) / 8;
+        for (int32_t i = 0; i < ra->size; i += 8) {
+            uint8_t runflags = 0;
+            for (int32_t j = i; j < i + 8 && j < ra->size; ++j) {
+                if (get_container_type(ra->containers[j], ra->typecodes[j]) ==
+                    RUN_CONTAINER_TYPE) {
+                    runflags |= (uint8_t)(1 << (j % 8));
+                }
+            }
+            ra_stream_copy(s, &runflags, sizeof(runflags));
+        }
+        if (ra->size < NO_OFFSET_THRESHOLD) {
+            startOffset = 4 + 4 * ra->size + runbytes;
+        } else {
+            startOffset = 4 + 8 * ra->size + runbytes;
+        }
+    } else {  // backwards compatibility
+        uint32_t cookie = SERIAL_COOKIE_NO_RUNCONTAINER;
+        ra_stream_copy(s, &cookie, sizeof(cookie));
+        ra_stream_copy(s, &ra->size, sizeof(ra->size));
+        startOffset = 4 + 4 + 4 * ra->size + 4 * ra->size;
     }
-    bytestotal += size * 2 * sizeof(uint16_t);
-    if(bytestotal > maxbytes) return 0;
-    uint16_t *keyscards = (uint16_t *)buf;
-    buf += size * 2 * sizeof(uint16_t);
-    if ((!hasrun) || (size >= NO_OFFSET_THRESHOLD)) {
-        // skipping the offsets
-        bytestotal += size * 4;
-        if(bytestotal > maxbytes) return 0;
-        buf += size * 4;
+    for (int32_t k = 0; k < ra->size; ++k) {
+        ra_stream_copy(s, &ra->keys[k], sizeof(ra->keys[k]));
+        uint16_t card = (uint16_t)(
+            container_get_cardinality(ra->containers[k], ra->typecodes[k]) - 1);
+        ra_stream_copy(s, &card, sizeof(card));
     }
-    // Reading the containers
-    for (int32_t k = 0; k < size; ++k) {
-        uint16_t tmp;
-        memcpy(&tmp, keyscards + 2*k+1, sizeof(tmp));
-        uint32_t thiscard = tmp + 1;
-        bool isbitmap = (thiscard > DEFAULT_MAX_SIZE);
-        bool isrun = false;
-        if(hasrun) {
-          if((bitmapOfRunContainers[k / 8] & (1 << (k % 8))) != 0) {
-            isbitmap = false;
-            isrun = true;
-          }
+    if ((!hasrun) || (ra->size >= NO_OFFSET_THRESHOLD)) {
+        for (int32_t k = 0; k < ra->size; k++) {
+            ra_stream_copy(s, &startOffset, sizeof(startOffset));
+            startOffset +=
+                container_size_in_bytes(ra->containers[k], ra->typecodes[k]);
         }
-        if (isbitmap) {
-            size_t containersize = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
-            bytestotal += containersize;
-            if(bytestotal > maxbytes) return 0;
-            buf += containersize;
-        } else if (isrun) {
-            bytestotal += sizeof(uint16_t);
-            if(bytestotal > maxbytes) return 0;
-            uint16_t n_runs;
-            memcpy(&n_runs, buf, sizeof(uint16_t));
-            buf += sizeof(uint16_t);
-            size_t containersize = n_runs * sizeof(rle16_t);
-            bytestotal += containersize;
-            if(bytestotal > maxbytes) return 0;
-            buf += containersize;
-        } else {
-            size_t containersize = thiscard * sizeof(uint16_t);
-            bytestotal += containersize;
-            if(bytestotal > maxbytes) return 0;
-            buf += containersize;
+    }
+    // the payloads go out straight from the containers, as in
+    // container_write
+    for (int32_t k = 0; k < ra->size && !s->failed; ++k) {
+        uint8_t typecode = ra->typecodes[k];
+        const container_t *c =
+            container_unwrap_shared(ra->containers[k], &typecode);
+        switch (typecode) {
+            case BITSET_CONTAINER_TYPE:
+                ra_stream_ref(s, const_CAST_bitset(c)->words,
+                              BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+                break;
+            case ARRAY_CONTAINER_TYPE: {
+                const array_container_t *ac = const_CAST_array(c);
+                ra_stream_ref(s, ac->array,
+                              ac->cardinality * sizeof(uint16_t));
+                break;
+            }
+            case RUN_CONTAINER_TYPE: {
+                const run_container_t *rc = const_CAST_run(c);
+                ra_stream_copy(s, &rc->n_runs, sizeof(uint16_t));
+                ra_stream_ref(s, rc->runs, rc->n_runs * sizeof(rle16_t));
+                break;
+            }
         }
     }
-    return bytestotal;
 }
 
-
-// this function populates answer from the content of buf (reading up to maxbytes bytes).
-// The function returns false if a properly serialized bitmap cannot be found.
-// if it returns true, readbytes is populated by how many bytes were read, we have that *readbytes <= maxbytes.
-bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const size_t maxbytes, size_t * readbytes) {
-    *readbytes = sizeof(int32_t);// for cookie
-    if(*readbytes > maxbytes) {
-      fprintf(stderr, "Ran out of bytes while reading first 4 bytes.\n");
-      return false;
-    }
-    uint32_t cookie;
-    memcpy(&cookie, buf, sizeof(int32_t));
-    buf += sizeof(uint32_t);
-    if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
-        cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
-        fprintf(stderr, "I failed to find one of the right cookies. Found %" PRIu32 "\n",
-                cookie);
+bool ra_portable_header_parse(const char *buf, size_t maxbytes,
+                              ra_portable_header_t *header) {
+    header->bytes = sizeof(uint32_t);
+    if (header->bytes > maxbytes) {
         return false;
     }
+    uint32_t cookie;
+    memcpy(&cookie, buf, sizeof(uint32_t));
+    const bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
     int32_t size;
-
-    if ((cookie & 0xFFFF) == SERIAL_COOKIE)
+    if (hasrun) {
         size = (cookie >> 16) + 1;
-    else {
-        *readbytes += sizeof(int32_t);
-        if(*readbytes > maxbytes) {
-          fprintf(stderr, "Ran out of bytes while reading second part of the cookie.\n");
-          return false;
+    } else if (cookie == SERIAL_COOKIE_NO_RUNCONTAINER) {
+        header->bytes += sizeof(int32_t);
+        if (header->bytes > maxbytes) {
+            return false;
+        }
+        memcpy(&size, buf + sizeof(uint32_t), sizeof(int32_t));
+        if (size < 0 || size > (1 << 16)) {
+            header->bytes = 0;  // logically impossible
+            return false;
         }
-        memcpy(&size, buf, sizeof(int32_t));
-        buf += sizeof(uint32_t);
+    } else {
+        header->bytes = 0;
+        return false;
     }
-    if (size < 0) {
-       fprintf(stderr, "You cannot have a negative number of containers, the data must be corrupted: %" PRId32 "\n",
-                size);
-       return false; // logically impossible
+    size_t run_flags = header->bytes;
+    if (hasrun) {
+        header->bytes += (size + 7) / 8;
     }
-    if (size > (1<<16)) {
-       fprintf(stderr, "You cannot have so many containers, the data must be corrupted: %" PRId32 "\n",
-                size);
-       return false; // logically impossible
+    size_t keyscards = header->bytes;
+    header->bytes += (size_t)size * 2 * sizeof(uint16_t);
+    if ((!hasrun) || (size >= NO_OFFSET_THRESHOLD)) {
+        header->bytes += (size_t)size * sizeof(uint32_t);  // the offsets
     }
-    const char *bitmapOfRunContainers = NULL;
-    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
-    if (hasrun) {
-        int32_t s = (size + 7) / 8;
-        *readbytes += s;
-        if(*readbytes > maxbytes) {// data is corrupted?
-          fprintf(stderr, "Ran out of bytes while reading run bitmap.\n");
-          return false;
+    if (header->bytes > maxbytes) {
+        return false;
+    }
+    header->size = size;
+    header->run_flags = hasrun ? buf + run_flags : NULL;
+    header->keyscards = buf + keyscards;
+    return true;
+}
+
+// Quickly checks whether there is a serialized bitmap at the pointer,
+// not exceeding size "maxbytes" in bytes. This function does not allocate
+// memory dynamically.
+//
+// This function returns 0 if and only if no valid bitmap is found.
+// Otherwise, it returns how many bytes are occupied.
+//
+size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes) {
+    ra_portable_header_t header;
+    if (!ra_portable_header_parse(buf, maxbytes, &header)) {
+        return 0;
+    }
+    size_t bytestotal = header.bytes;
+    buf += header.bytes;
+    // Reading the containers
+    for (int32_t k = 0; k < header.size; ++k) {
+        size_t containersize;
+        switch (ra_portable_header_typecode(&header, k)) {
+            case BITSET_CONTAINER_TYPE:
+                containersize =
+                    BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+                break;
+            case RUN_CONTAINER_TYPE: {
+                bytestotal += sizeof(uint16_t);
+                if (bytestotal > maxbytes) return 0;
+                uint16_t n_runs;
+                memcpy(&n_runs, buf, sizeof(uint16_t));
+                buf += sizeof(uint16_t);
+                containersize = n_runs * sizeof(rle16_t);
+                break;
+            }
+            default:
+                containersize =
+                    ra_portable_header_card(&header, k) * sizeof(uint16_t);
+                break;
         }
-        bitmapOfRunContainers = buf;
-        buf += s;
+        bytestotal += containersize;
+        if (bytestotal > maxbytes) return 0;
+        buf += containersize;
     }
-    uint16_t *keyscards = (uint16_t *)buf;
+    return bytestotal;
+}
+
 
-    *readbytes += size * 2 * sizeof(uint16_t);
-    if(*readbytes > maxbytes) {
-      fprintf(stderr, "Ran out of bytes while reading key-cardinality array.\n");
-      return false;
+// this function populates answer from the content of buf (reading up to maxbytes bytes).
+// The function returns false if a properly serialized bitmap cannot be found.
+// if it returns true, readbytes is populated by how many bytes were read, we have that *readbytes <= maxbytes.
+bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const size_t maxbytes, size_t * readbytes) {
+    ra_portable_header_t header;
+    if (!ra_portable_header_parse(buf, maxbytes, &header)) {
+        if (header.bytes == 0) {
+            fprintf(stderr, "I failed to find a valid header, the data must be corrupted.\n");
+        } else {
+            fprintf(stderr, "Ran out of bytes while reading the header.\n");
+        }
+        return false;
     }
-    buf += size * 2 * sizeof(uint16_t);
+    *readbytes = header.bytes;
+    buf += header.bytes;
+    const int32_t size = header.size;
 
     bool is_ok = ra_init_with_capacity(answer, size);
     if (!is_ok) {
@@ -760,35 +853,13 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
     }
 
     for (int32_t k = 0; k < size; ++k) {
-        uint16_t tmp;
-        memcpy(&tmp, keyscards + 2*k, sizeof(tmp));
-        answer->keys[k] = tmp;
-    }
-    if ((!hasrun) || (size >= NO_OFFSET_THRESHOLD)) {
-        *readbytes += size * 4;
-        if(*readbytes > maxbytes) {// data is corrupted?
-          fprintf(stderr, "Ran out of bytes while reading offsets.\n");
-          ra_clear(answer);// we need to clear the containers already allocated, and the roaring array
-          return false;
-        }
-
-        // skipping the offsets
-        buf += size * 4;
+        answer->keys[k] = ra_portable_header_key(&header, k);
     }
     // Reading the containers
     for (int32_t k = 0; k < size; ++k) {
-        uint16_t tmp;
-        memcpy(&tmp, keyscards + 2*k+1, sizeof(tmp));
-        uint32_t thiscard = tmp + 1;
-        bool isbitmap = (thiscard > DEFAULT_MAX_SIZE);
-        bool isrun = false;
-        if(hasrun) {
-          if((bitmapOfRunContainers[k / 8] & (1 << (k % 8))) != 0) {
-            isbitmap = false;
-            isrun = true;
-          }
-        }
-        if (isbitmap) {
+        uint32_t thiscard = ra_portable_header_card(&header, k);
+        uint8_t typecode = ra_portable_header_typecode(&header, k);
+        if (typecode == BITSET_CONTAINER_TYPE) {
             // we check that the read is allowed
             size_t containersize = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
             *readbytes += containersize;
@@ -808,7 +879,7 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
             buf += bitset_container_read(thiscard, c, buf);
             answer->containers[k] = c;
             answer->typecodes[k] = BITSET_CONTAINER_TYPE;
-        } else if (isrun) {
+        } else if (typecode == RUN_CONTAINER_TYPE) {
             // we check that the read is allowed
             *readbytes += sizeof(uint16_t);
             if(*readbytes > maxbytes) {
@@ -863,6 +934,162 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
     return true;
 }
 
+typedef struct ra_parallel_read_s {
+    const char *buf;
+    const size_t *offsets;     // where each container starts in buf
+    const uint32_t *cards;
+    roaring_array_t *answer;
+    const int32_t *bounds;     // containers [bounds[i], bounds[i+1]) for task i
+    bool *failed;              // one flag per task
+} ra_parallel_read_t;
+
+static void ra_parallel_read_task(void *arg, size_t index) {
+    ra_parallel_read_t *job = (ra_parallel_read_t *)arg;
+    roaring_array_t *answer = job->answer;
+    for (int32_t k = job->bounds[index]; k < job->bounds[index + 1]; ++k) {
+        const char *p = job->buf + job->offsets[k];
+        container_t *c = NULL;
+        switch (answer->typecodes[k]) {
+            case BITSET_CONTAINER_TYPE: {
+                bitset_container_t *bc = bitset_container_create();
+                if (bc != NULL) bitset_container_read(job->cards[k], bc, p);
+                c = bc;
+                break;
+            }
+            case RUN_CONTAINER_TYPE: {
+                uint16_t n_runs;
+                memcpy(&n_runs, p, sizeof(uint16_t));
+                run_container_t *rc = run_container_create_given_capacity(n_runs);
+                if (rc != NULL) run_container_read(job->cards[k], rc, p);
+                c = rc;
+                break;
+            }
+            default: {
+                array_container_t *ac =
+                    array_container_create_given_capacity(job->cards[k]);
+                if (ac != NULL) array_container_read(job->cards[k], ac, p);
+                c = ac;
+                break;
+            }
+        }
+        answer->containers[k] = c;
+        if (c == NULL) job->failed[index] = true;
+    }
+}
+
+bool ra_portable_deserialize_parallel(roaring_array_t *answer, const char *buf,
+                                      const size_t maxbytes, size_t *readbytes,
+                                      size_t partitions,
+                                      roaring_executor executor,
+                                      void *executor_context) {
+    if (partitions < 2) {
+        return ra_portable_deserialize(answer, buf, maxbytes, readbytes);
+    }
+    // The header is checked as in ra_portable_deserialize. The container
+    // offsets stored in the buffer are not trusted: one pass over the
+    // headers computes (and bounds-checks) where each container starts.
+    ra_portable_header_t header;
+    if (!ra_portable_header_parse(buf, maxbytes, &header)) return false;
+    const int32_t size = header.size;
+    size_t pos = header.bytes;
+
+    if (!ra_init_with_capacity(answer, size)) return false;
+    size_t *offsets = (size_t *)roaring_malloc((size + 1) * sizeof(size_t));
+    uint32_t *cards = (uint32_t *)roaring_malloc((size + 1) * sizeof(uint32_t));
+    if (offsets == NULL || cards == NULL) {
+        roaring_free(offsets);
+        roaring_free(cards);
+        ra_clear(answer);
+        return false;
+    }
+    for (int32_t k = 0; k < size; ++k) {
+        answer->keys[k] = ra_portable_header_key(&header, k);
+        answer->typecodes[k] = ra_portable_header_typecode(&header, k);
+        cards[k] = ra_portable_header_card(&header, k);
+        offsets[k] = pos;
+        size_t containersize;
+        if (answer->typecodes[k] == RUN_CONTAINER_TYPE) {
+            uint16_t n_runs = 0;
+            if (pos + sizeof(uint16_t) <= maxbytes) {
+                memcpy(&n_runs, buf + pos, sizeof(uint16_t));
+            }
+            containersize = sizeof(uint16_t) + n_runs * sizeof(rle16_t);
+        } else if (answer->typecodes[k] == BITSET_CONTAINER_TYPE) {
+            containersize = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+        } else {
+            containersize = cards[k] * sizeof(uint16_t);
+        }
+        pos += containersize;
+        if (pos > maxbytes) {
+            roaring_free(offsets);
+            roaring_free(cards);
+            ra_clear(answer);  // no container allocated yet
+            return false;
+        }
+    }
+    offsets[size] = pos;
+    *readbytes = pos;
+
+    // Split the containers into ranges holding about the same number of
+    // bytes; each range is read by its own task into its own slots.
+    if ((size_t)size < partitions) partitions = size > 0 ? size : 1;
+    int32_t *bounds =
+        (int32_t *)roaring_malloc((partitions + 1) * sizeof(int32_t));
+    bool *failed = (bool *)roaring_calloc(partitions, sizeof(bool));
+    if (bounds == NULL || failed == NULL) {
+        roaring_free(bounds);
+        roaring_free(failed);
+        roaring_free(offsets);
+        roaring_free(cards);
+        ra_clear(answer);
+        return false;
+    }
+    size_t payload = pos - offsets[0];
+    int32_t k = 0;
+    bounds[0] = 0;
+    for (size_t i = 1; i < partitions; ++i) {
+        size_t target = offsets[0] + payload / partitions * i;
+        while (k < size && offsets[k] < target) k++;
+        bounds[i] = k;
+    }
+    bounds[partitions] = size;
+
+    ra_parallel_read_t job;
+    job.buf = buf;
+    job.offsets = offsets;
+    job.cards = cards;
+    job.answer = answer;
+    job.bounds = bounds;
+    job.failed = failed;
+    if (executor != NULL) {
+        executor(executor_context, ra_parallel_read_task, &job, partitions);
+    } else {
+        for (size_t i = 0; i < partitions; i++) {
+            ra_parallel_read_task(&job, i);
+        }
+    }
+
+    bool is_ok = true;
+    for (size_t i = 0; i < partitions; i++) {
+        if (failed[i]) is_ok = false;
+    }
+    if (is_ok) {
+        answer->size = size;
+    } else {
+        for (int32_t j = 0; j < size; ++j) {
+            if (answer->containers[j] != NULL) {
+                container_free(answer->containers[j], answer->typecodes[j]);
+            }
+        }
+        ra_clear(answer);
+    }
+    roaring_free(bounds);
+    roaring_free(failed);
+    roaring_free(offsets);
+    roaring_free(cards);
+    return is_ok;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace internal {
 #endif
@@ -0,0 +1,347 @@
+#include <stdint.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_bsi.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+struct roaring_bsi_s {
+    roaring_bitmap_t *rows;     // rows that have a value
+    roaring_bitmap_t **slices;  // slices[i]: rows whose value has bit i set
+    uint32_t depth;             // number of slices
+};
+
+static inline uint32_t bsi_bit_length(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+// Adds empty slices so that values of `depth` bits can be stored.
+static bool bsi_grow(roaring_bsi_t *bsi, uint32_t depth) {
+    if (depth <= bsi->depth) return true;
+    roaring_bitmap_t **slices = (roaring_bitmap_t **)roaring_realloc(
+        bsi->slices, depth * sizeof(roaring_bitmap_t *));
+    if (slices == NULL) return false;
+    bsi->slices = slices;
+    for (; bsi->depth < depth; bsi->depth++) {
+        slices[bsi->depth] = roaring_bitmap_create();
+        if (slices[bsi->depth] == NULL) return false;
+    }
+    return true;
+}
+
+// The rows of found_set that have a value, which is where all the queries
+// start from.
+static roaring_bitmap_t *bsi_candidates(const roaring_bsi_t *bsi,
+                                        const roaring_bitmap_t *found_set) {
+    if (found_set == NULL) return roaring_bitmap_copy(bsi->rows);
+    return roaring_bitmap_and(bsi->rows, found_set);
+}
+
+roaring_bsi_t *roaring_bsi_create(void) {
+    roaring_bsi_t *bsi = (roaring_bsi_t *)roaring_malloc(sizeof(roaring_bsi_t));
+    if (bsi == NULL) return NULL;
+    bsi->rows = roaring_bitmap_create();
+    if (bsi->rows == NULL) {
+        roaring_free(bsi);
+        return NULL;
+    }
+    bsi->slices = NULL;
+    bsi->depth = 0;
+    return bsi;
+}
+
+void roaring_bsi_free(roaring_bsi_t *bsi) {
+    if (bsi == NULL) return;
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        roaring_bitmap_free(bsi->slices[i]);
+    }
+    roaring_free(bsi->slices);
+    roaring_bitmap_free(bsi->rows);
+    roaring_free(bsi);
+}
+
+void roaring_bsi_set(roaring_bsi_t *bsi, uint32_t row, uint64_t value) {
+    if (!bsi_grow(bsi, bsi_bit_length(value))) return;
+    bool existed = !roaring_bitmap_add_checked(bsi->rows, row);
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        if ((value >> i) & 1) {
+            roaring_bitmap_add(bsi->slices[i], row);
+        } else if (existed) {
+            roaring_bitmap_remove(bsi->slices[i], row);
+        }
+    }
+}
+
+void roaring_bsi_set_many(roaring_bsi_t *bsi, size_t n, const uint32_t *rows,
+                          const uint64_t *values) {
+    if (n == 0) return;
+    uint64_t all_bits = 0;
+    for (size_t j = 0; j < n; j++) {
+        all_bits |= values[j];
+    }
+    if (!bsi_grow(bsi, bsi_bit_length(all_bits))) return;
+    roaring_bitmap_t *batch = roaring_bitmap_of_ptr(n, rows);
+    uint32_t *buf = (uint32_t *)roaring_malloc(n * sizeof(uint32_t));
+    if (batch == NULL || buf == NULL) {
+        if (batch != NULL) roaring_bitmap_free(batch);
+        roaring_free(buf);
+        return;
+    }
+    // clear the previous values of the rows
+    if (roaring_bitmap_intersect(bsi->rows, batch)) {
+        for (uint32_t i = 0; i < bsi->depth; i++) {
+            roaring_bitmap_andnot_inplace(bsi->slices[i], batch);
+        }
+    }
+    roaring_bitmap_or_inplace(bsi->rows, batch);
+    roaring_bitmap_free(batch);
+
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        if (((all_bits >> i) & 1) == 0) continue;
+        size_t m = 0;
+        for (size_t j = 0; j < n; j++) {
+            if ((values[j] >> i) & 1) buf[m++] = rows[j];
+        }
+        roaring_bitmap_add_many(bsi->slices[i], m, buf);
+    }
+    roaring_free(buf);
+}
+
+bool roaring_bsi_get(const roaring_bsi_t *bsi, uint32_t row, uint64_t *value) {
+    if (!roaring_bitmap_contains(bsi->rows, row)) return false;
+    uint64_t v = 0;
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        if (roaring_bitmap_contains(bsi->slices[i], row)) {
+            v |= UINT64_C(1) << i;
+        }
+    }
+    *value = v;
+    return true;
+}
+
+void roaring_bsi_remove(roaring_bsi_t *bsi, uint32_t row) {
+    if (!roaring_bitmap_remove_checked(bsi->rows, row)) return;
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        roaring_bitmap_remove(bsi->slices[i], row);
+    }
+}
+
+const roaring_bitmap_t *roaring_bsi_rows(const roaring_bsi_t *bsi) {
+    return bsi->rows;
+}
+
+uint32_t roaring_bsi_bit_depth(const roaring_bsi_t *bsi) {
+    return bsi->depth;
+}
+
+/*
+ * The comparisons follow O'Neil and Quass, "Improved Query Performance with
+ * Variant Indexes": going from the most significant slice down, `eq` keeps
+ * the rows whose value matches `value` on the bits seen so far, and the rows
+ * leaving `eq` on a bit where they differ are added to `lt` or `gt`.
+ */
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi,
+                                      roaring_bsi_op_t op, uint64_t value,
+                                      const roaring_bitmap_t *found_set) {
+    roaring_bitmap_t *eq = bsi_candidates(bsi, found_set);
+    if (eq == NULL) return NULL;
+    if (bsi_bit_length(value) > bsi->depth) {
+        // value is larger than any stored value
+        if (op != ROARING_BSI_LT && op != ROARING_BSI_LE &&
+            op != ROARING_BSI_NEQ) {
+            roaring_bitmap_clear(eq);
+        }
+        return eq;
+    }
+    bool need_lt = op == ROARING_BSI_LT || op == ROARING_BSI_LE ||
+                   op == ROARING_BSI_NEQ;
+    bool need_gt = op == ROARING_BSI_GT || op == ROARING_BSI_GE ||
+                   op == ROARING_BSI_NEQ;
+    roaring_bitmap_t *lt = roaring_bitmap_create();
+    roaring_bitmap_t *gt = roaring_bitmap_create();
+    if (lt == NULL || gt == NULL) {
+        roaring_bitmap_free(eq);
+        if (lt != NULL) roaring_bitmap_free(lt);
+        if (gt != NULL) roaring_bitmap_free(gt);
+        return NULL;
+    }
+    for (uint32_t i = bsi->depth; i > 0 && !roaring_bitmap_is_empty(eq); i--) {
+        const roaring_bitmap_t *slice = bsi->slices[i - 1];
+        if ((value >> (i - 1)) & 1) {
+            if (need_lt) {
+                roaring_bitmap_t *t = roaring_bitmap_andnot(eq, slice);
+                roaring_bitmap_or_inplace(lt, t);
+                roaring_bitmap_free(t);
+            }
+            roaring_bitmap_and_inplace(eq, slice);
+        } else {
+            if (need_gt) {
+                roaring_bitmap_t *t = roaring_bitmap_and(eq, slice);
+                roaring_bitmap_or_inplace(gt, t);
+                roaring_bitmap_free(t);
+            }
+            roaring_bitmap_andnot_inplace(eq, slice);
+        }
+    }
+
+    roaring_bitmap_t *answer;
+    switch (op) {
+        case ROARING_BSI_LT:
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_LE:
+            roaring_bitmap_or_inplace(lt, eq);
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_EQ:
+            answer = eq;
+            eq = NULL;
+            break;
+        case ROARING_BSI_NEQ:
+            roaring_bitmap_or_inplace(lt, gt);
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_GE:
+            roaring_bitmap_or_inplace(gt, eq);
+            answer = gt;
+            gt = NULL;
+            break;
+        default:
+            answer = gt;
+            gt = NULL;
+            break;
+    }
+    if (lt != NULL) roaring_bitmap_free(lt);
+    if (gt != NULL) roaring_bitmap_free(gt);
+    if (eq != NULL) roaring_bitmap_free(eq);
+    return answer;
+}
+
+roaring_bitmap_t *roaring_bsi_range(const roaring_bsi_t *bsi, uint64_t min,
+                                    uint64_t max,
+                                    const roaring_bitmap_t *found_set) {
+    if (min > max) return roaring_bitmap_create();
+    roaring_bitmap_t *ge = roaring_bsi_compare(bsi, ROARING_BSI_GE, min,
+                                               found_set);
+    if (ge == NULL) return NULL;
+    roaring_bitmap_t *answer = roaring_bsi_compare(bsi, ROARING_BSI_LE, max, ge);
+    roaring_bitmap_free(ge);
+    return answer;
+}
+
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *found_set, uint64_t *count) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < bsi->depth; i++) {
+        uint64_t card =
+            found_set == NULL
+                ? roaring_bitmap_get_cardinality(bsi->slices[i])
+                : roaring_bitmap_and_cardinality(bsi->slices[i], found_set);
+        sum += card << i;
+    }
+    if (count != NULL) {
+        *count = found_set == NULL
+                     ? roaring_bitmap_get_cardinality(bsi->rows)
+                     : roaring_bitmap_and_cardinality(bsi->rows, found_set);
+    }
+    return sum;
+}
+
+// Going from the most significant slice down, keeps the candidates having
+// the bit (for the maximum) or not having it (for the minimum), unless there
+// are none.
+static bool bsi_extremum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *found_set, bool maximum,
+                         uint64_t *value) {
+    roaring_bitmap_t *candidates = bsi_candidates(bsi, found_set);
+    if (candidates == NULL) return false;
+    if (roaring_bitmap_is_empty(candidates)) {
+        roaring_bitmap_free(candidates);
+        return false;
+    }
+    uint64_t v = 0;
+    for (uint32_t i = bsi->depth; i > 0; i--) {
+        const roaring_bitmap_t *slice = bsi->slices[i - 1];
+        if (maximum) {
+            if (roaring_bitmap_intersect(candidates, slice)) {
+                roaring_bitmap_and_inplace(candidates, slice);
+                v |= UINT64_C(1) << (i - 1);
+            }
+        } else {
+            if (roaring_bitmap_is_subset(candidates, slice)) {
+                v |= UINT64_C(1) << (i - 1);
+            } else {
+                roaring_bitmap_andnot_inplace(candidates, slice);
+            }
+        }
+    }
+    roaring_bitmap_free(candidates);
+    *value = v;
+    return true;
+}
+
+bool roaring_bsi_min(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *found_set, uint64_t *value) {
+    return bsi_extremum(bsi, found_set, false, value);
+}
+
+bool roaring_bsi_max(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *found_set, uint64_t *value) {
+    return bsi_extremum(bsi, found_set, true, value);
+}
+
+/*
+ * Going from the most significant slice down, `top` holds rows known to be
+ * among the k largest and `ties` the rows that may still be, all with the
+ * same bits so far. |top| + |ties| > k holds throughout.
+ */
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi, uint64_t k,
+                                    const roaring_bitmap_t *found_set) {
+    roaring_bitmap_t *ties = bsi_candidates(bsi, found_set);
+    if (ties == NULL) return NULL;
+    if (roaring_bitmap_get_cardinality(ties) <= k) return ties;
+    roaring_bitmap_t *top = roaring_bitmap_create();
+    if (top == NULL) {
+        roaring_bitmap_free(ties);
+        return NULL;
+    }
+    uint64_t top_card = 0;
+    for (uint32_t i = bsi->depth; i > 0; i--) {
+        const roaring_bitmap_t *slice = bsi->slices[i - 1];
+        uint64_t n = top_card + roaring_bitmap_and_cardinality(ties, slice);
+        if (n > k) {
+            roaring_bitmap_and_inplace(ties, slice);
+        } else if (n < k) {
+            roaring_bitmap_t *t = roaring_bitmap_and(ties, slice);
+            roaring_bitmap_or_inplace(top, t);
+            roaring_bitmap_free(t);
+            top_card = n;
+            roaring_bitmap_andnot_inplace(ties, slice);
+        } else {
+            roaring_bitmap_and_inplace(ties, slice);
+            roaring_bitmap_or_inplace(top, ties);
+            roaring_bitmap_free(ties);
+            return top;
+        }
+    }
+    // the remaining ties all have the same value: keep the smallest rows
+    uint64_t missing = k - top_card;
+    if (missing > 0) {
+        uint32_t last;
+        roaring_bitmap_select(ties, (uint32_t)(missing - 1), &last);
+        roaring_bitmap_remove_range(ties, (uint64_t)last + 1,
+                                    UINT64_C(1) << 32);
+        roaring_bitmap_or_inplace(top, ties);
+    }
+    roaring_bitmap_free(ties);
+    return top;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
@@ -0,0 +1,209 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+
+#include <roaring/containers/containers.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+// What the decoder is waiting for. Each step reads a known number of bytes
+// into a known place before moving on.
+typedef enum decoder_step_e {
+    DECODER_HEADER,  // grows until ra_portable_header_parse succeeds
+    DECODER_RUN_HEADER,
+    DECODER_CONTAINER,
+    DECODER_DONE,
+    DECODER_ERROR
+} decoder_step_t;
+
+struct roaring_portable_decoder_s {
+    decoder_step_t step;
+    char *dst;    // where the bytes of the step go
+    size_t need;  // bytes in the step
+    size_t have;  // bytes of the step read so far
+    uint32_t word;  // cookie and run header
+    char *head;     // the header bytes once past the cookie
+    ra_portable_header_t header;
+    int32_t k;  // container being read
+    roaring_bitmap_t *bitmap;
+    container_t *container;  // container k, not yet in the bitmap
+    uint8_t typecode;
+};
+
+static void decoder_expect(roaring_portable_decoder_t *d, decoder_step_t step,
+                           void *dst, size_t need) {
+    d->step = step;
+    d->dst = (char *)dst;
+    d->need = need;
+    d->have = 0;
+}
+
+static void decoder_clear(roaring_portable_decoder_t *d) {
+    roaring_free(d->head);
+    if (d->container != NULL) {
+        container_free(d->container, d->typecode);
+    }
+    if (d->bitmap != NULL) {
+        roaring_bitmap_free(d->bitmap);
+    }
+    d->head = NULL;
+    d->container = NULL;
+    d->bitmap = NULL;
+    decoder_expect(d, DECODER_HEADER, &d->word, sizeof(d->word));
+}
+
+static bool decoder_fail(roaring_portable_decoder_t *d) {
+    decoder_clear(d);
+    d->step = DECODER_ERROR;
+    return false;
+}
+
+// Allocates the next container and sets up the read of its payload, or ends
+// the decoding after the last one.
+static bool decoder_next_container(roaring_portable_decoder_t *d) {
+    if (d->k == d->header.size) {
+        decoder_expect(d, DECODER_DONE, NULL, 0);
+        return true;
+    }
+    uint32_t card = ra_portable_header_card(&d->header, d->k);
+    switch (ra_portable_header_typecode(&d->header, d->k)) {
+        case RUN_CONTAINER_TYPE:
+            decoder_expect(d, DECODER_RUN_HEADER, &d->word, sizeof(uint16_t));
+            break;
+        case BITSET_CONTAINER_TYPE: {
+            bitset_container_t *c = bitset_container_create();
+            if (c == NULL) return decoder_fail(d);
+            c->cardinality = card;
+            d->container = c;
+            d->typecode = BITSET_CONTAINER_TYPE;
+            decoder_expect(d, DECODER_CONTAINER, c->words,
+                           BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+            break;
+        }
+        default: {
+            array_container_t *c = array_container_create_given_capacity(card);
+            if (c == NULL) return decoder_fail(d);
+            c->cardinality = card;
+            d->container = c;
+            d->typecode = ARRAY_CONTAINER_TYPE;
+            decoder_expect(d, DECODER_CONTAINER, c->array,
+                           card * sizeof(uint16_t));
+            break;
+        }
+    }
+    return true;
+}
+
+// Called once the bytes of the current step are all in: validates them and
+// sets up the next step. Follows ra_portable_deserialize.
+static bool decoder_advance(roaring_portable_decoder_t *d) {
+    switch (d->step) {
+        case DECODER_HEADER: {
+            const char *head = d->head != NULL ? d->head : (char *)&d->word;
+            if (ra_portable_header_parse(head, d->have, &d->header)) {
+                d->bitmap = roaring_bitmap_create_with_capacity(d->header.size);
+                if (d->bitmap == NULL) return decoder_fail(d);
+                d->k = 0;
+                return decoder_next_container(d);
+            }
+            if (d->header.bytes == 0) return decoder_fail(d);
+            // the header goes on: read up to the length it announces
+            char *grown = (char *)roaring_realloc(d->head, d->header.bytes);
+            if (grown == NULL) return decoder_fail(d);
+            if (d->head == NULL) memcpy(grown, &d->word, sizeof(d->word));
+            d->head = grown;
+            d->dst = grown;
+            d->need = d->header.bytes;
+            return true;
+        }
+        case DECODER_RUN_HEADER: {
+            uint16_t n_runs;
+            memcpy(&n_runs, &d->word, sizeof(n_runs));
+            run_container_t *c = run_container_create_given_capacity(n_runs);
+            if (c == NULL) return decoder_fail(d);
+            c->n_runs = n_runs;
+            d->container = c;
+            d->typecode = RUN_CONTAINER_TYPE;
+            decoder_expect(d, DECODER_CONTAINER, c->runs,
+                           n_runs * sizeof(rle16_t));
+            return true;
+        }
+        case DECODER_CONTAINER:
+            ra_append(&d->bitmap->high_low_container,
+                      ra_portable_header_key(&d->header, d->k), d->container,
+                      d->typecode);
+            d->container = NULL;
+            d->k++;
+            return decoder_next_container(d);
+        default:
+            return false;
+    }
+}
+
+roaring_portable_decoder_t *roaring_portable_decoder_create(void) {
+    roaring_portable_decoder_t *d = (roaring_portable_decoder_t *)
+        roaring_malloc(sizeof(roaring_portable_decoder_t));
+    if (d == NULL) return NULL;
+    d->head = NULL;
+    d->container = NULL;
+    d->bitmap = NULL;
+    decoder_clear(d);
+    return d;
+}
+
+void roaring_portable_decoder_free(roaring_portable_decoder_t *d) {
+    if (d == NULL) return;
+    decoder_clear(d);
+    roaring_free(d);
+}
+
+roaring_decoder_status_t roaring_portable_decoder_feed(
+    roaring_portable_decoder_t *d, const char *buf, size_t len,
+    size_t *consumed) {
+    size_t used = 0;
+    while (d->step != DECODER_DONE && d->step != DECODER_ERROR) {
+        if (d->have == d->need) {
+            decoder_advance(d);
+            continue;
+        }
+        if (used == len) break;
+        size_t n = d->need - d->have;
+        if (n > len - used) n = len - used;
+        if (d->dst != NULL) {
+            memcpy(d->dst + d->have, buf + used, n);
+        }
+        d->have += n;
+        used += n;
+    }
+    if (consumed != NULL) *consumed = used;
+    switch (d->step) {
+        case DECODER_DONE:
+            return ROARING_DECODER_DONE;
+        case DECODER_ERROR:
+            return ROARING_DECODER_ERROR;
+        default:
+            return ROARING_DECODER_NEED_MORE;
+    }
+}
+
+roaring_bitmap_t *roaring_portable_decoder_finish(
+    roaring_portable_decoder_t *d) {
+    if (d->step != DECODER_DONE) {
+        return NULL;
+    }
+    roaring_bitmap_t *r = d->bitmap;
+    d->bitmap = NULL;
+    decoder_clear(d);
+    return r;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
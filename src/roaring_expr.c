@@ -0,0 +1,308 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+
+#include <roaring/containers/containers.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+// Returned by expr_next_key() when there are no more keys.
+#define EXPR_NO_KEY 0x10000
+
+// Number of bitset containers kept around for reuse during an evaluation.
+#define EXPR_POOL_CAPACITY 8
+
+// The expression tree flattened into an array, with the evaluation state of
+// each node. Node 0 is the root.
+typedef struct expr_node_s {
+    roaring_expr_op_t op;
+    const roaring_array_t *ra;  // leaves only
+    int32_t left, right;        // operators only
+    int32_t next_pos;           // leaves: cursor of expr_next_key()
+    int32_t get_pos;            // leaves: cursor of expr_container()
+} expr_node_t;
+
+typedef struct expr_eval_s {
+    expr_node_t *nodes;
+    bitset_container_t *pool[EXPR_POOL_CAPACITY];
+    int32_t pool_size;
+} expr_eval_t;
+
+// Returns the number of nodes of the tree, or 0 if it is malformed.
+static int32_t expr_count_nodes(const roaring_expr_t *expr) {
+    if (expr == NULL) return 0;
+    switch (expr->op) {
+        case ROARING_EXPR_BITMAP:
+            return expr->bitmap != NULL ? 1 : 0;
+        case ROARING_EXPR_AND:
+        case ROARING_EXPR_OR:
+        case ROARING_EXPR_XOR:
+        case ROARING_EXPR_ANDNOT: {
+            int32_t left = expr_count_nodes(expr->left);
+            if (left == 0) return 0;
+            int32_t right = expr_count_nodes(expr->right);
+            if (right == 0) return 0;
+            return left + right + 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+static int32_t expr_flatten(const roaring_expr_t *expr, expr_node_t *nodes,
+                            int32_t *count) {
+    int32_t i = (*count)++;
+    expr_node_t *n = &nodes[i];
+    n->op = expr->op;
+    n->next_pos = 0;
+    n->get_pos = 0;
+    if (expr->op == ROARING_EXPR_BITMAP) {
+        n->ra = &expr->bitmap->high_low_container;
+        n->left = n->right = -1;
+    } else {
+        n->ra = NULL;
+        n->left = expr_flatten(expr->left, nodes, count);
+        n->right = expr_flatten(expr->right, nodes, count);
+    }
+    return i;
+}
+
+// Returns the smallest key >= min at which node i may be non-empty, or
+// EXPR_NO_KEY. This over-approximates (an XOR may cancel out), but never
+// skips a key where the node is non-empty. Successive calls on a node must
+// have non-decreasing values of min.
+static uint32_t expr_next_key(expr_eval_t *e, int32_t i, uint32_t min) {
+    expr_node_t *n = &e->nodes[i];
+    if (min >= EXPR_NO_KEY) return EXPR_NO_KEY;
+    switch (n->op) {
+        case ROARING_EXPR_BITMAP: {
+            const roaring_array_t *ra = n->ra;
+            int32_t pos = n->next_pos;
+            if (pos < ra->size && ra->keys[pos] < min) {
+                pos = ra_advance_until(ra, (uint16_t)min, pos);
+                n->next_pos = pos;
+            }
+            return pos < ra->size ? ra->keys[pos] : EXPR_NO_KEY;
+        }
+        case ROARING_EXPR_AND:
+            while (true) {
+                uint32_t key = expr_next_key(e, n->left, min);
+                if (key == EXPR_NO_KEY) return EXPR_NO_KEY;
+                min = expr_next_key(e, n->right, key);
+                if (min == key || min == EXPR_NO_KEY) return min;
+            }
+        case ROARING_EXPR_ANDNOT:
+            return expr_next_key(e, n->left, min);
+        default: {  // OR, XOR
+            uint32_t left = expr_next_key(e, n->left, min);
+            uint32_t right = expr_next_key(e, n->right, min);
+            return left < right ? left : right;
+        }
+    }
+}
+
+static bitset_container_t *expr_bitset(expr_eval_t *e) {
+    if (e->pool_size > 0) return e->pool[--e->pool_size];
+    return bitset_container_create();
+}
+
+// Frees an intermediate container, keeping bitsets for later use.
+static void expr_release(expr_eval_t *e, container_t *c, uint8_t type) {
+    if (type == BITSET_CONTAINER_TYPE && e->pool_size < EXPR_POOL_CAPACITY) {
+        e->pool[e->pool_size++] = CAST_bitset(c);
+    } else {
+        container_free(c, type);
+    }
+}
+
+// Computes two borrowed bitsets into a pooled bitset, rather than having
+// container_and() and friends allocate a new one.
+static container_t *expr_apply_bitsets(expr_eval_t *e, roaring_expr_op_t op,
+                                       const bitset_container_t *b1,
+                                       const bitset_container_t *b2,
+                                       uint8_t *type) {
+    bitset_container_t *dst = expr_bitset(e);
+    if (dst == NULL) return NULL;
+    int card;
+    switch (op) {
+        case ROARING_EXPR_AND:
+            card = bitset_container_and(b1, b2, dst);
+            break;
+        case ROARING_EXPR_OR:
+            card = bitset_container_or(b1, b2, dst);
+            break;
+        case ROARING_EXPR_XOR:
+            card = bitset_container_xor(b1, b2, dst);
+            break;
+        default:
+            card = bitset_container_andnot(b1, b2, dst);
+            break;
+    }
+    if (card > DEFAULT_MAX_SIZE) {
+        *type = BITSET_CONTAINER_TYPE;
+        return dst;
+    }
+    container_t *c = NULL;
+    if (card > 0) {
+        c = array_container_from_bitset(dst);
+        *type = ARRAY_CONTAINER_TYPE;
+    }
+    expr_release(e, dst, BITSET_CONTAINER_TYPE);
+    return c;
+}
+
+// Applies op to two non-empty containers and returns the result, which the
+// caller owns, or NULL if it is empty. Owned inputs are consumed, and are
+// computed into in place when possible.
+static container_t *expr_apply(expr_eval_t *e, roaring_expr_op_t op,
+                               container_t *c1, uint8_t t1, bool owned1,
+                               container_t *c2, uint8_t t2, bool owned2,
+                               uint8_t *type) {
+    if (!owned1 && owned2 && op != ROARING_EXPR_ANDNOT) {
+        container_t *tmp = c1;
+        c1 = c2;
+        c2 = tmp;
+        uint8_t t = t1;
+        t1 = t2;
+        t2 = t;
+        owned1 = true;
+        owned2 = false;
+    }
+    container_t *c;
+    if (owned1) {
+        switch (op) {
+            case ROARING_EXPR_AND:
+                c = container_iand(c1, t1, c2, t2, type);
+                if (c != c1) expr_release(e, c1, t1);
+                break;
+            case ROARING_EXPR_OR:
+                c = container_ior(c1, t1, c2, t2, type);
+                if (c != c1) expr_release(e, c1, t1);
+                break;
+            case ROARING_EXPR_XOR:
+                c = container_ixor(c1, t1, c2, t2, type);
+                break;
+            default:
+                c = container_iandnot(c1, t1, c2, t2, type);
+                break;
+        }
+    } else {
+        const container_t *u1 = container_unwrap_shared(c1, &t1);
+        const container_t *u2 = container_unwrap_shared(c2, &t2);
+        if (t1 == BITSET_CONTAINER_TYPE && t2 == BITSET_CONTAINER_TYPE) {
+            c = expr_apply_bitsets(e, op, const_CAST_bitset(u1),
+                                   const_CAST_bitset(u2), type);
+            if (owned2) expr_release(e, c2, t2);
+            return c;
+        }
+        switch (op) {
+            case ROARING_EXPR_AND:
+                c = container_and(u1, t1, u2, t2, type);
+                break;
+            case ROARING_EXPR_OR:
+                c = container_or(u1, t1, u2, t2, type);
+                break;
+            case ROARING_EXPR_XOR:
+                c = container_xor(u1, t1, u2, t2, type);
+                break;
+            default:
+                c = container_andnot(u1, t1, u2, t2, type);
+                break;
+        }
+    }
+    if (owned2) expr_release(e, c2, t2);
+    if (c != NULL && !container_nonzero_cardinality(c, *type)) {
+        expr_release(e, c, *type);
+        c = NULL;
+    }
+    return c;
+}
+
+// Returns the container of node i for key, or NULL if it is empty. If *owned
+// is set, the container is an intermediate result that the caller must consume,
+// otherwise it belongs to one of the input bitmaps. Keys must be increasing
+// from one call on the root to the next.
+static container_t *expr_container(expr_eval_t *e, int32_t i, uint16_t key,
+                                   uint8_t *type, bool *owned) {
+    expr_node_t *n = &e->nodes[i];
+    if (n->op == ROARING_EXPR_BITMAP) {
+        const roaring_array_t *ra = n->ra;
+        int32_t pos = n->get_pos;
+        if (pos < ra->size && ra->keys[pos] < key) {
+            pos = ra_advance_until(ra, key, pos);
+            n->get_pos = pos;
+        }
+        if (pos == ra->size || ra->keys[pos] != key) return NULL;
+        *type = ra->typecodes[pos];
+        *owned = false;
+        return ra->containers[pos];
+    }
+    uint8_t t1, t2;
+    bool owned1, owned2;
+    container_t *c1 = expr_container(e, n->left, key, &t1, &owned1);
+    if (c1 == NULL) {
+        if (n->op == ROARING_EXPR_AND || n->op == ROARING_EXPR_ANDNOT) {
+            return NULL;
+        }
+        return expr_container(e, n->right, key, type, owned);
+    }
+    container_t *c2 = expr_container(e, n->right, key, &t2, &owned2);
+    if (c2 == NULL) {
+        if (n->op == ROARING_EXPR_AND) {
+            if (owned1) expr_release(e, c1, t1);
+            return NULL;
+        }
+        *type = t1;
+        *owned = owned1;
+        return c1;
+    }
+    *owned = true;
+    return expr_apply(e, n->op, c1, t1, owned1, c2, t2, owned2, type);
+}
+
+roaring_bitmap_t *roaring_expr_evaluate(const roaring_expr_t *expr) {
+    int32_t count = expr_count_nodes(expr);
+    if (count == 0) return NULL;
+    expr_eval_t e;
+    e.nodes = (expr_node_t *)roaring_malloc(count * sizeof(expr_node_t));
+    if (e.nodes == NULL) return NULL;
+    e.pool_size = 0;
+    count = 0;
+    expr_flatten(expr, e.nodes, &count);
+
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (answer != NULL) {
+        uint32_t key = expr_next_key(&e, 0, 0);
+        while (key != EXPR_NO_KEY) {
+            uint8_t type;
+            bool owned;
+            container_t *c =
+                expr_container(&e, 0, (uint16_t)key, &type, &owned);
+            if (c != NULL) {
+                if (!owned) {
+                    const container_t *u = container_unwrap_shared(c, &type);
+                    c = container_clone(u, type);
+                }
+                ra_append(&answer->high_low_container, (uint16_t)key, c,
+                          type);
+            }
+            key = expr_next_key(&e, 0, key + 1);
+        }
+    }
+
+    for (int32_t i = 0; i < e.pool_size; i++) {
+        bitset_container_free(e.pool[i]);
+    }
+    roaring_free(e.nodes);
+    return answer;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
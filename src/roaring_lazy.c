@@ -0,0 +1,308 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <roaring/roaring.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+typedef enum lazy_kind_e {
+    LAZY_BITMAP,
+    LAZY_OR,
+    LAZY_AND
+} lazy_kind_t;
+
+struct roaring_lazy_iterator_s {
+    lazy_kind_t kind;
+    bool has_value;
+    uint32_t current_value;
+    roaring_uint32_iterator_t it;  // LAZY_BITMAP only
+    // LAZY_OR keeps its children that still have values as a min-heap on
+    // their current values, in children[0, heap_size).
+    roaring_lazy_iterator_t **children;
+    size_t number;
+    size_t heap_size;
+};
+
+static bool lazy_advance(roaring_lazy_iterator_t *it);
+static bool lazy_move(roaring_lazy_iterator_t *it, uint32_t val);
+
+static void lazy_sift_down(roaring_lazy_iterator_t **heap, size_t size,
+                           size_t i) {
+    roaring_lazy_iterator_t *top = heap[i];
+    while (2 * i + 1 < size) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < size && heap[child + 1]->current_value <
+                                    heap[child]->current_value) {
+            child++;
+        }
+        if (heap[child]->current_value >= top->current_value) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = top;
+}
+
+// Restores the heap after its top moved forward, dropping it if it is done.
+static void lazy_or_fix_top(roaring_lazy_iterator_t *it) {
+    if (!it->children[0]->has_value) {
+        it->heap_size--;
+        roaring_lazy_iterator_t *tmp = it->children[0];
+        it->children[0] = it->children[it->heap_size];
+        it->children[it->heap_size] = tmp;  // kept for freeing
+        if (it->heap_size == 0) return;
+    }
+    lazy_sift_down(it->children, it->heap_size, 0);
+}
+
+static void lazy_or_sync(roaring_lazy_iterator_t *it) {
+    it->has_value = it->heap_size > 0;
+    if (it->has_value) it->current_value = it->children[0]->current_value;
+}
+
+// Leapfrogs the children to their first common value, starting from the
+// current value of the first child.
+static void lazy_and_settle(roaring_lazy_iterator_t *it) {
+    roaring_lazy_iterator_t **children = it->children;
+    if (it->number == 0 || !children[0]->has_value) {
+        it->has_value = false;
+        return;
+    }
+    uint32_t target = children[0]->current_value;
+    size_t agree = 1;  // consecutive children positioned at target
+    for (size_t i = 1; agree < it->number; i = (i + 1) % it->number) {
+        if (!lazy_move(children[i], target)) {
+            it->has_value = false;
+            return;
+        }
+        if (children[i]->current_value == target) {
+            agree++;
+        } else {
+            target = children[i]->current_value;
+            agree = 1;
+        }
+    }
+    it->has_value = true;
+    it->current_value = target;
+}
+
+static bool lazy_advance(roaring_lazy_iterator_t *it) {
+    if (!it->has_value) return false;
+    switch (it->kind) {
+        case LAZY_BITMAP:
+            roaring_advance_uint32_iterator(&it->it);
+            it->has_value = it->it.has_value;
+            it->current_value = it->it.current_value;
+            break;
+        case LAZY_OR: {
+            // every child at the current value moves on
+            uint32_t v = it->current_value;
+            while (it->heap_size > 0 && it->children[0]->current_value == v) {
+                lazy_advance(it->children[0]);
+                lazy_or_fix_top(it);
+            }
+            lazy_or_sync(it);
+            break;
+        }
+        case LAZY_AND:
+            lazy_advance(it->children[0]);
+            lazy_and_settle(it);
+            break;
+    }
+    return it->has_value;
+}
+
+static bool lazy_move(roaring_lazy_iterator_t *it, uint32_t val) {
+    if (!it->has_value || it->current_value >= val) return it->has_value;
+    switch (it->kind) {
+        case LAZY_BITMAP:
+            roaring_move_uint32_iterator_equalorlarger(&it->it, val);
+            it->has_value = it->it.has_value;
+            it->current_value = it->it.current_value;
+            break;
+        case LAZY_OR:
+            while (it->heap_size > 0 && it->children[0]->current_value < val) {
+                lazy_move(it->children[0], val);
+                lazy_or_fix_top(it);
+            }
+            lazy_or_sync(it);
+            break;
+        case LAZY_AND:
+            lazy_move(it->children[0], val);
+            lazy_and_settle(it);
+            break;
+    }
+    return it->has_value;
+}
+
+static roaring_lazy_iterator_t *lazy_alloc(lazy_kind_t kind, size_t number) {
+    roaring_lazy_iterator_t *it = (roaring_lazy_iterator_t *)roaring_malloc(
+        sizeof(roaring_lazy_iterator_t));
+    if (it == NULL) return NULL;
+    it->kind = kind;
+    it->has_value = false;
+    it->current_value = 0;
+    it->number = number;
+    it->heap_size = 0;
+    it->children = NULL;
+    if (number > 0) {
+        it->children = (roaring_lazy_iterator_t **)roaring_malloc(
+            number * sizeof(roaring_lazy_iterator_t *));
+        if (it->children == NULL) {
+            roaring_free(it);
+            return NULL;
+        }
+    }
+    return it;
+}
+
+// Takes ownership of the inputs, which are freed if the allocation fails.
+static roaring_lazy_iterator_t *lazy_combine(lazy_kind_t kind, size_t number,
+                                             roaring_lazy_iterator_t **inputs) {
+    roaring_lazy_iterator_t *it = lazy_alloc(kind, number);
+    if (it == NULL) {
+        for (size_t i = 0; i < number; i++) {
+            roaring_lazy_iterator_free(inputs[i]);
+        }
+        return NULL;
+    }
+    for (size_t i = 0; i < number; i++) {
+        it->children[i] = inputs[i];
+    }
+    if (kind == LAZY_OR) {
+        // the children without values go to the end, then heapify
+        size_t size = 0;
+        for (size_t i = 0; i < number; i++) {
+            if (it->children[i]->has_value) {
+                roaring_lazy_iterator_t *tmp = it->children[size];
+                it->children[size++] = it->children[i];
+                it->children[i] = tmp;
+            }
+        }
+        it->heap_size = size;
+        for (size_t i = size / 2; i > 0; i--) {
+            lazy_sift_down(it->children, size, i - 1);
+        }
+        lazy_or_sync(it);
+    } else {
+        lazy_and_settle(it);
+    }
+    return it;
+}
+
+roaring_lazy_iterator_t *roaring_lazy_iterator_create(
+    const roaring_bitmap_t *r) {
+    roaring_lazy_iterator_t *it = lazy_alloc(LAZY_BITMAP, 0);
+    if (it == NULL) return NULL;
+    roaring_init_iterator(r, &it->it);
+    it->has_value = it->it.has_value;
+    it->current_value = it->it.current_value;
+    return it;
+}
+
+roaring_lazy_iterator_t *roaring_lazy_iterator_or(
+    size_t number, roaring_lazy_iterator_t **inputs) {
+    return lazy_combine(LAZY_OR, number, inputs);
+}
+
+roaring_lazy_iterator_t *roaring_lazy_iterator_and(
+    size_t number, roaring_lazy_iterator_t **inputs) {
+    return lazy_combine(LAZY_AND, number, inputs);
+}
+
+static roaring_lazy_iterator_t *lazy_many(lazy_kind_t kind, size_t number,
+                                          const roaring_bitmap_t **rs) {
+    roaring_lazy_iterator_t **inputs = (roaring_lazy_iterator_t **)
+        roaring_malloc((number + 1) * sizeof(roaring_lazy_iterator_t *));
+    if (inputs == NULL) return NULL;
+    for (size_t i = 0; i < number; i++) {
+        inputs[i] = roaring_lazy_iterator_create(rs[i]);
+        if (inputs[i] == NULL) {
+            while (i > 0) roaring_lazy_iterator_free(inputs[--i]);
+            roaring_free(inputs);
+            return NULL;
+        }
+    }
+    if (kind == LAZY_AND && number > 1) {
+        // the sparsest bitmap leads the leapfrog
+        size_t smallest = 0;
+        uint64_t smallest_card = roaring_bitmap_get_cardinality(rs[0]);
+        for (size_t i = 1; i < number; i++) {
+            uint64_t card = roaring_bitmap_get_cardinality(rs[i]);
+            if (card < smallest_card) {
+                smallest = i;
+                smallest_card = card;
+            }
+        }
+        roaring_lazy_iterator_t *tmp = inputs[0];
+        inputs[0] = inputs[smallest];
+        inputs[smallest] = tmp;
+    }
+    roaring_lazy_iterator_t *it = lazy_combine(kind, number, inputs);
+    roaring_free(inputs);
+    return it;
+}
+
+roaring_lazy_iterator_t *roaring_lazy_iterator_or_many(
+    size_t number, const roaring_bitmap_t **rs) {
+    return lazy_many(LAZY_OR, number, rs);
+}
+
+roaring_lazy_iterator_t *roaring_lazy_iterator_and_many(
+    size_t number, const roaring_bitmap_t **rs) {
+    return lazy_many(LAZY_AND, number, rs);
+}
+
+void roaring_lazy_iterator_free(roaring_lazy_iterator_t *it) {
+    if (it == NULL) return;
+    for (size_t i = 0; i < it->number; i++) {
+        roaring_lazy_iterator_free(it->children[i]);
+    }
+    roaring_free(it->children);
+    roaring_free(it);
+}
+
+bool roaring_lazy_iterator_has_value(const roaring_lazy_iterator_t *it) {
+    return it->has_value;
+}
+
+uint32_t roaring_lazy_iterator_value(const roaring_lazy_iterator_t *it) {
+    return it->current_value;
+}
+
+bool roaring_lazy_iterator_advance(roaring_lazy_iterator_t *it) {
+    return lazy_advance(it);
+}
+
+bool roaring_lazy_iterator_move_equalorlarger(roaring_lazy_iterator_t *it,
+                                              uint32_t val) {
+    return lazy_move(it, val);
+}
+
+uint32_t roaring_lazy_iterator_read(roaring_lazy_iterator_t *it,
+                                    uint32_t *buf, uint32_t count) {
+    uint32_t n = 0;
+    while (n < count && it->has_value) {
+        if (it->kind == LAZY_BITMAP) {
+            // batch read straight from the bitmap
+            n += roaring_read_uint32_iterator(&it->it, buf + n, count - n);
+            it->has_value = it->it.has_value;
+            it->current_value = it->it.current_value;
+        } else if (it->kind == LAZY_OR && it->heap_size == 1) {
+            // only one input left, no merging needed
+            n += roaring_lazy_iterator_read(it->children[0], buf + n,
+                                            count - n);
+            lazy_or_fix_top(it);
+            lazy_or_sync(it);
+        } else {
+            buf[n++] = it->current_value;
+            lazy_advance(it);
+        }
+    }
+    return n;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <roaring/array_util.h>
 #include <roaring/containers/array.h>
 #include <roaring/misc/configreport.h>
 
@@ -192,12 +193,76 @@ DEFINE_TEST(capacity_test) {
     array_container_free(array);
 }
 
+// The container operations dispatch to SIMD kernels when the processor
+// supports them; check them against the generic scalar functions.
+DEFINE_TEST(vectorized_ops_test) {
+    uint32_t seed = 42;
+    const int sizes[] = {0, 1, 7, 8, 31, 32, 33, 64, 100, 1000, 1024, 4000};
+    const int nsizes = (int)(sizeof(sizes) / sizeof(sizes[0]));
+    uint16_t* expected = (uint16_t*)malloc(2 * 65536 * sizeof(uint16_t));
+    for (int i = 0; i < nsizes; i++) {
+        for (int j = 0; j < nsizes; j++) {
+            for (int range = 1 << 10; range <= (1 << 16); range <<= 3) {
+                array_container_t* A = array_container_create();
+                array_container_t* B = array_container_create();
+                array_container_t* out = array_container_create();
+                while (A->cardinality < sizes[i] && A->cardinality < range) {
+                    seed = seed * 1103515245 + 12345;
+                    array_container_add(A, (uint16_t)((seed >> 8) % range));
+                }
+                while (B->cardinality < sizes[j] && B->cardinality < range) {
+                    seed = seed * 1103515245 + 12345;
+                    array_container_add(B, (uint16_t)((seed >> 8) % range));
+                }
+                int32_t card;
+
+                card = intersect_uint16(A->array, A->cardinality, B->array,
+                                        B->cardinality, expected);
+                array_container_intersection(A, B, out);
+                assert_int_equal(out->cardinality, card);
+                for (int k = 0; k < card; k++)
+                    assert_int_equal(out->array[k], expected[k]);
+                assert_int_equal(array_container_intersection_cardinality(A, B),
+                                 card);
+
+                card = (int32_t)union_uint16(A->array, A->cardinality,
+                                             B->array, B->cardinality,
+                                             expected);
+                array_container_union(A, B, out);
+                assert_int_equal(out->cardinality, card);
+                for (int k = 0; k < card; k++)
+                    assert_int_equal(out->array[k], expected[k]);
+
+                card = xor_uint16(A->array, A->cardinality, B->array,
+                                  B->cardinality, expected);
+                array_container_xor(A, B, out);
+                assert_int_equal(out->cardinality, card);
+                for (int k = 0; k < card; k++)
+                    assert_int_equal(out->array[k], expected[k]);
+
+                card = difference_uint16(A->array, A->cardinality, B->array,
+                                         B->cardinality, expected);
+                array_container_andnot(A, B, out);
+                assert_int_equal(out->cardinality, card);
+                for (int k = 0; k < card; k++)
+                    assert_int_equal(out->array[k], expected[k]);
+
+                array_container_free(A);
+                array_container_free(B);
+                array_container_free(out);
+            }
+        }
+    }
+    free(expected);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(printf_test), cmocka_unit_test(add_contains_test),
         cmocka_unit_test(and_or_test), cmocka_unit_test(to_uint32_array_test),
         cmocka_unit_test(select_test),
-        cmocka_unit_test(capacity_test)
+        cmocka_unit_test(capacity_test),
+        cmocka_unit_test(vectorized_ops_test)
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
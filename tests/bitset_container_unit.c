@@ -166,6 +166,48 @@ DEFINE_TEST(xor_test) {
     bitset_container_free(TMP);
 }
 
+DEFINE_TEST(runs_test) {
+    bitset_container_t* B1 = bitset_container_create();
+    bitset_container_t* B2 = bitset_container_create();
+    bitset_container_t* TMP = bitset_container_create();
+    bitset_container_t* EXPECTED = bitset_container_create();
+
+    assert_non_null(B1);
+    assert_non_null(B2);
+    assert_non_null(TMP);
+    assert_non_null(EXPECTED);
+
+    // runs of varying lengths, some across words, and the last bit
+    for (size_t x = 0; x < (1 << 16) - 70; x += 100) {
+        bitset_container_set_range(B1, x, x + (x % 70) + 1);
+    }
+    for (size_t x = 30; x < (1 << 16) - 50; x += 77) {
+        bitset_container_set_range(B2, x, x + (x % 50) + 1);
+    }
+    bitset_container_set(B2, (1 << 16) - 1);
+
+    int32_t n_runs;
+    int card = bitset_container_or_runs(B1, B2, TMP, &n_runs);
+    assert_int_equal(card, bitset_container_or(B1, B2, EXPECTED));
+    assert_true(bitset_container_equals(TMP, EXPECTED));
+    assert_int_equal(n_runs, bitset_container_number_of_runs(EXPECTED));
+
+    card = bitset_container_and_runs(B1, B2, TMP, &n_runs);
+    assert_int_equal(card, bitset_container_and(B1, B2, EXPECTED));
+    assert_true(bitset_container_equals(TMP, EXPECTED));
+    assert_int_equal(n_runs, bitset_container_number_of_runs(EXPECTED));
+
+    card = bitset_container_xor_runs(B1, B2, TMP, &n_runs);
+    assert_int_equal(card, bitset_container_xor(B1, B2, EXPECTED));
+    assert_true(bitset_container_equals(TMP, EXPECTED));
+    assert_int_equal(n_runs, bitset_container_number_of_runs(EXPECTED));
+
+    bitset_container_free(B1);
+    bitset_container_free(B2);
+    bitset_container_free(TMP);
+    bitset_container_free(EXPECTED);
+}
+
 DEFINE_TEST(andnot_test) {
     bitset_container_t* B1 = bitset_container_create();
     bitset_container_t* B2 = bitset_container_create();
@@ -259,6 +301,7 @@ int main() {
         cmocka_unit_test(printf_test), cmocka_unit_test(set_get_test),
         cmocka_unit_test(and_or_test), cmocka_unit_test(xor_test),
         cmocka_unit_test(andnot_test), cmocka_unit_test(to_uint32_array_test),
+        cmocka_unit_test(runs_test),
         cmocka_unit_test(select_test),
         cmocka_unit_test(test_bitset_compute_cardinality),
     };
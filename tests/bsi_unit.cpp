@@ -0,0 +1,243 @@
+/**
+ * Tests for the bit-sliced index, checked against a std::map of the values.
+ */
+
+#include <roaring/roaring_bsi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "roaring_bsi.hh"
+using roaring::Roaring;
+using roaring::RoaringBSI;
+
+#include "test.h"
+
+namespace {
+
+typedef std::map<uint32_t, uint64_t> reference_t;
+
+bool matches(roaring_bsi_op_t op, uint64_t v, uint64_t value) {
+    switch (op) {
+        case ROARING_BSI_LT: return v < value;
+        case ROARING_BSI_LE: return v <= value;
+        case ROARING_BSI_EQ: return v == value;
+        case ROARING_BSI_NEQ: return v != value;
+        case ROARING_BSI_GE: return v >= value;
+        default: return v > value;
+    }
+}
+
+bool in_found_set(const roaring_bitmap_t *found_set, uint32_t row) {
+    return found_set == NULL || roaring_bitmap_contains(found_set, row);
+}
+
+void assert_bitmap(const roaring_bitmap_t *r,
+                   const std::vector<uint32_t> &rows) {
+    assert_true(roaring_bitmap_get_cardinality(r) == rows.size());
+    for (uint32_t row : rows) {
+        assert_true(roaring_bitmap_contains(r, row));
+    }
+}
+
+// Rows spread over several containers, values of up to 20 bits with many
+// duplicates.
+void random_load(std::mt19937 &gen, size_t n, std::vector<uint32_t> &rows,
+                 std::vector<uint64_t> &values) {
+    reference_t unique;
+    while (unique.size() < n) {
+        uint32_t row = gen() % 500000;
+        unique[row] = (gen() % 4 == 0) ? gen() % 16 : gen() % 1000000;
+    }
+    rows.clear();
+    values.clear();
+    for (const auto &rv : unique) {
+        rows.push_back(rv.first);
+        values.push_back(rv.second);
+    }
+    // shuffle the batch, keeping rows and values together
+    for (size_t i = rows.size(); i > 1; i--) {
+        size_t j = gen() % i;
+        std::swap(rows[i - 1], rows[j]);
+        std::swap(values[i - 1], values[j]);
+    }
+}
+
+void check_queries(const roaring_bsi_t *bsi, const reference_t &ref,
+                   const roaring_bitmap_t *found_set, std::mt19937 &gen) {
+    // values around the stored ones, plus out of range ones
+    std::vector<uint64_t> probes = {0, 1, 15, 16, 999999, 1000000,
+                                    UINT64_C(1) << 40, UINT64_MAX};
+    for (int i = 0; i < 10; i++) {
+        auto it = ref.begin();
+        std::advance(it, gen() % ref.size());
+        probes.push_back(it->second);
+    }
+    const roaring_bsi_op_t ops[] = {ROARING_BSI_LT,  ROARING_BSI_LE,
+                                    ROARING_BSI_EQ,  ROARING_BSI_NEQ,
+                                    ROARING_BSI_GE,  ROARING_BSI_GT};
+    for (uint64_t value : probes) {
+        for (roaring_bsi_op_t op : ops) {
+            std::vector<uint32_t> expected;
+            for (const auto &rv : ref) {
+                if (in_found_set(found_set, rv.first) &&
+                    matches(op, rv.second, value)) {
+                    expected.push_back(rv.first);
+                }
+            }
+            roaring_bitmap_t *r =
+                roaring_bsi_compare(bsi, op, value, found_set);
+            assert_bitmap(r, expected);
+            roaring_bitmap_free(r);
+        }
+        uint64_t max = value + 5000;
+        std::vector<uint32_t> expected;
+        for (const auto &rv : ref) {
+            if (in_found_set(found_set, rv.first) && rv.second >= value &&
+                rv.second <= max) {
+                expected.push_back(rv.first);
+            }
+        }
+        roaring_bitmap_t *r = roaring_bsi_range(bsi, value, max, found_set);
+        assert_bitmap(r, expected);
+        roaring_bitmap_free(r);
+    }
+
+    uint64_t sum = 0, count = 0, min = UINT64_MAX, max = 0;
+    std::vector<std::pair<uint64_t, uint32_t> > by_value;
+    for (const auto &rv : ref) {
+        if (!in_found_set(found_set, rv.first)) continue;
+        sum += rv.second;
+        count++;
+        min = std::min(min, rv.second);
+        max = std::max(max, rv.second);
+        // largest values first, then smallest rows
+        by_value.push_back(std::make_pair(UINT64_MAX - rv.second, rv.first));
+    }
+    uint64_t actual_count;
+    assert_true(roaring_bsi_sum(bsi, found_set, &actual_count) == sum);
+    assert_true(actual_count == count);
+    uint64_t actual;
+    assert_true(roaring_bsi_min(bsi, found_set, &actual) == (count > 0));
+    if (count > 0) assert_true(actual == min);
+    assert_true(roaring_bsi_max(bsi, found_set, &actual) == (count > 0));
+    if (count > 0) assert_true(actual == max);
+
+    std::sort(by_value.begin(), by_value.end());
+    for (size_t k : {size_t(0), size_t(1), size_t(7), size_t(100),
+                     size_t(1000), by_value.size(), by_value.size() + 1}) {
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < k && i < by_value.size(); i++) {
+            expected.push_back(by_value[i].second);
+        }
+        roaring_bitmap_t *r = roaring_bsi_top_k(bsi, k, found_set);
+        assert_bitmap(r, expected);
+        roaring_bitmap_free(r);
+    }
+}
+
+DEFINE_TEST(set_get_remove) {
+    roaring_bsi_t *bsi = roaring_bsi_create();
+    uint64_t value;
+    assert_false(roaring_bsi_get(bsi, 3, &value));
+    assert_true(roaring_bsi_bit_depth(bsi) == 0);
+
+    roaring_bsi_set(bsi, 3, 0);
+    roaring_bsi_set(bsi, 70000, 12345);
+    roaring_bsi_set(bsi, 4, UINT64_MAX);
+    assert_true(roaring_bsi_bit_depth(bsi) == 64);
+    assert_true(roaring_bsi_get(bsi, 3, &value) && value == 0);
+    assert_true(roaring_bsi_get(bsi, 70000, &value) && value == 12345);
+    assert_true(roaring_bsi_get(bsi, 4, &value) && value == UINT64_MAX);
+
+    // overwriting clears the previous bits
+    roaring_bsi_set(bsi, 4, 6);
+    assert_true(roaring_bsi_get(bsi, 4, &value) && value == 6);
+    assert_true(roaring_bitmap_get_cardinality(roaring_bsi_rows(bsi)) == 3);
+
+    roaring_bsi_remove(bsi, 70000);
+    roaring_bsi_remove(bsi, 70001);
+    assert_false(roaring_bsi_get(bsi, 70000, &value));
+    assert_true(roaring_bitmap_get_cardinality(roaring_bsi_rows(bsi)) == 2);
+    roaring_bsi_free(bsi);
+}
+
+DEFINE_TEST(set_many_and_queries) {
+    std::mt19937 gen(1234);
+    std::vector<uint32_t> rows;
+    std::vector<uint64_t> values;
+    random_load(gen, 20000, rows, values);
+    reference_t ref;
+    roaring_bsi_t *bsi = roaring_bsi_create();
+    roaring_bsi_set_many(bsi, rows.size(), rows.data(), values.data());
+    for (size_t i = 0; i < rows.size(); i++) ref[rows[i]] = values[i];
+
+    // a second batch overwriting some rows
+    random_load(gen, 5000, rows, values);
+    roaring_bsi_set_many(bsi, rows.size(), rows.data(), values.data());
+    for (size_t i = 0; i < rows.size(); i++) ref[rows[i]] = values[i];
+
+    for (const auto &rv : ref) {
+        uint64_t value;
+        assert_true(roaring_bsi_get(bsi, rv.first, &value));
+        assert_true(value == rv.second);
+    }
+
+    check_queries(bsi, ref, NULL, gen);
+    // a found set with rows that have no value
+    roaring_bitmap_t *found_set = roaring_bitmap_create();
+    roaring_bitmap_add_range(found_set, 100000, 300000);
+    for (uint32_t row = 0; row < 600000; row += 3) {
+        roaring_bitmap_add(found_set, row);
+    }
+    check_queries(bsi, ref, found_set, gen);
+    roaring_bitmap_clear(found_set);
+    roaring_bitmap_t *r = roaring_bsi_top_k(bsi, 10, found_set);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(found_set);
+    roaring_bsi_free(bsi);
+}
+
+DEFINE_TEST(cpp_wrapper) {
+    RoaringBSI bsi;
+    const uint32_t rows[] = {1, 5, 9, 100000};
+    const uint64_t values[] = {10, 20, 20, 40};
+    bsi.setMany(4, rows, values);
+    bsi.set(7, 30);
+    assert_true(bsi.cardinality() == 5);
+
+    assert_true(bsi.compare(ROARING_BSI_EQ, 20) ==
+                Roaring::bitmapOfList({5, 9}));
+    assert_true(bsi.range(15, 35) == Roaring::bitmapOfList({5, 7, 9}));
+    Roaring found = Roaring::bitmapOfList({1, 7, 9, 12});
+    assert_true(bsi.compare(ROARING_BSI_GT, 10, &found) ==
+                Roaring::bitmapOfList({7, 9}));
+    uint64_t count;
+    assert_true(bsi.sum(&found, &count) == 60 && count == 3);
+    uint64_t value;
+    assert_true(bsi.min(&value) && value == 10);
+    assert_true(bsi.max(&value, &found) && value == 30);
+    assert_true(bsi.topK(2) == Roaring::bitmapOfList({7, 100000}));
+    assert_true(bsi.topK(3) == Roaring::bitmapOfList({5, 7, 100000}));
+
+    RoaringBSI moved(std::move(bsi));
+    assert_true(moved.get(100000, &value) && value == 40);
+    moved.remove(100000);
+    assert_false(moved.get(100000, &value));
+}
+
+}  // namespace
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(set_get_remove),
+        cmocka_unit_test(set_many_and_queries),
+        cmocka_unit_test(cpp_wrapper),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -17,6 +17,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <type_traits>
 #include <vector>
 
@@ -24,6 +25,13 @@
 #include "roaring.hh"
 using roaring::Roaring;  // the C++ wrapper class
 
+// Forward declarations of the 64-bit classes must keep compiling.
+namespace roaring {
+class Roaring64Map;
+class Roaring64MapSetBitForwardIterator;
+class Roaring64MapSetBitBiDirectionalIterator;
+}  // namespace roaring
+
 #include "roaring64map.hh"
 using roaring::Roaring64Map;  // C++ class extended for 64-bit numbers
 
@@ -64,6 +72,15 @@ DEFINE_TEST(serial_test) {
     memcpy(copy, serializedbytes, serializesize);
     Roaring t2 = Roaring::read(copy);
     assert_true(t2 == t);
+
+    std::ostringstream out;
+    r1.addRange(100000, 200000);
+    r1.runOptimize();
+    assert_true(r1.write(out) == r1.getSizeInBytes());
+    std::string streamed = out.str();
+    assert_true(Roaring::readSafe(streamed.data(), streamed.size()) == r1);
+    assert_true(Roaring::readSafe(streamed.data(), streamed.size(), 4,
+                                  nullptr, nullptr) == r1);
     delete[] serializedbytes;
     delete[] copy;
 }
@@ -383,6 +400,24 @@ void test_example_cpp(bool copy_on_write) {
     // we can compute intersection two-by-two
     Roaring i1_2 = r1 & r2;
 
+    // we can compute a big intersection
+    Roaring bigintersection = Roaring::fastintersect(3, allmybitmaps);
+    assert_true((i1_2 & r3) == bigintersection);
+
+    // both can be split into tasks handed to an executor
+    roaring::api::roaring_executor inline_executor =
+        [](void *, roaring::api::roaring_task task, void *arg, size_t count) {
+            for (size_t i = 0; i < count; i++) task(arg, i);
+        };
+    assert_true(Roaring::fastunion(3, allmybitmaps, 4, inline_executor,
+                                   nullptr) == bigunion);
+    assert_true(Roaring::fastintersect(3, allmybitmaps, 4, inline_executor,
+                                       nullptr) == bigintersection);
+
+    // values in at least 2 of the 3 bitmaps
+    assert_true(Roaring::fastthreshold(3, allmybitmaps, 2) ==
+                ((r1 & r2) | (r1 & r3) | (r2 & r3)));
+
     // we can write a bitmap to a pointer and recover it later
     size_t expectedsize = r1.getSizeInBytes();
     char *serializedbytes = new char[expectedsize];
@@ -926,6 +961,18 @@ DEFINE_TEST(test_cpp_add_many_64) {
         r2.add(value);
     }
     assert_true(r1 == r2);
+
+    // a large batch hopping between inner bitmaps is partitioned first
+    values.clear();
+    std::mt19937_64 gen(1234);
+    for (size_t i = 0; i < 100000; i++) {
+        values.push_back(((gen() % 300) << 32) | (gen() & 0xFFFFF));
+    }
+    r1.addMany(values.size(), values.data());
+    for (const auto value : values) {
+        r2.add(value);
+    }
+    assert_true(r1 == r2);
 }
 
 DEFINE_TEST(test_cpp_add_range_closed_combinatoric_64) {
@@ -1220,6 +1267,268 @@ DEFINE_TEST(test_cpp_move_64) {
     assert_false(i.move(0xFFFFFFFFFFULL));
 }
 
+template <typename Map>
+void check_read_batch_64() {
+    Map roaring;
+    std::set<uint64_t> expected;
+    for (uint64_t high : {0ULL, 1ULL, 7ULL, 0xFFFFFFFFULL}) {
+        for (uint64_t low = 0; low < 5000; low += 3) {
+            roaring.add((high << 32) | (low * 1000));
+            expected.insert((high << 32) | (low * 1000));
+        }
+    }
+    // Leaves empty bitmaps in the map, which must be skipped.
+    roaring.add(uint64_t(3) << 32);
+    roaring.remove(uint64_t(3) << 32);
+    roaring.add(uint64_t(5) << 32);
+    roaring.remove(uint64_t(5) << 32);
+
+    for (size_t batch : {size_t(1), size_t(7), size_t(1000), size_t(100000)}) {
+        typename Map::const_iterator it = roaring.begin();
+        std::vector<uint64_t> values;
+        std::vector<uint64_t> buf(batch);
+        size_t n;
+        while ((n = it.readBatch(buf.data(), buf.size())) > 0) {
+            values.insert(values.end(), buf.begin(), buf.begin() + n);
+        }
+        assert_true(it == roaring.end());
+        assert_true(values.size() == expected.size());
+        assert_true(std::equal(values.begin(), values.end(), expected.begin()));
+    }
+
+    typename Map::const_iterator it = roaring.begin();
+    for (uint64_t target : {0ULL, 5ULL, (1ULL << 32) + 4999000,
+                            (1ULL << 32) + 4999001, (2ULL << 32),
+                            (3ULL << 32), (7ULL << 32) + 2,
+                            (0xFFFFFFFFULL << 32) + 4998000, 3ULL}) {
+        auto expected_it = expected.lower_bound(target);
+        assert_true(it.moveEqualOrLarger(target));
+        assert_true(*it == *expected_it);
+    }
+    assert_false(it.moveEqualOrLarger(0xFFFFFFFFFFFFFFFFULL));
+    assert_true(it == roaring.end());
+
+    // Reading resumes from wherever the iterator was moved to.
+    it = roaring.begin();
+    assert_true(it.moveEqualOrLarger(uint64_t(7) << 32));
+    uint64_t first[2];
+    assert_true(it.readBatch(first, 2) == 2);
+    assert_true(first[0] == (uint64_t(7) << 32) && first[1] == first[0] + 3000);
+    assert_true(*it == first[1] + 3000);
+}
+
+DEFINE_TEST(test_cpp_rank_index) {
+    Roaring r;
+    for (uint32_t key = 0; key < 100; key += 2) {
+        r.addRange(uint64_t(key) << 16, (uint64_t(key) << 16) + key * 100 + 1);
+    }
+    std::vector<uint32_t> all(r.cardinality());
+    r.toUint32Array(all.data());
+
+    roaring::RoaringRankIndex index(r);
+    for (uint32_t rnk = 0; rnk < all.size(); rnk += 7) {
+        uint32_t element;
+        assert_true(index.select(rnk, &element));
+        assert_true(element == all[rnk]);
+        assert_true(index.rank(element) == r.rank(element));
+        assert_true(index.rank(element + 1000) == r.rank(element + 1000));
+    }
+    std::vector<uint32_t> page(10);
+    index.rangeUint32Array(page.data(), 1000, page.size());
+    assert_true(std::equal(page.begin(), page.end(), all.begin() + 1000));
+
+    // the index must be rebuilt after modifications
+    r.add(1);
+    uint32_t element;
+    assert_false(index.isValid());
+    assert_false(index.select(1, &element));
+    assert_true(index.rank(1) == 0);
+    assert_false(index.rangeUint32Array(page.data(), 0, page.size()));
+    index.rebuild();
+    assert_true(index.isValid());
+    assert_true(index.select(1, &element) && element == 1);
+    assert_false(index.select(uint32_t(r.cardinality()), &element));
+
+    // swapping or moving content in invalidates the index too
+    Roaring other(r);
+    r.swap(other);
+    assert_false(index.isValid());
+    index.rebuild();
+    r = std::move(other);
+    assert_false(index.isValid());
+}
+
+template <typename Map, typename RankIndex>
+void check_rank_index_64() {
+    Map r;
+    for (uint64_t high = 0; high < 20; high += 3) {
+        r.addRange((high << 32) + 5, (high << 32) + 5 + high * 1000 + 1);
+    }
+    r.add(uint64_t(7) << 32);
+    r.add((uint64_t(7) << 32) + 1);
+    r.remove(uint64_t(7) << 32);
+    r.remove((uint64_t(7) << 32) + 1);  // leaves an empty inner bitmap
+    std::vector<uint64_t> all(r.cardinality());
+    r.toUint64Array(all.data());
+
+    RankIndex index(r);
+    for (uint64_t rnk = 0; rnk < all.size(); rnk += 13) {
+        uint64_t element = 0;
+        assert_true(index.select(rnk, &element));
+        assert_true(element == all[rnk]);
+        assert_true(index.rank(element) == r.rank(element));
+        assert_true(index.rank(element + 500) == r.rank(element + 500));
+    }
+    uint64_t element;
+    assert_false(index.select(all.size(), &element));
+    assert_true(index.rank(UINT64_MAX) == all.size());
+
+    // pages spanning several inner bitmaps
+    for (uint64_t offset : {uint64_t(0), uint64_t(3000), uint64_t(3001),
+                            uint64_t(all.size() - 5),
+                            uint64_t(all.size())}) {
+        std::vector<uint64_t> page(5000);
+        size_t n = index.rangeUint64Array(page.data(), offset, page.size());
+        assert_true(n == std::min<size_t>(page.size(), all.size() - offset));
+        assert_true(std::equal(page.begin(), page.begin() + n,
+                               all.begin() + offset));
+    }
+
+    // a modified inner bitmap makes the queries involving it fail
+    r.add((uint64_t(3) << 32) + 1);
+    assert_false(index.select(2, &element));  // in the bitmap of high 3
+    assert_true(index.select(0, &element) && element == all[0]);
+}
+
+DEFINE_TEST(test_cpp_rank_index_64) {
+    check_rank_index_64<Roaring64Map, roaring::Roaring64MapRankIndex>();
+    check_rank_index_64<roaring::Roaring64FlatMap,
+                        roaring::Roaring64FlatMapRankIndex>();
+}
+
+DEFINE_TEST(test_cpp_for_each) {
+    Roaring r;
+    for (uint32_t i = 0; i < 300; i++) r.add(7 * i);        // array
+    for (uint32_t i = 0; i < 20000; i++) r.add(65536 + 3 * i);  // bitset
+    r.add(65536 + 65535);  // last bit of the bitset
+    r.addRange(5 * 65536 + 100, 8 * 65536 + 5);  // runs
+    r.addRange(uint64_t(uint32_max) - 10, uint64_t(uint32_max) + 1);
+    r.runOptimize();
+    std::vector<uint32_t> expected(r.cardinality());
+    r.toUint32Array(expected.data());
+
+    // the last run ends on the largest value, which must not wrap around
+    std::vector<uint32_t> values;
+    r.forEach([&values](uint32_t value) { values.push_back(value); });
+    assert_true(values == expected);
+
+    values.clear();
+    size_t calls = 0;
+    r.forEachBatch([&](const uint32_t *batch, size_t count) {
+        assert_true(count > 0 && count <= 256);
+        values.insert(values.end(), batch, batch + count);
+        calls++;
+    });
+    assert_true(values == expected);
+    assert_true(calls == (expected.size() + 255) / 256);
+
+    // const functors work too
+    uint64_t sum = 0;
+    const auto add_up = [&sum](uint32_t value) { sum += value; };
+    Roaring().forEach(add_up);
+    assert_true(sum == 0);
+
+    Roaring64Map r64;
+    r64.add(uint64_t(3) << 32 | 5);
+    r64.addRange(uint64_t(7) << 32, (uint64_t(7) << 32) + 1000);
+    r64.add(uint64_t(8) << 32);
+    std::vector<uint64_t> expected64(r64.cardinality());
+    r64.toUint64Array(expected64.data());
+    std::vector<uint64_t> values64;
+    r64.forEach([&](uint64_t value) { values64.push_back(value); });
+    assert_true(values64 == expected64);
+    values64.clear();
+    r64.forEachBatch([&](const uint64_t *batch, size_t count) {
+        assert_true(count <= 256);
+        values64.insert(values64.end(), batch, batch + count);
+    });
+    assert_true(values64 == expected64);
+}
+
+DEFINE_TEST(test_cpp_lazy) {
+    Roaring a, b, c;
+    a.addRange(0, 100000);
+    for (uint32_t v = 0; v < 1000000; v += 3) b.add(v);
+    for (uint32_t v = 50000; v < 3000000; v += 5) c.add(v);
+    const Roaring *inputs[] = {&a, &b, &c};
+
+    // the first values of the union, without computing all of it
+    std::vector<uint32_t> first;
+    for (uint32_t v : roaring::RoaringLazy::unionOf(3, inputs)) {
+        first.push_back(v);
+        if (first.size() == 10) break;
+    }
+    assert_true(first == std::vector<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    Roaring all;
+    for (uint32_t v : roaring::RoaringLazy::intersectionOf(3, inputs)) {
+        all.add(v);
+    }
+    assert_true(all == (a & b & c));
+
+    // a | (b & c), composed from lazy ranges
+    roaring::RoaringLazy bc[] = {roaring::RoaringLazy(b),
+                                 roaring::RoaringLazy(c)};
+    roaring::RoaringLazy parts[] = {
+        roaring::RoaringLazy(a), roaring::RoaringLazy::intersectionOf(2, bc)};
+    roaring::RoaringLazy lazy = roaring::RoaringLazy::unionOf(2, parts);
+    assert_true(lazy.moveEqualOrLarger(99999) && lazy.value() == 99999);
+    std::vector<uint32_t> buf(1000);
+    assert_true(lazy.read(buf.data(), 1000) == 1000);
+    Roaring expected = a | (b & c);
+    uint32_t v = 99999;
+    for (size_t i = 0; i < buf.size(); i++) {
+        assert_true(buf[i] == v);
+        expected.select(expected.rank(v), &v);
+    }
+}
+
+DEFINE_TEST(test_cpp_expr) {
+    Roaring a, b, c, d;
+    for (uint32_t key = 0; key < 50; key++) {
+        uint32_t base = key << 16;
+        a.addRange(base, base + 10000 + key * 10);
+        for (uint32_t v = key; v < 65536; v += 3) b.add(base + v);
+        if (key % 2 == 0) c.addRange(base + 5000, base + 60000);
+        for (uint32_t v = 0; v < 65536; v += 101) d.add(base + v);
+    }
+    b.runOptimize();
+
+    using roaring::expr;
+    Roaring r = (expr(a) & b) | (expr(c) - d);
+    assert_true(r == ((a & b) | (c - d)));
+    r = (expr(a) ^ b ^ c) & (d | expr(b));
+    assert_true(r == ((a ^ b ^ c) & (d | b)));
+    r = (expr(a) - b).evaluate();
+    assert_true(r == a - b);
+    r = expr(c) ^ c;
+    assert_true(r.isEmpty());
+
+    // an expression can be kept and evaluated again
+    auto e = expr(a) & expr(c);
+    assert_true(Roaring(e) == (a & c));
+    c.add(1);
+    assert_true(e.evaluate().contains(1));
+
+    // operators on plain bitmaps are unchanged
+    static_assert(std::is_same<decltype(a & b), Roaring>::value, "");
+}
+
+DEFINE_TEST(test_cpp_read_batch_64) {
+    check_read_batch_64<Roaring64Map>();
+    check_read_batch_64<roaring::Roaring64FlatMap>();
+}
+
 DEFINE_TEST(test_cpp_bidirectional_iterator_64) {
     Roaring64Map roaring;
 
@@ -1250,6 +1559,21 @@ DEFINE_TEST(test_cpp_bidirectional_iterator_64) {
     assert_true(i == roaring.begin());
 }
 
+DEFINE_TEST(test_cpp_from_sorted) {
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 100000; i += 3) values.push_back(i);
+    for (uint32_t i = 200000; i < 300000; i++) values.push_back(i);
+    values.push_back(uint32_max);
+
+    Roaring expected;
+    expected.addMany(values.size(), values.data());
+    expected.runOptimize();
+    Roaring r = Roaring::fromSorted(values.data(), values.size());
+    assert_true(r == expected);
+    assert_true(r.getSizeInBytes() == expected.getSizeInBytes());
+    assert_true(Roaring::fromSorted(values.data(), 0).isEmpty());
+}
+
 DEFINE_TEST(test_cpp_frozen) {
     const uint64_t s = 65536;
 
@@ -1331,6 +1655,50 @@ DEFINE_TEST(test_cpp_frozen) {
     roaring_aligned_free(buf);
 }
 
+DEFINE_TEST(test_cpp_portable_deserialize_frozen) {
+    Roaring r1;
+    r1.add(0);
+    r1.add(uint32_max);
+    r1.add(1001);
+    r1.addRange(655460, 851968);
+    for (uint32_t i = 0; i < 65536 * 3; i += 2) {
+        r1.add(65536 * 20 + i);
+    }
+    r1.runOptimize();
+
+    // write at an odd offset: the view does not need an aligned buffer
+    size_t num_bytes = r1.getSizeInBytes();
+    std::vector<char> storage(num_bytes + 1);
+    char *buf = storage.data() + 1;
+    r1.write(buf);
+
+    const Roaring r2 = Roaring::portableDeserializeFrozen(buf, num_bytes);
+    assert_true(r1 == r2);
+    assert_true(r2.contains(1001));
+    assert_false(r2.contains(1002));
+    assert_true((r1 & r2) == r1);
+    uint64_t count = 0;
+    for (Roaring::const_iterator i = r2.begin(); i != r2.end(); i++) {
+        count++;
+    }
+    assert_true(count == r1.cardinality());
+
+    // copies own their containers
+    {
+        Roaring tmp(r2);
+        tmp.add(1002);
+        assert_true(tmp.contains(1002));
+        assert_false(r2.contains(1002));
+    }
+#if ROARING_EXCEPTIONS
+    try {
+        Roaring::portableDeserializeFrozen(buf, num_bytes - 1);
+        assert(false);
+    } catch (...) {
+    }
+#endif
+}
+
 DEFINE_TEST(test_cpp_frozen_64) {
     const uint64_t s = 65536;
 
@@ -1892,6 +2260,177 @@ DEFINE_TEST(test_cpp_contains_range_interleaved_containers) {
     roaring.containsRange(0x1FFFF, 0x2FFFF + 2);
 }
 
+DEFINE_TEST(test_cpp_arena_scope) {
+    Roaring r1 = Roaring::bitmapOf(3, 1, 100000, 1000000);
+    r1.addRange(5000000, 5100000);
+    Roaring r2;
+    for (uint32_t i = 0; i < 200000; i += 3) r2.add(i);
+    Roaring expected = r1 ^ r2;
+
+    roaring_arena_t *arena = roaring_arena_create(1 << 16);
+    Roaring kept;
+    {
+        roaring::RoaringArenaScope scope(arena);
+        Roaring local(r2);
+        Roaring sym = r1 | local;
+        sym -= r1 & local;
+        assert_true(sym == expected);
+        assert_true(roaring_arena_used(arena) > 0);
+        {
+            roaring::RoaringArenaScope heap(nullptr);  // scopes nest
+            kept = sym;
+        }
+    }
+    roaring_arena_reset(arena);
+    assert_true(kept == expected);
+    roaring_arena_free(arena);
+}
+
+namespace {
+// Checks that a Roaring64FlatMap holds the same values as a Roaring64Map.
+void assert_same_64(const Roaring64Map &expected,
+                    const roaring::Roaring64FlatMap &actual) {
+    assert_true(expected.cardinality() == actual.cardinality());
+    // Both use the same serialization format.
+    std::vector<char> expected_buf(expected.getSizeInBytes());
+    expected.write(expected_buf.data());
+    std::vector<char> actual_buf(actual.getSizeInBytes());
+    actual.write(actual_buf.data());
+    assert_true(expected_buf == actual_buf);
+    assert_true(roaring::Roaring64FlatMap::read(expected_buf.data()) == actual);
+}
+}  // namespace
+
+DEFINE_TEST(test_cpp_roaring64map_class) {
+    Roaring64Map a = Roaring64Map::bitmapOf(3, uint64_t(1), uint64_t(5),
+                                            uint64_t(1) << 40);
+    Roaring64Map b = Roaring64Map::bitmapOfList({5, 6});
+    static_assert(std::is_same<decltype(a & b), Roaring64Map>::value, "");
+    static_assert(
+        std::is_same<decltype(Roaring64Map::bitmapOf(0)), Roaring64Map>::value,
+        "");
+    assert_true((a | b).cardinality() == 4);
+    assert_true((a & b) == Roaring64Map::bitmapOf(1, uint64_t(5)));
+    static_assert(std::is_same<decltype(a |= b), Roaring64Map &>::value, "");
+    Roaring64Map c = a;
+    Roaring64Map &chained = ((c |= b) &= a) ^= b;
+    assert_true(&chained == &c);
+    assert_true(((chained -= a) |= a) == (a | b));
+
+    const Roaring64Map *inputs[] = {&a, &b};
+    Roaring64Map u = Roaring64Map::fastunion(2, inputs);
+    assert_true(u == (a | b));
+
+    std::vector<char> buf(u.getSizeInBytes());
+    u.write(buf.data());
+    assert_true(Roaring64Map::readSafe(buf.data(), buf.size()) == u);
+
+    roaring::Roaring64MapSetBitForwardIterator it = u.begin();
+    assert_true(*it == 1);
+    ++it;
+    assert_true(*it == 5);
+    roaring::Roaring64MapSetBitBiDirectionalIterator bi(u);
+    bi.move(6);
+    assert_true(*bi == 6);
+    --bi;
+    assert_true(*bi == 5);
+}
+
+DEFINE_TEST(test_cpp_flat_map_64) {
+    using roaring::Roaring64FlatMap;
+    std::mt19937 gen(1234);
+    // A small set of high keys, so that the operations below keep hitting
+    // existing and missing slots, and values at both ends of the slots, so
+    // that ranges sometimes span two slots.
+    auto random_value = [&gen]() {
+        uint32_t low = gen() % 100000;
+        return (uint64_t(gen() % 40) << 32) |
+               (gen() % 2 ? low : uint32_max - low);
+    };
+    Roaring64Map map, other_map;
+    Roaring64FlatMap flat, other_flat;
+    for (int round = 0; round < 2000; round++) {
+        uint64_t x = random_value();
+        uint64_t y = x + gen() % 200000;
+        switch (gen() % 10) {
+            case 0:
+            case 1:
+            case 2:
+                map.add(x);
+                flat.add(x);
+                break;
+            case 3:
+                map.remove(x);
+                flat.remove(x);
+                break;
+            case 4:
+                map.addRange(x, y);
+                flat.addRange(x, y);
+                break;
+            case 5:
+                map.removeRangeClosed(x, y);
+                flat.removeRangeClosed(x, y);
+                break;
+            case 6:
+                map.flip(x, y);
+                flat.flip(x, y);
+                break;
+            case 7:
+                other_map.add(x);
+                other_flat.add(x);
+                other_map.addRange(y, y + 100);
+                other_flat.addRange(y, y + 100);
+                break;
+            default:
+                assert_true(map.contains(x) == flat.contains(x));
+                assert_true(map.rank(x) == flat.rank(x));
+                break;
+        }
+        if (round % 100 == 99) {
+            assert_same_64(map, flat);
+            assert_same_64(map | other_map, flat | other_flat);
+            assert_same_64(map & other_map, flat & other_flat);
+            assert_same_64(map - other_map, flat - other_flat);
+            assert_same_64(map ^ other_map, flat ^ other_flat);
+            const Roaring64FlatMap *inputs[] = {&flat, &other_flat};
+            // or_many may pick other container types than pairwise unions
+            assert_true(Roaring64FlatMap::fastunion(2, inputs) ==
+                        (flat | other_flat));
+        }
+    }
+    assert_true(map.minimum() == flat.minimum());
+    assert_true(map.maximum() == flat.maximum());
+
+    std::vector<uint64_t> forward(flat.begin(), flat.end());
+    std::vector<uint64_t> expected(map.cardinality());
+    map.toUint64Array(expected.data());
+    assert_true(forward == expected);
+    Roaring64FlatMap::const_bidirectional_iterator it(flat, true);
+    for (auto rit = expected.rbegin(); rit != expected.rend(); ++rit) {
+        --it;
+        assert_true(*it == *rit);
+    }
+
+    flat.shrinkToFit();
+    map.shrinkToFit();
+    assert_same_64(map, flat);
+
+    // Ranges covering whole slots, some of them missing.
+    const uint64_t slot = uint64_t(1) << 32;
+    map.addRangeClosed(3 * slot + 5, 7 * slot + 5);
+    flat.addRangeClosed(3 * slot + 5, 7 * slot + 5);
+    map.flipClosed(slot, 50 * slot - 1);
+    flat.flipClosed(slot, 50 * slot - 1);
+    map.runOptimize();
+    flat.runOptimize();
+    assert_same_64(map, flat);
+    map.removeRange(2 * slot + 7, 45 * slot);
+    flat.removeRange(2 * slot + 7, 45 * slot);
+    assert_same_64(map, flat);
+    flat.clear();
+    assert_true(flat.isEmpty());
+}
+
 int main() {
     roaring::misc::tellmeall();
     const struct CMUnitTest tests[] = {
@@ -1927,11 +2466,19 @@ int main() {
         cmocka_unit_test(test_cpp_xor_64),
         cmocka_unit_test(test_cpp_clear_64),
         cmocka_unit_test(test_cpp_move_64),
+        cmocka_unit_test(test_cpp_read_batch_64),
+        cmocka_unit_test(test_cpp_rank_index),
+        cmocka_unit_test(test_cpp_rank_index_64),
+        cmocka_unit_test(test_cpp_for_each),
+        cmocka_unit_test(test_cpp_lazy),
+        cmocka_unit_test(test_cpp_expr),
         cmocka_unit_test(test_roaring64_iterate_multi_roaring),
         cmocka_unit_test(test_roaring64_remove_32),
         cmocka_unit_test(test_roaring64_add_and_remove),
         cmocka_unit_test(test_cpp_bidirectional_iterator_64),
+        cmocka_unit_test(test_cpp_from_sorted),
         cmocka_unit_test(test_cpp_frozen),
+        cmocka_unit_test(test_cpp_portable_deserialize_frozen),
         cmocka_unit_test(test_cpp_frozen_64),
         cmocka_unit_test(test_cpp_flip),
         cmocka_unit_test(test_cpp_flip_closed),
@@ -1957,6 +2504,9 @@ int main() {
         cmocka_unit_test(test_cpp_to_string),
         cmocka_unit_test(test_cpp_remove_run_compression),
         cmocka_unit_test(test_cpp_contains_range_interleaved_containers),
+        cmocka_unit_test(test_cpp_arena_scope),
+        cmocka_unit_test(test_cpp_roaring64map_class),
+        cmocka_unit_test(test_cpp_flat_map_64),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -1995,6 +1995,96 @@ DEFINE_TEST(run_negation_range_test9) {
                              RUN_CONTAINER_TYPE, false, false);
 }
 
+// The adaptive union and xor must give the container that the plain
+// operation followed by convert_run_optimize gives.
+static void check_adaptive_pair(const container_t *c1, uint8_t type1,
+                                const container_t *c2, uint8_t type2) {
+    uint8_t plain_type, adaptive_type;
+    container_t *plain = container_or(c1, type1, c2, type2, &plain_type);
+    plain = convert_run_optimize(plain, plain_type, &plain_type);
+    container_t *adaptive =
+        container_or_adaptive(c1, type1, c2, type2, &adaptive_type);
+    assert_int_equal(adaptive_type, plain_type);
+    assert_true(container_equals(adaptive, adaptive_type, plain, plain_type));
+    container_free(adaptive, adaptive_type);
+    container_free(plain, plain_type);
+
+    plain = container_xor(c1, type1, c2, type2, &plain_type);
+    plain = convert_run_optimize(plain, plain_type, &plain_type);
+    adaptive = container_xor_adaptive(c1, type1, c2, type2, &adaptive_type);
+    assert_int_equal(adaptive_type, plain_type);
+    assert_true(container_equals(adaptive, adaptive_type, plain, plain_type));
+    container_free(adaptive, adaptive_type);
+    container_free(plain, plain_type);
+}
+
+DEFINE_TEST(adaptive_union_xor_test) {
+    enum { N = 8 };
+    container_t *c[N];
+    uint8_t types[N];
+
+    // small array, with values around word boundaries
+    array_container_t *small = array_container_create();
+    const uint16_t small_values[] = {0, 1, 2, 62, 63, 64, 65, 127, 128,
+                                     1000, 1001, 30000, 65534, 65535};
+    for (size_t i = 0; i < sizeof(small_values) / sizeof(uint16_t); i++) {
+        array_container_add(small, small_values[i]);
+    }
+    c[0] = small;
+    types[0] = ARRAY_CONTAINER_TYPE;
+    // arrays of 4000 values, sparse and dense, whose unions are bitsets
+    array_container_t *sparse = array_container_create();
+    array_container_t *dense = array_container_create();
+    for (uint32_t i = 0; i < 4000; i++) {
+        array_container_add(sparse, (uint16_t)(i * 16));
+        array_container_add(dense, (uint16_t)(3000 + i));
+    }
+    c[1] = sparse;
+    types[1] = ARRAY_CONTAINER_TYPE;
+    c[2] = dense;
+    types[2] = ARRAY_CONTAINER_TYPE;
+    // bitsets: alternating bits, long ranges, and all but a few values
+    bitset_container_t *alternating = bitset_container_create();
+    bitset_container_add_from_range(alternating, 0, 20000, 2);
+    bitset_container_set_range(alternating, 30000, 40001);
+    alternating->cardinality =
+        bitset_container_compute_cardinality(alternating);
+    bitset_container_t *almost_full = bitset_container_create();
+    bitset_container_set_range(almost_full, 0, 65536);
+    almost_full->cardinality = 65536;
+    bitset_container_remove(almost_full, 63);
+    bitset_container_remove(almost_full, 5000);
+    c[3] = alternating;
+    types[3] = BITSET_CONTAINER_TYPE;
+    c[4] = almost_full;
+    types[4] = BITSET_CONTAINER_TYPE;
+    // runs crossing word boundaries, and a full run
+    run_container_t *runs = run_container_create();
+    run_container_add_range(runs, 0, 10);
+    run_container_add_range(runs, 60, 70);
+    run_container_add_range(runs, 127, 128);
+    run_container_add_range(runs, 1000, 5000);
+    run_container_add_range(runs, 65000, 65535);
+    c[5] = runs;
+    types[5] = RUN_CONTAINER_TYPE;
+    c[6] = run_container_create_range(0, 65536);
+    types[6] = RUN_CONTAINER_TYPE;
+    run_container_t *few_runs = run_container_create();
+    run_container_add_range(few_runs, 5000, 5000);
+    run_container_add_range(few_runs, 20000, 29999);
+    c[7] = few_runs;
+    types[7] = RUN_CONTAINER_TYPE;
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            check_adaptive_pair(c[i], types[i], c[j], types[j]);
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        container_free(c[i], types[i]);
+    }
+}
+
 int main() {
     tellmeall();
 
@@ -2006,6 +2096,7 @@ int main() {
         cmocka_unit_test(run_andnot_test),
         cmocka_unit_test(run_iandnot_test),
         cmocka_unit_test(run_array_andnot_bug_test),
+        cmocka_unit_test(adaptive_union_xor_test),
         cmocka_unit_test(array_bitset_ixor_test),
         cmocka_unit_test(array_bitset_iandnot_test),
         cmocka_unit_test(array_negation_empty_test),
@@ -0,0 +1,517 @@
+/**
+ * Tests for the ART-based 64-bit bitmap, checked against std::set and against
+ * Roaring64Map for the serialized format.
+ */
+
+#include <roaring/roaring64.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "roaring64map.hh"
+using roaring::Roaring64Map;
+
+#include "test.h"
+
+namespace {
+
+// Values whose upper 48 bits are spread so that the ART builds (and later
+// shrinks) every node type: a dense run of keys fills a Node256, keys sharing
+// long prefixes exercise prefix splits, and random keys spread over the root.
+std::vector<uint64_t> make_high_keys(std::mt19937_64 &gen) {
+    std::vector<uint64_t> highs;
+    for (uint64_t i = 0; i < 300; i++) {
+        highs.push_back(0x123456780000ULL + i);
+    }
+    for (uint64_t i = 0; i < 20; i++) {
+        highs.push_back(0xABCD00000000ULL | (i << 24) | i);
+    }
+    for (int i = 0; i < 100; i++) {
+        highs.push_back(gen() >> 16);
+    }
+    highs.push_back(0);
+    highs.push_back(0xFFFFFFFFFFFFULL);
+    return highs;
+}
+
+uint64_t random_value(std::mt19937_64 &gen,
+                      const std::vector<uint64_t> &highs) {
+    uint64_t high = highs[gen() % highs.size()];
+    return (high << 16) | (gen() & 0xFFFF);
+}
+
+void assert_same(const roaring64_bitmap_t *r, const std::set<uint64_t> &ref) {
+    assert_true(roaring64_bitmap_get_cardinality(r) == ref.size());
+    std::vector<uint64_t> values(ref.size());
+    roaring64_bitmap_to_uint64_array(r, values.data());
+    assert_true(std::equal(values.begin(), values.end(), ref.begin()));
+    for (uint64_t v : ref) {
+        assert_true(roaring64_bitmap_contains(r, v));
+    }
+}
+
+roaring64_bitmap_t *random_bitmap(std::mt19937_64 &gen,
+                                  const std::vector<uint64_t> &highs,
+                                  size_t n, std::set<uint64_t> &ref) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = random_value(gen, highs);
+        roaring64_bitmap_add(r, v);
+        ref.insert(v);
+    }
+    // A few bitset and run containers as well.
+    for (int i = 0; i < 5; i++) {
+        uint64_t base = highs[gen() % highs.size()] << 16;
+        for (uint64_t j = 0; j < 10000; j++) {
+            roaring64_bitmap_add(r, base + 3 * j);
+            ref.insert(base + 3 * j);
+        }
+        uint64_t start = (highs[gen() % highs.size()] << 16) + 1000;
+        roaring64_bitmap_add_range_closed(r, start, start + 20000);
+        for (uint64_t v = start; v <= start + 20000; v++) {
+            ref.insert(v);
+        }
+    }
+    return r;
+}
+
+DEFINE_TEST(add_contains_remove) {
+    std::mt19937_64 gen(1234);
+    std::vector<uint64_t> highs = make_high_keys(gen);
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    std::set<uint64_t> ref;
+    assert_true(roaring64_bitmap_is_empty(r));
+    for (int i = 0; i < 50000; i++) {
+        uint64_t v = random_value(gen, highs);
+        assert_true(roaring64_bitmap_add_checked(r, v) == ref.insert(v).second);
+    }
+    assert_same(r, ref);
+    assert_false(roaring64_bitmap_contains(r, 0x9999999999999999ULL));
+
+    // Removing everything shrinks the nodes back down to an empty tree.
+    std::vector<uint64_t> values(ref.begin(), ref.end());
+    std::shuffle(values.begin(), values.end(), gen);
+    for (size_t i = 0; i < values.size(); i++) {
+        assert_true(roaring64_bitmap_remove_checked(r, values[i]));
+        assert_false(roaring64_bitmap_remove_checked(r, values[i]));
+        ref.erase(values[i]);
+        if (i % 5000 == 0) {
+            assert_same(r, ref);
+        }
+    }
+    assert_true(roaring64_bitmap_is_empty(r));
+    assert_true(roaring64_bitmap_get_cardinality(r) == 0);
+    roaring64_bitmap_free(r);
+}
+
+DEFINE_TEST(ranges) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    std::set<uint64_t> ref;
+    const uint64_t start = 0x0000FFFFFFFF0000ULL - 5;
+    roaring64_bitmap_add_range_closed(r, start, start + 200000);
+    for (uint64_t v = start; v <= start + 200000; v++) {
+        ref.insert(v);
+    }
+    roaring64_bitmap_add_range_closed(r, UINT64_MAX - 10, UINT64_MAX);
+    for (uint64_t v = UINT64_MAX - 10; v != 0; v++) {
+        ref.insert(v);
+    }
+    assert_same(r, ref);
+
+    roaring64_bitmap_remove_range_closed(r, start + 1000, start + 150000);
+    for (uint64_t v = start + 1000; v <= start + 150000; v++) {
+        ref.erase(v);
+    }
+    assert_same(r, ref);
+
+    roaring64_bitmap_remove_range_closed(r, 0, UINT64_MAX);
+    assert_true(roaring64_bitmap_is_empty(r));
+    roaring64_bitmap_free(r);
+}
+
+DEFINE_TEST(rank_select_min_max) {
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> highs = make_high_keys(gen);
+    std::set<uint64_t> ref;
+    roaring64_bitmap_t *r = random_bitmap(gen, highs, 20000, ref);
+    assert_true(roaring64_bitmap_minimum(r) == *ref.begin());
+    assert_true(roaring64_bitmap_maximum(r) == *ref.rbegin());
+
+    uint64_t rank = 0;
+    for (uint64_t v : ref) {
+        rank++;
+        if (rank % 97 != 0) continue;
+        assert_true(roaring64_bitmap_rank(r, v) == rank);
+        uint64_t element;
+        assert_true(roaring64_bitmap_select(r, rank - 1, &element));
+        assert_true(element == v);
+    }
+    uint64_t element;
+    assert_false(roaring64_bitmap_select(r, ref.size(), &element));
+    assert_true(roaring64_bitmap_rank(r, UINT64_MAX) == ref.size());
+
+    roaring64_bitmap_t *empty = roaring64_bitmap_create();
+    assert_true(roaring64_bitmap_minimum(empty) == UINT64_MAX);
+    assert_true(roaring64_bitmap_maximum(empty) == 0);
+    roaring64_bitmap_free(empty);
+
+    roaring64_bitmap_t *copy = roaring64_bitmap_copy(r);
+    assert_true(roaring64_bitmap_run_optimize(copy));
+    assert_true(roaring64_bitmap_equals(copy, r));
+    roaring64_bitmap_free(copy);
+    roaring64_bitmap_free(r);
+}
+
+DEFINE_TEST(set_operations) {
+    std::mt19937_64 gen(7);
+    std::vector<uint64_t> highs = make_high_keys(gen);
+    std::set<uint64_t> ref1, ref2;
+    roaring64_bitmap_t *r1 = random_bitmap(gen, highs, 30000, ref1);
+    roaring64_bitmap_t *r2 = random_bitmap(gen, highs, 30000, ref2);
+
+    std::set<uint64_t> expected_and, expected_or, expected_xor, expected_andnot;
+    std::set_intersection(ref1.begin(), ref1.end(), ref2.begin(), ref2.end(),
+                          std::inserter(expected_and, expected_and.end()));
+    std::set_union(ref1.begin(), ref1.end(), ref2.begin(), ref2.end(),
+                   std::inserter(expected_or, expected_or.end()));
+    std::set_symmetric_difference(
+        ref1.begin(), ref1.end(), ref2.begin(), ref2.end(),
+        std::inserter(expected_xor, expected_xor.end()));
+    std::set_difference(ref1.begin(), ref1.end(), ref2.begin(), ref2.end(),
+                        std::inserter(expected_andnot, expected_andnot.end()));
+
+    roaring64_bitmap_t *result = roaring64_bitmap_and(r1, r2);
+    assert_same(result, expected_and);
+    assert_true(roaring64_bitmap_and_cardinality(r1, r2) ==
+                expected_and.size());
+    assert_true(roaring64_bitmap_is_subset(result, r1));
+    assert_true(roaring64_bitmap_is_subset(result, r2));
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_or(r1, r2);
+    assert_same(result, expected_or);
+    assert_true(roaring64_bitmap_is_subset(r1, result));
+    assert_false(roaring64_bitmap_is_subset(result, r1));
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_xor(r1, r2);
+    assert_same(result, expected_xor);
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_andnot(r1, r2);
+    assert_same(result, expected_andnot);
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_copy(r1);
+    roaring64_bitmap_and_inplace(result, r2);
+    assert_same(result, expected_and);
+    roaring64_bitmap_and_inplace(result, result);
+    roaring64_bitmap_or_inplace(result, result);
+    assert_same(result, expected_and);
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_copy(r1);
+    roaring64_bitmap_or_inplace(result, r2);
+    assert_same(result, expected_or);
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_copy(r1);
+    roaring64_bitmap_xor_inplace(result, r2);
+    assert_same(result, expected_xor);
+    roaring64_bitmap_t *same = roaring64_bitmap_copy(result);
+    roaring64_bitmap_xor_inplace(result, same);
+    assert_true(roaring64_bitmap_is_empty(result));
+    roaring64_bitmap_free(same);
+    roaring64_bitmap_free(result);
+
+    result = roaring64_bitmap_copy(r1);
+    roaring64_bitmap_andnot_inplace(result, r2);
+    assert_same(result, expected_andnot);
+    roaring64_bitmap_andnot_inplace(result, r1);
+    assert_true(roaring64_bitmap_is_empty(result));
+    roaring64_bitmap_free(result);
+
+    assert_false(roaring64_bitmap_equals(r1, r2));
+    roaring64_bitmap_free(r1);
+    roaring64_bitmap_free(r2);
+}
+
+DEFINE_TEST(iterators) {
+    std::mt19937_64 gen(99);
+    std::vector<uint64_t> highs = make_high_keys(gen);
+    std::set<uint64_t> ref;
+    roaring64_bitmap_t *r = random_bitmap(gen, highs, 20000, ref);
+
+    roaring64_iterator_t *it = roaring64_iterator_create(r);
+    for (uint64_t v : ref) {
+        assert_true(roaring64_iterator_has_value(it));
+        assert_true(roaring64_iterator_value(it) == v);
+        roaring64_iterator_advance(it);
+    }
+    assert_false(roaring64_iterator_has_value(it));
+    assert_false(roaring64_iterator_advance(it));
+    // Stepping back from past the end lands on the last value.
+    assert_true(roaring64_iterator_previous(it));
+    assert_true(roaring64_iterator_value(it) == *ref.rbegin());
+    roaring64_iterator_free(it);
+
+    it = roaring64_iterator_create_last(r);
+    for (auto v = ref.rbegin(); v != ref.rend(); ++v) {
+        assert_true(roaring64_iterator_has_value(it));
+        assert_true(roaring64_iterator_value(it) == *v);
+        roaring64_iterator_previous(it);
+    }
+    assert_false(roaring64_iterator_has_value(it));
+    assert_true(roaring64_iterator_advance(it));
+    assert_true(roaring64_iterator_value(it) == *ref.begin());
+
+    for (int i = 0; i < 1000; i++) {
+        uint64_t target = random_value(gen, highs);
+        auto expected = ref.lower_bound(target);
+        bool found = roaring64_iterator_move_equalorlarger(it, target);
+        assert_true(found == (expected != ref.end()));
+        if (found) {
+            assert_true(roaring64_iterator_value(it) == *expected);
+            roaring64_iterator_t *copy = roaring64_iterator_copy(it);
+            roaring64_iterator_free(it);
+            it = copy;
+            roaring64_iterator_advance(it);
+            ++expected;
+            assert_true(roaring64_iterator_has_value(it) ==
+                        (expected != ref.end()));
+        }
+    }
+
+    // Batched reads across container boundaries.
+    roaring64_iterator_reinit(r, it);
+    std::vector<uint64_t> values;
+    std::vector<uint64_t> buf(777);
+    uint64_t n;
+    while ((n = roaring64_iterator_read(it, buf.data(), buf.size())) > 0) {
+        values.insert(values.end(), buf.begin(), buf.begin() + n);
+    }
+    assert_true(values.size() == ref.size());
+    assert_true(std::equal(values.begin(), values.end(), ref.begin()));
+    roaring64_iterator_free(it);
+
+    roaring64_bitmap_t *empty = roaring64_bitmap_create();
+    it = roaring64_iterator_create(empty);
+    assert_false(roaring64_iterator_has_value(it));
+    assert_false(roaring64_iterator_move_equalorlarger(it, 0));
+    roaring64_iterator_free(it);
+    roaring64_bitmap_free(empty);
+    roaring64_bitmap_free(r);
+}
+
+bool append_chunks(void *context, const roaring_iovec_t *iov, size_t iovcnt) {
+    std::string *out = static_cast<std::string *>(context);
+    for (size_t i = 0; i < iovcnt; i++) {
+        out->append(static_cast<const char *>(iov[i].base), iov[i].len);
+    }
+    return true;
+}
+
+DEFINE_TEST(portable_serialization) {
+    std::mt19937_64 gen(2024);
+    std::vector<uint64_t> highs = make_high_keys(gen);
+    std::set<uint64_t> ref;
+    roaring64_bitmap_t *r = random_bitmap(gen, highs, 20000, ref);
+    roaring64_bitmap_run_optimize(r);
+
+    size_t size = roaring64_bitmap_portable_size_in_bytes(r);
+    std::vector<char> buf(size);
+    assert_true(roaring64_bitmap_portable_serialize(r, buf.data()) == size);
+
+    // Roaring64Map reads and writes the same bytes.
+    Roaring64Map map = Roaring64Map::readSafe(buf.data(), buf.size());
+    assert_true(map.cardinality() == ref.size());
+    for (uint64_t v : ref) {
+        assert_true(map.contains(v));
+    }
+    map.runOptimize();
+    std::vector<char> map_buf(map.getSizeInBytes());
+    map.write(map_buf.data());
+    assert_true(map_buf == buf);
+
+    // The streaming writers produce the same bytes.
+    std::ostringstream map_out;
+    assert_true(map.write(map_out) == size);
+    assert_true(map_out.str() == std::string(buf.begin(), buf.end()));
+    std::string streamed;
+    assert_true(roaring64_bitmap_portable_serialize_stream(r, append_chunks,
+                                                           &streamed) == size);
+    assert_true(streamed == map_out.str());
+
+    // Parallel reads split the inner bitmaps, or the containers of each inner
+    // bitmap when there are more partitions than inner bitmaps.
+    roaring::api::roaring_executor inline_executor =
+        [](void *, roaring::api::roaring_task task, void *arg, size_t count) {
+            for (size_t i = 0; i < count; i++) task(arg, i);
+        };
+    for (size_t partitions : {size_t(1), size_t(3), size_t(100000)}) {
+        Roaring64Map parallel = Roaring64Map::readSafe(
+            buf.data(), buf.size(), partitions, inline_executor, nullptr);
+        assert_true(parallel == map);
+    }
+
+    roaring64_bitmap_t *r2 =
+        roaring64_bitmap_portable_deserialize_safe(map_buf.data(),
+                                                   map_buf.size());
+    assert_non_null(r2);
+    assert_true(roaring64_bitmap_equals(r, r2));
+    roaring64_bitmap_free(r2);
+
+    // Truncated input is rejected.
+    for (size_t len : {size_t(0), size_t(7), size_t(12), size - 1}) {
+        assert_null(roaring64_bitmap_portable_deserialize_safe(buf.data(), len));
+    }
+    roaring64_bitmap_free(r);
+}
+
+// Fails every allocation once `alloc_budget` allocations have succeeded; a
+// negative budget never fails.
+int alloc_budget = -1;
+
+bool alloc_allowed() {
+    if (alloc_budget < 0) return true;
+    if (alloc_budget == 0) return false;
+    alloc_budget--;
+    return true;
+}
+
+void *counting_malloc(size_t size) {
+    return alloc_allowed() ? malloc(size) : NULL;
+}
+
+void *counting_calloc(size_t count, size_t size) {
+    return alloc_allowed() ? calloc(count, size) : NULL;
+}
+
+void *counting_aligned_malloc(size_t alignment, size_t size) {
+    void *p = NULL;
+    if (alloc_allowed() && posix_memalign(&p, alignment, size) != 0) p = NULL;
+    return p;
+}
+
+void use_counting_allocator(bool counting) {
+    roaring_memory_t hook = {counting_malloc, realloc, counting_calloc, free,
+                             counting_aligned_malloc, free};
+    if (!counting) {
+        hook.malloc = malloc;
+        hook.calloc = calloc;
+        hook.aligned_malloc = [](size_t alignment, size_t size) -> void * {
+            void *p = NULL;
+            return posix_memalign(&p, alignment, size) == 0 ? p : NULL;
+        };
+    }
+    roaring_init_memory_hook(hook);
+}
+
+// Runs `op` with growing allocation budgets, until one is enough. Every
+// failure must return NULL without leaking (checked by the sanitizers).
+template <typename Op>
+void check_allocation_failures(Op op, const roaring64_bitmap_t *expected) {
+    use_counting_allocator(true);
+    for (int budget = 0;; budget++) {
+        alloc_budget = budget;
+        roaring64_bitmap_t *r = op();
+        alloc_budget = -1;
+        if (r != NULL) {
+            assert_true(roaring64_bitmap_equals(r, expected));
+            roaring64_bitmap_free(r);
+            break;
+        }
+    }
+    use_counting_allocator(false);
+}
+
+#ifndef _WIN32
+// The bitmap, leaf, inner node and iterator allocations are covered; the set
+// operations are left out because the container operations do not handle failures.
+DEFINE_TEST(allocation_failures) {
+    const uint64_t base = 0x123456780000ULL;
+    roaring64_bitmap_t *array = roaring64_bitmap_create();
+    roaring64_bitmap_add(array, base + 1);
+    roaring64_bitmap_add(array, base + 5);
+    roaring64_bitmap_t *bitset = roaring64_bitmap_create();
+    for (uint64_t v = base; v < base + 60000; v += 3) {
+        roaring64_bitmap_add(bitset, v);
+    }
+
+    // 300 keys under one prefix and a few others elsewhere, so that the tree
+    // has inner nodes of every size and prefixes that must be split
+    roaring64_bitmap_t *wide = roaring64_bitmap_create();
+    for (uint64_t key = 0; key < 300; key++) {
+        roaring64_bitmap_add(wide, base + (key << 16) + key);
+    }
+    for (uint64_t key = 1; key < 5; key++) {
+        roaring64_bitmap_add(wide, key << 40);
+    }
+
+    roaring64_bitmap_t *empty = roaring64_bitmap_create();
+    check_allocation_failures([] { return roaring64_bitmap_create(); }, empty);
+    roaring64_bitmap_free(empty);
+    check_allocation_failures([&] { return roaring64_bitmap_copy(array); },
+                              array);
+    check_allocation_failures([&] { return roaring64_bitmap_copy(bitset); },
+                              bitset);
+
+    std::vector<char> buf(roaring64_bitmap_portable_size_in_bytes(bitset));
+    roaring64_bitmap_portable_serialize(bitset, buf.data());
+    check_allocation_failures(
+        [&] {
+            return roaring64_bitmap_portable_deserialize_safe(buf.data(),
+                                                              buf.size());
+        },
+        bitset);
+
+    check_allocation_failures([&] { return roaring64_bitmap_copy(wide); },
+                              wide);
+    buf.resize(roaring64_bitmap_portable_size_in_bytes(wide));
+    roaring64_bitmap_portable_serialize(wide, buf.data());
+    check_allocation_failures(
+        [&] {
+            return roaring64_bitmap_portable_deserialize_safe(buf.data(),
+                                                              buf.size());
+        },
+        wide);
+
+    use_counting_allocator(true);
+    alloc_budget = 0;
+    assert_null(roaring64_iterator_create(wide));
+    assert_null(roaring64_iterator_create_last(wide));
+    alloc_budget = 1;
+    roaring64_iterator_t *it = roaring64_iterator_create(wide);
+    assert_non_null(it);
+    assert_null(roaring64_iterator_copy(it));
+    alloc_budget = -1;
+    roaring64_iterator_free(it);
+    use_counting_allocator(false);
+
+    roaring64_bitmap_free(array);
+    roaring64_bitmap_free(bitset);
+    roaring64_bitmap_free(wide);
+}
+#endif
+
+}  // namespace
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(add_contains_remove),
+        cmocka_unit_test(ranges),
+        cmocka_unit_test(rank_select_min_max),
+        cmocka_unit_test(set_operations),
+        cmocka_unit_test(iterators),
+        cmocka_unit_test(portable_serialization),
+#ifndef _WIN32
+        cmocka_unit_test(allocation_failures),
+#endif
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,263 @@
+/**
+ * Copy-on-write bitmaps share reference-counted containers. This test copies,
+ * modifies and frees such bitmaps from several threads at once, and runs the
+ * parallel operations on a real thread-per-task executor.
+ */
+
+#include <roaring/roaring.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "roaring.hh"
+using roaring::Roaring;
+
+#include "test.h"
+
+namespace {
+
+const int num_threads = 8;
+const int num_rounds = 200;
+
+// Array, bitset and run containers, all shared once the bitmap is copied.
+roaring_bitmap_t *make_cow_bitmap() {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_bitmap_set_copy_on_write(r, true);
+    for (uint32_t key = 0; key < 64; key++) {
+        uint32_t base = key << 16;
+        switch (key % 3) {
+            case 0:  // array
+                for (uint32_t i = 0; i < 1000; i++) {
+                    roaring_bitmap_add(r, base + 7 * i);
+                }
+                break;
+            case 1:  // bitset
+                for (uint32_t i = 0; i < 20000; i++) {
+                    roaring_bitmap_add(r, base + 3 * i);
+                }
+                break;
+            default:  // run
+                roaring_bitmap_add_range(r, base + 100, base + 60000);
+                break;
+        }
+    }
+    roaring_bitmap_run_optimize(r);
+    return r;
+}
+
+// Every thread takes copies of the same shared snapshot, reads them,
+// modifies some (which extracts private containers) and frees them.
+DEFINE_TEST(concurrent_copy_and_free) {
+    roaring_bitmap_t *snapshot = make_cow_bitmap();
+    roaring_bitmap_t *reference = roaring_bitmap_copy(snapshot);
+    const uint64_t cardinality = roaring_bitmap_get_cardinality(snapshot);
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(num_threads, 0);
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < num_rounds; round++) {
+                roaring_bitmap_t *copy = roaring_bitmap_copy(snapshot);
+                if (roaring_bitmap_get_cardinality(copy) != cardinality) {
+                    failures[t]++;
+                }
+                if (round % 2 == 0) {
+                    uint32_t key = (uint32_t)((t + round) % 64);
+                    roaring_bitmap_remove(copy, (key << 16) + 100);
+                    roaring_bitmap_add(copy, (key << 16) + 1);
+                    if (!roaring_bitmap_contains(copy, (key << 16) + 1)) {
+                        failures[t]++;
+                    }
+                }
+                roaring_bitmap_t *second = roaring_bitmap_copy(copy);
+                roaring_bitmap_free(copy);
+                if (round % 3 == 0) {
+                    roaring_bitmap_add_range(second, 0, 1 << 20);
+                }
+                roaring_bitmap_free(second);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < num_threads; t++) {
+        assert_int_equal(failures[t], 0);
+    }
+    assert_true(roaring_bitmap_equals(snapshot, reference));
+    roaring_bitmap_free(snapshot);
+    assert_true(roaring_bitmap_get_cardinality(reference) == cardinality);
+    roaring_bitmap_free(reference);
+}
+
+// Copies made on one thread are released by several threads at once, so the
+// last reference to each shared container is dropped concurrently.
+DEFINE_TEST(concurrent_release) {
+    for (int round = 0; round < 20; round++) {
+        roaring_bitmap_t *snapshot = make_cow_bitmap();
+        std::vector<roaring_bitmap_t *> copies;
+        for (int t = 0; t < num_threads; t++) {
+            copies.push_back(roaring_bitmap_copy(snapshot));
+        }
+        roaring_bitmap_free(snapshot);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&copies, t]() {
+                roaring_bitmap_flip_inplace(copies[t], 0, 1 << 18);
+                roaring_bitmap_free(copies[t]);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+DEFINE_TEST(concurrent_cpp_copies) {
+    Roaring snapshot;
+    snapshot.setCopyOnWrite(true);
+    snapshot.addRange(0, 1 << 20);
+    for (uint32_t i = 0; i < (1 << 20); i += 5) {
+        snapshot.remove(i);
+    }
+    const Roaring reference = snapshot;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&snapshot, t]() {
+            for (int round = 0; round < num_rounds; round++) {
+                Roaring copy(snapshot);
+                copy.add(5 * (uint32_t)(t + round));
+                Roaring other = copy;
+                other.flip(0, 1 << 16);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert_true(snapshot == reference);
+}
+
+// Runs every task on its own thread, so the tasks really run concurrently.
+// The context counts the tasks.
+void thread_executor(void *context, roaring_task task, void *arg,
+                     size_t count) {
+    static_cast<std::atomic<size_t> *>(context)->fetch_add(count);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back([task, arg, i]() { task(arg, i); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// The inputs share their containers with each other (copy-on-write), so
+// the tasks of the parallel or/and adjust the same reference counts.
+DEFINE_TEST(parallel_or_and_many) {
+    const size_t number = 6;
+    roaring_bitmap_t *snapshot = make_cow_bitmap();
+    std::vector<roaring_bitmap_t *> owned;
+    std::vector<const roaring_bitmap_t *> inputs;
+    for (size_t i = 0; i < number; i++) {
+        roaring_bitmap_t *copy = roaring_bitmap_copy(snapshot);
+        // a private container per input, and one key only some inputs have
+        roaring_bitmap_add(copy, (uint32_t)(i << 16) + 5);
+        roaring_bitmap_add(copy, (uint32_t)((100 + i % 2) << 16));
+        owned.push_back(copy);
+        inputs.push_back(copy);
+    }
+    roaring_bitmap_t *reference = roaring_bitmap_copy(snapshot);
+    roaring_bitmap_t *expected_or =
+        roaring_bitmap_or_many(number, inputs.data());
+    roaring_bitmap_t *expected_and = roaring_bitmap_copy(inputs[0]);
+    for (size_t i = 1; i < number; i++) {
+        roaring_bitmap_and_inplace(expected_and, inputs[i]);
+    }
+
+    for (int round = 0; round < 20; round++) {
+        const size_t partitions = 1 + (size_t)round % num_threads;
+        std::atomic<size_t> tasks(0);
+        roaring_bitmap_t *r = roaring_bitmap_or_many_parallel(
+            number, inputs.data(), partitions, thread_executor, &tasks);
+        assert_non_null(r);
+        assert_true(roaring_bitmap_equals(r, expected_or));
+        assert_true(tasks.load() <= partitions);
+        roaring_bitmap_t *a = roaring_bitmap_and_many_parallel(
+            number, inputs.data(), partitions, thread_executor, &tasks);
+        assert_non_null(a);
+        assert_true(roaring_bitmap_equals(a, expected_and));
+        // release the results concurrently with a copy of the inputs
+        std::thread releaser([r, a]() {
+            roaring_bitmap_free(r);
+            roaring_bitmap_free(a);
+        });
+        roaring_bitmap_free(roaring_bitmap_copy(inputs[round % number]));
+        releaser.join();
+    }
+
+    roaring_bitmap_free(expected_or);
+    roaring_bitmap_free(expected_and);
+    for (roaring_bitmap_t *copy : owned) {
+        roaring_bitmap_free(copy);
+    }
+    assert_true(roaring_bitmap_equals(snapshot, reference));
+    roaring_bitmap_free(snapshot);
+    roaring_bitmap_free(reference);
+}
+
+DEFINE_TEST(parallel_deserialize) {
+    roaring_bitmap_t *r = make_cow_bitmap();
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    roaring_bitmap_add_range(copy, 70 << 16, 75 << 16);
+    const size_t size = roaring_bitmap_portable_size_in_bytes(copy);
+    std::vector<char> buf(size);
+    assert_int_equal(roaring_bitmap_portable_serialize(copy, buf.data()), size);
+
+    std::vector<std::thread> readers;
+    std::vector<int> failures(num_threads, 0);
+    for (int t = 0; t < num_threads; t++) {
+        // several parallel deserializations at once, each on its own threads
+        readers.emplace_back([&, t]() {
+            std::atomic<size_t> tasks(0);
+            const size_t partitions = 2 + (size_t)t;
+            roaring_bitmap_t *d = roaring_bitmap_portable_deserialize_parallel(
+                buf.data(), size, partitions, thread_executor, &tasks);
+            if (d == NULL || !roaring_bitmap_equals(d, copy) ||
+                tasks.load() > partitions) {
+                failures[t]++;
+            }
+            roaring_bitmap_free(d);
+            // a truncated buffer is rejected
+            if (roaring_bitmap_portable_deserialize_parallel(
+                    buf.data(), size - 1, partitions, thread_executor,
+                    &tasks) != NULL) {
+                failures[t]++;
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (int t = 0; t < num_threads; t++) {
+        assert_int_equal(failures[t], 0);
+    }
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(r);
+}
+
+}  // namespace
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(concurrent_copy_and_free),
+        cmocka_unit_test(concurrent_release),
+        cmocka_unit_test(concurrent_cpp_copies),
+        cmocka_unit_test(parallel_or_and_many),
+        cmocka_unit_test(parallel_deserialize),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
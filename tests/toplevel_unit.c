@@ -1,3 +1,7 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // for fileno()
+#endif
+
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -709,6 +713,12 @@ void test_example(bool copy_on_write) {
     assert_true(roaring_bitmap_get_cardinality(i1_2) ==
                 roaring_bitmap_and_cardinality(r1, r2));
 
+    // we can compute a big intersection
+    roaring_bitmap_and_inplace(i1_2, r3);
+    roaring_bitmap_t *bigintersection = roaring_bitmap_and_many(3, allmybitmaps);
+    assert_true(roaring_bitmap_equals(i1_2, bigintersection));
+
+    roaring_bitmap_free(bigintersection);
     roaring_bitmap_free(i1_2);
 
     // we can write a bitmap to a pointer and recover it later
@@ -953,6 +963,110 @@ DEFINE_TEST(test_addremove_bulk) {
     roaring_bitmap_free(bm);
 }
 
+DEFINE_TEST(test_add_many_unsorted) {
+    // Large unsorted batches are radix partitioned: check them against
+    // roaring_bitmap_add() on a bitmap with every container type, and with
+    // batches spanning several partitioning chunks.
+    const size_t n = 150000;
+    uint32_t *vals = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint32_t masks[] = {0xFFFFFFFF, 0x3FFFFF, 0x3FFFF};
+    for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); m++) {
+        roaring_bitmap_t *r1 = roaring_bitmap_create();
+        roaring_bitmap_add_range(r1, 0, 70000);
+        for (uint32_t v = 100000; v < 200000; v += 3) {
+            roaring_bitmap_add(r1, v);
+        }
+        roaring_bitmap_add(r1, 300000);
+        roaring_bitmap_run_optimize(r1);
+        roaring_bitmap_t *r2 = roaring_bitmap_copy(r1);
+        for (size_t i = 0; i < n; i++) {
+            vals[i] = (uint32_t)rand() * 2654435761u & masks[m];
+        }
+        roaring_bitmap_add_many(r1, n, vals);
+        for (size_t i = 0; i < n; i++) {
+            roaring_bitmap_add(r2, vals[i]);
+        }
+        assert_true(roaring_bitmap_equals(r1, r2));
+        // with the same container types
+        for (int32_t i = 0; i < r1->high_low_container.size; i++) {
+            assert_int_equal(r1->high_low_container.typecodes[i],
+                             r2->high_low_container.typecodes[i]);
+        }
+        roaring_bitmap_free(r1);
+        roaring_bitmap_free(r2);
+    }
+    free(vals);
+}
+
+static int compare_uint32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void check_contains_many(const roaring_bitmap_t *r,
+                                const uint32_t *vals, size_t n) {
+    uint64_t *mask = (uint64_t *)malloc(((n + 63) / 64) * sizeof(uint64_t));
+    uint32_t *filtered = (uint32_t *)malloc(n * sizeof(uint32_t));
+    roaring_bitmap_contains_many(r, vals, n, mask);
+    size_t count = roaring_bitmap_filter_array(r, vals, n, filtered);
+    size_t expected_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        bool expected = roaring_bitmap_contains(r, vals[i]);
+        assert_true(((mask[i / 64] >> (i % 64)) & 1) == expected);
+        if (expected) {
+            assert_true(expected_count < count);
+            assert_int_equal(filtered[expected_count++], vals[i]);
+        }
+    }
+    assert_int_equal(count, expected_count);
+
+    // in place
+    memcpy(filtered, vals, n * sizeof(uint32_t));
+    assert_int_equal(roaring_bitmap_filter_array(r, filtered, n, filtered),
+                     count);
+    free(filtered);
+    free(mask);
+}
+
+DEFINE_TEST(test_contains_many) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t v = 0; v < 65536; v += 7) roaring_bitmap_add(r, v);
+    for (uint32_t v = 65536; v < 2 * 65536; v += 2) roaring_bitmap_add(r, v);
+    roaring_bitmap_add_range(r, 3 * 65536 + 100, 3 * 65536 + 5000);
+    roaring_bitmap_add_range(r, 3 * 65536 + 6000, 3 * 65536 + 7000);
+    for (uint32_t v = 4 * 65536; v < 5 * 65536; v += 300) {
+        // enough runs for the binary search over runs
+        roaring_bitmap_add_range(r, v, v + 100);
+    }
+    roaring_bitmap_add(r, UINT32_MAX);
+    roaring_bitmap_run_optimize(r);
+
+    // more than one chunk of 64k probes
+    const size_t n = 70000;
+    uint32_t *vals = (uint32_t *)malloc(n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+        // keys 0 to 4, so runs of equal keys are short when unsorted
+        vals[i] = (uint32_t)rand() % (5 * 65536);
+    }
+    vals[0] = UINT32_MAX;
+    vals[1] = 3 * 65536 + 7000;
+    vals[2] = vals[3];
+    check_contains_many(r, vals, n);
+    check_contains_many(r, vals, 2000);
+    check_contains_many(r, vals, 1);
+    check_contains_many(r, vals, 0);
+    qsort(vals, n, sizeof(uint32_t), compare_uint32);
+    check_contains_many(r, vals, n);
+
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    check_contains_many(empty, vals, n);
+    roaring_bitmap_free(empty);
+
+    free(vals);
+    roaring_bitmap_free(r);
+}
+
 DEFINE_TEST(test_addremoverun) {
     roaring_bitmap_t *bm = roaring_bitmap_create();
     for (uint32_t value = 33057; value < 147849; value += 8) {
@@ -1065,6 +1179,95 @@ DEFINE_TEST(test_bitmap_from_range) {
     roaring_bitmap_free(r);
 }
 
+static void check_from_sorted(const uint32_t *vals, size_t n) {
+    roaring_bitmap_t *expected = roaring_bitmap_of_ptr(n, vals);
+    roaring_bitmap_run_optimize(expected);
+    roaring_bitmap_t *r = roaring_bitmap_from_sorted(vals, n);
+    assert_non_null(r);
+    assert_true(roaring_bitmap_equals(r, expected));
+    assert_int_equal(r->high_low_container.size,
+                     expected->high_low_container.size);
+    for (int32_t i = 0; i < r->high_low_container.size; i++) {
+        assert_int_equal(r->high_low_container.typecodes[i],
+                         expected->high_low_container.typecodes[i]);
+    }
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_from_sorted) {
+    const size_t max_n = 3 * 65536;
+    uint32_t *vals = (uint32_t *)malloc(max_n * sizeof(uint32_t));
+    size_t n;
+
+    check_from_sorted(NULL, 0);
+
+    // sparse values, one per container, up to UINT32_MAX
+    n = 0;
+    for (uint64_t v = 5; v <= UINT32_MAX; v += 70001) vals[n++] = (uint32_t)v;
+    vals[n++] = UINT32_MAX;
+    check_from_sorted(vals, n);
+
+    // arrays, bitsets and runs, with duplicates
+    n = 0;
+    for (uint32_t v = 0; v < 65536; v += 17) vals[n++] = v;
+    for (uint32_t v = 65536; v < 2 * 65536; v += 3) {
+        vals[n++] = v;
+        if (v % 2 == 0) vals[n++] = v;
+    }
+    for (uint32_t v = 2 * 65536 + 10; v < 2 * 65536 + 30000; v++) {
+        vals[n++] = v;
+    }
+    for (uint32_t v = 3 * 65536; v < 3 * 65536 + 20000; v += 2) {
+        vals[n++] = v;
+    }
+    vals[n++] = 3 * 65536 + 19998;  // duplicate at the end of an array
+    check_from_sorted(vals, n);
+
+    // a full container
+    for (n = 0; n < 65536; n++) vals[n] = (uint32_t)(65536 * 7 + n);
+    check_from_sorted(vals, n);
+
+    // unsorted input falls back on the generic path
+    n = 0;
+    for (uint32_t v = 0; v < 1000; v++) vals[n++] = v * 997 % 1000;
+    vals[n++] = 300000;
+    vals[n++] = 5;
+    roaring_bitmap_t *expected = roaring_bitmap_of_ptr(n, vals);
+    roaring_bitmap_t *r = roaring_bitmap_from_sorted(vals, n);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+
+    free(vals);
+}
+
+DEFINE_TEST(test_from_sorted_trailing_duplicate) {
+    // array containers are allocated with exactly their cardinality, so a
+    // duplicate at the end of a chunk must not be written out again
+    uint32_t vals[64];
+    size_t n = 0;
+    for (uint32_t v = 0; v < 20; v += 2) vals[n++] = v;
+    vals[n++] = 18;
+    check_from_sorted(vals, n);  // input ends with a duplicate
+    roaring_bitmap_t *r = roaring_bitmap_from_sorted(vals, n);
+    const array_container_t *ac =
+        const_CAST_array(r->high_low_container.containers[0]);
+    assert_int_equal(ac->cardinality, 10);
+    assert_int_equal(ac->array[ac->cardinality - 1], 18);
+    roaring_bitmap_free(r);
+
+    vals[n++] = 18;
+    vals[n++] = 18;
+    check_from_sorted(vals, n);  // several trailing duplicates
+    vals[n++] = 65536 + 1;
+    vals[n++] = 65536 + 1;
+    check_from_sorted(vals, n);  // also at the end of an inner chunk
+
+    vals[0] = vals[1] = vals[2] = 7;
+    check_from_sorted(vals, 3);  // a single value, repeated
+}
+
 DEFINE_TEST(test_printf) {
     roaring_bitmap_t *r1 =
         roaring_bitmap_of(8, 1, 2, 3, 100, 1000, 10000, 1000000, 20000000);
@@ -1163,6 +1366,295 @@ DEFINE_TEST(test_iterate_withrun) {
     roaring_bitmap_free(r1);
 }
 
+typedef struct span_counts_s {
+    roaring_bitmap_t *rebuilt;
+    uint32_t types[4];
+    uint32_t visited;
+    uint32_t stop_after;
+} span_counts_t;
+
+static bool span_visitor(const roaring_container_span_t *span, void *param) {
+    span_counts_t *counts = (span_counts_t *)param;
+    uint32_t high = (uint32_t)span->key << 16;
+    uint32_t card = 0;
+    switch (span->type) {
+        case ROARING_SPAN_BITSET:
+            assert_true(span->array == NULL && span->runs == NULL);
+            assert_int_equal(span->length, 1024);
+            for (uint32_t i = 0; i < span->length; i++) {
+                for (uint32_t b = 0; b < 64; b++) {
+                    if ((span->words[i] >> b) & 1) {
+                        roaring_bitmap_add(counts->rebuilt, high + i * 64 + b);
+                        card++;
+                    }
+                }
+            }
+            break;
+        case ROARING_SPAN_ARRAY:
+            assert_true(span->words == NULL && span->runs == NULL);
+            for (uint32_t i = 0; i < span->length; i++) {
+                roaring_bitmap_add(counts->rebuilt, high + span->array[i]);
+            }
+            card = span->length;
+            break;
+        case ROARING_SPAN_RUN:
+            assert_true(span->words == NULL && span->array == NULL);
+            for (uint32_t i = 0; i < span->length; i++) {
+                uint32_t start = high + span->runs[i].value;
+                roaring_bitmap_add_range_closed(
+                    counts->rebuilt, start, start + span->runs[i].length);
+                card += span->runs[i].length + 1;
+            }
+            break;
+    }
+    assert_int_equal(span->cardinality, card);
+    counts->types[span->type]++;
+    return ++counts->visited != counts->stop_after;
+}
+
+DEFINE_TEST(test_visit_containers) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add(r, 3 * i);                  // array
+        roaring_bitmap_add(r, (5 << 16) + 7 * i + 1);  // array
+    }
+    for (uint32_t i = 0; i < 10000; i++) {
+        roaring_bitmap_add(r, (1 << 16) + 5 * i);  // bitset
+    }
+    roaring_bitmap_add_range(r, 2 << 16, (2 << 16) + 30000);  // run
+    roaring_bitmap_add_range(r, (7 << 16) + 10, (7 << 16) + 20);
+    roaring_bitmap_add_range(r, (7 << 16) + 40, (7 << 16) + 50);
+    roaring_bitmap_run_optimize(r);
+
+    span_counts_t counts;
+    memset(&counts, 0, sizeof(counts));
+    counts.rebuilt = roaring_bitmap_create();
+    assert_true(roaring_visit_containers(r, span_visitor, &counts));
+    assert_true(roaring_bitmap_equals(r, counts.rebuilt));
+    assert_int_equal(counts.visited, 5);
+    assert_int_equal(counts.types[ROARING_SPAN_BITSET], 1);
+    assert_int_equal(counts.types[ROARING_SPAN_ARRAY], 2);
+    assert_int_equal(counts.types[ROARING_SPAN_RUN], 2);
+    roaring_bitmap_free(counts.rebuilt);
+
+    // shared containers are unwrapped
+    roaring_bitmap_set_copy_on_write(r, true);
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    memset(&counts, 0, sizeof(counts));
+    counts.rebuilt = roaring_bitmap_create();
+    assert_true(roaring_visit_containers(copy, span_visitor, &counts));
+    assert_true(roaring_bitmap_equals(r, counts.rebuilt));
+    roaring_bitmap_free(counts.rebuilt);
+
+    // the visitor can stop early
+    memset(&counts, 0, sizeof(counts));
+    counts.rebuilt = roaring_bitmap_create();
+    counts.stop_after = 2;
+    assert_false(roaring_visit_containers(copy, span_visitor, &counts));
+    assert_int_equal(counts.visited, 2);
+    roaring_bitmap_free(counts.rebuilt);
+
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    memset(&counts, 0, sizeof(counts));
+    assert_true(roaring_visit_containers(empty, span_visitor, &counts));
+    assert_int_equal(counts.visited, 0);
+    roaring_bitmap_free(empty);
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(r);
+}
+
+typedef struct range_list_s {
+    uint32_t count;
+    uint32_t stop_after;
+    uint32_t starts[4096];
+    uint64_t ends[4096];
+} range_list_t;
+
+static bool range_collector(uint32_t start, uint64_t end, void *param) {
+    range_list_t *list = (range_list_t *)param;
+    assert_true(list->count < 4096);
+    list->starts[list->count] = start;
+    list->ends[list->count] = end;
+    return ++list->count != list->stop_after;
+}
+
+// Checks both range APIs against the intervals found in the values.
+static void check_ranges(const roaring_bitmap_t *r) {
+    range_list_t expected;
+    expected.count = 0;
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(r, &it);
+    while (it.has_value) {
+        uint64_t end = (uint64_t)it.current_value + 1;
+        if (expected.count > 0 &&
+            expected.ends[expected.count - 1] == it.current_value) {
+            expected.ends[expected.count - 1] = end;
+        } else {
+            range_collector(it.current_value, end, &expected);
+        }
+        roaring_advance_uint32_iterator(&it);
+    }
+
+    range_list_t actual;
+    actual.count = 0;
+    actual.stop_after = 0;
+    assert_true(roaring_iterate_ranges(r, range_collector, &actual));
+    assert_int_equal(actual.count, expected.count);
+    roaring_uint32_range_iterator_t rit;
+    roaring_init_range_iterator(r, &rit);
+    for (uint32_t i = 0; i < expected.count; i++) {
+        assert_int_equal(actual.starts[i], expected.starts[i]);
+        assert_true(actual.ends[i] == expected.ends[i]);
+        assert_true(rit.has_value);
+        assert_int_equal(rit.start, expected.starts[i]);
+        assert_true(rit.end == expected.ends[i]);
+        roaring_advance_range_iterator(&rit);
+    }
+    assert_false(rit.has_value);
+
+    if (expected.count > 1) {
+        actual.count = 0;
+        actual.stop_after = 1;
+        assert_false(roaring_iterate_ranges(r, range_collector, &actual));
+        assert_int_equal(actual.count, 1);
+    }
+}
+
+DEFINE_TEST(test_iterate_ranges) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    check_ranges(r);
+
+    // arrays with short runs
+    for (uint32_t i = 0; i < 300; i++) {
+        roaring_bitmap_add(r, i % 4 == 3 ? i * 2 : i);
+    }
+    check_ranges(r);
+
+    // bitsets with runs that cross words
+    for (uint32_t i = 0; i < 65000; i += 37) {
+        roaring_bitmap_add_range(r, (1 << 16) + i, (1 << 16) + i + (i % 30));
+    }
+    roaring_bitmap_add_range(r, (3 << 16) - 100, (3 << 16) - 64);
+    check_ranges(r);
+
+    // a run through three containers, the middle one full, then a run
+    // container ending the last one and an array starting the next one
+    roaring_bitmap_add_range(r, (5 << 16) + 50000, (7 << 16) + 10);
+    roaring_bitmap_add_range(r, (8 << 16) + 100, 9 << 16);
+    roaring_bitmap_add(r, 9 << 16);
+    roaring_bitmap_add(r, (9 << 16) + 1);
+    check_ranges(r);
+    // ranges were added as run containers, check arrays and bitsets too
+    roaring_bitmap_remove_run_compression(r);
+    roaring_statistics_t stats;
+    roaring_bitmap_statistics(r, &stats);
+    assert_int_equal(stats.n_run_containers, 0);
+    assert_true(stats.n_bitset_containers > 3);
+    check_ranges(r);
+    roaring_bitmap_run_optimize(r);
+    check_ranges(r);
+
+    // a bitset ending its container followed by an adjacent one
+    roaring_bitmap_t *b = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 65536; i += 64) {
+        roaring_bitmap_add_range(b, (20 << 16) + i, (20 << 16) + i + 40);
+    }
+    roaring_bitmap_add(b, (21 << 16) - 1);
+    roaring_bitmap_add_range(b, 21 << 16, (21 << 16) + 3);
+    roaring_bitmap_remove_run_compression(b);
+    check_ranges(b);
+    roaring_bitmap_free(b);
+
+    // up to the largest value, with shared containers
+    roaring_bitmap_add_range(r, UINT64_C(0xFFFF0000) - 5, UINT64_C(1) << 32);
+    roaring_bitmap_set_copy_on_write(r, true);
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    check_ranges(copy);
+    range_list_t all;
+    all.count = 0;
+    all.stop_after = 0;
+    roaring_iterate_ranges(copy, range_collector, &all);
+    assert_true(all.ends[all.count - 1] == (UINT64_C(1) << 32));
+    assert_int_equal(all.starts[all.count - 1], 0xFFFF0000 - 5);
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(r);
+}
+
+// The adaptive result must hold the same values as the plain one, with
+// the container types that roaring_bitmap_run_optimize() would pick.
+static void check_adaptive(const roaring_bitmap_t *adaptive,
+                           const roaring_bitmap_t *plain) {
+    assert_true(roaring_bitmap_get_adaptive_containers(adaptive));
+    assert_true(roaring_bitmap_equals(adaptive, plain));
+    roaring_bitmap_t *optimized = roaring_bitmap_copy(plain);
+    roaring_bitmap_run_optimize(optimized);
+    assert_int_equal(roaring_bitmap_portable_size_in_bytes(adaptive),
+                     roaring_bitmap_portable_size_in_bytes(optimized));
+    roaring_bitmap_free(optimized);
+}
+
+DEFINE_TEST(test_adaptive_containers) {
+    roaring_bitmap_t *x1 = roaring_bitmap_create();
+    roaring_bitmap_t *x2 = roaring_bitmap_create();
+    // two bitsets whose union is full: a bitset unless adaptive
+    for (uint32_t i = 0; i < 65536; i += 2) {
+        roaring_bitmap_add(x1, i);
+        roaring_bitmap_add(x2, i + 1);
+    }
+    // bitsets with long runs, whose intersection and xor are runs too
+    for (uint32_t i = 0; i < 65536; i += 1000) {
+        roaring_bitmap_add_range(x1, (1 << 16) + i, (1 << 16) + i + 700);
+        roaring_bitmap_add_range(x2, (1 << 16) + i + 300, (1 << 16) + i + 999);
+    }
+    // arrays whose union is a single run, array and run
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add(x1, (2 << 16) + 2 * i);
+        roaring_bitmap_add(x2, (2 << 16) + 2 * i + 1);
+    }
+    roaring_bitmap_add_range(x1, (3 << 16) + 10, (3 << 16) + 5000);
+    for (uint32_t i = 0; i < 1000; i += 3) {
+        roaring_bitmap_add(x2, (3 << 16) + 4000 + i);
+    }
+    // keys present in one input only
+    roaring_bitmap_add(x1, 5 << 16);
+    roaring_bitmap_add_range(x2, 6 << 16, (6 << 16) + 10);
+    roaring_bitmap_remove_run_compression(x1);
+
+    roaring_bitmap_t *plain_or = roaring_bitmap_or(x1, x2);
+    roaring_bitmap_t *plain_and = roaring_bitmap_and(x1, x2);
+    roaring_bitmap_t *plain_xor = roaring_bitmap_xor(x1, x2);
+    assert_false(roaring_bitmap_get_adaptive_containers(plain_or));
+
+    roaring_bitmap_set_adaptive_containers(x2, true);
+    roaring_bitmap_t *adaptive_or = roaring_bitmap_or(x1, x2);
+    roaring_bitmap_t *adaptive_and = roaring_bitmap_and(x1, x2);
+    roaring_bitmap_t *adaptive_xor = roaring_bitmap_xor(x2, x1);
+    check_adaptive(adaptive_or, plain_or);
+    check_adaptive(adaptive_and, plain_and);
+    check_adaptive(adaptive_xor, plain_xor);
+    assert_true(roaring_bitmap_portable_size_in_bytes(adaptive_or) <
+                roaring_bitmap_portable_size_in_bytes(plain_or));
+
+    // the flag carries over to copies and further results
+    roaring_bitmap_t *copy = roaring_bitmap_copy(adaptive_or);
+    assert_true(roaring_bitmap_get_adaptive_containers(copy));
+    roaring_bitmap_t *again = roaring_bitmap_and(copy, x1);
+    roaring_bitmap_t *plain_again = roaring_bitmap_and(plain_or, x1);
+    check_adaptive(again, plain_again);
+
+    roaring_bitmap_free(again);
+    roaring_bitmap_free(plain_again);
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(adaptive_or);
+    roaring_bitmap_free(adaptive_and);
+    roaring_bitmap_free(adaptive_xor);
+    roaring_bitmap_free(plain_or);
+    roaring_bitmap_free(plain_and);
+    roaring_bitmap_free(plain_xor);
+    roaring_bitmap_free(x1);
+    roaring_bitmap_free(x2);
+}
+
 DEFINE_TEST(test_remove_withrun) {
     roaring_bitmap_t *r1 = roaring_bitmap_create();
     assert_non_null(r1);
@@ -3477,6 +3969,115 @@ DEFINE_TEST(test_rank) {
     }
 }
 
+DEFINE_TEST(test_rank_index) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_rank_index_t *index = roaring_bitmap_rank_index_create(r);
+    uint32_t element;
+    uint32_t page[100];
+    assert_false(roaring_bitmap_select_indexed(r, index, 0, &element));
+    assert_int_equal(roaring_bitmap_rank_indexed(r, index, 12345), 0);
+    assert_true(
+        roaring_bitmap_range_uint32_array_indexed(r, index, 0, 100, page));
+    roaring_rank_index_free(index);
+
+    // arrays, bitsets and runs, with gaps between the keys
+    for (uint32_t key = 0; key < 300; key += 3) {
+        uint32_t base = key << 16;
+        if (key % 9 == 0) {
+            roaring_bitmap_add_range(r, base + 10, base + 20000);
+        } else if (key % 9 == 3) {
+            for (uint32_t v = 0; v < 65536; v += 3) roaring_bitmap_add(r, base + v);
+        } else {
+            for (uint32_t v = key; v < 65536; v += 997) {
+                roaring_bitmap_add(r, base + v);
+            }
+        }
+    }
+    roaring_bitmap_run_optimize(r);
+    index = roaring_bitmap_rank_index_create(r);
+    uint64_t card = roaring_bitmap_get_cardinality(r);
+    uint32_t *all = (uint32_t *)malloc(card * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(r, all);
+
+    for (uint64_t rank = 0; rank < card; rank += 331) {
+        assert_true(
+            roaring_bitmap_select_indexed(r, index, (uint32_t)rank, &element));
+        assert_int_equal(element, all[rank]);
+        assert_int_equal(roaring_bitmap_rank_indexed(r, index, element),
+                         rank + 1);
+        assert_int_equal(roaring_bitmap_rank_indexed(r, index, element + 1),
+                         roaring_bitmap_rank(r, element + 1));
+        assert_int_equal(roaring_bitmap_rank_indexed(r, index, element + 70000),
+                         roaring_bitmap_rank(r, element + 70000));
+
+        size_t limit = card - rank < 100 ? card - rank : 100;
+        memset(page, 0, sizeof(page));
+        assert_true(roaring_bitmap_range_uint32_array_indexed(r, index, rank,
+                                                              100, page));
+        for (size_t i = 0; i < limit; i++) {
+            assert_int_equal(page[i], all[rank + i]);
+        }
+    }
+    assert_false(
+        roaring_bitmap_select_indexed(r, index, (uint32_t)card, &element));
+    assert_int_equal(roaring_bitmap_rank_indexed(r, index, UINT32_MAX), card);
+    assert_true(
+        roaring_bitmap_range_uint32_array_indexed(r, index, card, 100, page));
+
+    free(all);
+    roaring_rank_index_free(index);
+    roaring_bitmap_free(r);
+}
+
+DEFINE_TEST(test_rank_index_stale) {
+    roaring_bitmap_t *r = roaring_bitmap_from_range(0, 200000, 7);
+    roaring_rank_index_t *index = roaring_bitmap_rank_index_create(r);
+    uint32_t element;
+    uint32_t page[10] = {0};
+    assert_true(roaring_rank_index_is_valid(r, index));
+    assert_true(roaring_bitmap_select_indexed(r, index, 1, &element));
+    assert_int_equal(element, 7);
+
+    // same containers, one more value in the first one
+    roaring_bitmap_add(r, 1);
+    assert_false(roaring_rank_index_is_valid(r, index));
+    assert_false(roaring_bitmap_select_indexed(r, index, 1, &element));
+    assert_int_equal(roaring_bitmap_rank_indexed(r, index, 100000), 0);
+    assert_false(
+        roaring_bitmap_range_uint32_array_indexed(r, index, 0, 10, page));
+    assert_int_equal(page[0], 0);
+    roaring_rank_index_free(index);
+
+    // a new container
+    index = roaring_bitmap_rank_index_create(r);
+    assert_true(roaring_bitmap_select_indexed(r, index, 1, &element));
+    assert_int_equal(element, 1);
+    roaring_bitmap_add(r, 1000000);
+    assert_false(roaring_bitmap_select_indexed(r, index, 1, &element));
+    roaring_rank_index_free(index);
+
+    // removing a value, then adding it back, still invalidates the index
+    index = roaring_bitmap_rank_index_create(r);
+    roaring_bitmap_remove(r, 7);
+    roaring_bitmap_add(r, 7);
+    assert_false(roaring_rank_index_is_valid(r, index));
+    roaring_rank_index_free(index);
+
+    // in-place operations and clearing
+    roaring_bitmap_t *other = roaring_bitmap_from_range(0, 10, 1);
+    index = roaring_bitmap_rank_index_create(r);
+    roaring_bitmap_or_inplace(r, other);
+    assert_false(roaring_rank_index_is_valid(r, index));
+    roaring_rank_index_free(index);
+    index = roaring_bitmap_rank_index_create(r);
+    roaring_bitmap_clear(r);
+    assert_false(roaring_rank_index_is_valid(r, index));
+    roaring_rank_index_free(index);
+
+    roaring_bitmap_free(other);
+    roaring_bitmap_free(r);
+}
+
 // Return a random value which does not belong to the roaring bitmap.
 // Value will be lower than upper_bound.
 uint32_t choose_missing_value(roaring_bitmap_t *rb, uint32_t upper_bound) {
@@ -3571,6 +4172,602 @@ DEFINE_TEST(test_or_many_memory_leak) {
     }
 }
 
+DEFINE_TEST(test_and_many) {
+    // bitmaps sharing some keys but not others, with a mix of container types
+    enum { NUMBER = 8 };
+    roaring_bitmap_t *bitmaps[NUMBER];
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        bitmaps[i] = roaring_bitmap_create();
+        for (uint32_t key = 0; key < 64; key++) {
+            if ((key % (i + 2)) == 1) continue;  // skip some keys
+            uint32_t base = key << 16;
+            switch (key % 3) {
+                case 0:  // array
+                    for (uint32_t v = 0; v < 1000; v++)
+                        roaring_bitmap_add(bitmaps[i], base + v * (i + 3));
+                    break;
+                case 1:  // bitset
+                    for (uint32_t v = 0; v < 65536; v += (i % 3) + 2)
+                        roaring_bitmap_add(bitmaps[i], base + v);
+                    break;
+                case 2:  // run
+                    roaring_bitmap_add_range(bitmaps[i], base + 100 * i,
+                                             base + 40000 + 50 * i);
+                    break;
+            }
+        }
+        roaring_bitmap_run_optimize(bitmaps[i]);
+    }
+
+    for (uint32_t n = 0; n <= NUMBER; n++) {
+        roaring_bitmap_t *expected = n == 0 ? roaring_bitmap_create()
+                                            : roaring_bitmap_copy(bitmaps[0]);
+        for (uint32_t i = 1; i < n; i++) {
+            roaring_bitmap_and_inplace(expected, bitmaps[i]);
+        }
+        roaring_bitmap_t *actual =
+            roaring_bitmap_and_many(n, (const roaring_bitmap_t **)bitmaps);
+        assert_true(roaring_bitmap_equals(expected, actual));
+        roaring_bitmap_free(expected);
+        roaring_bitmap_free(actual);
+    }
+
+    // an empty input empties the result
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    const roaring_bitmap_t *with_empty[] = {bitmaps[0], empty, bitmaps[1]};
+    roaring_bitmap_t *r = roaring_bitmap_and_many(3, with_empty);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(empty);
+
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        roaring_bitmap_free(bitmaps[i]);
+    }
+}
+
+static roaring_bitmap_t *arena_test_bitmap(uint32_t shift) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t key = 0; key < 20; key++) {
+        uint32_t base = key << 16;
+        if ((key + shift) % 3 == 0) {
+            roaring_bitmap_add_range(r, base + shift, base + 30000 + shift);
+        } else {
+            // grows an array container, then converts it to a bitset
+            for (uint32_t v = shift; v < 65536; v += (key % 2) ? 7 : 301) {
+                roaring_bitmap_add(r, base + v);
+            }
+        }
+    }
+    return r;
+}
+
+DEFINE_TEST(test_arena) {
+    roaring_bitmap_t *heap1 = arena_test_bitmap(1);
+    roaring_bitmap_t *heap2 = arena_test_bitmap(2);
+    roaring_bitmap_t *expected_and = roaring_bitmap_and(heap1, heap2);
+    roaring_bitmap_t *expected_or = roaring_bitmap_or(heap1, heap2);
+    roaring_bitmap_t *expected_andnot = roaring_bitmap_andnot(heap1, heap2);
+
+    roaring_arena_t *arena = roaring_arena_create(0);
+    assert_non_null(arena);
+    for (int round = 0; round < 3; round++) {
+        roaring_bitmap_t *heap3 = arena_test_bitmap(3);
+        assert_null(roaring_arena_activate(arena));
+        roaring_bitmap_t *r1 = arena_test_bitmap(1);
+        roaring_bitmap_t *r2 = arena_test_bitmap(2);
+        assert_true(roaring_arena_used(arena) > 0);
+        roaring_bitmap_t *r_and = roaring_bitmap_and(r1, r2);
+        roaring_bitmap_t *r_or = roaring_bitmap_or(r1, r2);
+        roaring_bitmap_t *r_andnot = roaring_bitmap_andnot(r1, r2);
+        roaring_bitmap_or_inplace(r1, heap2);
+        roaring_bitmap_free(r2);  // does nothing
+        // heap memory is still freed by the regular allocator
+        roaring_bitmap_free(heap3);
+        assert_true(roaring_arena_activate(NULL) == arena);
+
+        assert_true(roaring_bitmap_equals(r_and, expected_and));
+        assert_true(roaring_bitmap_equals(r_or, expected_or));
+        assert_true(roaring_bitmap_equals(r_andnot, expected_andnot));
+        assert_true(roaring_bitmap_equals(r1, expected_or));
+        // results can be copied out of the arena before it is reset
+        roaring_bitmap_t *kept = roaring_bitmap_copy(r_or);
+        roaring_arena_reset(arena);
+        assert_int_equal(roaring_arena_used(arena), 0);
+        assert_true(roaring_bitmap_equals(kept, expected_or));
+        roaring_bitmap_free(kept);
+    }
+    roaring_arena_free(arena);
+
+    roaring_bitmap_free(heap1);
+    roaring_bitmap_free(heap2);
+    roaring_bitmap_free(expected_and);
+    roaring_bitmap_free(expected_or);
+    roaring_bitmap_free(expected_andnot);
+}
+
+DEFINE_TEST(test_arena_nested) {
+    roaring_arena_t *outer = roaring_arena_create(0);
+    roaring_arena_t *inner = roaring_arena_create(0);
+    void *heap = roaring_malloc(16);
+
+    assert_null(roaring_arena_activate(outer));
+    roaring_bitmap_t *r_outer = arena_test_bitmap(1);
+    void *p = roaring_malloc(100);
+    assert_true(roaring_arena_activate(inner) == outer);
+    roaring_bitmap_t *r_inner = arena_test_bitmap(2);
+    size_t outer_used = roaring_arena_used(outer);
+    size_t inner_used = roaring_arena_used(inner);
+
+    // memory of the outer arena grows in the outer arena...
+    p = roaring_realloc(p, 10000);
+    assert_non_null(p);
+    memset(p, 1, 10000);
+    assert_true(roaring_arena_used(outer) > outer_used);
+    assert_int_equal(roaring_arena_used(inner), inner_used);
+    // ...and freeing it does nothing, as for the inner arena
+    roaring_free(p);
+    roaring_bitmap_free(r_outer);
+    roaring_bitmap_free(r_inner);
+    // heap memory stays on the heap
+    heap = roaring_realloc(heap, 10000);
+    assert_non_null(heap);
+    assert_int_equal(roaring_arena_used(inner), inner_used);
+    roaring_free(heap);
+
+    assert_true(roaring_arena_activate(outer) == inner);
+    // the inner arena is no longer active, so this comes from the outer one
+    outer_used = roaring_arena_used(outer);
+    roaring_bitmap_free(arena_test_bitmap(3));
+    assert_true(roaring_arena_used(outer) > outer_used);
+    assert_true(roaring_arena_activate(NULL) == outer);
+
+    roaring_arena_free(inner);
+    roaring_arena_free(outer);
+}
+
+DEFINE_TEST(test_arena_deactivated) {
+    // bitmaps built in an arena can still be freed once it is deactivated
+    roaring_arena_t *arena = roaring_arena_create(0);
+    roaring_arena_activate(arena);
+    roaring_bitmap_t *r = arena_test_bitmap(1);
+    roaring_arena_activate(NULL);
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    assert_true(roaring_bitmap_equals(copy, r));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(copy);
+
+    // deep nesting restores every enclosing arena in turn
+    enum { DEPTH = 40 };
+    roaring_arena_t *arenas[DEPTH];
+    void *blocks[DEPTH];
+    for (int i = 0; i < DEPTH; i++) {
+        arenas[i] = roaring_arena_create(0);
+        roaring_arena_t *previous = roaring_arena_activate(arenas[i]);
+        assert_true(previous == (i == 0 ? NULL : arenas[i - 1]));
+        blocks[i] = roaring_malloc(64);
+    }
+    for (int i = DEPTH - 1; i >= 0; i--) {
+        size_t used = roaring_arena_used(arenas[i]);
+        blocks[i] = roaring_realloc(blocks[i], 128);  // stays in its arena
+        assert_true(roaring_arena_used(arenas[i]) > used);
+        roaring_free(blocks[i]);
+        assert_true(roaring_arena_activate(i == 0 ? NULL : arenas[i - 1]) ==
+                    arenas[i]);
+    }
+    for (int i = 0; i < DEPTH; i++) {
+        roaring_arena_free(arenas[i]);
+    }
+    roaring_arena_free(arena);
+}
+
+#ifndef _WIN32
+static bool arena_malloc_fails = false;
+
+static void *arena_failing_malloc(size_t size) {
+    return arena_malloc_fails ? NULL : malloc(size);
+}
+
+static void *arena_test_aligned_malloc(size_t alignment, size_t size) {
+    void *p;
+    return posix_memalign(&p, alignment, size) == 0 ? p : NULL;
+}
+
+DEFINE_TEST(test_arena_reset_failure) {
+    roaring_memory_t hook = {arena_failing_malloc, realloc, calloc, free,
+                             arena_test_aligned_malloc, free};
+    roaring_init_memory_hook(hook);
+    roaring_arena_t *arena = roaring_arena_create(0);
+    assert_non_null(arena);
+    // several chunks, so that the reset tries to coalesce them
+    roaring_arena_activate(arena);
+    roaring_bitmap_free(arena_test_bitmap(1));
+    roaring_arena_activate(NULL);
+
+    arena_malloc_fails = true;
+    roaring_arena_reset(arena);
+    assert_int_equal(roaring_arena_used(arena), 0);
+    // the arena keeps a chunk and remains usable
+    roaring_arena_activate(arena);
+    void *p = roaring_malloc(100);
+    roaring_arena_activate(NULL);
+    arena_malloc_fails = false;
+    assert_non_null(p);
+    memset(p, 1, 100);
+
+    roaring_arena_free(arena);
+    hook.malloc = malloc;
+    roaring_init_memory_hook(hook);
+}
+#endif
+
+// runs the tasks backwards, which they must not mind
+static void reverse_executor(void *context, roaring_task task, void *arg,
+                             size_t count) {
+    *(size_t *)context += count;
+    for (size_t i = count; i > 0; i--) {
+        task(arg, i - 1);
+    }
+}
+
+// Drains the lazy iterator in batches of the given size and checks that it
+// yields exactly the values of expected. Frees both.
+static void lazy_compare(roaring_lazy_iterator_t *it,
+                         roaring_bitmap_t *expected, uint32_t batch) {
+    assert_non_null(it);
+    uint64_t card = roaring_bitmap_get_cardinality(expected);
+    uint32_t *values = (uint32_t *)malloc((card + batch) * sizeof(uint32_t));
+    uint64_t n = 0;
+    uint32_t got;
+    do {
+        got = roaring_lazy_iterator_read(it, values + n, batch);
+        n += got;
+        assert_true(n <= card);
+    } while (got == batch);
+    assert_false(roaring_lazy_iterator_has_value(it));
+    assert_true(n == card);
+    roaring_bitmap_t *actual = roaring_bitmap_of_ptr(n, values);
+    assert_true(roaring_bitmap_equals(actual, expected));
+    for (uint64_t i = 1; i < n; i++) assert_true(values[i - 1] < values[i]);
+    roaring_bitmap_free(actual);
+    free(values);
+    roaring_lazy_iterator_free(it);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_lazy_iterators) {
+    enum { NUMBER = 5 };
+    roaring_bitmap_t *rs[NUMBER];
+    for (int i = 0; i < NUMBER; i++) {
+        rs[i] = roaring_bitmap_create();
+        // dense, sparse and run containers, overlapping between inputs
+        roaring_bitmap_add_range(rs[i], 100000 * i, 100000 * i + 150000);
+        for (uint32_t v = 0; v < 2000000; v += 7 + 3 * i) {
+            roaring_bitmap_add(rs[i], v);
+        }
+        for (int j = 0; j < 2000; j++) {
+            roaring_bitmap_add(rs[i], our_rand() % 5000000);
+        }
+        if (i % 2) roaring_bitmap_run_optimize(rs[i]);
+    }
+    const roaring_bitmap_t **inputs = (const roaring_bitmap_t **)rs;
+    const uint32_t batches[] = {1, 3, 1000, 100000};
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        for (size_t n = 0; n <= NUMBER; n++) {
+            lazy_compare(roaring_lazy_iterator_or_many(n, inputs),
+                         roaring_bitmap_or_many(n, inputs), batches[b]);
+            roaring_bitmap_t *expected = n == 0
+                                             ? roaring_bitmap_create()
+                                             : roaring_bitmap_and_many(n, inputs);
+            lazy_compare(roaring_lazy_iterator_and_many(n, inputs), expected,
+                         batches[b]);
+        }
+        // (r0 & r1) | (r2 & r3 & r4), composed
+        roaring_lazy_iterator_t *left[2] = {
+            roaring_lazy_iterator_create(rs[0]),
+            roaring_lazy_iterator_create(rs[1])};
+        roaring_lazy_iterator_t *parts[2] = {
+            roaring_lazy_iterator_and(2, left),
+            roaring_lazy_iterator_and_many(3, inputs + 2)};
+        roaring_bitmap_t *a = roaring_bitmap_and(rs[0], rs[1]);
+        roaring_bitmap_t *c = roaring_bitmap_and_many(3, inputs + 2);
+        lazy_compare(roaring_lazy_iterator_or(2, parts), roaring_bitmap_or(a, c),
+                     batches[b]);
+        roaring_bitmap_free(a);
+        roaring_bitmap_free(c);
+    }
+
+    // skipping ahead matches the first value >= the target
+    roaring_bitmap_t *expected = roaring_bitmap_or_many(NUMBER, inputs);
+    roaring_lazy_iterator_t *it = roaring_lazy_iterator_or_many(NUMBER, inputs);
+    roaring_uint32_iterator_t ref;
+    roaring_init_iterator(expected, &ref);
+    for (uint32_t target = 0; target < 6000000; target += 12345) {
+        assert_true(roaring_lazy_iterator_move_equalorlarger(it, target) ==
+                    roaring_move_uint32_iterator_equalorlarger(&ref, target));
+        if (!ref.has_value) break;
+        assert_int_equal(roaring_lazy_iterator_value(it), ref.current_value);
+        // never backwards
+        assert_true(roaring_lazy_iterator_move_equalorlarger(it, 0));
+        assert_int_equal(roaring_lazy_iterator_value(it), ref.current_value);
+    }
+    roaring_lazy_iterator_free(it);
+    roaring_bitmap_free(expected);
+
+    expected = roaring_bitmap_and_many(NUMBER, inputs);
+    it = roaring_lazy_iterator_and_many(NUMBER, inputs);
+    roaring_init_iterator(expected, &ref);
+    for (uint32_t target = 0; target < 6000000; target += 4321) {
+        assert_true(roaring_lazy_iterator_move_equalorlarger(it, target) ==
+                    roaring_move_uint32_iterator_equalorlarger(&ref, target));
+        if (!ref.has_value) break;
+        assert_int_equal(roaring_lazy_iterator_value(it), ref.current_value);
+    }
+    roaring_lazy_iterator_free(it);
+    roaring_bitmap_free(expected);
+
+    for (int i = 0; i < NUMBER; i++) roaring_bitmap_free(rs[i]);
+}
+
+DEFINE_TEST(test_many_parallel) {
+    enum { NUMBER = 6 };
+    roaring_bitmap_t *bitmaps[NUMBER];
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        bitmaps[i] = roaring_bitmap_create();
+        // keys spread over the whole key space, more of them at the start
+        for (uint32_t key = 0; key < 65536; key += 1 + key / 64 + i) {
+            uint32_t base = key << 16;
+            roaring_bitmap_add_range(bitmaps[i], base + 10 * i,
+                                     base + 20 * i + 1000 * (key % 5));
+            roaring_bitmap_add(bitmaps[i], base + 60000);
+        }
+        roaring_bitmap_run_optimize(bitmaps[i]);
+    }
+    roaring_bitmap_set_copy_on_write(bitmaps[1], true);
+    const roaring_bitmap_t **inputs = (const roaring_bitmap_t **)bitmaps;
+
+    // the tasks only read the inputs, even the copy-on-write one, whose
+    // containers would otherwise be turned into shared containers in place
+    {
+        const roaring_array_t *ra = &bitmaps[1]->high_low_container;
+        size_t bytes = ra->size * sizeof(void *);
+        void *before = malloc(bytes);
+        memcpy(before, ra->containers, bytes);
+        size_t tasks = 0;
+        roaring_bitmap_t *r = roaring_bitmap_or_many_parallel(
+            2, inputs, 4, reverse_executor, &tasks);
+        assert_true(roaring_bitmap_get_copy_on_write(r));
+        roaring_bitmap_free(r);
+        r = roaring_bitmap_and_many_parallel(3, inputs, 4, reverse_executor,
+                                             &tasks);
+        roaring_bitmap_free(r);
+        assert_int_equal(memcmp(before, ra->containers, bytes), 0);
+        free(before);
+    }
+
+    size_t partitions[] = {0, 1, 2, 3, 7, 64, 1000000};
+    for (size_t n = 0; n <= NUMBER; n++) {
+        roaring_bitmap_t *expected_or = roaring_bitmap_or_many(n, inputs);
+        roaring_bitmap_t *expected_and = roaring_bitmap_and_many(n, inputs);
+        for (size_t p = 0; p < sizeof(partitions) / sizeof(partitions[0]);
+             p++) {
+            size_t tasks = 0;
+            roaring_bitmap_t *r = roaring_bitmap_or_many_parallel(
+                n, inputs, partitions[p], reverse_executor, &tasks);
+            assert_true(roaring_bitmap_equals(r, expected_or));
+            assert_true(tasks <= partitions[p]);
+            roaring_bitmap_free(r);
+
+            r = roaring_bitmap_and_many_parallel(n, inputs, partitions[p],
+                                                 reverse_executor, &tasks);
+            assert_true(roaring_bitmap_equals(r, expected_and));
+            roaring_bitmap_free(r);
+
+            // without an executor, the tasks run on the calling thread
+            r = roaring_bitmap_or_many_parallel(n, inputs, partitions[p],
+                                                NULL, NULL);
+            assert_true(roaring_bitmap_equals(r, expected_or));
+            roaring_bitmap_free(r);
+        }
+        roaring_bitmap_free(expected_or);
+        roaring_bitmap_free(expected_and);
+    }
+
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        roaring_bitmap_free(bitmaps[i]);
+    }
+}
+
+DEFINE_TEST(test_expr_evaluate) {
+    enum { NUMBER = 4 };
+    roaring_bitmap_t *bitmaps[NUMBER];
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        bitmaps[i] = roaring_bitmap_create();
+        // arrays, bitsets and runs, on partially overlapping keys
+        for (uint32_t key = i; key < 200; key += 1 + i) {
+            uint32_t base = key << 16;
+            if (key % 3 == 0) {
+                for (uint32_t v = i; v < 65536; v += 2 + i) {
+                    roaring_bitmap_add(bitmaps[i], base + v);
+                }
+            } else if (key % 3 == 1) {
+                roaring_bitmap_add_range(bitmaps[i], base + 1000 * i,
+                                         base + 30000 + 1000 * i);
+            } else {
+                for (uint32_t v = 0; v < 65536; v += 97 + i) {
+                    roaring_bitmap_add(bitmaps[i], base + v);
+                }
+            }
+        }
+        roaring_bitmap_run_optimize(bitmaps[i]);
+    }
+    roaring_bitmap_t *A = bitmaps[0], *B = bitmaps[1];
+    roaring_bitmap_t *C = bitmaps[2], *D = bitmaps[3];
+    // shared containers
+    roaring_bitmap_set_copy_on_write(C, true);
+    roaring_bitmap_t *C2 = roaring_bitmap_copy(C);
+
+    roaring_expr_t a = roaring_expr_bitmap(A), b = roaring_expr_bitmap(B);
+    roaring_expr_t c = roaring_expr_bitmap(C), d = roaring_expr_bitmap(D);
+    roaring_expr_t c2 = roaring_expr_bitmap(C2);
+
+    // (A & B) | (C - D)
+    roaring_expr_t ab = roaring_expr_op(ROARING_EXPR_AND, &a, &b);
+    roaring_expr_t cd = roaring_expr_op(ROARING_EXPR_ANDNOT, &c, &d);
+    roaring_expr_t root = roaring_expr_op(ROARING_EXPR_OR, &ab, &cd);
+    roaring_bitmap_t *r1 = roaring_bitmap_and(A, B);
+    roaring_bitmap_t *r2 = roaring_bitmap_andnot(C, D);
+    roaring_bitmap_t *expected = roaring_bitmap_or(r1, r2);
+    roaring_bitmap_t *r = roaring_expr_evaluate(&root);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r2);
+
+    // ((A & B) ^ C) & (D | B)
+    roaring_expr_t abc = roaring_expr_op(ROARING_EXPR_XOR, &ab, &c);
+    roaring_expr_t db = roaring_expr_op(ROARING_EXPR_OR, &d, &b);
+    root = roaring_expr_op(ROARING_EXPR_AND, &abc, &db);
+    r2 = roaring_bitmap_xor(r1, C);
+    roaring_bitmap_t *r3 = roaring_bitmap_or(D, B);
+    expected = roaring_bitmap_and(r2, r3);
+    r = roaring_expr_evaluate(&root);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r3);
+    roaring_bitmap_free(r2);
+    roaring_bitmap_free(r1);
+
+    // A - ((B | C) ^ D)
+    roaring_expr_t bc = roaring_expr_op(ROARING_EXPR_OR, &b, &c);
+    roaring_expr_t bcd = roaring_expr_op(ROARING_EXPR_XOR, &bc, &d);
+    root = roaring_expr_op(ROARING_EXPR_ANDNOT, &a, &bcd);
+    r1 = roaring_bitmap_or(B, C);
+    roaring_bitmap_xor_inplace(r1, D);
+    expected = roaring_bitmap_andnot(A, r1);
+    r = roaring_expr_evaluate(&root);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r1);
+
+    // results that cancel out
+    root = roaring_expr_op(ROARING_EXPR_XOR, &c, &c2);
+    r = roaring_expr_evaluate(&root);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+    root = roaring_expr_op(ROARING_EXPR_ANDNOT, &c2, &c);
+    r = roaring_expr_evaluate(&root);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+
+    // a single leaf is copied
+    r = roaring_expr_evaluate(&c2);
+    assert_true(roaring_bitmap_equals(r, C));
+    roaring_bitmap_free(r);
+
+    // malformed trees
+    roaring_expr_t bad = roaring_expr_op(ROARING_EXPR_AND, &a, NULL);
+    assert_null(roaring_expr_evaluate(&bad));
+    bad = roaring_expr_bitmap(NULL);
+    assert_null(roaring_expr_evaluate(&bad));
+    assert_null(roaring_expr_evaluate(NULL));
+
+    roaring_bitmap_free(C2);
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        roaring_bitmap_free(bitmaps[i]);
+    }
+}
+
+DEFINE_TEST(test_threshold_many) {
+    enum { NUMBER = 7 };
+    roaring_bitmap_t *bitmaps[NUMBER];
+    uint32_t state = 1234;
+#define NEXT_RANDOM() (state = state * 1103515245 + 12345, state >> 8)
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        bitmaps[i] = roaring_bitmap_create();
+        for (uint32_t key = 0; key < 24; key++) {
+            if ((key + i) % 5 == 0) continue;
+            uint32_t base = key << 16;
+            switch (key % 4) {
+                case 0:  // sparse arrays and small runs: sweep
+                    for (int j = 0; j < 300; j++) {
+                        roaring_bitmap_add(bitmaps[i],
+                                           base + NEXT_RANDOM() % 1000);
+                    }
+                    roaring_bitmap_add_range(bitmaps[i], base + 2000 + 10 * i,
+                                             base + 2100 + 10 * i);
+                    break;
+                case 1:  // dense arrays: too many events to sweep
+                    for (int j = 0; j < 4000; j++) {
+                        roaring_bitmap_add(bitmaps[i],
+                                           base + NEXT_RANDOM() % 8000);
+                    }
+                    break;
+                case 2:  // runs
+                    for (int j = 0; j < 20; j++) {
+                        uint32_t start = NEXT_RANDOM() % 60000;
+                        roaring_bitmap_add_range(
+                            bitmaps[i], base + start,
+                            base + start + NEXT_RANDOM() % 5000);
+                    }
+                    break;
+                default:  // bitsets mixed with runs
+                    if (i % 2 == 0) {
+                        for (int j = 0; j < 10000; j++) {
+                            roaring_bitmap_add(bitmaps[i],
+                                               base + NEXT_RANDOM() % 30000);
+                        }
+                    } else {
+                        roaring_bitmap_add_range(bitmaps[i], base + 1000 * i,
+                                                 base + 20000 + 1000 * i);
+                    }
+                    break;
+            }
+        }
+        roaring_bitmap_run_optimize(bitmaps[i]);
+    }
+#undef NEXT_RANDOM
+    // shared containers
+    roaring_bitmap_set_copy_on_write(bitmaps[2], true);
+    roaring_bitmap_t *copy = roaring_bitmap_copy(bitmaps[2]);
+    roaring_bitmap_free(copy);
+    const roaring_bitmap_t **inputs = (const roaring_bitmap_t **)bitmaps;
+
+    roaring_bitmap_t *all = roaring_bitmap_or_many(NUMBER, inputs);
+    uint64_t card = roaring_bitmap_get_cardinality(all);
+    uint32_t *values = (uint32_t *)malloc(card * sizeof(uint32_t));
+    uint8_t *counts = (uint8_t *)malloc(card);
+    roaring_bitmap_to_uint32_array(all, values);
+    for (uint64_t j = 0; j < card; j++) {
+        counts[j] = 0;
+        for (uint32_t i = 0; i < NUMBER; i++) {
+            counts[j] += roaring_bitmap_contains(bitmaps[i], values[j]);
+        }
+    }
+
+    for (uint32_t t = 0; t <= NUMBER + 1; t++) {
+        roaring_bitmap_t *expected = roaring_bitmap_create();
+        for (uint64_t j = 0; j < card; j++) {
+            if (counts[j] >= t) roaring_bitmap_add(expected, values[j]);
+        }
+        roaring_bitmap_t *r = roaring_bitmap_threshold_many(NUMBER, inputs, t);
+        assert_true(roaring_bitmap_equals(r, expected));
+        roaring_bitmap_free(r);
+        roaring_bitmap_free(expected);
+    }
+    roaring_bitmap_t *r = roaring_bitmap_threshold_many(0, inputs, 1);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+
+    free(values);
+    free(counts);
+    roaring_bitmap_free(all);
+    for (uint32_t i = 0; i < NUMBER; i++) {
+        roaring_bitmap_free(bitmaps[i]);
+    }
+}
+
 void test_iterator_generate_data(uint32_t **values_out, uint32_t *count_out) {
     const size_t capacity = 1000*1000;
     uint32_t* values =
@@ -4236,6 +5433,316 @@ DEFINE_TEST(test_frozen_serialization_max_containers) {
     frozen_serialization_compare(r);
 }
 
+static bool count_values(uint32_t value, void *param) {
+    (void)value;
+    (*(uint64_t *)param)++;
+    return true;
+}
+
+void portable_frozen_compare(roaring_bitmap_t *r1) {
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r1);
+    char *storage = (char *)roaring_aligned_malloc(32, num_bytes + 8);
+    roaring_bitmap_t *other = roaring_bitmap_from_range(0, 1u << 20, 3);
+
+    // The view must work whatever the alignment of the buffer.
+    for (size_t offset = 0; offset < 8; offset++) {
+        char *buf = storage + offset;
+        assert_int_equal(roaring_bitmap_portable_serialize(r1, buf), num_bytes);
+
+        const roaring_bitmap_t *r2 =
+            roaring_bitmap_portable_deserialize_frozen(buf, num_bytes);
+        assert_non_null(r2);
+        assert_true(roaring_bitmap_equals(r1, r2));
+        assert_int_equal(roaring_bitmap_get_cardinality(r1),
+                         roaring_bitmap_get_cardinality(r2));
+
+        roaring_bitmap_t *a1 = roaring_bitmap_and(r1, other);
+        roaring_bitmap_t *a2 = roaring_bitmap_and(r2, other);
+        assert_true(roaring_bitmap_equals(a1, a2));
+        roaring_bitmap_free(a1);
+        roaring_bitmap_free(a2);
+
+        uint32_t max = roaring_bitmap_maximum(r1);
+        for (uint32_t i = 0; i < 100; i++) {
+            uint32_t v = (uint32_t)(((uint64_t)max + 1) * i / 100);
+            assert_true(roaring_bitmap_contains(r1, v) ==
+                        roaring_bitmap_contains(r2, v));
+        }
+
+        uint64_t count = 0;
+        roaring_iterate(r2, count_values, &count);
+        assert_int_equal(count, roaring_bitmap_get_cardinality(r1));
+
+        roaring_bitmap_free((roaring_bitmap_t *)r2);
+    }
+
+    // Truncated buffers are rejected.
+    assert_null(roaring_bitmap_portable_deserialize_frozen(storage, 0));
+    assert_null(
+        roaring_bitmap_portable_deserialize_frozen(storage, num_bytes - 1));
+
+    roaring_bitmap_free(other);
+    roaring_bitmap_free(r1);
+    roaring_aligned_free(storage);
+}
+
+DEFINE_TEST(test_portable_deserialize_frozen) {
+    const uint64_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_bitmap_add(r, 0);
+    roaring_bitmap_add(r, UINT32_MAX);
+    roaring_bitmap_add(r, 1000);
+    roaring_bitmap_add(r, 2001);
+    roaring_bitmap_add(r, 100000);
+    roaring_bitmap_add(r, 200000);
+    roaring_bitmap_add_range(r, s*10 + 100, s*13 - 100);
+    for (uint64_t i = 0; i < s*3; i += 2) {
+        roaring_bitmap_add(r, s*20 + i);
+    }
+    roaring_bitmap_t *norun = roaring_bitmap_copy(r);
+    roaring_bitmap_run_optimize(r);
+    portable_frozen_compare(r);
+    portable_frozen_compare(norun);
+    portable_frozen_compare(roaring_bitmap_create());
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t capacity;
+    size_t calls;
+    size_t max_iovcnt;
+    size_t fail_after;  // number of calls that succeed
+} stream_sink_t;
+
+static bool stream_sink_writev(void *context, const roaring_iovec_t *iov,
+                               size_t iovcnt) {
+    stream_sink_t *sink = (stream_sink_t *)context;
+    if (sink->calls++ == sink->fail_after) return false;
+    if (iovcnt > sink->max_iovcnt) sink->max_iovcnt = iovcnt;
+    for (size_t i = 0; i < iovcnt; i++) {
+        assert_true(iov[i].len > 0);
+        if (sink->size + iov[i].len > sink->capacity) {
+            sink->capacity = 2 * (sink->size + iov[i].len);
+            sink->buf = (char *)realloc(sink->buf, sink->capacity);
+        }
+        memcpy(sink->buf + sink->size, iov[i].base, iov[i].len);
+        sink->size += iov[i].len;
+    }
+    return true;
+}
+
+void portable_stream_compare(roaring_bitmap_t *r) {
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r);
+    char *expected = (char *)malloc(num_bytes);
+    assert_int_equal(roaring_bitmap_portable_serialize(r, expected), num_bytes);
+
+    stream_sink_t sink = {NULL, 0, 0, 0, 0, SIZE_MAX};
+    assert_int_equal(
+        roaring_bitmap_portable_serialize_stream(r, stream_sink_writev, &sink),
+        num_bytes);
+    assert_int_equal(sink.size, num_bytes);
+    assert_true(memcmp(sink.buf, expected, num_bytes) == 0);
+    assert_true(sink.max_iovcnt <= RA_STREAM_MAX_IOV);
+
+    // a failing writer stops the serialization
+    size_t calls = sink.calls;
+    sink.size = 0;
+    sink.calls = 0;
+    sink.fail_after = calls - 1;
+    assert_int_equal(
+        roaring_bitmap_portable_serialize_stream(r, stream_sink_writev, &sink),
+        0);
+    assert_int_equal(sink.calls, calls);
+
+#if ROARING_HAS_WRITEV
+    FILE *f = tmpfile();
+    assert_non_null(f);
+    assert_int_equal(roaring_bitmap_portable_serialize_fd(r, fileno(f)),
+                     num_bytes);
+    rewind(f);
+    assert_int_equal(fread(sink.buf, 1, num_bytes, f), num_bytes);
+    assert_true(fgetc(f) == EOF);
+    assert_true(memcmp(sink.buf, expected, num_bytes) == 0);
+    fclose(f);
+#endif
+
+    free(sink.buf);
+    free(expected);
+    roaring_bitmap_free(r);
+}
+
+DEFINE_TEST(test_portable_serialize_stream) {
+    const uint32_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_from_range(0, 100, 1);
+    roaring_bitmap_add_range(r, s * 10 + 100, s * 13 - 100);
+    for (uint32_t i = 0; i < s * 3; i += 2) {
+        roaring_bitmap_add(r, s * 20 + i);
+    }
+    roaring_bitmap_t *norun = roaring_bitmap_copy(r);
+    roaring_bitmap_run_optimize(r);
+    portable_stream_compare(r);
+    portable_stream_compare(norun);
+    portable_stream_compare(roaring_bitmap_create());
+
+    // More containers than fit in one batch of chunks or one staging buffer,
+    // some of them shared.
+    r = roaring_bitmap_create();
+    for (uint32_t k = 0; k < 3000; k++) {
+        roaring_bitmap_add_range(r, k * s + k, k * s + 3 * k + 1);
+        roaring_bitmap_add(r, k * s + 60000);
+    }
+    roaring_bitmap_run_optimize(r);
+    roaring_bitmap_set_copy_on_write(r, true);
+    roaring_bitmap_t *shared = roaring_bitmap_copy(r);
+    portable_stream_compare(r);
+    portable_stream_compare(shared);
+}
+
+// Decodes the serialization of r followed by a copy of it, in chunks of the
+// given size.
+void portable_decoder_compare(roaring_portable_decoder_t *d,
+                              const roaring_bitmap_t *r, size_t chunk) {
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r);
+    char *buf = (char *)malloc(2 * num_bytes);
+    roaring_bitmap_portable_serialize(r, buf);
+    memcpy(buf + num_bytes, buf, num_bytes);
+
+    size_t pos = 0;
+    for (int copy = 0; copy < 2; copy++) {
+        roaring_decoder_status_t status = ROARING_DECODER_NEED_MORE;
+        while (status == ROARING_DECODER_NEED_MORE) {
+            assert_null(roaring_portable_decoder_finish(d));
+            size_t len = 2 * num_bytes - pos;
+            if (len > chunk) len = chunk;
+            size_t consumed;
+            status = roaring_portable_decoder_feed(d, buf + pos, len, &consumed);
+            assert_true(consumed <= len);
+            pos += consumed;
+        }
+        assert_int_equal(status, ROARING_DECODER_DONE);
+        assert_int_equal(pos, (copy + 1) * num_bytes);
+        roaring_bitmap_t *r2 = roaring_portable_decoder_finish(d);
+        assert_non_null(r2);
+        assert_true(roaring_bitmap_equals(r, r2));
+        roaring_bitmap_free(r2);
+    }
+    free(buf);
+}
+
+DEFINE_TEST(test_portable_decoder) {
+    const uint32_t s = 65536;
+    roaring_bitmap_t *r = roaring_bitmap_from_range(0, 100, 1);
+    roaring_bitmap_add_range(r, s * 10 + 100, s * 13 - 100);
+    for (uint32_t i = 0; i < s * 3; i += 2) {
+        roaring_bitmap_add(r, s * 20 + i);
+    }
+    roaring_bitmap_t *norun = roaring_bitmap_copy(r);
+    roaring_bitmap_run_optimize(r);
+    roaring_bitmap_t *small = roaring_bitmap_of(3, 1, 100000, 1000000);
+    roaring_bitmap_run_optimize(small);
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+
+    roaring_portable_decoder_t *d = roaring_portable_decoder_create();
+    assert_non_null(d);
+    const size_t chunks[] = {1, 3, 1000, 8192, SIZE_MAX};
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        portable_decoder_compare(d, r, chunks[i]);
+        portable_decoder_compare(d, norun, chunks[i]);
+        portable_decoder_compare(d, small, chunks[i]);
+        portable_decoder_compare(d, empty, chunks[i]);
+    }
+
+    // truncated input leaves the decoder waiting, and freeing it releases the
+    // partial bitmap
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r);
+    char *buf = (char *)malloc(num_bytes);
+    roaring_bitmap_portable_serialize(r, buf);
+    assert_int_equal(roaring_portable_decoder_feed(d, buf, num_bytes - 1, NULL),
+                     ROARING_DECODER_NEED_MORE);
+    assert_null(roaring_portable_decoder_finish(d));
+    roaring_portable_decoder_free(d);
+
+    // invalid cookie or container count
+    d = roaring_portable_decoder_create();
+    uint32_t bad[2] = {12345, 0};
+    assert_int_equal(
+        roaring_portable_decoder_feed(d, (const char *)bad, sizeof(bad), NULL),
+        ROARING_DECODER_ERROR);
+    assert_int_equal(roaring_portable_decoder_feed(d, buf, num_bytes, NULL),
+                     ROARING_DECODER_ERROR);
+    assert_null(roaring_portable_decoder_finish(d));
+    roaring_portable_decoder_free(d);
+    d = roaring_portable_decoder_create();
+    bad[0] = SERIAL_COOKIE_NO_RUNCONTAINER;
+    bad[1] = (1 << 16) + 1;
+    assert_int_equal(
+        roaring_portable_decoder_feed(d, (const char *)bad, sizeof(bad), NULL),
+        ROARING_DECODER_ERROR);
+    roaring_portable_decoder_free(d);
+
+    free(buf);
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(norun);
+    roaring_bitmap_free(small);
+    roaring_bitmap_free(empty);
+}
+
+DEFINE_TEST(test_portable_deserialize_parallel) {
+    const uint32_t s = 65536;
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t k = 0; k < 500; k++) {
+        switch (k % 3) {
+            case 0:  // array
+                roaring_bitmap_add_range(r, k * s + k, k * s + 2 * k + 1);
+                break;
+            case 1:  // bitset
+                for (uint32_t i = 0; i < s; i += 3) {
+                    roaring_bitmap_add(r, k * s + i);
+                }
+                break;
+            default:  // run
+                roaring_bitmap_add_range(r, k * s, k * s + 30000);
+        }
+    }
+    roaring_bitmap_t *norun = roaring_bitmap_copy(r);
+    roaring_bitmap_run_optimize(r);
+    roaring_bitmap_t *small = roaring_bitmap_of(3, 1, 100000, 1000000);
+    roaring_bitmap_run_optimize(small);
+    roaring_bitmap_t *inputs[] = {r, norun, small, roaring_bitmap_create()};
+    const size_t partitions[] = {0, 1, 2, 7, 1000};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        size_t num_bytes = roaring_bitmap_portable_size_in_bytes(inputs[i]);
+        char *buf = (char *)malloc(num_bytes);
+        roaring_bitmap_portable_serialize(inputs[i], buf);
+        for (size_t p = 0; p < sizeof(partitions) / sizeof(partitions[0]);
+             p++) {
+            size_t tasks = 0;
+            roaring_bitmap_t *r2 = roaring_bitmap_portable_deserialize_parallel(
+                buf, num_bytes, partitions[p], reverse_executor, &tasks);
+            assert_non_null(r2);
+            assert_true(roaring_bitmap_equals(inputs[i], r2));
+            assert_true(tasks <= partitions[p]);
+            roaring_bitmap_free(r2);
+            // without an executor, the tasks run on the calling thread
+            r2 = roaring_bitmap_portable_deserialize_parallel(
+                buf, num_bytes, partitions[p], NULL, NULL);
+            assert_true(roaring_bitmap_equals(inputs[i], r2));
+            roaring_bitmap_free(r2);
+            // truncated input
+            for (size_t len = 0; len < num_bytes; len += 1 + len / 2) {
+                assert_null(roaring_bitmap_portable_deserialize_parallel(
+                    buf, len, partitions[p], reverse_executor, &tasks));
+            }
+        }
+        free(buf);
+        roaring_bitmap_free(inputs[i]);
+    }
+}
+
 
 int main() {
     tellmeall();
@@ -4269,10 +5776,14 @@ int main() {
         cmocka_unit_test(test_intersect_small_run_bitset),
         cmocka_unit_test(is_really_empty),
         cmocka_unit_test(test_rank),
+        cmocka_unit_test(test_rank_index),
+        cmocka_unit_test(test_rank_index_stale),
         cmocka_unit_test(test_maximum_minimum),
         cmocka_unit_test(test_stats),
         cmocka_unit_test(test_addremove),
         cmocka_unit_test(test_addremove_bulk),
+        cmocka_unit_test(test_add_many_unsorted),
+        cmocka_unit_test(test_contains_many),
         cmocka_unit_test(test_addremoverun),
         cmocka_unit_test(test_basic_add),
         cmocka_unit_test(test_remove_withrun),
@@ -4285,6 +5796,8 @@ int main() {
         cmocka_unit_test(leaks_with_empty_true),
         cmocka_unit_test(leaks_with_empty_false),
         cmocka_unit_test(test_bitmap_from_range),
+        cmocka_unit_test(test_from_sorted),
+        cmocka_unit_test(test_from_sorted_trailing_duplicate),
         cmocka_unit_test(test_printf),
         cmocka_unit_test(test_printf_withbitmap),
         cmocka_unit_test(test_printf_withrun),
@@ -4292,6 +5805,9 @@ int main() {
         cmocka_unit_test(test_iterate_empty),
         cmocka_unit_test(test_iterate_withbitmap),
         cmocka_unit_test(test_iterate_withrun),
+        cmocka_unit_test(test_visit_containers),
+        cmocka_unit_test(test_iterate_ranges),
+        cmocka_unit_test(test_adaptive_containers),
         cmocka_unit_test(test_serialize),
         cmocka_unit_test(test_portable_serialize),
         cmocka_unit_test(test_add),
@@ -4350,6 +5866,17 @@ int main() {
         cmocka_unit_test(select_test),
         cmocka_unit_test(test_subset),
         cmocka_unit_test(test_or_many_memory_leak),
+        cmocka_unit_test(test_and_many),
+        cmocka_unit_test(test_many_parallel),
+        cmocka_unit_test(test_lazy_iterators),
+        cmocka_unit_test(test_expr_evaluate),
+        cmocka_unit_test(test_threshold_many),
+        cmocka_unit_test(test_arena),
+        cmocka_unit_test(test_arena_nested),
+        cmocka_unit_test(test_arena_deactivated),
+#ifndef _WIN32
+        cmocka_unit_test(test_arena_reset_failure),
+#endif
         // cmocka_unit_test(test_run_to_bitset),
         // cmocka_unit_test(test_run_to_array),
         cmocka_unit_test(test_read_uint32_iterator_array),
@@ -4368,6 +5895,10 @@ int main() {
         cmocka_unit_test(test_range_cardinality),
         cmocka_unit_test(test_frozen_serialization),
         cmocka_unit_test(test_frozen_serialization_max_containers),
+        cmocka_unit_test(test_portable_deserialize_frozen),
+        cmocka_unit_test(test_portable_serialize_stream),
+        cmocka_unit_test(test_portable_decoder),
+        cmocka_unit_test(test_portable_deserialize_parallel),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -74,6 +74,59 @@ DEFINE_TEST(setandextract_uint32) {
     }
 }
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+// The AVX-512 decoders must agree with the scalar decoders, including when
+// the output capacity forces them onto their scalar tail.
+DEFINE_TEST(setandextract_avx512) {
+    if (!croaring_avx512()) {
+        return;
+    }
+    const unsigned int bitset_size = 1 << 16;
+    const unsigned int bitset_size_in_words =
+        bitset_size / (sizeof(uint64_t) * 8);
+    uint64_t* bitset = (uint64_t*)calloc(bitset_size_in_words, sizeof(uint64_t));
+    uint32_t* expected32 = (uint32_t*)malloc(bitset_size * sizeof(uint32_t));
+    uint32_t* got32 = (uint32_t*)malloc(bitset_size * sizeof(uint32_t));
+    uint16_t* expected16 = (uint16_t*)malloc(bitset_size * sizeof(uint16_t));
+    uint16_t* got16 = (uint16_t*)malloc(bitset_size * sizeof(uint16_t));
+    uint32_t seed = 1234;
+    for (int density = 1; density <= 64; density *= 2) {
+        for (unsigned int k = 0; k < bitset_size_in_words; ++k) {
+            uint64_t w = 0;
+            for (int b = 0; b < 64; ++b) {
+                seed = seed * 1103515245 + 12345;
+                if ((seed >> 16) % 64 < (uint32_t)density) w |= UINT64_C(1) << b;
+            }
+            bitset[k] = w;
+        }
+        size_t card = bitset_extract_setbits(bitset, bitset_size_in_words,
+                                             expected32, 100000);
+        bitset_extract_setbits_uint16(bitset, bitset_size_in_words,
+                                      expected16, 7);
+        // exact capacity and generous capacity
+        for (size_t capacity = card; capacity <= card + 64; capacity += 64) {
+            size_t got = bitset_extract_setbits_avx512(
+                bitset, bitset_size_in_words, got32, capacity, 100000);
+            assert_int_equal(got, card);
+            for (size_t k = 0; k < card; ++k) {
+                assert_int_equal(got32[k], expected32[k]);
+            }
+            got = bitset_extract_setbits_avx512_uint16(
+                bitset, bitset_size_in_words, got16, capacity, 7);
+            assert_int_equal(got, card);
+            for (size_t k = 0; k < card; ++k) {
+                assert_int_equal(got16[k], expected16[k]);
+            }
+        }
+    }
+    free(bitset);
+    free(expected32);
+    free(got32);
+    free(expected16);
+    free(got16);
+}
+#endif
+
 
 int main() {
     tellmeall();
@@ -81,6 +134,9 @@ int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(setandextract_uint16),
         cmocka_unit_test(setandextract_uint32),
+#if CROARING_COMPILER_SUPPORTS_AVX512
+        cmocka_unit_test(setandextract_avx512),
+#endif
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
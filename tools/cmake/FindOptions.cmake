@@ -24,6 +24,14 @@ if(ROARING_DISABLE_AVX)
    # we can manually disable AVX by defining DISABLEAVX
    set (OPT_FLAGS "${OPT_FLAGS} -DROARING_DISABLE_AVX" )
  endif()
+if(ROARING_DISABLE_AVX512)
+   # AVX2 remains available, only the AVX-512 kernels are disabled
+   set (OPT_FLAGS "${OPT_FLAGS} -DROARING_DISABLE_AVX512" )
+endif()
+if(ROARING_DISABLE_ATOMICS)
+   # shared containers then cannot be copied or freed concurrently
+   set (OPT_FLAGS "${OPT_FLAGS} -DROARING_DISABLE_ATOMICS" )
+endif()
 if(ROARING_DISABLE_NEON)
   set (OPT_FLAGS "${OPT_FLAGS} -DDISABLENEON" )
 endif()